@@ -43,11 +43,30 @@
     filter of TextWindow.
   - Remembering current pattern and search text would be nice, for repeated
     invocations.  Maybe some more tweaks.
+  - Directory traversal stays on the GUI thread, so pause and stop work as before;
+    but each file is handed to a SearchJob on the thread pool, which memory-maps
+    the file and searches it from hit to hit with FXRex::search(), instead of
+    loading it and trying a match at every position.
+  - Files with a NUL byte in the first BINARYCHECK bytes are assumed to be binary,
+    and are skipped.
+  - FXRex searches with FXint offsets, so the size limit is at most 2GB; it is
+    checked again on the mapped file, which may have grown since it was visited.
+  - Hits are collected in batches of "path:line:column\tcontext" lines, and handed
+    back to the dialog through the message channel; so results from different
+    files come in the order the files were finished, not the order they were found.
+    Each batch starts with its length, as a hit further into the file may still
+    contain a NUL.
+  - When the thread pool's queue is full, the traversal waits, and processes events
+    in the mean time, so the dialog stays responsive, and pending results appear.
+  - When stopped, the workers stop at the next hit, and drop what they found.
 */
 
 #define HORZ_PAD      12
 #define VERT_PAD      2
 
+#define BINARYCHECK   4096      // Bytes checked for NUL to tell if file is binary
+#define BATCHSIZE     16384     // Results batched up to about this many bytes
+
 /*******************************************************************************/
 
 // Map
@@ -74,6 +93,7 @@ FXDEFMAP(FindInFiles) FindInFilesMap[]={
   FXMAPFUNC(SEL_COMMAND,FindInFiles::ID_FIRST_HIT,FindInFiles::onCmdFirstHit),
   FXMAPFUNCS(SEL_UPDATE,FindInFiles::ID_ICASE,FindInFiles::ID_HIDDEN,FindInFiles::onUpdFlags),
   FXMAPFUNCS(SEL_COMMAND,FindInFiles::ID_ICASE,FindInFiles::ID_HIDDEN,FindInFiles::onCmdFlags),
+  FXMAPFUNC(SEL_COMMAND,FindInFiles::ID_RESULTS,FindInFiles::onCmdResults),
   };
 
 
@@ -146,49 +166,106 @@ FXuint SearchVisitor::visit(const FXString& path){
 
 // Search file contents for pattern
 FXint SearchVisitor::searchFile(const FXString& path) const {
-  FXString text;
   FXTRACE((1,"searchFile(path=%s)\n",path.text()));
-  if(loadFile(path,text)){
-    FXString relpath=FXPath::relative(dlg->getDirectory(),path);
-    FXString hit;
-    FXint beg[10],end[10],ls,le,p;
-    FXint lineno=1;
-    FXint column=0;
-    FXint pos=0;
-    FXTRACE((1,"loadFile(path=%s) -> %d bytes\n",relpath.text(),text.length()));
-    dlg->setSearchingText(relpath);
-    while(pos<text.length()){
-      if(rex.amatch(text,pos,FXRex::Normal,beg,end,10)){
-        for(ls=beg[0]; 0<ls && text[ls-1]!='\n'; --ls){ }               // Back up to line start
-        for(le=beg[0]; le<text.length() && text[le]!='\n'; ++le){ }     // Advance to line end
-        for(p=ls,column=0; p<beg[0]; p=text.inc(p)){                    // Count columns, assuming for now tabs are set at 8
-          column+=(text[p]=='\t')?8-column%8:1;
+  if(!dlg->searchFile(rex,path,limit)) return 2;
+  return 0;
+  }
+
+/*******************************************************************************/
+
+// Search one file on a worker thread
+class SearchJob : public FXRunnable {
+private:
+  FindInFiles      *dlg;        // Find dialog, receives results
+  FXMessageChannel *channel;    // Channel to send results over
+  FXCompletion     *jobs;       // Signal when done
+  volatile FXint   *cancel;     // Set when search is stopped
+  const FXRex      *rex;        // Pattern, shared by all jobs
+  FXString          path;       // File to search
+  FXString          relpath;    // File name shown in results
+  FXString          batch;      // Results not yet sent
+  FXlong            limit;      // File size limit
+  FXbool            firsthit;   // Record only first hit in file
+private:
+  void search(const FXchar* text,FXint len);
+  void send();
+private:
+  SearchJob(const SearchJob&);
+  SearchJob& operator=(const SearchJob&);
+public:
+  SearchJob(FindInFiles* dg,FXMessageChannel* ch,FXCompletion* cp,volatile FXint* cn,const FXRex* rx,const FXString& pa,const FXString& rp,FXlong lm,FXbool fh):dlg(dg),channel(ch),jobs(cp),cancel(cn),rex(rx),path(pa),relpath(rp),limit(lm),firsthit(fh){ }
+  virtual FXint run();
+  };
+
+
+// Map file, search it unless it looks binary, and send what was found
+FXint SearchJob::run(){
+  FXlong size=FXStat::size(path);
+  if(0<size && size<=limit && !*cancel){
+    FXMappedFile file;
+    if(file.open(path,FXIO::Reading)){
+      const FXchar* text=(const FXchar*)file.data();
+      FXlong len=file.length();
+      if(0<len && len<=limit){
+        file.advise(FXMappedFile::Sequential);
+        if(!memchr(text,'\0',FXMIN(len,BINARYCHECK))){
+          search(text,(FXint)len);
           }
-        hit.assign(&text[ls],le-ls);
-        hit.trim();
-        dlg->appendSearchResult(relpath,hit,lineno,column);
-        if(dlg->getFirstHit()) break;
-        pos=le;
         }
-      lineno+=(text[pos++]=='\n');              // Moved to next line
+      file.close();
       }
     }
+  send();
+  jobs->decrement();
+  delete this;
   return 0;
   }
 
 
-// Load file contents
-FXlong SearchVisitor::loadFile(const FXString& path,FXString& text) const {
-  FXFile file(path,FXFile::Reading);
-  if(file.isOpen()){
-    FXlong size=file.size();
-    if(0<size && size<=limit){
-      if(text.length(size)){
-        return file.readBlock(text.text(),text.length());
-        }
+// Find hits, jumping from one to the next
+void SearchJob::search(const FXchar* text,FXint len){
+  const FXchar *p,*e;
+  FXString hit;
+  FXint beg[1],end[1],ls,le,column;
+  FXint lineno=1;
+  FXint at=0;
+  FXint pos=0;
+  while(pos<len && 0<=rex->search(text,len,pos,len,FXRex::Normal,beg,end,1)){
+    if(*cancel) break;
+    for(; at<beg[0]; ++at){                                             // Count lines up to hit
+      lineno+=(text[at]=='\n');
+      }
+    for(ls=beg[0]; 0<ls && text[ls-1]!='\n'; --ls){ }                   // Back up to line start
+    e=(const FXchar*)memchr(text+beg[0],'\n',len-beg[0]);               // Advance to line end
+    le=e?(FXint)(e-text):len;
+    for(p=text+ls,column=0; p<text+beg[0]; p=wcinc(p)){                 // Count columns, assuming for now tabs are set at 8
+      column+=(*p=='\t')?8-column%8:1;
+      }
+    hit.assign(text+ls,le-ls);
+    hit.trim();
+    batch.append(FXString::value("%s:%d:%d\t",relpath.text(),lineno,column));
+    batch.append(hit);
+    batch.append('\n');
+    if(firsthit) break;
+    if(BATCHSIZE<=batch.length()) send();
+    pos=le+1;
+    }
+  }
+
+
+// Hand batch of results to the dialog, unless stopped; the batch is
+// preceded by its length
+void SearchJob::send(){
+  if(!batch.empty() && !*cancel){
+    FXint len=batch.length();
+    FXchar* data;
+    if(allocElms(data,sizeof(FXint)+len)){
+      memcpy(data,&len,sizeof(FXint));
+      copyElms(data+sizeof(FXint),batch.text(),len);
+      channel->handoff(dlg,FXSEL(SEL_COMMAND,FindInFiles::ID_RESULTS),data,sizeof(FXint)+len);
       }
     }
-  return 0L;
+  batch.clear();
   }
 
 /*******************************************************************************/
@@ -209,6 +286,8 @@ FindInFiles::FindInFiles():visitor(this){
   index=-1;
   proceed=1;
   firsthit=false;
+  channel=nullptr;
+  cancel=0;
   }
 
 
@@ -296,6 +375,10 @@ FindInFiles::FindInFiles(Adie *a):FXDialogBox(a,"Find In Files",DECOR_TITLE|DECO
   index=-1;
   proceed=1;
   firsthit=false;
+
+  // Results from workers
+  channel=new FXMessageChannel(a);
+  cancel=0;
   }
 
 
@@ -388,12 +471,21 @@ FXbool FindInFiles::continueProcessing(){
   }
 
 
-// Called by visitor to deposit new search result
-// List will show filename relativized to base name, and location of where string was found
-void FindInFiles::appendSearchResult(const FXString& relpath,const FXString& text,FXint lineno,FXint column){
-  FXString string;
-  string.format("%s:%d:%d\t%s",relpath.text(),lineno,column,text.text());
-  locations->appendItem(string);
+// Called by visitor to search file for pattern on a worker thread
+// While the thread pool's queue is full, keep processing events; return false if stopped
+FXbool FindInFiles::searchFile(const FXRex& rex,const FXString& path,FXlong limit){
+  FXString relpath=FXPath::relative(getDirectory(),path);
+  SearchJob* job=new SearchJob(this,channel,&jobs,&cancel,&rex,path,relpath,limit,firsthit);
+  setSearchingText(relpath);
+  jobs.increment();
+  while(!pool.execute(job,0)){
+    if(!continueProcessing()){
+      jobs.decrement();
+      delete job;
+      return false;
+      }
+    }
+  return true;
   }
 
 
@@ -529,6 +621,7 @@ long FindInFiles::onUpdStop(FXObject* sender,FXSelector,void*){
 // Stop scanning disk
 long FindInFiles::onCmdStop(FXObject*,FXSelector,void*){
   proceed=2;
+  cancel=1;
   return 1;
   }
 
@@ -536,7 +629,7 @@ long FindInFiles::onCmdStop(FXObject*,FXSelector,void*){
 // Update pause/resume button
 long FindInFiles::onUpdPause(FXObject* sender,FXSelector,void*){
   sender->handle(this,(proceed==0)?FXSEL(SEL_COMMAND,ID_CHECK):FXSEL(SEL_COMMAND,ID_UNCHECK),nullptr);
-  sender->handle(this,visitor.visiting()?FXSEL(SEL_COMMAND,ID_ENABLE):FXSEL(SEL_COMMAND,ID_DISABLE),nullptr);
+  sender->handle(this,(visitor.visiting() || !jobs.done())?FXSEL(SEL_COMMAND,ID_ENABLE):FXSEL(SEL_COMMAND,ID_DISABLE),nullptr);
   return 1;
   }
 
@@ -564,7 +657,7 @@ long FindInFiles::onCmdDelete(FXObject*,FXSelector,void*){
 
 // Grey out buttons if no search text
 long FindInFiles::onUpdSearch(FXObject* sender,FXSelector,void*){
-  FXbool enabled=!visitor.visiting() && !findstring->getText().empty();
+  FXbool enabled=!visitor.visiting() && jobs.done() && !findstring->getText().empty();
   sender->handle(this,enabled?FXSEL(SEL_COMMAND,ID_ENABLE):FXSEL(SEL_COMMAND,ID_DISABLE),nullptr);
   return 1;
   }
@@ -580,9 +673,15 @@ long FindInFiles::onCmdSearch(FXObject*,FXSelector,void*){
   if(!(getSearchMode()&SearchRegex)) rexmode|=FXRex::Verbatim;                  // Verbatim match
   if(getSearchMode()&SeachHidden) opts|=FXDir::HiddenFiles|FXDir::HiddenDirs;   // Visit hidden files and directories
   if(!(getSearchMode()&SearchRecurse)) limit=2;                                 // Don't recurse
+  if(visitor.visiting() || !jobs.done()) return 1;                              // Still searching
   appendHistory(getSearchText(),getDirectory(),getCurrentPattern(),getSearchMode());
+  if(!pool.active()) pool.start();
   proceed=1;
+  cancel=0;
   visitor.traverse(getDirectory(),getSearchText(),getPattern(),rexmode,opts,limit);
+  while(!jobs.wait(10000000)){                                                  // Wait for workers to finish
+    continueProcessing();
+    }
   setSearchingText(tr("<stopped>"));
   getApp()->refresh();
   return 1;
@@ -732,6 +831,15 @@ long FindInFiles::onMouseWheel(FXObject*,FXSelector,void* ptr){
   }
 
 
+// Batch of results from worker, preceded by its length
+long FindInFiles::onCmdResults(FXObject*,FXSelector,void* ptr){
+  FXint len;
+  memcpy(&len,ptr,sizeof(FXint));
+  locations->fillItems(FXString((const FXchar*)ptr+sizeof(FXint),len));
+  return 1;
+  }
+
+
 // File list double clicked
 long FindInFiles::onCmdFileDblClicked(FXObject*,FXSelector,void* ptr){
   FXint which=(FXint)(FXival)ptr;
@@ -753,10 +861,14 @@ long FindInFiles::onCmdFileDblClicked(FXObject*,FXSelector,void* ptr){
 
 // Clean up
 FindInFiles::~FindInFiles(){
+  cancel=1;
+  pool.stop();
+  delete channel;
   locations=(FXIconList*)-1L;
   findstring=(FXTextField*)-1L;
   filefolder=(FXTextField*)-1L;
   filefilter=(FXComboBox*)-1L;
   pausebutton=(FXToggleButton*)-1L;
   searching=(FXLabel*)-1L;
+  channel=(FXMessageChannel*)-1L;
   }
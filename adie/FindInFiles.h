@@ -33,7 +33,6 @@ private:
   FXRex        rex;     // Regex parser
   FXlong       limit;   // File size limit
 private:
-  FXlong loadFile(const FXString& path,FXString& text) const;
   FXint searchFile(const FXString& path) const;
 private:
   SearchVisitor();
@@ -82,6 +81,10 @@ protected:
   FXint           index;                // History index
   FXuint          proceed;              // Flag
   FXbool          firsthit;             // Record only first hit in file
+  FXThreadPool    pool;                 // Workers searching files
+  FXCompletion    jobs;                 // Files still being searched
+  FXMessageChannel *channel;            // Results from workers
+  volatile FXint  cancel;               // Tell workers to stop early
 protected:
   FindInFiles();
 private:
@@ -113,6 +116,7 @@ public:
   long onArrowKey(FXObject*,FXSelector,void*);
   long onMouseWheel(FXObject*,FXSelector,void*);
   long onCmdFileDblClicked(FXObject*,FXSelector,void*);
+  long onCmdResults(FXObject*,FXSelector,void*);
 public:
   enum {
     SearchExact    = 0,         /// Search exact matches
@@ -141,6 +145,7 @@ public:
     ID_PAUSE,
     ID_STOP,
     ID_DELETE,
+    ID_RESULTS,
     ID_LAST
     };
 public:
@@ -160,8 +165,8 @@ public:
   /// Called by visitor to see if we should continue processing
   FXbool continueProcessing();
 
-  /// Called by visitor to deposit new search result
-  void appendSearchResult(const FXString& relpath,const FXString& text,FXint lineno,FXint column);
+  /// Called by visitor to search file for pattern on a worker thread
+  FXbool searchFile(const FXRex& rex,const FXString& path,FXlong limit);
 
   /// Clear search results
   void clearSearchResults();
@@ -280,12 +280,20 @@ void FX2DChart::drawSelf(FXDC& dc) const {
         axes[YLO]->drawAxis(dc,plotleft,plotbottom,plotleft,plottop,plotright-plotleft,0);
         axes[XHI]->drawAxis(dc,plotleft,plottop,plotright,plottop,0,plotbottom-plottop);
         axes[YHI]->drawAxis(dc,plotright,plotbottom,plotright,plottop,plotleft-plotright,0);
+
+        // Draw the data
+        drawData(dc,plotleft,plottop,plotright-plotleft+1,plotbottom-plottop+1);
         }
       }
     }
   }
 
 
+// Draw data inside the plot area; overridden by subclasses
+void FX2DChart::drawData(FXDC&,FXint,FXint,FXint,FXint) const {
+  }
+
+
 long FX2DChart::onCmdXXX(FXObject*,FXSelector,void*){
   return 1;
   }
@@ -37,6 +37,7 @@ protected:
 protected:
   FX2DChart();
   virtual void drawSelf(FXDC& dc) const;
+  virtual void drawData(FXDC& dc,FXint x,FXint y,FXint w,FXint h) const;
 private:
   FX2DChart(const FX2DChart&);
   FX2DChart &operator=(const FX2DChart&);
@@ -21,6 +21,7 @@
 #include "fx.h"
 #include "chartdefs.h"
 #include "chartutils.h"
+#include "FXAxis.h"
 #include "FXChart.h"
 #include "FXCurve.h"
 #include "FX2DChart.h"
@@ -28,6 +29,8 @@
 
 /*
   Notes:
+  - Curves are drawn against the lower x and y axes, or against the upper ones
+    if their x or y axis is set to a non-zero value, clipped to the plot area.
 */
 
 
@@ -93,6 +96,25 @@ void FX2DPlot::clearCurves(){
   }
 
 
+// Draw the curves
+void FX2DPlot::drawData(FXDC& dc,FXint x,FXint y,FXint w,FXint h) const {
+  FXRectangle clip=dc.getClipRectangle();
+  Range xr,yr;
+  FXAxis *ax;
+  dc.setClipRectangle(x,y,w,h);
+  for(FXint i=0; i<curves.no(); i++){
+    ax=axes[curves[i]->getXAxis()?XHI:XLO];
+    xr.minimum=ax->getAxisRangeMin();
+    xr.maximum=ax->getAxisRangeMax();
+    ax=axes[curves[i]->getYAxis()?YHI:YLO];
+    yr.minimum=ax->getAxisRangeMin();
+    yr.maximum=ax->getAxisRangeMax();
+    curves[i]->drawCurve(dc,x,y,w,h,xr,yr);
+    }
+  dc.setClipRectangle(clip);
+  }
+
+
 // Save data
 void FX2DPlot::save(FXStream& store) const {
   FX2DChart::save(store);
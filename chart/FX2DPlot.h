@@ -42,6 +42,7 @@ protected:
   FXCurveList curves;   // List of curves
 protected:
   FX2DPlot();
+  virtual void drawData(FXDC& dc,FXint x,FXint y,FXint w,FXint h) const;
 private:
   FX2DPlot(const FX2DPlot&);
   FX2DPlot &operator=(const FX2DPlot&);
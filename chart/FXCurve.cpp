@@ -22,14 +22,42 @@
 #include "chartdefs.h"
 #include "chartutils.h"
 #include "FXChart.h"
+#include "FXData.h"
+#include "FXSummary.h"
 #include "FXCurve.h"
 #include "FX2DChart.h"
 #include "FX2DPlot.h"
 
 /*
   Notes:
+  - The x and y samples are columns of FXData tables, which may be the same
+    table; tables may be shared between curves, so the curve doesn't own them.
+  - Without x samples, the row number is used for x.
+  - Curves are reduced to the pixel grid before drawing, so drawing takes time
+    proportional to the width of the plot, not to the number of samples.  Both
+    ways of doing this use the min/max pyramid of the y samples (FXSummary),
+    which finds the smallest and largest sample in a range of rows in O(log n).
+  - The envelope, for time series, where x never decreases: the rows in each
+    pixel column are found by binary search on x; then the first, smallest,
+    largest, and last sample in the column are drawn, so that no spike gets lost
+    and lines between columns still join up.  One row on either side of the
+    plot is added, so the curve runs up to the edges.
+  - Largest-Triangle-Three-Buckets (LTTB), for other curves: the rows in view
+    (all rows, if x isn't ordered) are split into 4*w buckets, and the smallest
+    and largest sample of each bucket become candidates; LTTB then picks 2*w of
+    the candidates, each the one making the largest triangle with the point
+    picked before and the average of the next bucket.  Fewer than 8*w rows are
+    given to LTTB as they are.
+  - Both work in pixel coordinates, clamped to what fits in FXPoint.
+  - NaN samples are skipped; they don't break the line.
+  - Saved curves start with label, x axis, and y axis, as they always did; the line
+    style and decimation mode follow only if the high bit of the saved x axis is
+    set, so curves saved before these existed still load.
 */
 
+// Saved x axis flag: line style and decimation follow
+#define CURVE_STYLED 0x80
+
 
 using namespace FXCHART;
 
@@ -37,21 +65,33 @@ using namespace FXCHART;
 
 namespace FXCHART {
 
-// Object implementation
-FXIMPLEMENT(FXCurve,FXObject,nullptr,0)
+// Default line style
+const LineStyle defaultLineStyle={FXRGB(0,0,0),1,LINESTYLE_SOLID};
+
+// Dash patterns for line styles
+static const FXuchar dotted[]={1,2};
+static const FXuchar shortdashed[]={3,3};
+static const FXuchar longdashed[]={6,3};
+static const FXuchar dotdashed[]={6,2,1,2};
 
 
-class FXData {
-  };
+// Object implementation
+FXIMPLEMENT(FXCurve,FXObject,nullptr,0)
 
 
 // Deserialization
-FXCurve::FXCurve():plot(nullptr),xdata(nullptr),ydata(nullptr),xaxis(0),yaxis(0){
+FXCurve::FXCurve():plot(nullptr),xdata(nullptr),ydata(nullptr),xcolumn(0),ycolumn(0),decimation(DECIMATE_AUTO),xaxis(0),yaxis(0){
+  xsummary=new FXSummary;
+  ysummary=new FXSummary;
+  linestyle=defaultLineStyle;
   }
 
 
 // Init
-FXCurve::FXCurve(FX2DPlot* plt,const FXString& nm):plot(plt),xdata(nullptr),ydata(nullptr),label(nm),xaxis(0),yaxis(0){
+FXCurve::FXCurve(FX2DPlot* plt,const FXString& nm):plot(plt),xdata(nullptr),ydata(nullptr),xcolumn(0),ycolumn(0),label(nm),decimation(DECIMATE_AUTO),xaxis(0),yaxis(0){
+  xsummary=new FXSummary;
+  ysummary=new FXSummary;
+  linestyle=defaultLineStyle;
   }
 
 
@@ -83,28 +123,266 @@ void FXCurve::setYAxis(FXuchar ax){
 
 
 // Change x data samples
-void FXCurve::setXData(FXData* dd){
-  if(xdata!=dd){
+void FXCurve::setXData(FXData* dd,FXint col){
+  if(xdata!=dd || xcolumn!=col){
     xdata=dd;
+    xcolumn=col;
     plot->update();
     }
   }
 
+
 // Change y data samples
-void FXCurve::setYData(FXData* dd){
-  if(ydata!=dd){
+void FXCurve::setYData(FXData* dd,FXint col){
+  if(ydata!=dd || ycolumn!=col){
     ydata=dd;
+    ycolumn=col;
+    plot->update();
+    }
+  }
+
+
+// Change line style
+void FXCurve::setLineStyle(const LineStyle& ls){
+  linestyle=ls;
+  plot->update();
+  }
+
+
+// Change decimation mode
+void FXCurve::setDecimation(FXuint mode){
+  if(decimation!=mode){
+    decimation=mode;
     plot->update();
     }
   }
 
 
+// Number of rows with both x and y samples
+FXival FXCurve::numRows() const {
+  FXival n=ydata->getNumRows();
+  if(xdata) n=FXMIN(n,xdata->getNumRows());
+  return n;
+  }
+
+
+// X sample in row, or row itself if there are no x samples
+FXdouble FXCurve::xValue(FXival row) const {
+  return xdata ? xdata->getValue(xcolumn,row) : (FXdouble)row;
+  }
+
+
+// Pixel coordinate, clamped to fit in FXPoint
+static inline FXshort pixel(FXdouble t){
+  return (FXshort)Math::floor(Math::fclamp(-32000.0,t+0.5,32000.0));
+  }
+
+
+// Append point, unless it's the same as the last one
+static inline FXint append(FXPoint* points,FXint np,FXshort px,FXshort py){
+  if(np==0 || points[np-1].x!=px || points[np-1].y!=py){
+    points[np].x=px;
+    points[np].y=py;
+    np++;
+    }
+  return np;
+  }
+
+
+// Find first row in fm...to-1 which falls in pixel column c or beyond, given ordered x
+FXival FXCurve::findColumn(FXival fm,FXival to,FXdouble xmin,FXdouble sx,FXint c) const {
+  FXival m;
+  while(fm<to){
+    m=fm+((to-fm)>>1);
+    if(Math::floor((xValue(m)-xmin)*sx+0.5)<c) fm=m+1; else to=m;
+    }
+  return fm;
+  }
+
+
+// Draw first, smallest, largest, and last sample in each pixel column
+FXint FXCurve::envelope(FXPoint* points,FXint x,FXint y,FXint w,FXint h,const Range& xr,const Range& yr) const {
+  FXdouble sx=(w-1)/(xr.maximum-xr.minimum);
+  FXdouble sy=(h-1)/(yr.maximum-yr.minimum);
+  FXdouble yb=y+h-1+yr.minimum*sy;
+  FXival n=numRows(),r0,r1,rlo,rhi;
+  FXdouble lo,hi,v;
+  FXint np=0,c;
+  FXshort px;
+  r0=findColumn(0,n,xr.minimum,sx,0);
+  if(0<r0 && !Math::fpNan(v=ydata->getValue(ycolumn,r0-1))){     // Lead in from the left
+    np=append(points,np,pixel(x+(xValue(r0-1)-xr.minimum)*sx),pixel(yb-v*sy));
+    }
+  for(c=0; c<w && r0<n; ++c){
+    r1=findColumn(r0,n,xr.minimum,sx,c+1);
+    if(r0<r1 && ysummary->extent(r0,r1,rlo,rhi,lo,hi)){
+      px=(FXshort)(x+c);
+      if(!Math::fpNan(v=ydata->getValue(ycolumn,r0))) np=append(points,np,px,pixel(yb-v*sy));
+      if(rlo<rhi){
+        np=append(points,np,px,pixel(yb-lo*sy));
+        np=append(points,np,px,pixel(yb-hi*sy));
+        }
+      else{
+        np=append(points,np,px,pixel(yb-hi*sy));
+        np=append(points,np,px,pixel(yb-lo*sy));
+        }
+      if(!Math::fpNan(v=ydata->getValue(ycolumn,r1-1))) np=append(points,np,px,pixel(yb-v*sy));
+      }
+    r0=r1;
+    }
+  if(r0<n && !Math::fpNan(v=ydata->getValue(ycolumn,r0))){        // Lead out to the right
+    np=append(points,np,pixel(x+(xValue(r0)-xr.minimum)*sx),pixel(yb-v*sy));
+    }
+  return np;
+  }
+
+
+// Pick t of m points by Largest-Triangle-Three-Buckets
+static FXint largestTriangles(FXPoint* points,const FXdouble* px,const FXdouble* py,FXival m,FXint t){
+  FXival a,i,j,fm,to,nt,best;
+  FXdouble every,avgx,avgy,area,most;
+  FXint np=0;
+  if(m<=t){
+    for(i=0; i<m; ++i) np=append(points,np,pixel(px[i]),pixel(py[i]));
+    return np;
+    }
+  every=(FXdouble)(m-2)/(t-2);
+  np=append(points,np,pixel(px[0]),pixel(py[0]));
+  for(a=0,i=0; i<t-2; ++i){
+    fm=(FXival)(i*every)+1;
+    to=(FXival)((i+1)*every)+1;
+    nt=FXMIN((FXival)((i+2)*every)+1,m);
+    avgx=avgy=0.0;
+    for(j=to; j<nt; ++j){ avgx+=px[j]; avgy+=py[j]; }
+    avgx/=(nt-to);
+    avgy/=(nt-to);
+    for(best=fm,most=-1.0,j=fm; j<to; ++j){
+      area=Math::fabs((px[a]-avgx)*(py[j]-py[a])-(px[a]-px[j])*(avgy-py[a]));
+      if(area>most){ most=area; best=j; }
+      }
+    np=append(points,np,pixel(px[best]),pixel(py[best]));
+    a=best;
+    }
+  np=append(points,np,pixel(px[m-1]),pixel(py[m-1]));
+  return np;
+  }
+
+
+// Reduce rows in view to candidates, then pick points among them by LTTB
+FXint FXCurve::triangles(FXPoint* points,FXint x,FXint y,FXint w,FXint h,const Range& xr,const Range& yr,FXbool ordered) const {
+  FXdouble sx=(w-1)/(xr.maximum-xr.minimum);
+  FXdouble sy=(h-1)/(yr.maximum-yr.minimum);
+  FXdouble yb=y+h-1+yr.minimum*sy;
+  FXint t=FXMAX(2*w,3);
+  FXival n=numRows(),r0=0,r1=n,m=0,b,nb,r,rlo,rhi;
+  FXdouble *px,*py,lo,hi,u,v;
+  FXint np=0;
+  if(ordered){                                          // Rows in view, and one either side
+    r0=findColumn(0,n,xr.minimum,sx,0);
+    r1=findColumn(r0,n,xr.minimum,sx,w);
+    if(0<r0) r0--;
+    if(r1<n) r1++;
+    }
+  if(allocElms(px,4*t+2)){
+    if(allocElms(py,4*t+2)){
+      if(r1-r0<=4*t){                                   // Few enough rows to take them all
+        for(r=r0; r<r1; ++r){
+          u=xValue(r);
+          v=ydata->getValue(ycolumn,r);
+          if(Math::fpNan(u) || Math::fpNan(v)) continue;
+          px[m]=x+(u-xr.minimum)*sx;
+          py[m]=yb-v*sy;
+          m++;
+          }
+        }
+      else{                                             // Smallest and largest in each bucket
+        nb=2*t;
+        for(b=0; b<nb; ++b){
+          if(ysummary->extent(r0+(r1-r0)*b/nb,r0+(r1-r0)*(b+1)/nb,rlo,rhi,lo,hi)){
+            if(rhi<rlo){ FXSWAP(rlo,rhi,r); FXSWAP(lo,hi,v); }
+            if(!Math::fpNan(u=xValue(rlo))){
+              px[m]=x+(u-xr.minimum)*sx;
+              py[m]=yb-lo*sy;
+              m++;
+              }
+            if(rhi!=rlo && !Math::fpNan(u=xValue(rhi))){
+              px[m]=x+(u-xr.minimum)*sx;
+              py[m]=yb-hi*sy;
+              m++;
+              }
+            }
+          }
+        }
+      np=largestTriangles(points,px,py,m,t);
+      freeElms(py);
+      }
+    freeElms(px);
+    }
+  return np;
+  }
+
+
+// Reduce samples to polyline for drawing
+FXint FXCurve::decimate(FXPoint* points,FXint x,FXint y,FXint w,FXint h,const Range& xr,const Range& yr) const {
+  FXint np=0;
+  if(ydata && 0<w && 0<h && xr.minimum<xr.maximum && yr.minimum<yr.maximum){
+    if(xdata) xdata->lock();
+    ydata->lock();
+    if(ysummary->update(ydata,ycolumn) && (!xdata || xsummary->update(xdata,xcolumn))){
+      FXbool ordered=!xdata || xsummary->isOrdered();
+      if(ordered && decimation!=DECIMATE_LTTB){
+        np=envelope(points,x,y,w,h,xr,yr);
+        }
+      else{
+        np=triangles(points,x,y,w,h,xr,yr,ordered);
+        }
+      }
+    ydata->unlock();
+    if(xdata) xdata->unlock();
+    }
+  return np;
+  }
+
+
+// Draw curve
+void FXCurve::drawCurve(FXDC& dc,FXint x,FXint y,FXint w,FXint h,const Range& xr,const Range& yr) const {
+  FXPoint *points;
+  FXint np;
+  if(linestyle.style!=LINESTYLE_NONE && allocElms(points,4*w+4)){
+    np=decimate(points,x,y,w,h,xr,yr);
+    if(0<np){
+      dc.setForeground(linestyle.color);
+      dc.setLineWidth(linestyle.weight);
+      switch(linestyle.style){
+        case LINESTYLE_DOTTED: dc.setDashes(0,dotted,ARRAYNUMBER(dotted)); dc.setLineStyle(LINE_ONOFF_DASH); break;
+        case LINESTYLE_SHORTDASHED: dc.setDashes(0,shortdashed,ARRAYNUMBER(shortdashed)); dc.setLineStyle(LINE_ONOFF_DASH); break;
+        case LINESTYLE_LONGDASHED: dc.setDashes(0,longdashed,ARRAYNUMBER(longdashed)); dc.setLineStyle(LINE_ONOFF_DASH); break;
+        case LINESTYLE_DOTDASHED: dc.setDashes(0,dotdashed,ARRAYNUMBER(dotdashed)); dc.setLineStyle(LINE_ONOFF_DASH); break;
+        }
+      if(np==1){
+        dc.drawPoint(points[0].x,points[0].y);
+        }
+      else{
+        dc.drawLines(points,np);
+        }
+      dc.setLineStyle(LINE_SOLID);
+      dc.setLineWidth(0);
+      }
+    freeElms(points);
+    }
+  }
+
+
 // Save data
 void FXCurve::save(FXStream& store) const {
   FXObject::save(store);
   store << label;
-  store << xaxis;
+  store << (FXuchar)(xaxis|CURVE_STYLED);
   store << yaxis;
+  store << linestyle.color;
+  store << linestyle.weight;
+  store << linestyle.style;
+  store << decimation;
   }
 
 
@@ -114,16 +392,25 @@ void FXCurve::load(FXStream& store){
   store >> label;
   store >> xaxis;
   store >> yaxis;
+  if(xaxis&CURVE_STYLED){
+    store >> linestyle.color;
+    store >> linestyle.weight;
+    store >> linestyle.style;
+    store >> decimation;
+    xaxis&=~CURVE_STYLED;
+    }
   }
 
 
 // Destroy
 FXCurve::~FXCurve(){
-  delete xdata;
-  delete ydata;
+  delete xsummary;
+  delete ysummary;
   plot=(FX2DPlot*)-1L;
   xdata=(FXData*)-1L;
   ydata=(FXData*)-1L;
+  xsummary=(FXSummary*)-1L;
+  ysummary=(FXSummary*)-1L;
   }
 
 }
@@ -25,9 +25,18 @@ namespace FXCHART {
 
 
 class FXData;
+class FXSummary;
 class FX2DPlot;
 
 
+/// Decimation of curves with more samples than pixels
+enum {
+  DECIMATE_AUTO     = 0,        /// Envelope if x samples are ordered, else LTTB
+  DECIMATE_ENVELOPE = 1,        /// Minimum and maximum in each pixel column
+  DECIMATE_LTTB     = 2         /// Largest-Triangle-Three-Buckets
+  };
+
+
 /// Describe how curve is done
 class FXCHARTAPI FXCurve : public FXObject {
   FXDECLARE(FXCurve)
@@ -35,11 +44,22 @@ protected:
   FX2DPlot *plot;       // Plot control
   FXData   *xdata;      // X data samples
   FXData   *ydata;      // Y data samples
+  FXint     xcolumn;    // Column of x data samples
+  FXint     ycolumn;    // Column of y data samples
+  FXSummary *xsummary;  // Summary of x data samples
+  FXSummary *ysummary;  // Summary of y data samples
   FXString  label;      // Name of plot
+  LineStyle linestyle;  // Line style
+  FXuchar   decimation; // Decimation mode
   FXuchar   xaxis;      // X-Axis
   FXuchar   yaxis;      // Y-Axis
 protected:
   FXCurve();
+  FXival numRows() const;
+  FXdouble xValue(FXival row) const;
+  FXival findColumn(FXival fm,FXival to,FXdouble xmin,FXdouble sx,FXint c) const;
+  FXint envelope(FXPoint* points,FXint x,FXint y,FXint w,FXint h,const Range& xr,const Range& yr) const;
+  FXint triangles(FXPoint* points,FXint x,FXint y,FXint w,FXint h,const Range& xr,const Range& yr,FXbool ordered) const;
 private:
   FXCurve(const FXCurve&);
   FXCurve &operator=(const FXCurve&);
@@ -66,18 +86,46 @@ public:
   /// Return y axis description
   FXuchar getYAxis() const { return yaxis; }
 
-  /// Change x data samples
-  void setXData(FXData* dd);
+  /// Change x data samples to column of data; the data is not owned by the curve
+  void setXData(FXData* dd,FXint col=0);
 
   /// Return x data samples
   FXData* getXData() const { return xdata; }
 
-  /// Change y data samples
-  void setYData(FXData* dd);
+  /// Return column of x data samples
+  FXint getXColumn() const { return xcolumn; }
+
+  /// Change y data samples to column of data; the data is not owned by the curve
+  void setYData(FXData* dd,FXint col=0);
 
   /// Return y data samples
   FXData* getYData() const { return ydata; }
 
+  /// Return column of y data samples
+  FXint getYColumn() const { return ycolumn; }
+
+  /// Change line style
+  void setLineStyle(const LineStyle& ls);
+
+  /// Return line style
+  const LineStyle& getLineStyle() const { return linestyle; }
+
+  /// Change decimation mode
+  void setDecimation(FXuint mode);
+
+  /// Return decimation mode
+  FXuint getDecimation() const { return decimation; }
+
+  /**
+  * Reduce the samples to a polyline for drawing into the rectangle x,y,w,h,
+  * where xr and yr are the ranges of the axes; return the number of points.
+  * There should be room for 4*w+4 points, however many samples there are.
+  */
+  virtual FXint decimate(FXPoint* points,FXint x,FXint y,FXint w,FXint h,const Range& xr,const Range& yr) const;
+
+  /// Draw curve into the rectangle x,y,w,h, where xr and yr are the ranges of the axes
+  virtual void drawCurve(FXDC& dc,FXint x,FXint y,FXint w,FXint h,const Range& xr,const Range& yr) const;
+
   /// Save curve to a stream
   virtual void save(FXStream& store) const;
 
@@ -0,0 +1,455 @@
+/********************************************************************************
+*                                                                               *
+*                     C o l u m n a r   D a t a   S t o r e                     *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#include "fx.h"
+#include "chartdefs.h"
+#include "FXData.h"
+
+/*
+  Notes:
+
+  - Each column is one array of values, of the column's own type; rows are not
+    objects, and appending a row only stores a value in each column.
+
+  - When growing, capacity doubles as needed, so appending is amortized O(1).
+    With a window, the arrays hold exactly window rows, used as a ring buffer:
+    the row with serial number s lives in slot s%window, so the oldest row is
+    simply overwritten when a new one comes in.
+
+  - When growing, the extent of a column is the running minimum and maximum.
+    In a ring buffer, values drop out again, so each column keeps two monotonic
+    queues of rows (by serial number, truncated to 32 bits), one of rows which
+    may yet become the minimum, one of rows which may yet become the maximum:
+
+      - A new row first expires rows older than the window from the front;
+      - Then pops rows from the back which can never be the minimum (maximum)
+        again, since the new row is smaller (larger) and will outlive them;
+      - Then goes to the back.
+
+    The front of each queue is then the minimum (maximum) of the window, and
+    each row goes in and out of each queue at most once, so keeping the extent
+    up to date costs amortized O(1) per row, and reading it O(1).
+
+  - NaN values are stored, but are left out of the extent; they may mark gaps.
+    Integer columns can't hold NaN, and store zero instead.
+
+  - All access goes through a recursive mutex, so that a producer thread can
+    append while the user-interface thread reads; readers can hold the lock
+    across several calls to get a consistent view.
+*/
+
+
+using namespace FXCHART;
+
+/*******************************************************************************/
+
+namespace FXCHART {
+
+
+// Column of values
+struct FXData::Column {
+  FXuchar  *data;               // Values, in type of column
+  FXuint   *minq;               // Rows which may become minimum, in ring buffer
+  FXuint   *maxq;               // Rows which may become maximum, in ring buffer
+  FXival    minh;               // Front of minimum queue
+  FXival    minn;               // Length of minimum queue
+  FXival    maxh;               // Front of maximum queue
+  FXival    maxn;               // Length of maximum queue
+  FXdouble  minimum;            // Running minimum when growing
+  FXdouble  maximum;            // Running maximum when growing
+  FXuint    type;               // Type of values
+  FXuint    size;               // Bytes per value
+  };
+
+
+// Value in column at slot, as double
+static inline FXdouble valueAt(const FXuchar* data,FXuint type,FXival at){
+  switch(type){
+    case FXData::Float: return ((const FXfloat*)data)[at];
+    case FXData::Double: return ((const FXdouble*)data)[at];
+    }
+  return (FXdouble)((const FXlong*)data)[at];
+  }
+
+
+// Store double in column at slot
+static inline void storeAt(FXuchar* data,FXuint type,FXival at,FXdouble value){
+  switch(type){
+    case FXData::Float: ((FXfloat*)data)[at]=(FXfloat)value; return;
+    case FXData::Double: ((FXdouble*)data)[at]=value; return;
+    }
+  ((FXlong*)data)[at]=Math::fpNan(value)?0:(FXlong)value;
+  }
+
+
+// Create empty table
+FXData::FXData():columns(nullptr),ncolumns(0),capacity(0),window(0),count(0),serial(0),mutex(true){
+  }
+
+
+// Create table with ncols columns of given type
+FXData::FXData(FXint ncols,FXuint type):columns(nullptr),ncolumns(0),capacity(0),window(0),count(0),serial(0),mutex(true){
+  for(FXint i=0; i<ncols; ++i){ appendColumn(type); }
+  }
+
+
+// Append column of given type; only allowed while table is empty
+FXint FXData::appendColumn(FXuint type){
+  FXScopedMutex locker(mutex);
+  if(count){ fxerror("FXData::appendColumn: table not empty.\n"); }
+  if(Long<type){ fxerror("FXData::appendColumn: bad column type.\n"); }
+  if(resizeElms(columns,ncolumns+1)){
+    Column& c=columns[ncolumns];
+    c.data=nullptr;
+    c.minq=nullptr;
+    c.maxq=nullptr;
+    c.minh=c.minn=0;
+    c.maxh=c.maxn=0;
+    c.minimum=1.0;
+    c.maximum=-1.0;
+    c.type=type;
+    c.size=(type==Float)?sizeof(FXfloat):(type==Double)?sizeof(FXdouble):sizeof(FXlong);
+    if((!capacity || callocElms(c.data,capacity*c.size)) && (!window || (allocElms(c.minq,window) && allocElms(c.maxq,window)))){
+      return ncolumns++;
+      }
+    freeElms(c.data);
+    freeElms(c.minq);
+    freeElms(c.maxq);
+    }
+  return -1;
+  }
+
+
+// Return type of column
+FXuint FXData::getColumnType(FXint col) const {
+  if(col<0 || ncolumns<=col){ fxerror("FXData::getColumnType: column out of range.\n"); }
+  return columns[col].type;
+  }
+
+
+// Slot of row
+FXival FXData::slot(FXival row) const {
+  return window ? (FXival)((serial-count+row)%window) : row;
+  }
+
+
+// Recompute extents of all rows
+void FXData::rebuild(){
+  for(FXint col=0; col<ncolumns; ++col){
+    Column& c=columns[col];
+    c.minh=c.minn=0;
+    c.maxh=c.maxn=0;
+    c.minimum=1.0;
+    c.maximum=-1.0;
+    admit(col,window?serial-count:0,count);
+    }
+  }
+
+
+// Slot d rows before slot p, wrapping around the ring buffer
+inline FXival FXData::back(FXival p,FXuint d) const {
+  p-=d;
+  return (p<0) ? p+window : (p<window) ? p : p-window;
+  }
+
+
+// Add n rows of column, stored already, starting at serial number s, to its extent
+void FXData::admit(FXint col,FXlong s,FXival n){
+  Column& c=columns[col];
+  FXdouble v;
+  FXuint t;
+  FXival p;
+  if(window){
+    p=(FXival)(s%window);
+    t=(FXuint)s;
+    while(0<n--){
+      v=valueAt(c.data,c.type,p);
+      while(c.minn && (FXuint)window<=(FXuint)(t-c.minq[c.minh])){        // Expire rows older than the window
+        if(++c.minh==window) c.minh=0;
+        c.minn--;
+        }
+      while(c.maxn && (FXuint)window<=(FXuint)(t-c.maxq[c.maxh])){
+        if(++c.maxh==window) c.maxh=0;
+        c.maxn--;
+        }
+      if(!Math::fpNan(v)){
+        while(c.minn && v<=valueAt(c.data,c.type,back(p,t-c.minq[back(c.minh+c.minn,1)]))){
+          c.minn--;                                                     // Won't be minimum anymore
+          }
+        c.minq[back(c.minh+c.minn++,0)]=t;
+        while(c.maxn && v>=valueAt(c.data,c.type,back(p,t-c.maxq[back(c.maxh+c.maxn,1)]))){
+          c.maxn--;                                                     // Won't be maximum anymore
+          }
+        c.maxq[back(c.maxh+c.maxn++,0)]=t;
+        }
+      if(++p==window) p=0;
+      t++;
+      }
+    }
+  else{
+    for(p=(FXival)s; 0<n--; ++p){
+      v=valueAt(c.data,c.type,p);
+      if(Math::fpNan(v)) continue;
+      if(c.maximum<c.minimum){
+        c.minimum=c.maximum=v;
+        }
+      else if(v<c.minimum){
+        c.minimum=v;
+        }
+      else if(v>c.maximum){
+        c.maximum=v;
+        }
+      }
+    }
+  }
+
+
+// Make room for n more rows when growing
+FXbool FXData::grow(FXival n){
+  if(!window && capacity<count+n){
+    return reserve(FXMAX(count+n,capacity+(capacity>>1)+16));
+    }
+  return true;
+  }
+
+
+// Reserve room for n rows
+FXbool FXData::reserve(FXival n){
+  FXScopedMutex locker(mutex);
+  if(!window && capacity<n){
+    for(FXint col=0; col<ncolumns; ++col){
+      if(!resizeElms(columns[col].data,n*columns[col].size)) return false;
+      }
+    capacity=n;
+    }
+  return true;
+  }
+
+
+// Keep only the most recent n rows, or grow without limit if n is zero
+FXbool FXData::setWindow(FXival n){
+  FXScopedMutex locker(mutex);
+  if(n<0){ fxerror("FXData::setWindow: bad window size.\n"); }
+  if(window!=n){
+    FXival keep=n?FXMIN(count,n):count;
+    FXival size=n?n:keep;
+    Column* fresh;
+    FXlong s;
+    FXint col;
+    if(!callocElms(fresh,FXMAX(ncolumns,1))) return false;
+    for(col=0; col<ncolumns; ++col){                    // Allocate everything first
+      if(!callocElms(fresh[col].data,FXMAX(size,1)*columns[col].size)) break;
+      if(n && (!allocElms(fresh[col].minq,n) || !allocElms(fresh[col].maxq,n))) break;
+      }
+    if(col<ncolumns){                                   // Out of memory; leave table as it was
+      for(col=0; col<ncolumns; ++col){
+        freeElms(fresh[col].data);
+        freeElms(fresh[col].minq);
+        freeElms(fresh[col].maxq);
+        }
+      freeElms(fresh);
+      return false;
+      }
+    for(col=0; col<ncolumns; ++col){
+      Column& c=columns[col];
+      for(s=serial-keep; s<serial; ++s){
+        memcpy(fresh[col].data+(n?s%n:s-serial+keep)*c.size,c.data+slot((FXival)(s-serial+count))*c.size,c.size);
+        }
+      freeElms(c.data);
+      freeElms(c.minq);
+      freeElms(c.maxq);
+      c.data=fresh[col].data;
+      c.minq=fresh[col].minq;
+      c.maxq=fresh[col].maxq;
+      }
+    freeElms(fresh);
+    window=n;
+    capacity=size;
+    count=keep;
+    rebuild();
+    }
+  return true;
+  }
+
+
+// Return number of rows
+FXival FXData::getNumRows() const {
+  FXScopedMutex locker((FXMutex&)mutex);
+  return count;
+  }
+
+
+// Return number of rows ever appended
+FXlong FXData::getSerial() const {
+  FXScopedMutex locker((FXMutex&)mutex);
+  return serial;
+  }
+
+
+// Append one row
+void FXData::appendRow(const FXdouble* values){
+  appendRows(values,1);
+  }
+
+
+// Append n rows, given as an array of values per column
+void FXData::appendRows(const void* const* values,FXival n){
+  FXScopedMutex locker(mutex);
+  FXival skip=0,at,m,done;
+  FXint col;
+  if(window && window<n){                               // Only last window rows survive
+    skip=n-window;
+    serial+=skip;
+    n=window;
+    }
+  if(0<n && grow(n)){
+    for(done=0; done<n; done+=m){
+      at=window?(FXival)((serial+done)%window):count+done;
+      m=window?FXMIN(n-done,window-at):n-done;
+      for(col=0; col<ncolumns; ++col){
+        memcpy(columns[col].data+at*columns[col].size,(const FXuchar*)values[col]+(skip+done)*columns[col].size,m*columns[col].size);
+        }
+      }
+    for(col=0; col<ncolumns; ++col){
+      admit(col,window?serial:(FXlong)count,n);
+      }
+    serial+=n;
+    count=window?FXMIN(count+n,window):count+n;
+    }
+  }
+
+
+// Append n rows, given one after the other
+void FXData::appendRows(const FXdouble* values,FXival n){
+  FXScopedMutex locker(mutex);
+  FXival at,r;
+  FXint col;
+  if(window && window<n){                               // Only last window rows survive
+    values+=(n-window)*ncolumns;
+    serial+=n-window;
+    n=window;
+    }
+  if(0<n && grow(n)){
+    for(r=0; r<n; ++r){
+      at=window?(FXival)((serial+r)%window):count+r;
+      for(col=0; col<ncolumns; ++col){
+        storeAt(columns[col].data,columns[col].type,at,*values++);
+        }
+      }
+    for(col=0; col<ncolumns; ++col){
+      admit(col,window?serial:(FXlong)count,n);
+      }
+    serial+=n;
+    count=window?FXMIN(count+n,window):count+n;
+    }
+  }
+
+
+// Remove all rows
+void FXData::clear(){
+  FXScopedMutex locker(mutex);
+  count=0;
+  rebuild();
+  }
+
+
+// Return value in column at row
+FXdouble FXData::getValue(FXint col,FXival row) const {
+  FXScopedMutex locker((FXMutex&)mutex);
+  if(col<0 || ncolumns<=col || row<0 || count<=row){ fxerror("FXData::getValue: index out of range.\n"); }
+  return valueAt(columns[col].data,columns[col].type,slot(row));
+  }
+
+
+// Copy n values of column starting at row as doubles
+FXival FXData::getValues(FXint col,FXival row,FXdouble* values,FXival n) const {
+  FXScopedMutex locker((FXMutex&)mutex);
+  FXival done=0,m,at,i;
+  if(col<0 || ncolumns<=col){ fxerror("FXData::getValues: column out of range.\n"); }
+  if(row<0) row=0;
+  n=FXMIN(n,count-row);
+  while(done<n){
+    at=slot(row+done);
+    m=window?FXMIN(n-done,window-at):n-done;
+    switch(columns[col].type){
+      case Float:
+        for(i=0; i<m; ++i) values[done+i]=((const FXfloat*)columns[col].data)[at+i];
+        break;
+      case Double:
+        copyElms(values+done,((const FXdouble*)columns[col].data)+at,m);
+        break;
+      default:
+        for(i=0; i<m; ++i) values[done+i]=(FXdouble)((const FXlong*)columns[col].data)[at+i];
+        break;
+      }
+    done+=m;
+    }
+  return FXMAX(n,0);
+  }
+
+
+// Return pointer to contiguous values of column, starting at row
+const void* FXData::getSpan(FXint col,FXival row,FXival& n) const {
+  FXScopedMutex locker((FXMutex&)mutex);
+  FXival at;
+  if(col<0 || ncolumns<=col){ fxerror("FXData::getSpan: column out of range.\n"); }
+  n=0;
+  if(0<=row && row<count){
+    at=slot(row);
+    n=window?FXMIN(count-row,window-at):count-row;
+    return columns[col].data+at*columns[col].size;
+    }
+  return nullptr;
+  }
+
+
+// Return extent of column
+Range FXData::getExtent(FXint col) const {
+  FXScopedMutex locker((FXMutex&)mutex);
+  Range range={0.0,0.0};
+  if(col<0 || ncolumns<=col){ fxerror("FXData::getExtent: column out of range.\n"); }
+  const Column& c=columns[col];
+  if(window){
+    if(c.minn && c.maxn){
+      FXlong s=serial-1;
+      FXuint t=(FXuint)s;
+      range.minimum=valueAt(c.data,c.type,(FXival)((s-(FXuint)(t-c.minq[c.minh]))%window));
+      range.maximum=valueAt(c.data,c.type,(FXival)((s-(FXuint)(t-c.maxq[c.maxh]))%window));
+      }
+    }
+  else if(c.minimum<=c.maximum){
+    range.minimum=c.minimum;
+    range.maximum=c.maximum;
+    }
+  return range;
+  }
+
+
+// Destroy data
+FXData::~FXData(){
+  for(FXint col=0; col<ncolumns; ++col){
+    freeElms(columns[col].data);
+    freeElms(columns[col].minq);
+    freeElms(columns[col].maxq);
+    }
+  freeElms(columns);
+  }
+
+}
@@ -0,0 +1,162 @@
+/********************************************************************************
+*                                                                               *
+*                     C o l u m n a r   D a t a   S t o r e                     *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXDATA_H
+#define FXDATA_H
+
+namespace FXCHART {
+
+
+/**
+* FXData holds samples for plotting, as a table of rows and typed columns.
+* Each column is kept in one contiguous array of floats, doubles, or 64-bit
+* integers (e.g. timestamps), so millions of samples take no more memory than
+* their values, and can be drawn without per-point objects.
+* Rows are appended, one at a time or many at once; a producer thread may append
+* while the user-interface thread draws, as all access goes through a mutex.
+* Readers who need a consistent view over several calls should lock() the data.
+* Normally, the table grows as rows are appended; with a window set, it keeps
+* only the most recent rows, in a ring buffer, and the oldest are dropped as
+* new ones come in.
+* The extent (minimum and maximum) of each column is kept up to date as rows are
+* appended and dropped, so it can be passed to FXAxis::setDataRange() at any time,
+* without going through the data; NaN values are left out of the extent.
+* Row numbers run from 0, the oldest row, to getNumRows()-1; the serial number
+* counts all rows ever appended, so it changes whenever rows are appended.
+*/
+class FXCHARTAPI FXData {
+public:
+  enum {
+    Float  = 0,         /// Single precision floating point
+    Double = 1,         /// Double precision floating point
+    Long   = 2          /// 64-bit integer, e.g. timestamp
+    };
+protected:
+  struct Column;
+protected:
+  Column   *columns;    // Columns
+  FXint     ncolumns;   // Number of columns
+  FXival    capacity;   // Rows allocated in each column
+  FXival    window;     // Rows kept in ring buffer, or 0 if growing
+  FXival    count;      // Rows currently in table
+  FXlong    serial;     // Rows ever appended
+  FXMutex   mutex;      // Guards access from other threads
+protected:
+  FXival slot(FXival row) const;
+  FXival back(FXival p,FXuint d) const;
+  FXbool grow(FXival n);
+  void admit(FXint col,FXlong s,FXival n);
+  void rebuild();
+private:
+  FXData(const FXData&);
+  FXData &operator=(const FXData&);
+public:
+
+  /// Create empty table, without columns
+  FXData();
+
+  /// Create table with ncols columns of given type
+  FXData(FXint ncols,FXuint type=Double);
+
+  /// Lock data, to read it consistently from another thread
+  void lock() const { ((FXMutex&)mutex).lock(); }
+
+  /// Unlock data
+  void unlock() const { ((FXMutex&)mutex).unlock(); }
+
+  /// Append column of given type; only allowed while table is empty
+  FXint appendColumn(FXuint type=Double);
+
+  /// Return number of columns
+  FXint getNumColumns() const { return ncolumns; }
+
+  /// Return type of column
+  FXuint getColumnType(FXint col) const;
+
+  /**
+  * Keep only the most recent n rows, in a ring buffer, or let the table grow
+  * without limit if n is zero; rows beyond the new window are dropped.
+  * Return false if out of memory.
+  */
+  FXbool setWindow(FXival n);
+
+  /// Return window size, or 0 if table grows without limit
+  FXival getWindow() const { return window; }
+
+  /**
+  * Reserve room for n rows, so appending doesn't have to reallocate.
+  * Return false if out of memory.
+  */
+  FXbool reserve(FXival n);
+
+  /// Return number of rows
+  FXival getNumRows() const;
+
+  /// Return number of rows ever appended; changes whenever rows are appended
+  FXlong getSerial() const;
+
+  /// Append one row, given as one value per column
+  void appendRow(const FXdouble* values);
+
+  /**
+  * Append n rows, given as an array of n values per column, each array
+  * of the type of its column.
+  */
+  void appendRows(const void* const* values,FXival n);
+
+  /// Append n rows, given one after the other, one value per column
+  void appendRows(const FXdouble* values,FXival n);
+
+  /// Remove all rows
+  void clear();
+
+  /// Return value in column at row
+  FXdouble getValue(FXint col,FXival row) const;
+
+  /**
+  * Copy n values of column, starting at row, into array as doubles;
+  * return number of values copied.
+  */
+  FXival getValues(FXint col,FXival row,FXdouble* values,FXival n) const;
+
+  /**
+  * Return pointer to the values of column, starting at row, in the column's
+  * own type; the number of values which follow contiguously is returned
+  * in n, which may be less than the rows left when the ring buffer wraps.
+  * The data should be locked while the pointer is used.
+  */
+  const void* getSpan(FXint col,FXival row,FXival& n) const;
+
+  /// Return extent of column; both zero if there are no (non-NaN) values
+  Range getExtent(FXint col) const;
+
+  /// Return smallest value in column
+  FXdouble getMinimum(FXint col) const { return getExtent(col).minimum; }
+
+  /// Return largest value in column
+  FXdouble getMaximum(FXint col) const { return getExtent(col).maximum; }
+
+  /// Destroy data
+  virtual ~FXData();
+  };
+
+}
+
+#endif
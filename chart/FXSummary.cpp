@@ -0,0 +1,253 @@
+/********************************************************************************
+*                                                                               *
+*                 M u l t i - R e s o l u t i o n   S u m m a r y               *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#include "fx.h"
+#include "chartdefs.h"
+#include "FXData.h"
+#include "FXSummary.h"
+
+/*
+  Notes:
+
+  - Level 0 of the pyramid are the rows themselves; entry b of level k > 0
+    summarizes entries 16*b...16*b+15 of level k-1, i.e. rows 16^k*b and up.
+    Each entry holds the smallest and largest value, and the rows they are in,
+    or row -1 if all its values are NaN.
+
+  - The pyramid stops at the first level with at most 16 entries, but always has
+    level 1, so that every row passes through summarize() once.  With 16 entries
+    per block, it takes about 2 bytes per row, less than the values themselves.
+
+  - Finding the extent of a range of rows takes at most 15 entries from each end
+    of the range at each level, then moves up a level; so it looks at no more
+    than 30 entries per level, and O(log n) entries in all.
+
+  - When rows have been appended to a growing table, only the entries covering
+    the new rows are redone, at each level.  Otherwise, as when rows drop out of
+    a ring buffer, or the table is cleared, the summary is redone from scratch,
+    which takes time proportional to the rows in the window.
+
+  - While summarizing the rows, we also note whether they are ordered; NaN values
+    count as out of order, as they can't be found by value.
+*/
+
+#define MAXLEVELS 16            // Enough for 16^16 rows
+#define CHUNK     4096          // Rows read at a time
+
+using namespace FXCHART;
+
+/*******************************************************************************/
+
+namespace FXCHART {
+
+
+// Level of pyramid
+struct FXSummary::Level {
+  FXdouble *lo;                 // Smallest value in each block
+  FXdouble *hi;                 // Largest value in each block
+  FXival   *rlo;                // Row of smallest value, or -1
+  FXival   *rhi;                // Row of largest value, or -1
+  FXival    n;                  // Number of entries
+  FXival    capacity;           // Entries allocated
+  };
+
+
+// Create empty summary
+FXSummary::FXSummary():levels(nullptr),nlevels(0),data(nullptr),column(0),rows(0),serial(0),last(0.0),ordered(true){
+  callocElms(levels,MAXLEVELS);
+  }
+
+
+// Build entries of level from entry fm onward, out of the level below
+FXbool FXSummary::build(FXint lev,FXival fm){
+  Level& l=levels[lev];
+  FXival below=(lev==1)?data->getNumRows():levels[lev-1].n;
+  FXival n=(below+15)>>4;
+  FXival cap,b,i,e;
+  if(l.capacity<n){
+    cap=FXMAX(n,l.capacity+(l.capacity>>1));
+    if(!resizeElms(l.lo,cap) || !resizeElms(l.hi,cap) || !resizeElms(l.rlo,cap) || !resizeElms(l.rhi,cap)) return false;
+    l.capacity=cap;
+    }
+  l.n=n;
+  if(lev==1){
+    FXdouble values[CHUNK];
+    FXival row=fm<<4,m,r;
+    while(row<below){
+      m=data->getValues(column,row,values,CHUNK);
+      for(i=0; i<m; i+=16){
+        b=(row+i)>>4;
+        e=FXMIN(i+16,m);
+        l.rlo[b]=l.rhi[b]=-1;
+        for(r=i; r<e; ++r){
+          if(rows<=row+r){                              // Not seen before
+            if(0<row+r && !(last<=values[r])) ordered=false;
+            last=values[r];
+            }
+          if(Math::fpNan(values[r])) continue;
+          if(l.rlo[b]<0 || values[r]<l.lo[b]){ l.lo[b]=values[r]; l.rlo[b]=row+r; }
+          if(l.rhi[b]<0 || values[r]>l.hi[b]){ l.hi[b]=values[r]; l.rhi[b]=row+r; }
+          }
+        }
+      row+=m;
+      }
+    }
+  else{
+    const Level& d=levels[lev-1];
+    for(b=fm; b<n; ++b){
+      e=FXMIN((b<<4)+16,below);
+      l.rlo[b]=l.rhi[b]=-1;
+      for(i=b<<4; i<e; ++i){
+        if(d.rlo[i]>=0 && (l.rlo[b]<0 || d.lo[i]<l.lo[b])){ l.lo[b]=d.lo[i]; l.rlo[b]=d.rlo[i]; }
+        if(d.rhi[i]>=0 && (l.rhi[b]<0 || d.hi[i]>l.hi[b])){ l.hi[b]=d.hi[i]; l.rhi[b]=d.rhi[i]; }
+        }
+      }
+    }
+  return true;
+  }
+
+
+// Summarize rows from fm onward, at each level
+FXbool FXSummary::summarize(FXival fm){
+  FXint lev=1;
+  fm>>=4;
+  do{
+    if(lev>=MAXLEVELS) break;
+    if(lev>=nlevels){ nlevels=lev+1; fm=0; }            // New level made from scratch
+    if(!build(lev,fm)) return false;
+    fm>>=4;
+    }
+  while(16<levels[lev++].n);
+  nlevels=lev;
+  return true;
+  }
+
+
+// Bring summary of column of data up to date
+FXbool FXSummary::update(const FXData* dat,FXint col){
+  FXival n=dat->getNumRows();
+  FXlong s=dat->getSerial();
+  FXival fm=rows;
+  if(dat!=data || col!=column){
+    clear();
+    data=dat;
+    column=col;
+    fm=0;
+    }
+  else if(s==serial && n==rows){                        // Nothing changed
+    return true;
+    }
+  else if(dat->getWindow() || n<rows || s-serial!=n-rows){
+    fm=0;                                               // Rows dropped; start over
+    }
+  if(fm==0){
+    rows=0;
+    nlevels=1;
+    ordered=true;
+    }
+  if(0<n && !summarize(fm)){
+    clear();
+    return false;
+    }
+  rows=n;
+  serial=s;
+  return true;
+  }
+
+
+// Fold entries fm...to-1 of level into extent so far
+void FXSummary::gather(FXint lev,FXival fm,FXival to,FXival& rlo,FXival& rhi,FXdouble& lo,FXdouble& hi) const {
+  if(lev==0){
+    FXdouble values[16];
+    FXival i,m;
+    while(fm<to){
+      m=data->getValues(column,fm,values,FXMIN(to-fm,16));
+      if(m<=0) break;
+      for(i=0; i<m; ++i){
+        if(Math::fpNan(values[i])) continue;
+        if(rlo<0 || values[i]<lo){ lo=values[i]; rlo=fm+i; }
+        if(rhi<0 || values[i]>hi){ hi=values[i]; rhi=fm+i; }
+        }
+      fm+=m;
+      }
+    }
+  else{
+    const Level& l=levels[lev];
+    while(fm<to){
+      if(l.rlo[fm]>=0 && (rlo<0 || l.lo[fm]<lo)){ lo=l.lo[fm]; rlo=l.rlo[fm]; }
+      if(l.rhi[fm]>=0 && (rhi<0 || l.hi[fm]>hi)){ hi=l.hi[fm]; rhi=l.rhi[fm]; }
+      fm++;
+      }
+    }
+  }
+
+
+// Find smallest and largest value in range of rows
+FXbool FXSummary::extent(FXival fm,FXival to,FXival& rlo,FXival& rhi,FXdouble& lo,FXdouble& hi) const {
+  FXival a,b;
+  FXint lev=0;
+  rlo=rhi=-1;
+  lo=hi=0.0;
+  if(fm<0) fm=0;
+  if(to>rows) to=rows;
+  while(fm<to){
+    if(lev+1>=nlevels){                                 // Top level: all that's left
+      gather(lev,fm,to,rlo,rhi,lo,hi);
+      break;
+      }
+    a=FXMIN((fm+15)&~15,to);                            // Unaligned entries at the start
+    gather(lev,fm,a,rlo,rhi,lo,hi);
+    b=FXMAX(a,to&~15);                                  // Unaligned entries at the end
+    gather(lev,b,to,rlo,rhi,lo,hi);
+    fm=a>>4;                                            // Whole blocks in between
+    to=b>>4;
+    lev++;
+    }
+  return 0<=rlo;
+  }
+
+
+// Forget summary
+void FXSummary::clear(){
+  for(FXint lev=0; lev<MAXLEVELS; ++lev){
+    freeElms(levels[lev].lo);
+    freeElms(levels[lev].hi);
+    freeElms(levels[lev].rlo);
+    freeElms(levels[lev].rhi);
+    levels[lev].n=0;
+    levels[lev].capacity=0;
+    }
+  nlevels=1;
+  data=nullptr;
+  column=0;
+  rows=0;
+  serial=0;
+  last=0.0;
+  ordered=true;
+  }
+
+
+// Destroy summary
+FXSummary::~FXSummary(){
+  clear();
+  freeElms(levels);
+  }
+
+}
@@ -0,0 +1,103 @@
+/********************************************************************************
+*                                                                               *
+*                 M u l t i - R e s o l u t i o n   S u m m a r y               *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXSUMMARY_H
+#define FXSUMMARY_H
+
+namespace FXCHART {
+
+
+class FXData;
+
+
+/**
+* FXSummary keeps a pyramid of minima and maxima of one column of an FXData
+* table, so that the smallest and largest value over any range of rows can be
+* found without going through the rows in the range.
+* Each level of the pyramid summarizes blocks of 16 entries of the level below,
+* so finding the extent of a range takes O(log n) time, however many rows the
+* range spans; this is what lets a plot draw millions of samples in time
+* proportional to its width in pixels.
+* The summary is brought up to date by update(), which only summarizes the new
+* rows when rows have been appended to a growing table.
+* It also notes whether the column is ordered, i.e. never decreases, which is
+* needed to find rows by value, as when the column holds the x samples of a
+* time series.
+*/
+class FXCHARTAPI FXSummary {
+protected:
+  struct Level;
+protected:
+  Level        *levels;         // Levels of pyramid, level 0 being the rows
+  FXint         nlevels;        // Number of levels
+  const FXData *data;           // Data summarized
+  FXint         column;         // Column of data summarized
+  FXival        rows;           // Rows summarized
+  FXlong        serial;         // Serial number of data when summarized
+  FXdouble      last;           // Value in last row summarized
+  FXbool        ordered;        // Column never decreases
+protected:
+  FXbool build(FXint lev,FXival fm);
+  FXbool summarize(FXival fm);
+  void gather(FXint lev,FXival fm,FXival to,FXival& rlo,FXival& rhi,FXdouble& lo,FXdouble& hi) const;
+private:
+  FXSummary(const FXSummary&);
+  FXSummary &operator=(const FXSummary&);
+public:
+
+  /// Create empty summary
+  FXSummary();
+
+  /**
+  * Bring summary of column of data up to date; the data should be
+  * locked by the caller if other threads may append to it.
+  * Return false if out of memory.
+  */
+  FXbool update(const FXData* dat,FXint col);
+
+  /// Return data summarized
+  const FXData* getData() const { return data; }
+
+  /// Return column summarized
+  FXint getColumn() const { return column; }
+
+  /// Return number of rows summarized
+  FXival getNumRows() const { return rows; }
+
+  /// Return true if values never decrease from one row to the next
+  FXbool isOrdered() const { return ordered; }
+
+  /**
+  * Find smallest and largest value in rows fm up to (but not including) to,
+  * and the rows where they are; return false if all values are NaN or the
+  * range is empty.
+  */
+  FXbool extent(FXival fm,FXival to,FXival& rlo,FXival& rhi,FXdouble& lo,FXdouble& hi) const;
+
+  /// Forget summary
+  void clear();
+
+  /// Destroy summary
+  virtual ~FXSummary();
+  };
+
+}
+
+#endif
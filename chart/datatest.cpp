@@ -0,0 +1,217 @@
+/********************************************************************************
+*                                                                               *
+*                          D a t a   S t o r e   T e s t                        *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "chart.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Append random rows to tables of every column type, growing and with a window,
+    one row at a time and many at once, with some NaN values thrown in; check
+    values and extents against the same rows kept in a plain array.
+  - Check that changing the window keeps the most recent rows.
+  - Time appending rows, and reading extents, with a big window; and appending
+    from a producer thread while the main thread reads.
+*/
+
+/*******************************************************************************/
+
+using namespace FXCHART;
+
+// Not a number
+static FXdouble notANumber(){
+  union { FXulong u; FXdouble d; } z={FXULONG(0x7ff8000000000000)};
+  return z.d;
+  }
+
+
+// Value as it comes back from a column of given type
+static FXdouble typed(FXdouble v,FXuint type){
+  if(type==FXData::Float) return (FXfloat)v;
+  if(type==FXData::Long) return Math::fpNan(v) ? 0.0 : (FXdouble)(FXlong)v;
+  return v;
+  }
+
+
+// Compare table against reference rows, oldest first
+static void compare(const FXData& data,const FXdouble* ref,FXival nref,FXuint type,const FXchar* what){
+  FXdouble lo,hi;
+  FXival r;
+  check(data.getNumRows()==nref,what,(FXdouble)data.getNumRows(),(FXdouble)nref);
+  if(data.getNumRows()!=nref) return;
+  for(FXint c=0; c<data.getNumColumns(); ++c){
+    lo=1.0E308;
+    hi=-1.0E308;
+    for(r=0; r<nref; ++r){
+      FXdouble v=typed(ref[r*data.getNumColumns()+c],type);
+      FXdouble w=data.getValue(c,r);
+      if(!(v==w || (Math::fpNan(v) && Math::fpNan(w)))){ check(false,what,v,w); return; }
+      if(Math::fpNan(v)) continue;
+      lo=FXMIN(lo,v);
+      hi=FXMAX(hi,v);
+      }
+    if(hi<lo){ lo=hi=0.0; }
+    Range range=data.getExtent(c);
+    check(range.minimum==lo,what,range.minimum,lo);
+    check(range.maximum==hi,what,range.maximum,hi);
+    }
+  }
+
+
+// Append random rows to table, and check it along the way
+static void exercise(FXRandom& random,FXuint type,FXival window,FXbool bulk){
+  const FXint NCOLS=3;
+  const FXival NROWS=5000;
+  FXData data(NCOLS,type);
+  FXdouble *ref;
+  FXdouble row[NCOLS*64];
+  FXival nref=0,n,r,i,first;
+  FXString what;
+  what.format("type %u window %ld %s",type,(long)window,bulk?"bulk":"single");
+  data.setWindow(window);
+  allocElms(ref,NROWS*NCOLS+64*NCOLS);
+  while(nref<NROWS){
+    n=bulk?1+(FXival)(random.randLong()%64):1;
+    for(i=0; i<n*NCOLS; ++i){
+      row[i]=(random.randLong()%50==0) ? notANumber() : (FXdouble)(FXlong)(random.randLong()%20000)-10000.0;
+      ref[nref*NCOLS+i]=row[i];
+      }
+    if(bulk && (random.randLong()&1)){
+      FXfloat fv[NCOLS][64];
+      FXdouble dv[NCOLS][64];
+      FXlong lv[NCOLS][64];
+      const void* cols[NCOLS];
+      for(FXint c=0; c<NCOLS; ++c){
+        for(r=0; r<n; ++r){
+          fv[c][r]=(FXfloat)row[r*NCOLS+c];
+          dv[c][r]=row[r*NCOLS+c];
+          lv[c][r]=Math::fpNan(row[r*NCOLS+c]) ? 0 : (FXlong)row[r*NCOLS+c];
+          }
+        cols[c]=(type==FXData::Float)?(const void*)fv[c]:(type==FXData::Long)?(const void*)lv[c]:(const void*)dv[c];
+        }
+      data.appendRows(cols,n);
+      }
+    else if(bulk){
+      data.appendRows(row,n);
+      }
+    else{
+      data.appendRow(row);
+      }
+    nref+=n;
+    if(random.randLong()%16==0 || NROWS<=nref){
+      first=(window && window<nref) ? nref-window : 0;
+      compare(data,ref+first*NCOLS,nref-first,type,what.text());
+      }
+    }
+  freeElms(ref);
+  }
+
+
+// Check that changing the window keeps the most recent rows
+static void rewindow(){
+  FXData data(1,FXData::Double);
+  FXdouble v;
+  FXival n;
+  for(FXint i=0; i<100; ++i){ v=i; data.appendRow(&v); }
+  data.setWindow(10);
+  check(data.getNumRows()==10,"shrink window",(FXdouble)data.getNumRows(),10);
+  check(data.getValue(0,0)==90.0,"shrink window",data.getValue(0,0),90);
+  check(data.getExtent(0).minimum==90.0,"shrink window",data.getExtent(0).minimum,90);
+  for(FXint i=100; i<105; ++i){ v=i; data.appendRow(&v); }
+  data.setWindow(50);
+  check(data.getNumRows()==10,"grow window",(FXdouble)data.getNumRows(),10);
+  check(data.getValue(0,0)==95.0,"grow window",data.getValue(0,0),95);
+  check(data.getValue(0,9)==104.0,"grow window",data.getValue(0,9),104);
+  data.setWindow(0);
+  for(FXint i=105; i<110; ++i){ v=i; data.appendRow(&v); }
+  check(data.getNumRows()==15,"unlimited",(FXdouble)data.getNumRows(),15);
+  check(data.getExtent(0).minimum==95.0,"unlimited",data.getExtent(0).minimum,95);
+  check(data.getExtent(0).maximum==109.0,"unlimited",data.getExtent(0).maximum,109);
+  const FXdouble* span=(const FXdouble*)data.getSpan(0,0,n);
+  check(span && n==15 && span[14]==109.0,"span",(FXdouble)n,15);
+  data.clear();
+  check(data.getNumRows()==0,"clear",(FXdouble)data.getNumRows(),0);
+  check(data.getExtent(0).minimum==0.0 && data.getExtent(0).maximum==0.0,"clear",data.getExtent(0).minimum,data.getExtent(0).maximum);
+  }
+
+
+// Producer appending rows, one small batch at a time
+class Producer : public FXThread {
+  FXData  *data;
+  FXival   total;
+public:
+  Producer(FXData* d,FXival t):data(d),total(t){ }
+  virtual FXint run(){
+    FXdouble rows[2*256];
+    for(FXival n=0; n<total; n+=256){
+      for(FXint i=0; i<256; ++i){ rows[2*i]=(FXdouble)(n+i); rows[2*i+1]=Math::sin(0.001*(n+i)); }
+      data->appendRows(rows,256);
+      }
+    return 0;
+    }
+  };
+
+
+// Time appending rows, and reading extents
+static void benchmark(FXival window,FXival total){
+  FXData data(2,FXData::Double);
+  FXdouble rows[2*1024];
+  FXTime start;
+  FXival n,reads=0;
+  FXlong before;
+  Range range;
+  data.setWindow(window);
+  start=FXThread::time();
+  for(n=0; n<total; n+=1024){
+    for(FXint i=0; i<1024; ++i){ rows[2*i]=(FXdouble)(n+i); rows[2*i+1]=Math::sin(0.001*(n+i)); }
+    data.appendRows(rows,1024);
+    }
+  fxmessage("  window %9ld: append %ld rows %9.3lfms",(long)window,(long)total,elapsed(start));
+  start=FXThread::time();
+  for(n=0; n<1000000; ++n){ range=data.getExtent(n&1); }
+  fxmessage(", 1000000 extents %8.3lfms",elapsed(start));
+  data.clear();
+  before=data.getSerial();
+  Producer producer(&data,total);
+  start=FXThread::time();
+  producer.start();
+  while(producer.running()){
+    data.lock();
+    range=data.getExtent(0);
+    if(data.getNumRows() && range.maximum!=data.getValue(0,data.getNumRows()-1)){ check(false,"producer extent",range.maximum,data.getValue(0,data.getNumRows()-1)); }
+    data.unlock();
+    reads++;
+    }
+  producer.join();
+  fxmessage(", from thread %9.3lfms (%ld reads)\n",elapsed(start),(long)reads);
+  check(data.getSerial()-before==total,"producer rows",(FXdouble)(data.getSerial()-before),(FXdouble)total);
+  }
+
+
+// Start
+int main(int,char**){
+  static const FXival windows[]={0,1,7,100,4096};
+  FXRandom random(1234);
+
+  // Correctness
+  for(FXuint type=FXData::Float; type<=FXData::Long; ++type){
+    for(FXint w=0; w<(FXint)ARRAYNUMBER(windows); ++w){
+      exercise(random,type,windows[w],false);
+      exercise(random,type,windows[w],true);
+      }
+    }
+  rewindow();
+
+  // Speed
+  fxmessage("2 columns:\n");
+  benchmark(0,8388608);
+  benchmark(100000,8388608);
+  benchmark(1000000,8388608);
+
+  return report();
+  }
@@ -0,0 +1,329 @@
+/********************************************************************************
+*                                                                               *
+*                      C u r v e   D e c i m a t i o n   T e s t                *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "chart.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Check extents found by FXSummary against going through the rows, for random
+    ranges, after appending rows, and with a window.
+  - Check that the envelope of a curve has, in each pixel column, the same highest
+    and lowest pixel as all the samples in that column; zoomed out and zoomed in,
+    with and without x samples.
+  - Check that LTTB keeps to its budget of points, and stays within the data.
+  - Time redrawing (decimating) curves of 10^4 up to 10^8 samples, or up to 10^N
+    if N is passed; zoomed out, zoomed in, and panned; the first redraw includes
+    building the summary.  The samples are floats, so 10^9 samples need about
+    6GB of memory.  Drawing every sample is timed up to 10^7 samples.
+  - No display is needed; the curves are decimated, not drawn.
+*/
+
+/*******************************************************************************/
+
+using namespace FXCHART;
+
+// Not a number
+static FXdouble notANumber(){
+  union { FXulong u; FXdouble d; } z={FXULONG(0x7ff8000000000000)};
+  return z.d;
+  }
+
+
+// Pixel coordinate, as the curve computes it
+static FXint pixel(FXdouble t){
+  return (FXint)Math::floor(Math::fclamp(-32000.0,t+0.5,32000.0));
+  }
+
+
+// Compare extents of random ranges against going through the rows
+static void compareExtents(FXRandom& random,const FXData& data,const FXchar* what){
+  FXSummary summary;
+  FXival fm,to,rlo,rhi,r,n;
+  FXdouble lo,hi,v,blo,bhi;
+  FXbool found,any;
+  summary.update(&data,0);
+  n=data.getNumRows();
+  check(summary.getNumRows()==n,what,(FXdouble)summary.getNumRows(),(FXdouble)n);
+  for(FXint i=0; i<500; ++i){
+    fm=(FXival)(random.randLong()%(n+1));
+    to=(i&1)?fm+(FXival)(random.randLong()%40):(FXival)(random.randLong()%(n+1));
+    to=FXMIN(to,n);
+    found=summary.extent(fm,to,rlo,rhi,lo,hi);
+    blo=bhi=0.0;
+    any=false;
+    for(r=fm; r<to; ++r){
+      v=data.getValue(0,r);
+      if(Math::fpNan(v)) continue;
+      if(!any || v<blo) blo=v;
+      if(!any || v>bhi) bhi=v;
+      any=true;
+      }
+    if(found!=any){ check(false,what,(FXdouble)fm,(FXdouble)to); return; }
+    if(!found) continue;
+    if(lo!=blo || hi!=bhi || data.getValue(0,rlo)!=lo || data.getValue(0,rhi)!=hi || rlo<fm || to<=rlo || rhi<fm || to<=rhi){
+      fxwarning("FAILED: %s: rows %ld-%ld: %lg %lg, expected %lg %lg\n",what,(long)fm,(long)to,lo,hi,blo,bhi);
+      failures++;
+      return;
+      }
+    }
+  }
+
+
+// Append random values, some NaN
+static void appendRandom(FXRandom& random,FXData& data,FXival n){
+  FXdouble v;
+  for(FXival i=0; i<n; ++i){
+    v=(random.randLong()%100==0) ? notANumber() : (FXdouble)(FXlong)(random.randLong()%100000);
+    data.appendRow(&v);
+    }
+  }
+
+
+// Check summaries
+static void checkSummary(FXRandom& random){
+  FXData data(1,FXData::Double);
+  FXSummary summary;
+  FXdouble v;
+  FXint i;
+  compareExtents(random,data,"empty");
+  appendRandom(random,data,5);
+  compareExtents(random,data,"5 rows");
+  appendRandom(random,data,70000);
+  compareExtents(random,data,"70005 rows");
+
+  // Incremental update, and ordering
+  data.clear();
+  for(i=0; i<100000; ++i){ v=i/3; data.appendRow(&v); }
+  summary.update(&data,0);
+  check(summary.isOrdered(),"ordered",0,0);
+  for(i=0; i<1000; ++i){ v=100000+i; data.appendRow(&v); }
+  summary.update(&data,0);
+  check(summary.isOrdered(),"still ordered",0,0);
+  v=0.0;
+  data.appendRow(&v);
+  summary.update(&data,0);
+  check(!summary.isOrdered(),"not ordered",0,0);
+  for(i=0; i<300; ++i){ appendRandom(random,data,1+random.randLong()%2000); }
+  compareExtents(random,data,"appended");
+
+  // Ring buffer
+  data.setWindow(33333);
+  appendRandom(random,data,100000);
+  compareExtents(random,data,"window");
+  }
+
+
+// Check envelope against going through the rows in each pixel column
+static void checkEnvelope(FX2DPlot* plot,FXData* data,FXint xcol,FXint ycol,const Range& xr,const Range& yr,const FXchar* what){
+  const FXint X=10,Y=20,W=500,H=300;
+  FXCurve curve(plot);
+  FXPoint points[4*W+4];
+  FXint blo[W],bhi[W],plo[W],phi[W];
+  FXdouble sx=(W-1)/(xr.maximum-xr.minimum);
+  FXdouble sy=(H-1)/(yr.maximum-yr.minimum);
+  FXdouble yb=Y+H-1+yr.minimum*sy;
+  FXdouble u,v;
+  FXint np,c,p,i;
+  if(0<=xcol) curve.setXData(data,xcol);
+  curve.setYData(data,ycol);
+  curve.setDecimation(DECIMATE_ENVELOPE);
+  np=curve.decimate(points,X,Y,W,H,xr,yr);
+  check(np<=4*W+4,what,np,4*W+4);
+  for(c=0; c<W; ++c){ blo[c]=plo[c]=100000; bhi[c]=phi[c]=-100000; }
+  for(FXival r=0; r<data->getNumRows(); ++r){
+    u=(0<=xcol)?data->getValue(xcol,r):(FXdouble)r;
+    v=data->getValue(ycol,r);
+    c=(FXint)Math::floor((u-xr.minimum)*sx+0.5);
+    if(c<0 || W<=c || Math::fpNan(v)) continue;
+    p=pixel(yb-v*sy);
+    blo[c]=FXMIN(blo[c],p);
+    bhi[c]=FXMAX(bhi[c],p);
+    }
+  for(i=0; i<np; ++i){
+    c=points[i].x-X;
+    if(c<0 || W<=c) continue;
+    plo[c]=FXMIN(plo[c],points[i].y);
+    phi[c]=FXMAX(phi[c],points[i].y);
+    }
+  for(c=0; c<W; ++c){
+    if(blo[c]!=plo[c] || bhi[c]!=phi[c]){
+      fxwarning("FAILED: %s: column %d: %d-%d, expected %d-%d\n",what,c,plo[c],phi[c],blo[c],bhi[c]);
+      failures++;
+      return;
+      }
+    }
+  }
+
+
+// Check LTTB stays within budget and data
+static void checkTriangles(FX2DPlot* plot,FXData* data,const Range& xr,const Range& yr){
+  const FXint X=0,Y=0,W=400,H=300;
+  FXCurve curve(plot);
+  FXPoint points[4*W+4];
+  FXint np,i;
+  curve.setXData(data,0);
+  curve.setYData(data,1);
+  curve.setDecimation(DECIMATE_LTTB);
+  np=curve.decimate(points,X,Y,W,H,xr,yr);
+  check(2<np && np<=2*W,"lttb points",np,2*W);
+  for(i=0; i<np; ++i){
+    if(points[i].x<X || X+W<=points[i].x || points[i].y<Y || Y+H<=points[i].y){
+      check(false,"lttb point in range",points[i].x,points[i].y);
+      break;
+      }
+    }
+  }
+
+
+// Check curves
+static void checkCurves(FXRandom& random,FX2DPlot* plot){
+  FXData data(3,FXData::Double);
+  FXdouble row[3],t=0.0;
+  Range xr,yr;
+  for(FXint i=0; i<200000; ++i){
+    t+=(FXdouble)(random.randLong()%10)*0.001;           // Irregular but ordered x
+    row[0]=t;
+    row[1]=(random.randLong()%500==0) ? notANumber() : Math::sin(0.001*i)+(FXdouble)(random.randLong()%1000)*0.0002;
+    row[2]=(FXdouble)(random.randLong()%1000);          // Scattered x
+    data.appendRow(row);
+    }
+  yr.minimum=-1.5; yr.maximum=1.5;
+  xr.minimum=0.0; xr.maximum=200000.0;
+  checkEnvelope(plot,&data,-1,1,xr,yr,"envelope by row");
+  xr.minimum=12345.0; xr.maximum=14000.0;
+  checkEnvelope(plot,&data,-1,1,xr,yr,"envelope by row zoomed");
+  xr.minimum=12345.0; xr.maximum=12500.0;
+  checkEnvelope(plot,&data,-1,1,xr,yr,"envelope by row zoomed way in");
+  xr.minimum=0.0; xr.maximum=t;
+  checkEnvelope(plot,&data,0,1,xr,yr,"envelope by x");
+  xr.minimum=0.3*t; xr.maximum=0.31*t;
+  checkEnvelope(plot,&data,0,1,xr,yr,"envelope by x zoomed");
+  yr.minimum=-0.5; yr.maximum=0.5;
+  checkEnvelope(plot,&data,0,1,xr,yr,"envelope clipped");
+  xr.minimum=0.0; xr.maximum=1000.0;
+  yr.minimum=-1.5; yr.maximum=1.5;
+  checkTriangles(plot,&data,xr,yr);
+  }
+
+
+// Time drawing every sample: mapping each to a pixel
+static FXdouble drawEverything(const FXfloat* values,FXival n,FXint w,FXint h){
+  FXdouble sx=(w-1)/(FXdouble)n;
+  FXdouble sy=(h-1)/4.0;
+  FXPoint *points;
+  FXTime start;
+  allocElms(points,n);
+  start=FXThread::time();
+  for(FXival i=0; i<n; ++i){
+    points[i].x=(FXshort)pixel(i*sx);
+    points[i].y=(FXshort)pixel(h-1-((FXdouble)values[i]+2.0)*sy);
+    }
+  FXdouble t=elapsed(start);
+  freeElms(points);
+  return t;
+  }
+
+
+// Time redraws of curve with n samples
+static void benchmark(FX2DPlot* plot,FXival n){
+  const FXint W=1920,H=1080;
+  FXData data(1,FXData::Float);
+  FXCurve curve(plot);
+  FXPoint points[4*W+4];
+  FXRandom random(42);
+  FXfloat *values;
+  FXdouble v=0.0,first,full,zoom,pan,lttb;
+  FXival i,m,span;
+  FXint np=0,k;
+  FXTime start;
+  Range xr,yr;
+
+  // Random walk
+  if(!allocElms(values,FXMIN(n,1048576))){ fxwarning("Out of memory\n"); return; }
+  if(!data.reserve(n)){ fxwarning("Out of memory for %ld samples\n",(long)n); freeElms(values); return; }
+  for(i=0; i<n; i+=m){
+    m=FXMIN(n-i,1048576);
+    for(FXival j=0; j<m; ++j){ v=0.999*v+0.01*((FXdouble)(random.randLong()&1023)/512.0-1.0); values[j]=(FXfloat)v; }
+    const void* cols[1]={values};
+    data.appendRows(cols,m);
+    }
+  freeElms(values);
+  curve.setYData(&data,0);
+  yr.minimum=-2.0; yr.maximum=2.0;
+
+  // Zoomed out; first time builds summary
+  xr.minimum=0.0; xr.maximum=(FXdouble)n;
+  start=FXThread::time();
+  curve.decimate(points,0,0,W,H,xr,yr);
+  first=elapsed(start);
+  start=FXThread::time();
+  for(k=0; k<10; ++k){ np=curve.decimate(points,0,0,W,H,xr,yr); }
+  full=elapsed(start)/10;
+
+  // Zoomed in on 1%
+  span=FXMAX(n/100,W);
+  start=FXThread::time();
+  for(k=0; k<10; ++k){
+    xr.minimum=(FXdouble)(random.randLong()%(n-span+1));
+    xr.maximum=xr.minimum+span;
+    curve.decimate(points,0,0,W,H,xr,yr);
+    }
+  zoom=elapsed(start)/10;
+
+  // Panned, by a tenth of the view at a time
+  start=FXThread::time();
+  for(k=0; k<10; ++k){
+    xr.minimum+=(k<5?0.1:-0.1)*span;
+    xr.maximum+=(k<5?0.1:-0.1)*span;
+    curve.decimate(points,0,0,W,H,xr,yr);
+    }
+  pan=elapsed(start)/10;
+
+  // LTTB zoomed out
+  curve.setDecimation(DECIMATE_LTTB);
+  xr.minimum=0.0; xr.maximum=(FXdouble)n;
+  start=FXThread::time();
+  for(k=0; k<10; ++k){ curve.decimate(points,0,0,W,H,xr,yr); }
+  lttb=elapsed(start)/10;
+
+  fxmessage("  %11ld %10.3lfms %8.3lfms %8.3lfms %8.3lfms %8.3lfms",(long)n,first,full,zoom,pan,lttb);
+  if(n<=10000000){
+    FXival sn;
+    fxmessage(" %10.3lfms",drawEverything((const FXfloat*)data.getSpan(0,0,sn),n,W,H));
+    }
+  fxmessage("  (%d points)\n",np);
+  }
+
+
+// Start
+int main(int argc,char *argv[]){
+  FXApp app("decimatetest");
+  FXRandom random(1234);
+  FXint maxpower=8;
+  FXival n;
+
+  // Plot to hang curves on; never shown
+  FXMainWindow *main=new FXMainWindow(&app,"decimatetest");
+  FX2DPlot *plot=new FX2DPlot(main);
+
+  if(1<argc) maxpower=FXCLAMP(4,atoi(argv[1]),10);
+
+  // Correctness
+  checkSummary(random);
+  checkCurves(random,plot);
+
+  // Speed
+  fxmessage("1920x1080, redraw times:\n");
+  fxmessage("  %11s %12s %10s %10s %10s %10s %12s\n","samples","first","envelope","zoom 1%","pan","lttb","every sample");
+  for(n=10000; maxpower>=4; n*=10,maxpower--){
+    benchmark(plot,n);
+    }
+
+  return report();
+  }
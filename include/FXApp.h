@@ -178,7 +178,10 @@ private:
   FXRootWindow    *root;                // Root window
   FXVisual        *monoVisual;          // Monochrome visual
   FXVisual        *defaultVisual;       // Default [color] visual
-  FXTimer         *timers;              // List of timers, sorted by time
+  FXTimer        **timers;              // Heap of timers, earliest first
+  FXint            ntimers;             // Number of timers in heap
+  FXint            maxtimers;           // Space in timer heap
+  FXHash           timertable;          // Timers by target
   FXChore         *chores;              // List of chores
   FXRepaint       *repaints;            // Unhandled repaint rectangles
   FXTimer         *timerrecs;           // List of recycled timer records
@@ -365,6 +368,10 @@ private:
   void dragdropGetTypes(const FXWindow* window,FXDragType*& types,FXuint& numtypes);
   void openInputDevices();
   void closeInputDevices();
+  FXTimer* findTimer(FXObject* tgt,FXSelector sel) const;
+  void placeTimer(FXTimer* t);
+  void insertTimer(FXTimer* t);
+  void removeTimer(FXTimer* t);
 #ifdef WIN32
   static FXival CALLBACK wndproc(FXID hwnd,FXuint iMsg,FXuval wParam,FXival lParam);
 protected:
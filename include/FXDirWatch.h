@@ -37,6 +37,11 @@ class FXApp;
 * Issue messages when one of them was changed.
 * Each path has a corresponding handle which is used to interact with
 * the operating system.
+* The target is sent SEL_INSERTED, SEL_DELETED, or SEL_CHANGED, with the
+* pathname (const FXchar*) of the entry that was added, removed, or changed.
+* A SEL_CHANGED for a watched directory itself means the whole directory
+* should be re-examined; this happens on systems which can not report
+* changes of individual entries, or if some changes were lost.
 */
 class FXAPI FXDirWatch : public FXObject {
   FXDECLARE(FXDirWatch)
@@ -27,8 +27,11 @@ private:
   struct Timer;
 private:
   FXHash        handles;                // Handle callbacks
+  FXHash        timertable;             // Timeout callbacks by callback
   Signal      **signals;                // Signal callbacks
-  Timer        *timers;                 // Timeout callbacks
+  Timer       **timers;                 // Heap of timeout callbacks, earliest first
+  FXint         ntimers;                // Number of timeout callbacks
+  FXint         maxtimers;              // Space in timeout heap
   Idle         *idles;                  // Idle callbacks
   Timer        *timerrecs;              // Timer records
   Idle         *idlerecs;               // Idle records
@@ -49,6 +52,12 @@ public:
   /// Idle callback when dispatcher is about to block
   typedef FXCallback<FXbool(FXDispatcher*,void*)> IdleCallback;
 
+private:
+  Timer* findTimer(const TimeoutCallback& cb) const;
+  void placeTimer(Timer* t);
+  void insertTimer(Timer* t);
+  void removeTimer(Timer* t);
+
 public:
 
   /// Construct dispatcher object.
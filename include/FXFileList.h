@@ -30,6 +30,10 @@ namespace FX {
 
 struct FXFileAssoc;
 class FXFileList;
+class FXStat;
+class FXDirWatch;
+class FXThreadPool;
+class FXMessageChannel;
 class FXIconSource;
 class FXFileAssociations;
 
@@ -55,6 +59,10 @@ protected:
   FXlong       size;            // File size
   FXTime       date;            // File time
   FXuint       mode;            // Mode flags
+protected:
+  enum {
+    PREVIEWED = 64              // Preview was attempted
+    };
 private:
   FXFileItem(const FXFileItem&);
   FXFileItem& operator=(const FXFileItem&);
@@ -120,20 +128,27 @@ public:
 
 /**
 * A File List widget provides an icon rich view of the file system.
-* It automatically updates itself periodically by re-scanning the file system
-* for any changes.  As it scans the displayed directory, it automatically
-* determines the icons to be displayed by consulting the file associations registry
-* settings.  A number of messages can be sent to the File List to control the
+* It automatically updates itself when the displayed directory changes, using
+* change notifications from the file system where available, or by periodically
+* re-scanning the directory otherwise.  As it scans the displayed directory, it
+* automatically determines the icons to be displayed by consulting the file
+* associations registry settings.  A number of messages can be sent to the File List to control the
 * filter pattern, sort category, sorting order, case sensitivity, and hidden file
 * display mode.
 * The File list widget supports drags and drops of files.
 */
 class FXAPI FXFileList : public FXIconList {
   FXDECLARE(FXFileList)
+protected:
+  struct Thumbnail;
 protected:
   FXFileAssociations *associations;     // Association table
   FXIconSource       *iconloader;       // Icon loader
   FXFileItem         *list;             // File item list
+  FXDirWatch         *watcher;          // Directory change watcher
+  FXThreadPool       *threadpool;       // Thread pool making thumbnails
+  FXMessageChannel   *channel;          // Finished thumbnails from workers
+  Thumbnail          *thumbnails;       // Thumbnails being made
   FXIcon             *big_folder;       // Big folder icon
   FXIcon             *mini_folder;      // Mini folder icon
   FXIcon             *big_doc;          // Big document icon
@@ -148,16 +163,32 @@ protected:
   FXString            clipfiles;        // Clipped files
   FXString            dragfiles;        // Dragged files
   FXString            dropfiles;        // Dropped files
+  FXString            thumbdir;         // Thumbnail cache directory
+  FXStringDictionary  pending;          // Changed entries awaiting update
   FXDragAction        dropaction;       // Drop action
   FXuint              matchmode;        // File wildcard match mode
   FXint               imagesize;        // Image size
+  FXint               thumbnext;        // Next item to get thumbnail
+  FXint               thumbbusy;        // Thumbnails being made
+  FXCompletion        thumbjobs;        // Thumbnail jobs still with workers
   FXTime              timestamp;        // Time when last refreshed
   FXuint              counter;          // Refresh counter
+  FXbool              rescan;           // Rescan whole directory on update
   FXbool              clipcut;          // Cut or copy
   FXbool              draggable;        // Dragable files
 protected:
   FXFileList();
   FXbool listItems(FXbool force,FXbool notify);
+  FXbool updateItems(FXbool notify);
+  void updateItem(const FXString& name,FXbool notify);
+  FXbool acceptItem(const FXString& name,const FXString& pathname,FXbool istop,FXStat& info,FXuint& mode) const;
+  FXFileItem* buildItem(const FXString& name,const FXString& pathname,const FXStat& info,FXuint mode);
+  void watchDirectory();
+  void getVisibleItems(FXint& lo,FXint& hi) const;
+  FXint nextThumbnail();
+  void startThumbnails();
+  void stopThumbnails();
+  void showThumbnail(Thumbnail* thumb);
   FXString getSelectedFiles() const;
   virtual FXIconItem *createItem(const FXString& text,FXIcon *big,FXIcon* mini,void* ptr);
   void delete_files(const FXString& files);
@@ -170,7 +201,10 @@ private:
 public:
   long onOpenTimer(FXObject*,FXSelector,void*);
   long onRefreshTimer(FXObject*,FXSelector,void*);
+  long onUpdateTimer(FXObject*,FXSelector,void*);
+  long onWatchChanged(FXObject*,FXSelector,void*);
   long onPreviewChore(FXObject*,FXSelector,void*);
+  long onThumbnail(FXObject*,FXSelector,void*);
   long onDNDEnter(FXObject*,FXSelector,void*);
   long onDNDLeave(FXObject*,FXSelector,void*);
   long onDNDMotion(FXObject*,FXSelector,void*);
@@ -241,15 +275,32 @@ public:
   static FXint descendingUser(const FXIconItem* a,const FXIconItem* b);
   static FXint ascendingGroup(const FXIconItem* a,const FXIconItem* b);
   static FXint descendingGroup(const FXIconItem* a,const FXIconItem* b);
+  static FXlong ascendingKey(const FXIconItem* a);
+  static FXlong descendingKey(const FXIconItem* a);
+  static FXlong ascendingCaseKey(const FXIconItem* a);
+  static FXlong descendingCaseKey(const FXIconItem* a);
+  static FXlong ascendingTypeKey(const FXIconItem* a);
+  static FXlong descendingTypeKey(const FXIconItem* a);
+  static FXlong ascendingSizeKey(const FXIconItem* a);
+  static FXlong descendingSizeKey(const FXIconItem* a);
+  static FXlong ascendingTimeKey(const FXIconItem* a);
+  static FXlong descendingTimeKey(const FXIconItem* a);
+  static FXlong ascendingUserKey(const FXIconItem* a);
+  static FXlong descendingUserKey(const FXIconItem* a);
+  static FXlong ascendingGroupKey(const FXIconItem* a);
+  static FXlong descendingGroupKey(const FXIconItem* a);
 public:
   enum {
     ID_OPENTIMER=FXIconList::ID_LAST,
     ID_REFRESHTIMER,
+    ID_UPDATETIMER,
+    ID_WATCH,
     ID_DROPASK,
     ID_DROPCOPY,
     ID_DROPMOVE,
     ID_DROPLINK,
     ID_PREVIEWCHORE,
+    ID_THUMBNAIL,
     ID_SORT_BY_NAME,    /// Sort by name
     ID_SORT_BY_TYPE,    /// Sort by type
     ID_SORT_BY_SIZE,    /// Sort by size
@@ -382,6 +433,35 @@ public:
   /// Return images preview size
   FXint getImageSize() const { return imagesize; }
 
+  /**
+  * Change sort function, and optional sort key function.
+  * If no key function is passed, the matching key function is
+  * used for the file list's own sort functions.
+  */
+  virtual void setSortFunc(FXIconListSortFunc func,FXIconListSortKey key=nullptr);
+
+  /**
+  * Set thread pool used to make image previews in the background.
+  * Without thread pool, previews are made one at a time, by chores
+  * running in the user-interface thread.
+  * The thread pool should outlive the file list.
+  */
+  void setThreadPool(FXThreadPool* pool);
+
+  /// Return thread pool used to make image previews
+  FXThreadPool* getThreadPool() const { return threadpool; }
+
+  /**
+  * Set directory where image previews are cached; the cache
+  * is keyed by the image file's pathname, modified time, and size,
+  * so previews are remade only when the image is changed.
+  * By default, no cache is used.
+  */
+  void setThumbnailDirectory(const FXString& dir);
+
+  /// Return directory where image previews are cached
+  const FXString& getThumbnailDirectory() const { return thumbdir; }
+
   /// Set draggable files
   void setDraggableFiles(FXbool flag,FXbool notify=false);
 
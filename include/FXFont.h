@@ -158,9 +158,16 @@ private:
 #ifdef WIN32
   FXID      dc;
 #endif
+  struct Advances;
+  Advances *advances;           // Cached glyph advance widths
 protected:
   FXFont();
   void* match(const FXString& wantfamily,const FXString& wantforge,FXuint wantsize,FXuint wantweight,FXuint wantslant,FXuint wantsetwidth,FXuint wantencoding,FXuint wanthints,FXint res);
+private:
+  FXint measureChar(FXwchar ch) const;
+  FXint advance(FXwchar ch) const;
+  FXint sumAdvances(const FXchar* string,FXuint length) const;
+  void clearAdvances();
 private:
   FXFont(const FXFont&);
   FXFont &operator=(const FXFont&);
@@ -29,14 +29,33 @@
 namespace FX {
 
 
+class FXThreadPool;
 struct ZBlock;
-
-
-/// GZIP compressed stream
+struct ZQueue;
+
+
+/**
+* GZIP compressed stream.
+* Data are compressed with zlib as one stream, at the given compression level.
+* If a thread pool is set before opening the stream for saving, the data are
+* cut into blocks of the stream's buffer size instead, which are compressed
+* independently and concurrently, and then joined into one valid stream.
+* An index of the blocks is appended after the end of the compressed stream;
+* when loading such a file with a thread pool set, the blocks are decompressed
+* concurrently, ahead of the data being loaded.  Either way, files saved with
+* or without thread pool can be loaded with or without thread pool.
+*/
 class FXAPI FXGZFileStream : public FXFileStream {
 private:
-  ZBlock *gz;
-  int     ac;
+  ZBlock       *gz;
+  ZQueue       *pz;
+  FXThreadPool *pool;
+  int           ac;
+  int           level;
+private:
+  FXbool submitPart(FXuval size,FXbool last);
+  FXbool retirePart();
+  FXbool schedulePart();
 protected:
   virtual FXuval writeBuffer(FXuval count);
   virtual FXuval readBuffer(FXuval count);
@@ -51,10 +70,25 @@ public:
   /// Create and open GZIP compressed file stream
   FXGZFileStream(const FXString& filename,FXStreamDirection save_or_load=FXStreamLoad,FXuval size=8192UL);
 
-  /// Open file stream
+  /**
+  * Open file stream; the buffer size is also the size of the compressed blocks
+  * when a thread pool is set, in which case it is at least 64KB.
+  */
   FXbool open(const FXString& filename,FXStreamDirection save_or_load=FXStreamLoad,FXuval size=8192UL);
 
-  /// Flush buffer
+  /// Change compression level, from 0 (none) to 9 (best), or -1 for the default
+  void setCompressionLevel(FXint lev){ level=lev; }
+
+  /// Return compression level
+  FXint getCompressionLevel() const { return level; }
+
+  /// Change thread pool for block compression; set it before opening the stream
+  void setThreadPool(FXThreadPool* p){ pool=p; }
+
+  /// Return thread pool for block compression
+  FXThreadPool* getThreadPool() const { return pool; }
+
+  /// Flush buffer; with a thread pool, only whole blocks are written out
   virtual FXbool flush();
 
   /// Close file stream
@@ -167,6 +167,9 @@ public:
 /// Icon item collate function
 typedef FXint (*FXIconListSortFunc)(const FXIconItem*,const FXIconItem*);
 
+/// Icon item sort key function
+typedef FXlong (*FXIconListSortKey)(const FXIconItem*);
+
 
 /// List of FXIconItem's
 typedef FXObjectListOf<FXIconItem> FXIconItemList;
@@ -210,6 +213,7 @@ protected:
   FXint              viewable;          // Visible item
   FXFont            *font;              // Font
   FXIconListSortFunc sortfunc;          // Item sort function
+  FXIconListSortKey  sortkey;           // Item sort key function
   FXColor            textColor;         // Text color
   FXColor            selbackColor;      // Selected back color
   FXColor            seltextColor;      // Selected text color
@@ -558,8 +562,16 @@ public:
   /// Return sort function
   FXIconListSortFunc getSortFunc() const { return sortfunc; }
 
-  /// Change sort function
-  void setSortFunc(FXIconListSortFunc func){ sortfunc=func; }
+  /**
+  * Change sort function, and optional sort key function.
+  * The key function should map items to keys ordered consistently
+  * with the sort function; keys are computed once per sort, and the
+  * sort function is only called to order items with equal keys.
+  */
+  virtual void setSortFunc(FXIconListSortFunc func,FXIconListSortKey key=nullptr){ sortfunc=func; sortkey=key; }
+
+  /// Return sort key function
+  FXIconListSortKey getSortKey() const { return sortkey; }
 
   /// Change text font
   void setFont(FXFont* fnt);
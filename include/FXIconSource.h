@@ -48,6 +48,13 @@ class FXAPI FXIconSource : public FXObject {
   FXDECLARE(FXIconSource)
 private:
   FXImage *scaleToSize(FXImage *image,FXint size,FXint qual) const;
+  FXImage *loadScaledPixels(FXImage *image,FXStream& store,FXint size,FXint qual) const;
+  FXIcon *iconOfType(FXApp* app,FXStream& store,const FXString& type) const;
+  FXImage *imageOfType(FXApp* app,FXStream& store,const FXString& type) const;
+  FXIcon *iconFromFile(FXApp* app,const FXString& filename,FXint size,FXint qual,const FXString& type) const;
+  FXIcon *iconFromData(FXApp* app,const FXuchar *pixels,FXint size,FXint qual,const FXString& type) const;
+  FXImage *imageFromFile(FXApp* app,const FXString& filename,FXint size,FXint qual,const FXString& type) const;
+  FXImage *imageFromData(FXApp* app,const FXuchar *pixels,FXint size,FXint qual,const FXString& type) const;
 public:
 
   /**
@@ -151,6 +158,8 @@ public:
 
   /**
   * Load icon from stream and scale it such that its dimensions does not exceed given size.
+  * Formats which can do so cheaply load at reduced size first.  The icon type is
+  * found through iconFromType() or iconFromStream(), as for loadIconStream().
   */
   virtual FXIcon *loadScaledIconStream(FXApp* app,FXStream& store,FXint size=32,FXint qual=0,const FXString& type=FXString::null) const;
 
@@ -167,6 +176,8 @@ public:
 
   /**
   * Load image and scale it such that its dimensions does not exceed given size.
+  * Formats which can do so cheaply load at reduced size first.  The image type is
+  * found through imageFromType() or imageFromStream(), as for loadImageStream().
   */
   virtual FXImage *loadScaledImageStream(FXApp* app,FXStream& store,FXint size=32,FXint qual=0,const FXString& type=FXString::null) const;
   };
@@ -209,6 +209,9 @@ public:
   /**
   * Rescale pixels image to the specified width and height; this calls
   * resize() to adjust the client and server side representations.
+  * Quality 0 picks the nearest pixel, 1 averages the pixels covered, and
+  * 2 does the same in linear light; quality 3 filters with Lanczos in linear
+  * light, using the thread pool of the calling thread, if any.
   */
   virtual void scale(FXint w,FXint h,FXint quality=0);
 
@@ -273,6 +276,13 @@ public:
   /// Load pixel data only
   virtual FXbool loadPixels(FXStream& store);
 
+  /**
+  * Load pixel data only, reduced while loading where the format allows,
+  * but no further than needed to fit in size by size pixels; the default
+  * loads the pixels at full size.
+  */
+  virtual FXbool loadScaledPixels(FXStream& store,FXint size);
+
   /// Save object to stream
   virtual void save(FXStream& store) const;
 
@@ -0,0 +1,158 @@
+/********************************************************************************
+*                                                                               *
+*                        I m a g e   R e a d e r   C l a s s                    *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXIMAGEREADER_H
+#define FXIMAGEREADER_H
+
+namespace FX {
+
+
+class FXStream;
+
+
+/**
+* FXImageReader decodes an image from a stream a few rows at a time, into a
+* buffer provided by the caller, instead of into one array for the whole image.
+* This way, images far bigger than would fit in memory may be processed, or
+* scaled down for display; only a few rows of the image are kept at any time.
+* Reading is started by start(), which reads the image header, after which
+* the size of the image is known; then rows are read top to bottom by read(),
+* and finally finish() moves the stream past the end of the image.
+* Rows may be left unread; finish() skips past them.
+* Subclasses implement this for each format which can be decoded this way.
+*/
+class FXAPI FXImageReader {
+protected:
+  FXStream *store;              // Stream being read
+  FXint     width;              // Width of image
+  FXint     height;             // Height of image
+  FXint     row;                // Next row to be read
+private:
+  FXImageReader(const FXImageReader&);
+  FXImageReader &operator=(const FXImageReader&);
+public:
+
+  /// Create image reader
+  FXImageReader();
+
+  /**
+  * Start reading image from stream, reading its header; return false if the
+  * stream does not contain an image of this format, or if it is corrupt.
+  */
+  virtual FXbool start(FXStream& store)=0;
+
+  /// Width of image, once started
+  FXint getWidth() const { return width; }
+
+  /// Height of image, once started
+  FXint getHeight() const { return height; }
+
+  /// Next row to be read
+  FXint getRow() const { return row; }
+
+  /**
+  * Read up to n rows into buffer, with rows stride pixels apart; return the
+  * number of rows read, or 0 if all rows have been read, or on error.
+  */
+  virtual FXint read(FXColor* buffer,FXint n,FXint stride)=0;
+
+  /**
+  * Finish reading, leaving the stream after the end of the image; return
+  * false if the image was corrupt.
+  */
+  virtual FXbool finish()=0;
+
+  /**
+  * Read the rest of the image, which must not be smaller than dw by dh pixels,
+  * and scale it down to dw by dh pixels into dst, with rows dstride pixels
+  * apart, averaging the pixels covered by each output pixel.
+  * Only one row of the image and one row of the output are kept while doing
+  * so.  Return false if the size is out of range, or if the image is corrupt.
+  */
+  FXbool readScaled(FXColor* dst,FXint dw,FXint dh,FXint dstride);
+
+  /// Destroy image reader
+  virtual ~FXImageReader();
+  };
+
+
+/**
+* Image reader for PNG images.
+* Rows are inflated and unfiltered one at a time, unless the image is interlaced;
+* then, as interlace passes cover the whole image, it is decoded in full by
+* start(), and read() hands out its rows.
+*/
+class FXAPI FXPNGReader : public FXImageReader {
+protected:
+  struct Decoder;
+protected:
+  Decoder *decoder;             // Decoder state
+public:
+
+  /// Create PNG reader
+  FXPNGReader();
+
+  /// Start reading PNG image from stream
+  virtual FXbool start(FXStream& store);
+
+  /// Read up to n rows into buffer
+  virtual FXint read(FXColor* buffer,FXint n,FXint stride);
+
+  /// Finish reading PNG image
+  virtual FXbool finish();
+
+  /// Destroy PNG reader
+  virtual ~FXPNGReader();
+  };
+
+
+/**
+* Image reader for JPEG images.
+* If a size is given, the image is decoded at 1/2, 1/4, or 1/8 of its size,
+* where this leaves at least size pixels in its largest dimension; getWidth()
+* and getHeight() return the reduced size.
+*/
+class FXAPI FXJPGReader : public FXImageReader {
+protected:
+  struct Decoder;
+protected:
+  Decoder *decoder;             // Decoder state
+  FXint    size;                // Reduce to no less than this size
+public:
+
+  /// Create JPEG reader, reducing to no less than sz pixels if sz>0
+  FXJPGReader(FXint sz=0);
+
+  /// Start reading JPEG image from stream
+  virtual FXbool start(FXStream& store);
+
+  /// Read up to n rows into buffer
+  virtual FXint read(FXColor* buffer,FXint n,FXint stride);
+
+  /// Finish reading JPEG image
+  virtual FXbool finish();
+
+  /// Destroy JPEG reader
+  virtual ~FXJPGReader();
+  };
+
+}
+
+#endif
@@ -61,6 +61,9 @@ public:
   /// Load pixels from stream in JPEG format
   virtual FXbool loadPixels(FXStream& store);
 
+  /// Load pixels from stream in JPEG format, reduced to no less than size
+  virtual FXbool loadScaledPixels(FXStream& store,FXint size);
+
   /// Destroy
   virtual ~FXJPGIcon();
   };
@@ -83,6 +86,15 @@ extern FXAPI FXbool fxcheckJPG(FXStream& store);
 extern FXAPI FXbool fxloadJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint& quality);
 
 
+/**
+* Load a JPEG file from a stream, decoded at 1/2, 1/4, or 1/8 of its size
+* where this leaves at least size pixels in its largest dimension.
+* Upon successful return, the pixel array and reduced size are returned.
+* If an error occurred, the pixel array is set to NULL.
+*/
+extern FXAPI FXbool fxloadScaledJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint& quality,FXint size);
+
+
 /**
 * Save an JPEG (Joint Photographics Experts Group) file to a stream.
 */
@@ -148,6 +148,9 @@ public:
 /// List item collate function
 typedef FXint (*FXListSortFunc)(const FXListItem*,const FXListItem*);
 
+/// List item sort key function
+typedef FXlong (*FXListSortKey)(const FXListItem*);
+
 
 /// List of FXListItem's
 typedef FXObjectListOf<FXListItem> FXListItemList;
@@ -183,6 +186,7 @@ protected:
   FXint          visible;           // Number of rows high
   FXString       help;              // Help text
   FXListSortFunc sortfunc;          // Item sort function
+  FXListSortKey  sortkey;           // Item sort key function
   FXint          grabx;             // Grab point x
   FXint          graby;             // Grab point y
   FXString       lookup;            // Lookup string
@@ -436,8 +440,16 @@ public:
   /// Return sort function
   FXListSortFunc getSortFunc() const { return sortfunc; }
 
-  /// Change sort function
-  void setSortFunc(FXListSortFunc func){ sortfunc=func; }
+  /**
+  * Change sort function, and optional sort key function.
+  * The key function should map items to keys ordered consistently
+  * with the sort function; the sort function is then only called
+  * to order items with equal keys.
+  */
+  void setSortFunc(FXListSortFunc func,FXListSortKey key=nullptr){ sortfunc=func; sortkey=key; }
+
+  /// Return sort key function
+  FXListSortKey getSortKey() const { return sortkey; }
 
   /// Change text font
   void setFont(FXFont* fnt);
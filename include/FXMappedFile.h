@@ -44,6 +44,16 @@ private:
   FXMappedFile &operator=(const FXMappedFile&);
 public:
 
+  /// Access pattern hints
+  enum {
+    Normal,             /// No special treatment
+    Sequential,         /// Pages will be accessed in order; read ahead aggressively
+    Random,             /// Pages will be accessed in random order; no read ahead
+    WillNeed,           /// Pages will be needed soon; start reading them in
+    DontNeed            /// Pages will not be needed soon
+    };
+public:
+
   /// Construct a memory map
   FXMappedFile();
 
@@ -68,6 +78,13 @@ public:
   /// Flush to disk
   virtual FXbool flush();
 
+  /**
+  * Advise the system how len bytes of the map, starting at offset off,
+  * will be accessed; if len is zero, advise about the rest of the map.
+  * This is only a hint, and returns false where not supported.
+  */
+  FXbool advise(FXuint hint,FXival off=0,FXival len=0);
+
   /// Close file, and also the map
   virtual FXbool close();
 
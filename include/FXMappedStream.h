@@ -0,0 +1,138 @@
+/********************************************************************************
+*                                                                               *
+*                M a p p e d   F i l e   S t r e a m   C l a s s                *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXMAPPEDSTREAM_H
+#define FXMAPPEDSTREAM_H
+
+#ifndef FXSTREAM_H
+#include "FXStream.h"
+#endif
+#ifndef FXMAPPEDFILE_H
+#include "FXMappedFile.h"
+#endif
+
+namespace FX {
+
+
+/**
+* Mapped file stream loads from a memory mapped file.
+* Data are copied straight from the mapping into the variables being loaded,
+* without going through an intermediate buffer, and the system is advised
+* to read the file ahead while it is being loaded, one window at a time.
+* Large arrays may be used in place, without copying them at all, by obtaining
+* a view of them; this is only possible if the array in the file is stored
+* in the native byte order, and properly aligned for its type.
+* Mapped file streams can only be used for loading.
+*/
+class FXAPI FXMappedStream : public FXStream {
+protected:
+  FXMappedFile file;            // Mapped file
+  FXuval       window;          // Read ahead window
+protected:
+  virtual FXuval writeBuffer(FXuval count);
+  virtual FXuval readBuffer(FXuval count);
+  FXbool viewBlock(const void*& p,FXuval n,FXuval size);
+private:
+  FXMappedStream(const FXMappedStream&);
+  FXMappedStream& operator=(const FXMappedStream&);
+public:
+
+  /// Create mapped file stream
+  FXMappedStream(const FXObject* cont=nullptr);
+
+  /// Create and open mapped file stream
+  FXMappedStream(const FXString& filename,FXuval win=4194304UL);
+
+  /**
+  * Open binary data file for loading, and map it into memory; the system is
+  * advised to read ahead at least win bytes beyond the data already loaded.
+  */
+  FXbool open(const FXString& filename,FXuval win=4194304UL);
+
+  /// Close mapped file stream
+  virtual FXbool close();
+
+  /// Return size of the file
+  FXlong size() const { return file.length(); }
+
+  /// Get position
+  FXlong position() const { return FXStream::position(); }
+
+  /// Move to position
+  virtual FXbool position(FXlong offset,FXWhence whence=FXFromStart);
+
+  /**
+  * Obtain a view of an array of n items at the current position, and move past
+  * it.  Returns false, without moving, if the items would have to be byte-swapped,
+  * or are not aligned properly in memory; the array must then be loaded instead.
+  * Returns false, setting the stream status, if the array runs past the end of
+  * the file.  The view stays valid until the stream is closed.
+  */
+  FXbool view(const FXuchar*& p,FXuval n){ return viewBlock(reinterpret_cast<const void*&>(p),n,1); }
+  FXbool view(const FXchar*& p,FXuval n){ return viewBlock(reinterpret_cast<const void*&>(p),n,1); }
+  FXbool view(const FXushort*& p,FXuval n){ return viewBlock(reinterpret_cast<const void*&>(p),n,2); }
+  FXbool view(const FXshort*& p,FXuval n){ return viewBlock(reinterpret_cast<const void*&>(p),n,2); }
+  FXbool view(const FXuint*& p,FXuval n){ return viewBlock(reinterpret_cast<const void*&>(p),n,4); }
+  FXbool view(const FXint*& p,FXuval n){ return viewBlock(reinterpret_cast<const void*&>(p),n,4); }
+  FXbool view(const FXfloat*& p,FXuval n){ return viewBlock(reinterpret_cast<const void*&>(p),n,4); }
+  FXbool view(const FXdouble*& p,FXuval n){ return viewBlock(reinterpret_cast<const void*&>(p),n,8); }
+  FXbool view(const FXlong*& p,FXuval n){ return viewBlock(reinterpret_cast<const void*&>(p),n,8); }
+  FXbool view(const FXulong*& p,FXuval n){ return viewBlock(reinterpret_cast<const void*&>(p),n,8); }
+
+  /// Load single items from stream
+  FXMappedStream& operator>>(FXuchar& v){ FXStream::operator>>(v); return *this; }
+  FXMappedStream& operator>>(FXchar& v){ FXStream::operator>>(v); return *this; }
+  FXMappedStream& operator>>(FXbool& v){ FXStream::operator>>(v); return *this; }
+  FXMappedStream& operator>>(FXushort& v){ FXStream::operator>>(v); return *this; }
+  FXMappedStream& operator>>(FXshort& v){ FXStream::operator>>(v); return *this; }
+  FXMappedStream& operator>>(FXuint& v){ FXStream::operator>>(v); return *this; }
+  FXMappedStream& operator>>(FXint& v){ FXStream::operator>>(v); return *this; }
+  FXMappedStream& operator>>(FXfloat& v){ FXStream::operator>>(v); return *this; }
+  FXMappedStream& operator>>(FXdouble& v){ FXStream::operator>>(v); return *this; }
+  FXMappedStream& operator>>(FXlong& v){ FXStream::operator>>(v); return *this; }
+  FXMappedStream& operator>>(FXulong& v){ FXStream::operator>>(v); return *this; }
+
+  /// Load arrays of items from stream
+  FXMappedStream& load(FXuchar* p,FXuval n){ FXStream::load(p,n); return *this; }
+  FXMappedStream& load(FXchar* p,FXuval n){ FXStream::load(p,n); return *this; }
+  FXMappedStream& load(FXbool* p,FXuval n){ FXStream::load(p,n); return *this; }
+  FXMappedStream& load(FXushort* p,FXuval n){ FXStream::load(p,n); return *this; }
+  FXMappedStream& load(FXshort* p,FXuval n){ FXStream::load(p,n); return *this; }
+  FXMappedStream& load(FXuint* p,FXuval n){ FXStream::load(p,n); return *this; }
+  FXMappedStream& load(FXint* p,FXuval n){ FXStream::load(p,n); return *this; }
+  FXMappedStream& load(FXfloat* p,FXuval n){ FXStream::load(p,n); return *this; }
+  FXMappedStream& load(FXdouble* p,FXuval n){ FXStream::load(p,n); return *this; }
+  FXMappedStream& load(FXlong* p,FXuval n){ FXStream::load(p,n); return *this; }
+  FXMappedStream& load(FXulong* p,FXuval n){ FXStream::load(p,n); return *this; }
+
+  /// Load object
+  FXMappedStream& loadObject(FXObject*& v){ FXStream::loadObject(v); return *this; }
+
+  /// Load object
+  template<class TYPE>
+  FXMappedStream& operator>>(TYPE*& obj){ return loadObject(reinterpret_cast<FXObject*&>(obj)); }
+
+  /// Destructor
+  virtual ~FXMappedStream();
+  };
+
+}
+
+#endif
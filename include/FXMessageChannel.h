@@ -47,17 +47,33 @@ class FXApp;
 * any message handler in the context of the main user-interface thread.
 * If the size of the optional data is zero, the message handler will be passed a
 * NULL pointer.
-* The maximum payload size passed with message() is 8192 bytes.
+* The maximum payload size passed with message() is 8192 bytes; larger payloads may
+* be handed off, without copying, with handoff().
+* Messages are kept in a lock-free ring buffer, and the main user-interface thread is
+* only awakened when it isn't already about to read the channel; each time, all pending
+* messages are dispatched, in the order they were sent.
+* Messages sent with coalesce() only deliver the latest of a burst: if a newer one with
+* the same target and selector is pending, the older one is dropped.
+* When the ring buffer is full, senders wait until the main user-interface thread has
+* caught up.
 */
 class FXAPI FXMessageChannel : public FXObject {
   FXDECLARE(FXMessageChannel)
 private:
   FXApp *app;
 protected:
-  FXInputHandle h[3];
-  FXMutex       m;
+  struct Slot;
+protected:
+  Slot           *slots;        // Ring buffer of messages
+  FXuint          mask;         // Ring buffer size less one
+  volatile FXuint wpos;         // Next slot to write
+  FXuint          rpos;         // Next slot to read
+  volatile FXint  signaled;     // Wakeup pending
+  FXInputHandle   h[2];         // Wakeup handles
 protected:
   FXMessageChannel();
+  FXbool post(FXObject* tgt,FXSelector msg,const void* data,FXint size,FXuchar* heap,FXuint flags);
+  void wakeup();
 private:
   FXMessageChannel(const FXMessageChannel&);
   FXMessageChannel& operator=(const FXMessageChannel&);
@@ -90,6 +106,21 @@ public:
   */
   FXbool message(FXObject* tgt,FXSelector msg,const void* data=nullptr,FXint size=0);
 
+  /**
+  * Send a message like message(), but if a message with the same target and selector,
+  * also sent with coalesce(), is still pending when this one is delivered, only this
+  * one is delivered.  Use this for progress updates and other messages where only
+  * the latest state matters.
+  */
+  FXbool coalesce(FXObject* tgt,FXSelector msg,const void* data=nullptr,FXint size=0);
+
+  /**
+  * Send a message msg to target tgt, handing off data of any size without copying it.
+  * The data must have been allocated with allocElms() or malloc(); the channel takes
+  * ownership, and frees it after the handler has been called.
+  */
+  FXbool handoff(FXObject* tgt,FXSelector msg,void* data,FXint size);
+
   /**
   * Clean up message channel.
   * Removes the message channel from FXApp's input watch set.
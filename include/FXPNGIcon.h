@@ -61,6 +61,9 @@ public:
   /// Load pixels from stream in PNG format
   virtual FXbool loadPixels(FXStream& store);
 
+  /// Load pixels from stream in PNG format, scaled to fit in size
+  virtual FXbool loadScaledPixels(FXStream& store,FXint size);
+
   /// Destroy
   virtual ~FXPNGIcon();
   };
@@ -43,7 +43,8 @@ enum {
   PNG_IMAGE_GRAY    = 32,       // Write only one grey channel (blue)
   PNG_IMAGE_OPAQUE  = 64,       // Write no alpha alpha channel
   PNG_IMAGE_ANALYZE = 128,      // Analyze image for opacity or alpha
-  PNG_INDEX_COLOR   = 256       // Try indexed (colormap) mode
+  PNG_INDEX_COLOR   = 256,      // Try indexed (colormap) mode
+  PNG_PARALLEL      = 512       // Filter and compress in parallel on thread pool
   };
 
 
@@ -81,6 +82,9 @@ public:
   /// Save pixels into stream in PNG format
   virtual FXbool loadPixels(FXStream& store);
 
+  /// Load pixels from stream in PNG format, scaled to fit in size
+  virtual FXbool loadScaledPixels(FXStream& store,FXint size);
+
   /// Destroy
   virtual ~FXPNGImage();
   };
@@ -101,6 +105,16 @@ extern FXAPI FXbool fxcheckPNG(FXStream& store);
 extern FXAPI FXbool fxloadPNG(FXStream& store,FXColor*& data,FXint& width,FXint& height);
 
 
+/**
+* Load a PNG file from a stream, scaled down to fit in size by size pixels,
+* keeping its aspect ratio, by averaging the pixels covered by each pixel of
+* the scaled image; only a few rows of the full size image are kept at once.
+* Upon successful return, the pixel array and reduced size are returned.
+* If an error occurred, the pixel array is set to NULL.
+*/
+extern FXAPI FXbool fxloadScaledPNG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint size);
+
+
 /**
 * Save an PNG (Portable Network Graphics) file to a stream.
 */
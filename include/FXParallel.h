@@ -342,6 +342,535 @@ void FXParallelFor(Index fm,Index to,Index by,const Functor& fun){
   FXParallelFor(FXThreadPool::instance(),fm,to,by,fun);
   }
 
+/*******************************************************************************/
+
+/**
+* FXParallelSplitFunctor is a helper for FXParallelForAdaptive.  It executes a part of
+* the index range which was split off by another thread, and signals the splitting
+* thread's completion counter when done.  It lives on the splitting thread's stack,
+* so no memory needs to be allocated.
+*/
+template <typename Functor,typename Index>
+class FXParallelSplitFunctor : public FXRunnable {
+  FXThreadPool  *pool;
+  FXCompletion&  completion;
+  const Functor& functor;
+  const Index    fm;
+  const Index    to;
+  const Index    by;
+  const Index    grain;
+private:
+  FXParallelSplitFunctor(const FXParallelSplitFunctor&);
+  FXParallelSplitFunctor &operator=(const FXParallelSplitFunctor&);
+public:
+  FXParallelSplitFunctor(FXThreadPool* p,FXCompletion& c,const Functor& fun,Index f,Index t,Index b,Index g):pool(p),completion(c),functor(fun),fm(f),to(t),by(b),grain(g){ }
+  virtual FXint run();
+  };
+
+
+/**
+* FXParallelTileFunctor is a helper for FXParallelForTiles.  It executes a block of
+* tiles which was split off by another thread, and signals the splitting thread's
+* completion counter when done.
+*/
+template <typename Functor,typename Index>
+class FXParallelTileFunctor : public FXRunnable {
+  FXThreadPool  *pool;
+  FXCompletion&  completion;
+  const Functor& functor;
+  const Index    xfm;
+  const Index    xto;
+  const Index    yfm;
+  const Index    yto;
+  const Index    xgrain;
+  const Index    ygrain;
+private:
+  FXParallelTileFunctor(const FXParallelTileFunctor&);
+  FXParallelTileFunctor &operator=(const FXParallelTileFunctor&);
+public:
+  FXParallelTileFunctor(FXThreadPool* p,FXCompletion& c,const Functor& fun,Index xf,Index xt,Index yf,Index yt,Index xg,Index yg):pool(p),completion(c),functor(fun),xfm(xf),xto(xt),yfm(yf),yto(yt),xgrain(xg),ygrain(yg){ }
+  virtual FXint run();
+  };
+
+
+/**
+* Return true if some of the thread pool's workers (already running or yet to be
+* started) are idle, so that splitting off more work will pay off.
+*/
+static inline FXbool FXParallelDemand(FXThreadPool* pool){
+  return pool->getRunningTasks()<pool->getMaximumThreads();
+  }
+
+
+/**
+* Perform parallel for-loop executing functor fun(x) for indexes x=fm+by*i, where x<to.
+* Unlike FXParallelFor, the range is not cut into pieces up front; instead, the calling
+* thread works through the range grain iterations at a time, and splits the remaining
+* range in half whenever the FXThreadPool has idle workers.  The split-off half is
+* processed the same way by another thread, so it may be split further in turn.
+* Thus, when iterations take unequal amounts of time, idle threads keep receiving
+* work until the entire range is done.  The range is never split into pieces smaller
+* than grain iterations.  No memory is allocated in the process.
+*/
+template <typename Functor,typename Index>
+void FXParallelForAdaptive(FXThreadPool* pool,Index fm,Index to,Index by,Index grain,const Functor& fun){
+  Index nits,ni;
+  if(grain<1) grain=1;
+  while(fm<to){
+    nits=1+(to-fm-1)/by;
+    if(grain<nits && FXParallelDemand(pool)){
+      FXCompletion completion;
+      Index mid=fm+(nits-nits/2)*by;
+      FXParallelSplitFunctor<Functor,Index> upper(pool,completion,fun,mid,to,by,grain);
+      completion.increment();
+      if(pool->execute(&upper,0)){
+        FXParallelForAdaptive(pool,fm,mid,by,grain,fun);
+        pool->waitFor(completion);
+        return;
+        }
+      completion.decrement();
+      }
+    for(ni=FXMIN(grain,nits); ni; --ni,fm+=by){
+      fun(fm);
+      }
+    }
+  }
+
+
+/**
+* Perform parallel for-loop executing functor fun(x) for indexes x=fm+by*i, where x<to,
+* splitting the range on demand but never into pieces of fewer than grain iterations.
+* The FXThreadPool associated with the calling thread is used.
+*/
+template <typename Functor,typename Index>
+void FXParallelForAdaptive(Index fm,Index to,Index by,Index grain,const Functor& fun){
+  FXParallelForAdaptive(FXThreadPool::instance(),fm,to,by,grain,fun);
+  }
+
+
+/**
+* Perform parallel loop over a two-dimensional block of indexes [xfm,xto) x [yfm,yto),
+* such as the pixels of an image, executing functor fun(xf,xt,yf,yt) for rectangular
+* tiles [xf,xt) x [yf,yt) covering the block.
+* Like FXParallelForAdaptive, the block is split in half along its longest dimension
+* (measured in grains) whenever the FXThreadPool has idle workers; tiles are never
+* smaller than xgrain by ygrain, except at the edges of the block.
+* When no idle workers are available, the calling thread processes strips of one grain
+* wide off of the block.  No memory is allocated in the process.
+*/
+template <typename Functor,typename Index>
+void FXParallelForTiles(FXThreadPool* pool,Index xfm,Index xto,Index yfm,Index yto,Index xgrain,Index ygrain,const Functor& fun){
+  Index nx,ny;
+  if(xgrain<1) xgrain=1;
+  if(ygrain<1) ygrain=1;
+  while(xfm<xto && yfm<yto){
+    nx=1+(xto-xfm-1)/xgrain;
+    ny=1+(yto-yfm-1)/ygrain;
+    if(1<FXMAX(nx,ny) && FXParallelDemand(pool)){
+      FXCompletion completion;
+      Index xmid=xfm+(nx-nx/2)*xgrain;
+      Index ymid=yfm+(ny-ny/2)*ygrain;
+      if(nx<ny){
+        FXParallelTileFunctor<Functor,Index> upper(pool,completion,fun,xfm,xto,ymid,yto,xgrain,ygrain);
+        completion.increment();
+        if(pool->execute(&upper,0)){
+          FXParallelForTiles(pool,xfm,xto,yfm,ymid,xgrain,ygrain,fun);
+          pool->waitFor(completion);
+          return;
+          }
+        completion.decrement();
+        }
+      else{
+        FXParallelTileFunctor<Functor,Index> upper(pool,completion,fun,xmid,xto,yfm,yto,xgrain,ygrain);
+        completion.increment();
+        if(pool->execute(&upper,0)){
+          FXParallelForTiles(pool,xfm,xmid,yfm,yto,xgrain,ygrain,fun);
+          pool->waitFor(completion);
+          return;
+          }
+        completion.decrement();
+        }
+      }
+    if(nx<ny){
+      Index yt=(ygrain<yto-yfm)?yfm+ygrain:yto;
+      fun(xfm,xto,yfm,yt);
+      yfm=yt;
+      }
+    else{
+      Index xt=(xgrain<xto-xfm)?xfm+xgrain:xto;
+      fun(xfm,xt,yfm,yto);
+      xfm=xt;
+      }
+    }
+  }
+
+
+/**
+* Perform parallel loop over a two-dimensional block of indexes [xfm,xto) x [yfm,yto),
+* executing functor fun(xf,xt,yf,yt) for tiles of at least xgrain by ygrain indexes.
+* The FXThreadPool associated with the calling thread is used.
+*/
+template <typename Functor,typename Index>
+void FXParallelForTiles(Index xfm,Index xto,Index yfm,Index yto,Index xgrain,Index ygrain,const Functor& fun){
+  FXParallelForTiles(FXThreadPool::instance(),xfm,xto,yfm,yto,xgrain,ygrain,fun);
+  }
+
+
+// Process split-off part of the range, then signal the splitting thread
+template <typename Functor,typename Index>
+FXint FXParallelSplitFunctor<Functor,Index>::run(){
+  FXParallelForAdaptive(pool,fm,to,by,grain,functor);
+  completion.decrement();
+  return 0;
+  }
+
+
+// Process split-off block of tiles, then signal the splitting thread
+template <typename Functor,typename Index>
+FXint FXParallelTileFunctor<Functor,Index>::run(){
+  FXParallelForTiles(pool,xfm,xto,yfm,yto,xgrain,ygrain,functor);
+  completion.decrement();
+  return 0;
+  }
+
+/*******************************************************************************/
+
+/**
+* FXParallelForkFunctor is a helper for FXParallelFork.  It executes a functor on a
+* thread provided by the FXThreadPool, and signals a completion counter when done.
+*/
+template <typename Functor>
+class FXParallelForkFunctor : public FXRunnable {
+  FXCompletion&  completion;
+  const Functor& functor;
+private:
+  FXParallelForkFunctor(const FXParallelForkFunctor&);
+  FXParallelForkFunctor &operator=(const FXParallelForkFunctor&);
+public:
+  FXParallelForkFunctor(FXCompletion& c,const Functor& fun):completion(c),functor(fun){ }
+  virtual FXint run(){ functor(); completion.decrement(); return 0; }
+  };
+
+
+/**
+* Call functors fun1 and fun2, in parallel if the FXThreadPool has idle workers, and
+* sequentially otherwise.  Return when both functors have completed.
+* This is the building block for the recursive algorithms below; no memory is
+* allocated in the process.
+*/
+template <typename Functor1,typename Functor2>
+void FXParallelFork(FXThreadPool* pool,const Functor1& fun1,const Functor2& fun2){
+  if(FXParallelDemand(pool)){
+    FXCompletion completion;
+    FXParallelForkFunctor<Functor2> task(completion,fun2);
+    completion.increment();
+    if(pool->execute(&task,0)){
+      fun1();
+      pool->waitFor(completion);
+      return;
+      }
+    completion.decrement();
+    }
+  fun1();
+  fun2();
+  }
+
+/*******************************************************************************/
+
+/**
+* FXParallelReduceCall is a helper for FXParallelReduce.  It reduces a subrange and
+* stores the result.
+*/
+template <typename Type,typename Index,typename Functor,typename Combine>
+class FXParallelReduceCall {
+  FXThreadPool  *pool;
+  Type          *result;
+  const Index    fm;
+  const Index    to;
+  const Index    grain;
+  const Type&    identity;
+  const Functor& functor;
+  const Combine& combine;
+public:
+  FXParallelReduceCall(FXThreadPool* p,Type* r,Index f,Index t,Index g,const Type& id,const Functor& fun,const Combine& com):pool(p),result(r),fm(f),to(t),grain(g),identity(id),functor(fun),combine(com){ }
+  void operator()() const;
+  };
+
+
+/**
+* Perform parallel reduction over the index range [fm,to), using the given FXThreadPool.
+* The functor fun(f,t) returns the reduction of subrange [f,t), and is called for pieces
+* of the range containing at most grain indexes; partial results are combined pairwise
+* with combine(a,b), in left-to-right order, starting from identity.
+* Thus, combine must be associative, but need not be commutative.
+* The range is split on demand, as in FXParallelForAdaptive; partial results are kept on
+* the stack of the thread computing them, so threads don't contend for shared counters.
+*/
+template <typename Type,typename Index,typename Functor,typename Combine>
+Type FXParallelReduce(FXThreadPool* pool,Index fm,Index to,Index grain,const Type& identity,const Functor& fun,const Combine& combine){
+  Type result=identity;
+  Index n,t;
+  if(grain<1) grain=1;
+  while(fm<to){
+    n=to-fm;
+    if(grain<n && FXParallelDemand(pool)){
+      Type lower(identity);
+      Type upper(identity);
+      Index mid=fm+(n-n/2);
+      FXParallelFork(pool,FXParallelReduceCall<Type,Index,Functor,Combine>(pool,&lower,fm,mid,grain,identity,fun,combine),FXParallelReduceCall<Type,Index,Functor,Combine>(pool,&upper,mid,to,grain,identity,fun,combine));
+      return combine(combine(result,lower),upper);
+      }
+    t=fm+FXMIN(grain,n);
+    result=combine(result,fun(fm,t));
+    fm=t;
+    }
+  return result;
+  }
+
+
+/**
+* Perform parallel reduction over the index range [fm,to), using the FXThreadPool
+* associated with the calling thread.
+*/
+template <typename Type,typename Index,typename Functor,typename Combine>
+Type FXParallelReduce(Index fm,Index to,Index grain,const Type& identity,const Functor& fun,const Combine& combine){
+  return FXParallelReduce(FXThreadPool::instance(),fm,to,grain,identity,fun,combine);
+  }
+
+
+// Reduce subrange
+template <typename Type,typename Index,typename Functor,typename Combine>
+void FXParallelReduceCall<Type,Index,Functor,Combine>::operator()() const {
+  *result=FXParallelReduce(pool,fm,to,grain,identity,functor,combine);
+  }
+
+/*******************************************************************************/
+
+/**
+* FXParallelScanBlock is a helper for FXParallelScan.  In the first pass, it computes
+* the total of each block; in the second pass, it scans each block starting from the
+* total of all preceding blocks.
+*/
+template <typename Type,typename Combine>
+class FXParallelScanBlock {
+  const Type    *src;
+  Type          *dst;
+  Type          *sums;
+  const FXival   num;
+  const FXival   nblocks;
+  const Combine& combine;
+  const FXbool   inclusive;
+  const FXbool   totals;
+public:
+  FXParallelScanBlock(const Type* s,Type* d,Type* t,FXival n,FXival nb,const Combine& com,FXbool inc,FXbool tot):src(s),dst(d),sums(t),num(n),nblocks(nb),combine(com),inclusive(inc),totals(tot){ }
+  void operator()(FXival b) const {
+    FXival fm=(num*b)/nblocks;
+    FXival to=(num*(b+1))/nblocks;
+    if(totals){
+      Type acc(src[fm]);
+      for(FXival i=fm+1; i<to; ++i){ acc=combine(acc,src[i]); }
+      sums[b+1]=acc;
+      }
+    else if(inclusive){
+      Type acc(sums[b]);
+      for(FXival i=fm; i<to; ++i){ acc=combine(acc,src[i]); dst[i]=acc; }
+      }
+    else{
+      Type acc(sums[b]);
+      for(FXival i=fm; i<to; ++i){ Type t(src[i]); dst[i]=acc; acc=combine(acc,t); }
+      }
+    }
+  };
+
+
+/**
+* Perform parallel prefix sum of n items in src, using the given FXThreadPool and the
+* associative combine(a,b) operation, leaving the result in dst.
+* With an inclusive scan, dst[i] = identity + src[0] + ... + src[i]; with an exclusive
+* scan, dst[i] = identity + src[0] + ... + src[i-1], where + stands for combine.
+* The items are cut into one block per thread; a first parallel pass computes the totals
+* of each block, and after adding up the totals, a second parallel pass scans each block.
+* The src and dst arrays may be the same, in which case the scan is performed in place.
+*/
+template <typename Type,typename Combine>
+void FXParallelScan(FXThreadPool* pool,const Type* src,Type* dst,FXival n,const Type& identity,const Combine& combine,FXbool inclusive=true){
+  if(0<n){
+    Type sums[FXParallelMax+1];
+    FXival nb=FXMIN(FXMIN(n,(FXival)pool->getMaximumThreads()),FXParallelMax-1);
+    sums[0]=identity;
+    if(1<nb){
+      FXParallelFor(pool,(FXival)0,nb,(FXival)1,nb,FXParallelScanBlock<Type,Combine>(src,dst,sums,n,nb,combine,inclusive,true));
+      for(FXival b=1; b<nb; ++b){ sums[b]=combine(sums[b-1],sums[b]); }
+      }
+    FXParallelFor(pool,(FXival)0,nb,(FXival)1,nb,FXParallelScanBlock<Type,Combine>(src,dst,sums,n,nb,combine,inclusive,false));
+    }
+  }
+
+
+/**
+* Perform parallel prefix sum of n items in src, leaving the result in dst, using the
+* FXThreadPool associated with the calling thread.
+*/
+template <typename Type,typename Combine>
+void FXParallelScan(const Type* src,Type* dst,FXival n,const Type& identity,const Combine& combine,FXbool inclusive=true){
+  FXParallelScan(FXThreadPool::instance(),src,dst,n,identity,combine,inclusive);
+  }
+
+/*******************************************************************************/
+
+/**
+* FXParallelSorter is a helper for FXParallelSort.  It implements a stable merge sort,
+* sorting both halves of the array in parallel, and merging the two sorted halves in
+* parallel by splitting the larger half at its middle, and locating the corresponding
+* split point in the other half by bisection.
+*/
+template <typename Type,typename Compare>
+class FXParallelSorter {
+public:
+  enum {
+    SORTCUTOFF=16,              // Below this size, use insertion sort
+    MERGECUTOFF=4096            // Below this size, merge serially
+    };
+public:
+  FXThreadPool  *pool;
+  const Compare& less;
+public:
+
+  // Sort call; sort a, leaving result in b if inb is set; otherwise in a
+  class SortCall {
+    const FXParallelSorter* sorter;
+    Type*  a;
+    Type*  b;
+    FXival n;
+    FXbool inb;
+  public:
+    SortCall(const FXParallelSorter* s,Type* x,Type* y,FXival num,FXbool iny):sorter(s),a(x),b(y),n(num),inb(iny){ }
+    void operator()() const { sorter->sort(a,b,n,inb); }
+    };
+
+  // Merge call; merge sorted runs l and r into out
+  class MergeCall {
+    const FXParallelSorter* sorter;
+    const Type* l;
+    const Type* r;
+    Type*  out;
+    FXival nl;
+    FXival nr;
+  public:
+    MergeCall(const FXParallelSorter* s,const Type* x,FXival nx,const Type* y,FXival ny,Type* o):sorter(s),l(x),r(y),out(o),nl(nx),nr(ny){ }
+    void operator()() const { sorter->merge(l,nl,r,nr,out); }
+    };
+
+public:
+
+  // Construct sorter
+  FXParallelSorter(FXThreadPool* p,const Compare& com):pool(p),less(com){ }
+
+  // Stable insertion sort of small array
+  void insertionsort(Type* a,FXival n) const {
+    for(FXival i=1,j; i<n; ++i){
+      Type t(a[i]);
+      for(j=i; 0<j && less(t,a[j-1]); --j){ a[j]=a[j-1]; }
+      a[j]=t;
+      }
+    }
+
+  // Sort a, using b as scratch; result ends up in b if inb is set
+  void sort(Type* a,Type* b,FXival n,FXbool inb) const {
+    if(n<=SORTCUTOFF){
+      insertionsort(a,n);
+      if(inb){ for(FXival i=0; i<n; ++i) b[i]=a[i]; }
+      return;
+      }
+    FXival h=n>>1;
+    FXParallelFork(pool,SortCall(this,a,b,h,!inb),SortCall(this,a+h,b+h,n-h,!inb));
+    if(inb){
+      merge(a,h,a+h,n-h,b);
+      }
+    else{
+      merge(b,h,b+h,n-h,a);
+      }
+    }
+
+  // Stable merge of sorted runs l and r into out
+  void merge(const Type* l,FXival nl,const Type* r,FXival nr,Type* out) const {
+    if(nl+nr<=MERGECUTOFF){
+      while(0<nl && 0<nr){
+        if(less(*r,*l)){ *out++=*r++; --nr; } else { *out++=*l++; --nl; }
+        }
+      while(0<nl){ *out++=*l++; --nl; }
+      while(0<nr){ *out++=*r++; --nr; }
+      return;
+      }
+    FXival m,j,lo,hi,mid;
+    if(nr<=nl){
+      m=nl>>1;
+      for(lo=0,hi=nr; lo<hi; ){         // First r[j] not less than l[m]
+        mid=(lo+hi)>>1;
+        if(less(r[mid],l[m])) lo=mid+1; else hi=mid;
+        }
+      j=lo;
+      out[m+j]=l[m];
+      FXParallelFork(pool,MergeCall(this,l,m,r,j,out),MergeCall(this,l+m+1,nl-m-1,r+j,nr-j,out+m+j+1));
+      }
+    else{
+      m=nr>>1;
+      for(lo=0,hi=nl; lo<hi; ){         // First l[j] greater than r[m]
+        mid=(lo+hi)>>1;
+        if(less(r[m],l[mid])) hi=mid; else lo=mid+1;
+        }
+      j=lo;
+      out[j+m]=r[m];
+      FXParallelFork(pool,MergeCall(this,l,j,r,m,out),MergeCall(this,l+j,nl-j,r+m+1,nr-m-1,out+j+m+1));
+      }
+    }
+  };
+
+
+/**
+* Perform parallel stable sort of n items, using the given FXThreadPool and comparison
+* functor less(a,b), which returns true if a should be ordered before b.
+* A scratch buffer of n items is allocated for the duration of the sort.
+*/
+template <typename Type,typename Compare>
+FXbool FXParallelSort(FXThreadPool* pool,Type* data,FXival n,const Compare& less){
+  if(1<n){
+    FXArray<Type> scratch;
+    if(!scratch.no(n)) return false;
+    FXParallelSorter<Type,Compare>(pool,less).sort(data,scratch.data(),n,false);
+    }
+  return true;
+  }
+
+
+/**
+* Perform parallel stable sort of n items, using the FXThreadPool associated with
+* the calling thread.
+*/
+template <typename Type,typename Compare>
+FXbool FXParallelSort(Type* data,FXival n,const Compare& less){
+  return FXParallelSort(FXThreadPool::instance(),data,n,less);
+  }
+
+
+/**
+* Perform parallel stable sort of array, using the given FXThreadPool.
+*/
+template <typename Type,typename Compare>
+FXbool FXParallelSort(FXThreadPool* pool,FXArray<Type>& array,const Compare& less){
+  return FXParallelSort(pool,array.data(),array.no(),less);
+  }
+
+
+/**
+* Perform parallel stable sort of array, using the FXThreadPool associated with
+* the calling thread.
+*/
+template <typename Type,typename Compare>
+FXbool FXParallelSort(FXArray<Type>& array,const Compare& less){
+  return FXParallelSort(FXThreadPool::instance(),array.data(),array.no(),less);
+  }
+
 }
 
 #endif
@@ -0,0 +1,107 @@
+/********************************************************************************
+*                                                                               *
+*                      I m a g e   R e s a m p l e r   C l a s s                *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXRESAMPLER_H
+#define FXRESAMPLER_H
+
+namespace FX {
+
+
+class FXThreadPool;
+
+
+/**
+* FXResampler scales images of 32-bit RGBA pixels from one size to another,
+* filtering them with a box, Mitchell, or Lanczos filter.
+* The weights of the filter are worked out once for each column and row of the
+* output, and kept for the next image of the same size.
+* Pixels are converted to linear light before filtering, and back again after,
+* using the given gamma; color is weighted by alpha, so that transparent pixels
+* do not bleed their color into their neighbors.
+* The output is divided into tiles, which are filtered in parallel on the
+* thread pool, if one is given; where available, SSE2 or AVX is used to filter
+* all four channels of a pixel at once.
+* Source and destination are buffers provided by the caller, each with its own
+* stride, so that parts of images may be scaled in place of whole images.
+* The same resampler may not be used by two threads at the same time.
+*/
+class FXAPI FXResampler {
+public:
+  enum {
+    Box,                /// Box filter, averaging the pixels covered
+    Mitchell,           /// Mitchell-Netravali cubic filter (B=C=1/3)
+    Lanczos             /// Lanczos windowed sinc filter with 3 lobes
+    };
+protected:
+  struct Weights;
+protected:
+  Weights      *xweights;       // Weights for each column of output
+  Weights      *yweights;       // Weights for each row of output
+  FXfloat      *decode;         // Pixel value to linear light
+  FXuchar      *encode;         // Square root of linear light to pixel value
+  FXThreadPool *pool;           // Thread pool, if any
+  FXuint        filter;         // Filter
+  FXfloat       gamma;          // Gamma
+protected:
+  FXbool weigh(Weights& wts,FXint src,FXint dst);
+private:
+  FXResampler(const FXResampler&);
+  FXResampler &operator=(const FXResampler&);
+public:
+
+  /**
+  * Create resampler with given filter and gamma, using the given thread pool;
+  * by default, the thread pool associated with the calling thread is used.
+  */
+  FXResampler(FXuint filt=Lanczos,FXfloat gam=2.2f,FXThreadPool* p=nullptr);
+
+  /// Change filter
+  void setFilter(FXuint filt);
+
+  /// Return filter
+  FXuint getFilter() const { return filter; }
+
+  /// Change gamma; a gamma of 1 filters pixel values as they are
+  void setGamma(FXfloat gam);
+
+  /// Return gamma
+  FXfloat getGamma() const { return gamma; }
+
+  /// Change thread pool; if null, scale on the calling thread only
+  void setThreadPool(FXThreadPool* p){ pool=p; }
+
+  /// Return thread pool
+  FXThreadPool* getThreadPool() const { return pool; }
+
+  /**
+  * Scale source image of sw by sh pixels to destination image of dw by dh pixels.
+  * Rows of source and destination are sstride and dstride pixels apart; the
+  * buffers may not overlap.
+  * Return false if a size is less than 1, or if out of memory.
+  */
+  FXbool scale(FXColor* dst,FXint dw,FXint dh,FXint dstride,const FXColor* src,FXint sw,FXint sh,FXint sstride);
+
+  /// Destroy resampler
+  virtual ~FXResampler();
+  };
+
+}
+
+#endif
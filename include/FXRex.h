@@ -59,14 +59,22 @@ namespace FX {
 * causes the begin and end of the subject string NOT to be considered a line start or
 * line end.
 *
-* Patterns which cause inordinate amounts of recursion may cause FXRex to fail where
-* otherwise it would succeed to match.
+* Patterns which do not use back references, look-arounds, atomic groups, possessive
+* repeats, or counted repeats of groups, are also translated for a Pike VM matcher, which
+* takes time linear in the length of the subject string.  The faster backtracking matcher
+* is tried first, but when it takes too long, or recurses too deep, the match is done over
+* with the Pike VM.  Passing the match flag Backtrack uses the backtracking matcher only,
+* and passing Linear uses the Pike VM right away, if the pattern allows it.
+* Patterns which can only be matched by backtracking, and cause inordinate amounts of
+* recursion, may cause FXRex to fail where otherwise it would succeed to match.
 * FXRex uses no global variables, and thus multiple threads may simultaneously use it;
 * moreover, multiple threads may use the same instance to perform a match.
 */
 class FXAPI FXRex {
 private:
   FXString code;
+  FXString scan;
+  FXString nfa;
 private:
   static const FXchar *const errors[];
 public:
@@ -91,7 +99,9 @@ public:
 
     /// Regular expression match flags
     NotBol     = 1024,  /// Start of string is NOT begin of line
-    NotEol     = 2048   /// End of string is NOT end of line
+    NotEol     = 2048,  /// End of string is NOT end of line
+    Backtrack  = 4096,  /// Match with backtracking matcher only
+    Linear     = 8192   /// Match in linear time, if the pattern allows
     };
 
   /// Regular expression error codes
@@ -25,6 +25,87 @@ namespace FX {
 
 
 class FXThreadPool;
+class FXTaskGroup;
+
+
+/**
+* An FXTaskNode is a task which may depend on other tasks; together, the task nodes
+* form a task graph whose tasks are executed by an FXTaskGroup.
+* Each task node wraps an FXRunnable, which will not be run until all of the node's
+* predecessors have completed.  Dependencies are added by calling after() for each
+* predecessor, before the task node itself is scheduled; a predecessor may already be
+* scheduled, or running, or even done at that time.
+* A task node is not entered into the thread pool's queue until it is both scheduled
+* and its last predecessor has completed; thus, no thread is ever parked waiting for a
+* dependency; instead, the thread completing the last predecessor enters the node into
+* the thread pool's queue.
+* A task node without a runnable performs no work of its own, and may serve as a join
+* point, completing when all of its predecessors have completed.
+* Cancelling a task node prevents its runnable from being started; the cancellation is
+* passed on to the node's successors.  Likewise, if the runnable raises an exception,
+* the node's successors will be cancelled.
+* A task node which can not be entered into the thread pool's queue, because the
+* thread pool is not running, is cancelled as well.
+* Every task node in the graph must eventually be scheduled, lest its successors never
+* run.  The task node must stay alive until it has completed; the FXTaskGroup's wait()
+* can be used to ensure this.
+*/
+class FXAPI FXTaskNode : public FXRunnable {
+  friend class FXTaskGroup;
+private:
+  FXTaskGroup             *taskgroup;   // Task group executing the node
+  FXRunnable              *runnable;    // Wrapped runnable
+  FXPtrListOf<FXTaskNode>  successors;  // Nodes waiting for this one
+  FXSpinLock               spinlock;    // Guards successor list
+  volatile FXint           pending;     // Pending predecessors, plus one until scheduled
+  volatile FXuint          state;       // Progress of the node
+  volatile FXbool          cancelled;   // Node was cancelled
+private:
+  void release();
+  void finish();
+private:
+  FXTaskNode(const FXTaskNode&);
+  FXTaskNode &operator=(const FXTaskNode&);
+public:
+
+  /// Create task node wrapping the given runnable
+  FXTaskNode(FXRunnable* task=nullptr);
+
+  /// Change runnable if not scheduled yet
+  void setRunnable(FXRunnable* task){ runnable=task; }
+
+  /// Return runnable
+  FXRunnable* getRunnable() const { return runnable; }
+
+  /**
+  * Make this task node wait for completion of task node pred.
+  * Must be called before this task node is scheduled.
+  */
+  FXbool after(FXTaskNode* pred);
+
+  /**
+  * Make this task node wait for completion of all n task nodes in preds.
+  */
+  FXbool after(FXTaskNode* const* preds,FXuint n);
+
+  /// Cancel the task node, unless it already started
+  void cancel(){ cancelled=true; }
+
+  /// Return true if the task node was cancelled
+  FXbool isCancelled() const { return cancelled; }
+
+  /// Return true if the task node has been scheduled
+  FXbool isScheduled() const { return 0<state; }
+
+  /// Return true if the task node has completed
+  FXbool isDone() const { return state==2; }
+
+  /// Execute the task node; called by the thread pool
+  virtual FXint run();
+
+  /// Destroy task node
+  virtual ~FXTaskNode();
+  };
 
 
 /**
@@ -44,8 +125,14 @@ class FXThreadPool;
 * or when the task-queue is empty (in this case another thread may still be working on
 * a task from the FXTaskGroup). Thus, the calling thread should block on the completion
 * semaphore to ensure all tasks are completed.
+* Besides independent tasks, the FXTaskGroup can execute a graph of FXTaskNodes, each
+* of which is started only when the task nodes it depends on have completed.
+* An FXTaskGroup may be cancelled; any of its tasks that have not started running by
+* that time will be skipped.  Tasks that are already running may poll isCancelled() to
+* finish early.
 */
 class FXAPI FXTaskGroup {
+  friend class FXTaskNode;
 private:
   class Task : public FXRunnable {
   private:
@@ -60,8 +147,9 @@ private:
     virtual ~Task();
     };
 private:
-  FXThreadPool *threadpool;     // Thread pool used by task group
-  FXCompletion  completion;     // Completion counter
+  FXThreadPool    *threadpool;  // Thread pool used by task group
+  FXCompletion     completion;  // Completion counter
+  volatile FXbool  cancelled;   // Group was cancelled
 private:
   FXTaskGroup(const FXTaskGroup&);
   FXTaskGroup &operator=(const FXTaskGroup&);
@@ -93,6 +181,13 @@ public:
   */
   FXbool execute(FXRunnable* task);
 
+  /**
+  * Schedule task node in this task group.  The task node will be started
+  * as soon as all of its predecessors have completed; if it has none, it
+  * is started right away.
+  */
+  FXbool schedule(FXTaskNode* node);
+
   /**
   * Start task in this task group, and then enter the task-processing
   * loop, returning when all tasks have been completed.
@@ -107,6 +202,17 @@ public:
   */
   FXbool wait();
 
+  /**
+  * Cancel the task group, or clear the cancellation.  Tasks which have not
+  * yet started when the task group is cancelled will not be run.
+  */
+  void setCancelled(FXbool flag){ cancelled=flag; }
+
+  /**
+  * Return true if the task group was cancelled.
+  */
+  FXbool isCancelled() const { return cancelled; }
+
   /**
   * Wait for the semaphore to be signaled, then destroy the task group.
   */
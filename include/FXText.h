@@ -154,6 +154,8 @@ struct FXTextSelection {
 */
 class FXAPI FXText : public FXScrollArea {
   FXDECLARE(FXText)
+protected:
+  struct LineBlock;
 protected:
   FXchar         *buffer;               // Text buffer being edited
   FXchar         *sbuffer;              // Text style buffer
@@ -213,6 +215,9 @@ protected:
   FXint           graby;                // Grab point y
   FXuchar         mode;                 // Mode widget is in
   FXbool          modified;             // User has modified text
+  LineBlock      *blocks;               // Blocks of whole lines
+  LineBlock      *blocksums;            // Partial sums over line blocks
+  FXint           nblocks;              // Number of line blocks
 protected:
   FXText();
   void movegap(FXint pos);
@@ -227,6 +232,17 @@ protected:
   FXint columnFromPos(FXint start,FXint pos) const;
   FXint posFromColumn(FXint start,FXint col) const;
   FXint indentOfLine(FXint start,FXint pos) const;
+  FXint findNewline(FXint pos,FXint end) const;
+  FXint countNewlines(FXint start,FXint end) const;
+  FXint findBlock(FXint LineBlock::* field,FXint value,LineBlock& before) const;
+  FXint blockOfPos(FXint pos,LineBlock& before) const;
+  FXint linesBefore(FXint pos) const;
+  FXint posOfLine(FXint line) const;
+  FXint rowsBefore(FXint pos) const;
+  FXint posOfRow(FXint row) const;
+  void sumBlocks();
+  void makeBlocks(FXint b,FXint n,FXint start,FXint end);
+  void changeBlocks(FXint pos,FXint del,FXint ins,FXint nldelta,FXint nrdelta);
   FXbool isdelimiter(FXwchar w) const;
   FXint measureText(FXint start,FXint end,FXint& wmax,FXint& hmax) const;
   void calcVisRows(FXint s,FXint e);
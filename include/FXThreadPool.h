@@ -64,10 +64,19 @@ typedef FXLFQueueOf<FXRunnable> FXTaskQueue;
 * In addition, each worker will similarly be associated with the thread pool.
 * Thus both the main thread as well as the worker threads can easily find the thread
 * pool through the member-function instance().
+* When work-stealing is enabled, each worker thread owns a private task deque; tasks
+* which are started from inside a worker thread are pushed onto that worker's deque,
+* and only tasks submitted from outside the thread pool are entered into the shared
+* task queue.  Worker threads run their own tasks first, most recently added first;
+* when they run out of work, they take tasks from the shared queue or steal the oldest
+* tasks from other worker threads' deques.
 */
 class FXAPI FXThreadPool : public FXRunnable {
+private:
+  struct Deque;
 private:
   FXTaskQueue     queue;        // Task queue
+  Deque          *deques;       // Per-worker task deques
   FXCompletion    tasks;        // Active tasks
   FXCompletion    threads;      // Active threads
   FXSemaphore     freeslots;    // Free slots in queue
@@ -78,10 +87,16 @@ private:
   volatile FXuint minimum;      // Minimum threads
   volatile FXuint workers;      // Working threads
   volatile FXuint running;      // Context is running
+  volatile FXuint ndeques;      // Number of per-worker deques
+  FXbool          stealing;     // Work-stealing enabled
 private:
   static FXAutoThreadStorageKey reference;
+  static FXAutoThreadStorageKey owndeque;
 private:
   FXbool startWorker();
+  Deque* claimDeque();
+  void releaseDeque(Deque* deque);
+  FXbool nextTask(FXRunnable*& task,FXTime timeout);
   void runWhile(FXCompletion& comp,FXTime timeout);
   virtual FXint run();
 private:
@@ -133,6 +148,17 @@ public:
   /// Get stack size
   FXuval getStackSize() const { return stacksize; }
 
+  /**
+  * Enable or disable work-stealing mode.
+  * In work-stealing mode, tasks started from a worker thread are kept on that
+  * worker's private deque, and idle workers steal tasks from each other.
+  * Can only be changed while the thread pool is not running.
+  */
+  FXbool setWorkStealing(FXbool flag);
+
+  /// Return true if work-stealing mode is enabled
+  FXbool getWorkStealing() const { return stealing; }
+
   /// Return calling thread's thread pool
   static FXThreadPool* instance();
 
@@ -155,6 +181,9 @@ public:
   * Return false if the task could not be added within the given time interval.
   * Possibly starts additional worker threads if the maximum number of worker
   * threads has not yet been exceeded.
+  * In work-stealing mode, a task started from one of the worker threads is pushed
+  * onto the worker's own deque instead, and the call does not block unless that
+  * deque is full.
   */
   FXbool execute(FXRunnable* task,FXTime blocking=forever);
 
@@ -0,0 +1,458 @@
+/********************************************************************************
+*                                                                               *
+*                    V i r t u a l   T a b l e   W i d g e t                    *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXVIRTUALTABLE_H
+#define FXVIRTUALTABLE_H
+
+#ifndef FXTABLE_H
+#include "FXTable.h"
+#endif
+
+namespace FX {
+
+class FXIcon;
+class FXFont;
+class FXHeader;
+class FXVirtualTable;
+
+
+/**
+* A table provider supplies the contents of the cells of a virtual table.
+* The table only asks for the cells it needs to draw, and caches them until
+* they are scrolled out of view, or until the table is told the rows have
+* changed.
+* The cell style is a combination of the FXTableItem justification, icon
+* position, border, and stipple flags; the default is FXTableItem::RIGHT.
+*/
+class FXAPI FXTableProvider {
+public:
+
+  /// Return text of cell at row, column
+  virtual FXString getCellText(FXint row,FXint col) const = 0;
+
+  /// Return icon of cell at row, column; the provider owns the icon
+  virtual FXIcon* getCellIcon(FXint row,FXint col) const;
+
+  /// Return style of cell at row, column
+  virtual FXuint getCellStyle(FXint row,FXint col) const;
+
+  /// Return label of row; default is the row number, counting from 1
+  virtual FXString getRowLabel(FXint row) const;
+
+  /// Destructor
+  virtual ~FXTableProvider();
+  };
+
+
+/**
+* The Virtual Table widget displays a table whose cells are supplied on demand
+* by an FXTableProvider, rather than being stored in the widget.  Only the cells
+* of visible rows are requested, and these are cached for a window of rows
+* around the visible part of the table.  Thus, memory use and drawing time don't
+* depend on the number of rows, and tables of hundreds of millions of rows can
+* be scrolled smoothly.
+* All rows have the same height; columns have individual widths, and may be
+* resized using the column header if TABLE_COL_SIZABLE is passed.  A row label
+* area is shown on the left if its width is set to a non-zero value.
+* When the provider's data changes, the table is notified by rowsInserted(),
+* rowsRemoved(), rowsMoved(), or rowsChanged(); these only adjust the current
+* position and selection, and discard cached rows, so their cost does not
+* depend on the number of rows.
+* When the current cell changes, the table sends a SEL_CHANGED message to its
+* target with a pointer to the FXTablePos of the new current cell.  Mouse
+* clicks generate SEL_CLICKED, SEL_DOUBLECLICKED, or SEL_TRIPLECLICKED, and
+* SEL_COMMAND, each with the FXTablePos of the current cell.  Changing the
+* selection sends SEL_SELECTED with a pointer to the selected FXTableRange,
+* or SEL_DESELECTED when the selection is cleared.
+* Cells can not be edited in place; the application is expected to modify
+* its data, and call rowsChanged().
+*/
+class FXAPI FXVirtualTable : public FXScrollArea {
+  FXDECLARE(FXVirtualTable)
+protected:
+  struct Cell;
+protected:
+  FXHeader        *colHeader;           // Column header
+  FXTableProvider *provider;            // Provider of cells
+  Cell            *cells;               // Cached cells, ncols+1 per cached row
+  FXint           *cachedrows;          // Row held by each cache slot, or -1
+  FXint            cachesize;           // Number of rows in cache
+  FXlong           offset;              // Vertical scroll offset in pixels
+  FXFont          *font;                // Font
+  FXint            nrows;               // Number of rows
+  FXint            ncols;               // Number of columns
+  FXint            rowHeight;           // Row height
+  FXint            rowLabelWidth;       // Width of row label area
+  FXint            visiblerows;         // Visible rows
+  FXint            visiblecols;         // Visible columns
+  FXint            margintop;           // Margin top
+  FXint            marginbottom;        // Margin bottom
+  FXint            marginleft;          // Margin left
+  FXint            marginright;         // Margin right
+  FXColor          textColor;           // Normal text color
+  FXColor          baseColor;           // Base color
+  FXColor          hiliteColor;         // Highlight color
+  FXColor          shadowColor;         // Shadow color
+  FXColor          selbackColor;        // Select background color
+  FXColor          seltextColor;        // Select text color
+  FXColor          gridColor;           // Grid line color
+  FXColor          stippleColor;        // Stipple color
+  FXColor          cellBorderColor;     // Cell border color
+  FXint            cellBorderWidth;     // Cell border width
+  FXColor          cellBackColor[2][2]; // Row/Column even/odd background color
+  FXTablePos       current;             // Current position
+  FXTablePos       anchor;              // Anchor position
+  FXTableRange     selection;           // Range of selected cells
+  FXString         help;                // Help text
+  FXbool           hgrid;               // Horizontal grid lines shown
+  FXbool           vgrid;               // Vertical grid lines shown
+  FXuchar          mode;                // Mode widget is in
+  FXint            grabx;               // Grab point x
+  FXint            graby;               // Grab point y
+protected:
+  FXVirtualTable();
+  FXlong getTotalHeight() const;
+  FXlong positionToOffset(FXint y) const;
+  FXint offsetToPosition(FXlong off) const;
+  void scrollRows(FXint dx,FXint dy) const;
+  const Cell* getCachedRow(FXint row);
+  void resizeCache(FXint size);
+  void flushRows(FXint fr,FXint lr);
+  void updateRows(FXint fr,FXint lr) const;
+  void drawCell(FXDC& dc,const Cell& cell,FXint row,FXint col,FXint x,FXint y,FXint w,FXint h);
+  void drawRowLabel(FXDC& dc,const Cell& cell,FXint y,FXint h);
+  void moveTo(FXint row,FXint col,FXuint state);
+  enum {
+    MOUSE_NONE,         // Nop
+    MOUSE_SCROLL,       // Scrolling
+    MOUSE_SELECT        // Selecting
+    };
+private:
+  FXVirtualTable(const FXVirtualTable&);
+  FXVirtualTable& operator=(const FXVirtualTable&);
+public:
+  long onPaint(FXObject*,FXSelector,void*);
+  long onFocusIn(FXObject*,FXSelector,void*);
+  long onFocusOut(FXObject*,FXSelector,void*);
+  long onMotion(FXObject*,FXSelector,void*);
+  long onKeyPress(FXObject*,FXSelector,void*);
+  long onKeyRelease(FXObject*,FXSelector,void*);
+  long onLeftBtnPress(FXObject*,FXSelector,void*);
+  long onLeftBtnRelease(FXObject*,FXSelector,void*);
+  long onRightBtnPress(FXObject*,FXSelector,void*);
+  long onRightBtnRelease(FXObject*,FXSelector,void*);
+  long onUngrabbed(FXObject*,FXSelector,void*);
+  long onAutoScroll(FXObject*,FXSelector,void*);
+  long onQueryHelp(FXObject*,FXSelector,void*);
+  long onCommand(FXObject*,FXSelector,void*);
+  long onClicked(FXObject*,FXSelector,void*);
+  long onDoubleClicked(FXObject*,FXSelector,void*);
+  long onTripleClicked(FXObject*,FXSelector,void*);
+  long onCmdSelectColumnIndex(FXObject*,FXSelector,void*);
+  long onCmdSelectAll(FXObject*,FXSelector,void*);
+  long onCmdDeselectAll(FXObject*,FXSelector,void*);
+public:
+  enum {
+    ID_SELECT_COLUMN_INDEX=FXScrollArea::ID_LAST,
+    ID_SELECT_ALL,
+    ID_DESELECT_ALL,
+    ID_LAST
+    };
+public:
+
+  /**
+  * Construct a new virtual table.
+  * The table is initially empty, and has no provider.
+  */
+  FXVirtualTable(FXComposite *p,FXObject* tgt=nullptr,FXSelector sel=0,FXuint opts=0,FXint x=0,FXint y=0,FXint w=0,FXint h=0,FXint pl=DEFAULT_MARGIN,FXint pr=DEFAULT_MARGIN,FXint pt=DEFAULT_MARGIN,FXint pb=DEFAULT_MARGIN);
+
+  /// Create the server-side resources
+  virtual void create();
+
+  /// Detach the server-side resources
+  virtual void detach();
+
+  /// Return default width
+  virtual FXint getDefaultWidth();
+
+  /// Return default height
+  virtual FXint getDefaultHeight();
+
+  /// Return visible scroll-area x position
+  virtual FXint getVisibleX() const;
+
+  /// Return visible scroll-area y position
+  virtual FXint getVisibleY() const;
+
+  /// Return visible scroll-area width
+  virtual FXint getVisibleWidth() const;
+
+  /// Return visible scroll-area height
+  virtual FXint getVisibleHeight() const;
+
+  /// Return content width
+  virtual FXint getContentWidth();
+
+  /// Return content height
+  virtual FXint getContentHeight();
+
+  /// Move contents to the specified position
+  virtual void moveContents(FXint x,FXint y);
+
+  /// Perform layout
+  virtual void layout();
+
+  /// Mark this window's layout as dirty
+  virtual void recalc();
+
+  /// Table widget can receive focus
+  virtual FXbool canFocus() const;
+
+  /// Move the focus to this window
+  virtual void setFocus();
+
+  /// Remove the focus from this window
+  virtual void killFocus();
+
+  /// Return column header control
+  FXHeader* getColumnHeader() const { return colHeader; }
+
+  /// Change provider of cells; the provider is not owned by the table
+  void setProvider(FXTableProvider* prov);
+
+  /// Return provider of cells
+  FXTableProvider* getProvider() const { return provider; }
+
+  /// Change the number of rows
+  void setNumRows(FXint rows,FXbool notify=false);
+
+  /// Return the number of rows
+  FXint getNumRows() const { return nrows; }
+
+  /// Change the number of columns; new columns get default width
+  void setNumColumns(FXint cols,FXbool notify=false);
+
+  /// Return the number of columns
+  FXint getNumColumns() const { return ncols; }
+
+  /// Notify table that rows were inserted by the provider
+  void rowsInserted(FXint row,FXint count=1,FXbool notify=false);
+
+  /// Notify table that rows were removed by the provider
+  void rowsRemoved(FXint row,FXint count=1,FXbool notify=false);
+
+  /// Notify table that count rows were moved from row to before row to
+  void rowsMoved(FXint from,FXint to,FXint count=1,FXbool notify=false);
+
+  /// Notify table that the contents of rows have changed, including reordering
+  void rowsChanged(FXint row,FXint count=1);
+
+  /// Notify table that all contents have changed
+  void contentsChanged();
+
+  /// Change column caption
+  void setColumnText(FXint col,const FXString& text);
+
+  /// Return column caption
+  FXString getColumnText(FXint col) const;
+
+  /// Change column width
+  void setColumnWidth(FXint col,FXint cwidth);
+
+  /// Return column width
+  FXint getColumnWidth(FXint col) const;
+
+  /// Return window x-coordinate of column
+  FXint getColumnX(FXint col) const;
+
+  /// Change height of all rows
+  void setRowHeight(FXint rheight);
+
+  /// Return height of all rows
+  FXint getRowHeight() const { return rowHeight; }
+
+  /// Change width of row label area; zero hides the row labels
+  void setRowLabelWidth(FXint lwidth);
+
+  /// Return width of row label area
+  FXint getRowLabelWidth() const { return rowLabelWidth; }
+
+  /// Change number of visible rows, for the default height
+  void setVisibleRows(FXint nvrows);
+
+  /// Return number of visible rows
+  FXint getVisibleRows() const { return visiblerows; }
+
+  /// Change number of visible columns, for the default width
+  void setVisibleColumns(FXint nvcols);
+
+  /// Return number of visible columns
+  FXint getVisibleColumns() const { return visiblecols; }
+
+  /// Change vertical scroll offset, in pixels from the top of the first row
+  void setScrollOffset(FXlong off);
+
+  /// Return vertical scroll offset, in pixels from the top of the first row
+  FXlong getScrollOffset() const { return offset; }
+
+  /// Return window y-coordinate of row, which may be outside the window
+  FXlong getRowY(FXint row) const;
+
+  /// Return the row at window y-coordinate; -1 above the first row, or number of rows below the last
+  FXint rowAtY(FXint y) const;
+
+  /// Return the column at window x-coordinate; -1 left of the first column, or number of columns right of the last
+  FXint colAtX(FXint x) const;
+
+  /// Return true if cell (partially) visible
+  FXbool isItemVisible(FXint row,FXint col) const;
+
+  /// Scroll to make cell at row, column fully visible
+  void makePositionVisible(FXint row,FXint col);
+
+  /// Repaint cell at row, column
+  void updateItem(FXint row,FXint col) const;
+
+  /// Change current cell
+  void setCurrentItem(FXint row,FXint col,FXbool notify=false);
+
+  /// Return row of current cell
+  FXint getCurrentRow() const { return current.row; }
+
+  /// Return column of current cell
+  FXint getCurrentColumn() const { return current.col; }
+
+  /// Change anchor cell
+  void setAnchorItem(FXint row,FXint col);
+
+  /// Return row of anchor cell
+  FXint getAnchorRow() const { return anchor.row; }
+
+  /// Return column of anchor cell
+  FXint getAnchorColumn() const { return anchor.col; }
+
+  /// Select range of cells
+  FXbool selectRange(FXint startrow,FXint endrow,FXint startcol,FXint endcol,FXbool notify=false);
+
+  /// Select rows
+  FXbool selectRows(FXint startrow,FXint endrow,FXbool notify=false);
+
+  /// Extend selection from anchor to row, column
+  FXbool extendSelection(FXint row,FXint col,FXbool notify=false);
+
+  /// Kill selection
+  FXbool killSelection(FXbool notify=false);
+
+  /// Return true if cell is selected
+  FXbool isItemSelected(FXint row,FXint col) const;
+
+  /// Return true if anything is selected
+  FXbool isAnythingSelected() const;
+
+  /// Return selected range; false if nothing selected
+  FXbool getSelection(FXTableRange& range) const;
+
+  /// Change table style
+  void setTableStyle(FXuint style);
+
+  /// Return table style
+  FXuint getTableStyle() const;
+
+  /// Change text font
+  void setFont(FXFont* fnt);
+
+  /// Return text font
+  FXFont* getFont() const { return font; }
+
+  /// Change cell margins
+  void setMarginTop(FXint pt);
+  FXint getMarginTop() const { return margintop; }
+  void setMarginBottom(FXint pb);
+  FXint getMarginBottom() const { return marginbottom; }
+  void setMarginLeft(FXint pl);
+  FXint getMarginLeft() const { return marginleft; }
+  void setMarginRight(FXint pr);
+  FXint getMarginRight() const { return marginright; }
+
+  /// Show or hide horizontal grid
+  void showHorzGrid(FXbool on=true);
+
+  /// Is horizontal grid shown
+  FXbool isHorzGridShown() const { return hgrid; }
+
+  /// Show or hide vertical grid
+  void showVertGrid(FXbool on=true);
+
+  /// Is vertical grid shown
+  FXbool isVertGridShown() const { return vgrid; }
+
+  /// Change colors
+  void setTextColor(FXColor clr);
+  void setBaseColor(FXColor clr);
+  void setHiliteColor(FXColor clr);
+  void setShadowColor(FXColor clr);
+  void setSelBackColor(FXColor clr);
+  void setSelTextColor(FXColor clr);
+  void setGridColor(FXColor clr);
+  void setStippleColor(FXColor clr);
+  void setCellBorderColor(FXColor clr);
+
+  /// Return colors
+  FXColor getTextColor() const { return textColor; }
+  FXColor getBaseColor() const { return baseColor; }
+  FXColor getHiliteColor() const { return hiliteColor; }
+  FXColor getShadowColor() const { return shadowColor; }
+  FXColor getSelBackColor() const { return selbackColor; }
+  FXColor getSelTextColor() const { return seltextColor; }
+  FXColor getGridColor() const { return gridColor; }
+  FXColor getStippleColor() const { return stippleColor; }
+  FXColor getCellBorderColor() const { return cellBorderColor; }
+
+  /// Change cell background color for even/odd rows/columns
+  void setCellColor(FXint row,FXint col,FXColor clr);
+
+  /// Obtain cell background color for even/odd rows/columns
+  FXColor getCellColor(FXint row,FXint col) const;
+
+  /// Change cell border width
+  void setCellBorderWidth(FXint borderwidth);
+
+  /// Return cell border width
+  FXint getCellBorderWidth() const { return cellBorderWidth; }
+
+  /// Set the status line help text for this table
+  void setHelpText(const FXString& text){ help=text; }
+
+  /// Get the status line help text for this table
+  const FXString& getHelpText() const { return help; }
+
+  /// Save table to a stream
+  virtual void save(FXStream& store) const;
+
+  /// Load table from a stream
+  virtual void load(FXStream& store);
+
+  /// Destructor
+  virtual ~FXVirtualTable();
+  };
+
+}
+
+#endif
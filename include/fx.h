@@ -92,6 +92,7 @@
 #include "FXMappedFile.h"
 #include "FXFileStream.h"
 #include "FXMemoryStream.h"
+#include "FXMappedStream.h"
 #include "FXProcess.h"
 #include "FXString.h"
 #include "FXVariant.h"
@@ -147,6 +148,7 @@
 #include "FXEventDispatcher.h"
 #include "FXDrawable.h"
 #include "FXBitmap.h"
+#include "FXResampler.h"
 #include "FXImage.h"
 #include "FXIcon.h"
 #include "FXWindow.h"
@@ -197,6 +199,7 @@
 #include "FXDCWindow.h"
 #include "FXDCPrint.h"
 #include "FXIconSource.h"
+#include "FXImageReader.h"
 #include "FXIconCache.h"
 #include "FXFileAssociations.h"
 #include "FXFrame.h"
@@ -266,6 +269,7 @@
 #include "FXImageFrame.h"
 #include "FXHeader.h"
 #include "FXTable.h"
+#include "FXVirtualTable.h"
 #include "FXDragCorner.h"
 #include "FXStatusBar.h"
 #include "FXStatusLine.h"
@@ -253,11 +253,12 @@ struct FXCBSpec {
 
 // Timer record
 struct FXTimer {
-  FXTimer       *next;              // Next timeout in list
+  FXTimer       *next;              // Next timer for same target, or next recycled record
   FXObject      *target;            // Receiver object
   FXptr          data;              // User data
   FXSelector     message;           // Message sent to receiver
   FXTime         due;               // When timer is due (ns)
+  FXint          index;             // Position in timer heap
   };
 
 
@@ -488,6 +489,8 @@ FXApp::FXApp(const FXString& name,const FXString& vendor):registry(name,vendor){
   refresherstop=nullptr;                  // GUI refresher end pointer
   popupWindow=nullptr;                    // No popup windows
   timers=nullptr;                         // No timers present
+  ntimers=0;                              // Number of timers
+  maxtimers=0;                            // Space for timers
   chores=nullptr;                         // No chores present
   repaints=nullptr;                       // No outstanding repaints
   timerrecs=nullptr;                      // No timer records
@@ -1866,12 +1869,96 @@ FXbool FXApp::closeDisplay(){
 
 /*******************************************************************************/
 
+// Timers are kept in a binary heap ordered by due time, so the earliest timer
+// is always timers[0]; each timer records its own position in the heap, so it can
+// be removed or moved in O(log N) time.  In addition, timers are filed by target
+// in the timer table, each entry heading a short list of that target's timers;
+// thus timers can be located by target and message without scanning all timers.
+// Timers without target are filed under the application object itself.
+
+
+// Find timer with given target and message; any message if sel is zero
+FXTimer* FXApp::findTimer(FXObject* tgt,FXSelector sel) const {
+  FXival pos=timertable.find(tgt?(const void*)tgt:(const void*)this);
+  if(0<=pos){
+    for(FXTimer *t=(FXTimer*)timertable.data(pos); t; t=t->next){
+      if(t->target==tgt && (sel==0 || t->message==sel)) return t;
+      }
+    }
+  return nullptr;
+  }
+
+
+// Restore heap order after timer's due time has changed
+void FXApp::placeTimer(FXTimer* t){
+  FXint i=t->index;
+  FXint c;
+  while(0<i && t->due<timers[c=(i-1)>>1]->due){
+    timers[i]=timers[c];
+    timers[i]->index=i;
+    i=c;
+    }
+  while((c=i+i+1)<ntimers){
+    if(c+1<ntimers && timers[c+1]->due<timers[c]->due) c++;
+    if(t->due<=timers[c]->due) break;
+    timers[i]=timers[c];
+    timers[i]->index=i;
+    i=c;
+    }
+  timers[i]=t;
+  t->index=i;
+  }
+
+
+// Add new timer to heap and timer table
+void FXApp::insertTimer(FXTimer* t){
+  void*& head=timertable.at(t->target?(const void*)t->target:(const void*)this);
+  if(ntimers>=maxtimers){
+    maxtimers=FXMAX(2*maxtimers,16);
+    resizeElms(timers,maxtimers);
+    }
+  t->next=(FXTimer*)head;
+  head=t;
+  t->index=ntimers++;
+  timers[t->index]=t;
+  placeTimer(t);
+  }
+
+
+// Remove timer from heap and timer table, and recycle it
+void FXApp::removeTimer(FXTimer* t){
+  const void* key=t->target?(const void*)t->target:(const void*)this;
+  FXival pos=timertable.find(key);
+  FXTimer *h=(FXTimer*)timertable.data(pos);
+  if(h==t){
+    if(t->next) timertable.data(pos)=t->next; else timertable.erase(pos);
+    }
+  else{
+    while(h->next!=t){ h=h->next; }
+    h->next=t->next;
+    }
+  if(t->index<--ntimers){
+    timers[t->index]=timers[ntimers];
+    timers[t->index]->index=t->index;
+    placeTimer(timers[t->index]);
+    }
+  t->next=timerrecs;
+  timerrecs=t;
+  }
+
+
 // Add deadline in nanoseconds
 FXptr FXApp::addDeadline(FXObject* tgt,FXSelector sel,FXTime due,FXptr ptr){
   FXptr result=nullptr;
-  FXTimer *t,**tt;
-  for(tt=&timers; (t=*tt)!=nullptr; tt=&t->next){
-    if(t->target==tgt && t->message==sel){ *tt=t->next; result=t->data; goto a; }
+  FXTimer *t;
+  for(t=findTimer(tgt,sel); t; t=t->next){
+    if(t->target==tgt && t->message==sel){
+      result=t->data;
+      t->data=ptr;
+      t->due=due;
+      placeTimer(t);
+      return result;
+      }
     }
   if(timerrecs){
     t=timerrecs;
@@ -1880,13 +1967,11 @@ FXptr FXApp::addDeadline(FXObject* tgt,FXSelector sel,FXTime due,FXptr ptr){
   else{
     t=new FXTimer;
     }
-a:t->data=ptr;
+  t->data=ptr;
   t->target=tgt;
   t->message=sel;
   t->due=due;
-  for(tt=&timers; *tt!=nullptr && ((*tt)->due < t->due); tt=&(*tt)->next){}
-  t->next=*tt;
-  *tt=t;
+  insertTimer(t);
   return result;
   }
 
@@ -1899,24 +1984,17 @@ FXptr FXApp::addTimeout(FXObject* tgt,FXSelector sel,FXTime ns,FXptr ptr){
 
 // Check if timeout identified by tgt and sel has been set
 FXbool FXApp::hasTimeout(FXObject* tgt,FXSelector sel) const {
-  for(FXTimer *t=timers; t; t=t->next){
-    if(t->target==tgt && (sel==0 || t->message==sel)) return true;
-    }
-  return false;
+  return findTimer(tgt,sel)!=nullptr;
   }
 
 
 // Remove timeout(s) identified by tgt and sel from the list
 FXptr FXApp::removeTimeout(FXObject* tgt,FXSelector sel){
   FXptr result=nullptr;
-  FXTimer **tt=&timers;
   FXTimer *t;
-  while((t=*tt)!=nullptr){
-    if(t->target==tgt && (sel==0 || t->message==sel)){
-      *tt=t->next; result=t->data; t->next=timerrecs; timerrecs=t;
-      continue;
-      }
-    tt=&t->next;
+  while((t=findTimer(tgt,sel))!=nullptr){
+    result=t->data;
+    removeTimer(t);
     }
   return result;
   }
@@ -1924,11 +2002,10 @@ FXptr FXApp::removeTimeout(FXObject* tgt,FXSelector sel){
 
 // Return the remaining time, in nanoseconds
 FXTime FXApp::remainingTimeout(FXObject *tgt,FXSelector sel) const {
-  for(FXTimer *t=timers; t; t=t->next){
-    if(t->target==tgt && (sel==0 || t->message==sel)){
-      FXTime now=FXThread::time();
-      return t->due>now ? t->due-now : 0L;
-      }
+  FXTimer *t=findTimer(tgt,sel);
+  if(t){
+    FXTime now=FXThread::time();
+    return t->due>now ? t->due-now : 0L;
     }
   return forever;
   }
@@ -2368,11 +2445,9 @@ FXbool FXApp::getNextEvent(FXRawEvent& ev,FXTime blocking){
 a:ev.xany.type=0;
 
   // If a timer is due, handle it
-  if(timers && timers->due<=FXThread::time()){
-    FXTimer* t=timers;
-    timers=t->next;
-    t->next=timerrecs;
-    timerrecs=t;
+  if(ntimers && timers[0]->due<=FXThread::time()){
+    FXTimer* t=timers[0];
+    removeTimer(t);
     if(t->target && t->target->tryHandle(this,FXSEL(SEL_TIMEOUT,t->message),t->data)) refresh();
     return false;
     }
@@ -2488,11 +2563,11 @@ a:ev.xany.type=0;
         }
 
       // If there are timers, we block only for a little while.
-      if(timers || blocking<forever){
+      if(ntimers || blocking<forever){
         FXTime interval;
 
         // All that testing above may have taken some time...
-        if(timers && (interval=timers->due-FXThread::time())<blocking) blocking=interval;
+        if(ntimers && (interval=timers[0]->due-FXThread::time())<blocking) blocking=interval;
 
         // Some timers are already due; do them right away!
         if(blocking<=0) return false;
@@ -2662,8 +2737,8 @@ FXbool FXApp::peekEvent(){
     if(chores) return true;
 
     // Timers are due?
-    if(timers){
-      if(timers->due <= FXThread::time()) return true;
+    if(ntimers){
+      if(timers[0]->due <= FXThread::time()) return true;
       }
 
     // Events queued up in client already (Shouldn't this not be QueuedAlready?)
@@ -3799,11 +3874,9 @@ FXbool FXApp::getNextEvent(FXRawEvent& msg,FXTime blocking){
   msg.message=0;
 
   // If a timer is due, handle it
-  if(timers && timers->due<=FXThread::time()){
-    FXTimer* t=timers;
-    timers=t->next;
-    t->next=timerrecs;
-    timerrecs=t;
+  if(ntimers && timers[0]->due<=FXThread::time()){
+    FXTimer* t=timers[0];
+    removeTimer(t);
     if(t->target && t->target->tryHandle(this,FXSEL(SEL_TIMEOUT,t->message),t->data)) refresh();
     return false;
     }
@@ -3873,11 +3946,11 @@ FXbool FXApp::getNextEvent(FXRawEvent& msg,FXTime blocking){
 
     // If there are timers, block only a little time
     allinputs=maxhandle+1;
-    if(timers || blocking<forever){
+    if(ntimers || blocking<forever){
       FXTime interval;
 
       // All that testing above may have taken some time...
-      if(timers && (interval=timers->due-FXThread::time())<blocking) blocking=interval;
+      if(ntimers && (interval=timers[0]->due-FXThread::time())<blocking) blocking=interval;
 
       // Some timers are already due; do them right away!
       if(blocking<=0) return false;
@@ -3955,8 +4028,8 @@ FXbool FXApp::peekEvent(){
     if(chores) return true;
 
     // Timers are due?
-    if(timers){
-      if(timers->due <= FXThread::time()) return true;
+    if(ntimers){
+      if(timers[0]->due <= FXThread::time()) return true;
       }
 
     // Other events due?
@@ -5904,11 +5977,10 @@ FXApp::~FXApp(){
     }
 
   // Kill outstanding timers
-  while(timers){
-    t=timers;
-    timers=timers->next;
-    delete t;
+  while(ntimers){
+    delete timers[--ntimers];
     }
+  freeElms(timers);
 
   // Free recycled timer records
   while(timerrecs){
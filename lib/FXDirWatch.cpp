@@ -63,7 +63,13 @@
   - In other words, if watching a file then there is no name string in the
     inotify_event!!
 
-  - We need a fallback version that uses timers.
+  - Changes are reported to the target as SEL_INSERTED, SEL_DELETED, or SEL_CHANGED,
+    with the full pathname of the affected entry as a const FXchar* argument.
+    When a directory itself changes (or the kernel event queue overflowed, so that
+    individual changes have been lost), SEL_CHANGED is sent with the directory's own
+    pathname: the receiver should then rescan the entire directory.
+  - On systems without a change notification mechanism, a fallback version polls
+    the modification times of the watched paths using a timer.
 */
 
 #define TOPIC_CONSTRUCT 1000
@@ -81,10 +87,6 @@
 #endif
 
 
-// Test
-#undef HAVE_INOTIFY_INIT1
-
-
 using namespace FX;
 
 /*******************************************************************************/
@@ -202,6 +204,7 @@ long FXDirWatch::onMessage(FXObject*,FXSelector,void* ptr){
   FindNextChangeNotification(h);
   pathname=handleToPath[(FXptr)h];
   FXTRACE((TOPIC_DEBUG,"pathname=\"%s\"\n",pathname.text()));
+  if(target){ target->tryHandle(this,FXSEL(SEL_CHANGED,message),(void*)pathname.text()); }
 #if 0
 BOOL ReadDirectoryChangesW(
   HANDLE                          hDirectory,
@@ -254,7 +257,7 @@ struct FILE_NOTIFY_INFORMATION {
 
 
 // Event filter flags
-const FXuint FILTER_DIRS=IN_ATTRIB|IN_DELETE_SELF|IN_MOVE|IN_CREATE|IN_DELETE;
+const FXuint FILTER_DIRS=IN_ATTRIB|IN_DELETE_SELF|IN_MOVE|IN_CREATE|IN_DELETE|IN_MODIFY|IN_MOVE_SELF;
 const FXuint FILTER_FILE=IN_ATTRIB|IN_DELETE_SELF|IN_MOVE|IN_MODIFY|IN_MOVE_SELF;
 
 
@@ -344,8 +347,8 @@ long FXDirWatch::onMessage(FXObject*,FXSelector,void*){
         FXchar *pne=ptr;
         while(pne<end){
           inotify_event* ne=(inotify_event*)pne;
-          FXString pathname=FXPath::absolute(handleToPath[(FXptr)(FXival)ne->wd],ne->name);
-          FXTRACE((TOPIC_DEBUG,"wd=%d mask=%x cookie=%u len=%u name=\"%s\" pathname=\"%s\"\n",ne->wd,ne->mask,ne->cookie,ne->len,ne->name,pathname.text()));
+          pne+=sizeof(inotify_event)+ne->len;
+          FXTRACE((TOPIC_DEBUG,"wd=%d mask=%x cookie=%u len=%u name=\"%s\"\n",ne->wd,ne->mask,ne->cookie,ne->len,ne->len?ne->name:""));
           if(ne->mask&IN_ACCESS)        FXTRACE((TOPIC_DEBUG,"IN_ACCESS "));
           if(ne->mask&IN_ATTRIB)        FXTRACE((TOPIC_DEBUG,"IN_ATTRIB "));
           if(ne->mask&IN_CLOSE_NOWRITE) FXTRACE((TOPIC_DEBUG,"IN_CLOSE_NOWRITE "));
@@ -363,16 +366,34 @@ long FXDirWatch::onMessage(FXObject*,FXSelector,void*){
           if(ne->mask&IN_Q_OVERFLOW)    FXTRACE((TOPIC_DEBUG,"IN_Q_OVERFLOW "));
           if(ne->mask&IN_UNMOUNT)       FXTRACE((TOPIC_DEBUG,"IN_UNMOUNT "));
           FXTRACE((TOPIC_DEBUG,"\n"));
+
+          // Queue overflowed; events were lost, so everything may have changed
+          if(ne->mask&IN_Q_OVERFLOW){
+            FXTRACE((TOPIC_DEBUG,"SEL_CHANGED (all)\n"));
+            for(FXint i=0; i<pathToHandle.no(); ++i){
+              if(!pathToHandle.empty(i) && target){ target->tryHandle(this,FXSEL(SEL_CHANGED,message),(void*)pathToHandle.key(i).text()); }
+              }
+            continue;
+            }
+
+          // Skip events for watches no longer known, like IN_IGNORED after removal
+          if(ne->wd<0) continue;
+          FXival pos=handleToPath.find((FXptr)(FXival)ne->wd);
+          if(pos<0) continue;
+          FXString pathname=FXPath::absolute(handleToPath.data(pos),ne->len?ne->name:"");
+          FXTRACE((TOPIC_DEBUG,"pathname=\"%s\"\n",pathname.text()));
           if(ne->mask&(IN_MOVED_TO|IN_CREATE)){
             FXTRACE((TOPIC_DEBUG,"SEL_INSERTED \"%s\"\n",pathname.text()));
+            if(target){ target->tryHandle(this,FXSEL(SEL_INSERTED,message),(void*)pathname.text()); }
             }
-          else if(ne->mask&(IN_DELETE|IN_MOVED_FROM)){
+          else if(ne->mask&(IN_DELETE|IN_MOVED_FROM|IN_DELETE_SELF|IN_MOVE_SELF)){
             FXTRACE((TOPIC_DEBUG,"SEL_DELETED \"%s\"\n",pathname.text()));
+            if(target){ target->tryHandle(this,FXSEL(SEL_DELETED,message),(void*)pathname.text()); }
             }
-          else if(ne->mask&(IN_ATTRIB)){
+          else if(ne->mask&(IN_ATTRIB|IN_MODIFY)){
             FXTRACE((TOPIC_DEBUG,"SEL_CHANGED \"%s\"\n",pathname.text()));
+            if(target){ target->tryHandle(this,FXSEL(SEL_CHANGED,message),(void*)pathname.text()); }
             }
-          pne+=sizeof(inotify_event)+ne->len;
           }
         }
       freeElms(ptr);
@@ -397,8 +418,10 @@ FXbool FXDirWatch::addWatch(const FXString& path){
     if(FXStat::statFile(path,stat)){
       if(pathToHandle.used()==0){
         getApp()->addTimeout(this,ID_CHANGE,REFRESHINTERVAL);
+        timestamp=0;
         }
       pathToHandle[path]=(FXptr)(stat.isFile()?1L:2L);
+      if(timestamp<stat.modified()) timestamp=stat.modified();
       return true;
       }
     }
@@ -445,10 +468,12 @@ long FXDirWatch::onMessage(FXObject*,FXSelector,void*){
           if(newstamp<time) newstamp=time;
           if(timestamp<time){
             FXTRACE((TOPIC_DETAIL,"SEL_CHANGED \"%s\"\n",pathToHandle.key(i).text()));
+            if(target){ target->tryHandle(this,FXSEL(SEL_CHANGED,message),(void*)pathToHandle.key(i).text()); }
             }
           }
         else{
           FXTRACE((TOPIC_DETAIL,"SEL_DELETED \"%s\"\n",pathToHandle.key(i).text()));
+          if(target){ target->tryHandle(this,FXSEL(SEL_DELETED,message),(void*)pathToHandle.key(i).text()); }
           }
         }
       }
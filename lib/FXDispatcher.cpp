@@ -89,8 +89,9 @@ struct FXDispatcher::Signal {
 struct FXDispatcher::Timer {
   TimeoutCallback    cb;          // Callback
   FXTime             due;         // When timer is due (ns)
-  Timer             *next;        // Next timeout in list
+  Timer             *next;        // Next timeout with same key, or next recycled record
   void              *ptr;         // User data
+  FXint              index;       // Position in timer heap
   };
 
 
@@ -105,7 +106,7 @@ struct FXDispatcher::Idle {
 /*******************************************************************************/
 
 // Construct dispatcher object
-FXDispatcher::FXDispatcher():signals(nullptr),timers(nullptr),idles(nullptr),timerrecs(nullptr),idlerecs(nullptr){
+FXDispatcher::FXDispatcher():signals(nullptr),timers(nullptr),ntimers(0),maxtimers(0),idles(nullptr),timerrecs(nullptr),idlerecs(nullptr){
   }
 
 
@@ -114,6 +115,8 @@ FXbool FXDispatcher::init(){
   if(FXReactor::init()){
     callocElms(signals,64);
     timers=nullptr;
+    ntimers=0;
+    maxtimers=0;
     idles=nullptr;
     timerrecs=nullptr;
     idlerecs=nullptr;
@@ -163,19 +166,105 @@ FXbool FXDispatcher::dispatchSignal(FXint sig){
 
 /*******************************************************************************/
 
+// Timers are kept in a binary heap ordered by due time, so that the earliest timer
+// is always timers[0]; each timer records its own position in the heap, so it can
+// be removed or moved in O(log N) time.  To locate the timer for a given callback,
+// timers are also filed in the timer table, under a key derived from the callback.
+// Callbacks which map to the same key are chained together.
+
+
+// Map timeout callback to hash key; never null, and never -1
+static inline const void* timerkey(const FXDispatcher::TimeoutCallback& cb){
+  FXuval words[(sizeof(cb)+sizeof(FXuval)-1)/sizeof(FXuval)]={0};
+  FXuval key=0;
+  memcpy(words,&cb,sizeof(cb));
+  for(FXuint i=0; i<ARRAYNUMBER(words); ++i){
+    key=(key^words[i])*FXULONG(0x9E3779B97F4A7C15);
+    }
+  return (const void*)((key|2)&~(FXuval)1);
+  }
+
+
+// Find timer for callback
+FXDispatcher::Timer* FXDispatcher::findTimer(const TimeoutCallback& cb) const {
+  FXival pos=timertable.find(timerkey(cb));
+  if(0<=pos){
+    for(Timer *t=(Timer*)timertable.data(pos); t; t=t->next){
+      if(t->cb==cb) return t;
+      }
+    }
+  return nullptr;
+  }
+
+
+// Restore heap order after timer's due time has changed
+void FXDispatcher::placeTimer(Timer* t){
+  FXint i=t->index;
+  FXint c;
+  while(0<i && t->due<timers[c=(i-1)>>1]->due){
+    timers[i]=timers[c];
+    timers[i]->index=i;
+    i=c;
+    }
+  while((c=i+i+1)<ntimers){
+    if(c+1<ntimers && timers[c+1]->due<timers[c]->due) c++;
+    if(t->due<=timers[c]->due) break;
+    timers[i]=timers[c];
+    timers[i]->index=i;
+    i=c;
+    }
+  timers[i]=t;
+  t->index=i;
+  }
+
+
+// Add new timer to heap and timer table
+void FXDispatcher::insertTimer(Timer* t){
+  void*& head=timertable.at(timerkey(t->cb));
+  if(ntimers>=maxtimers){
+    maxtimers=FXMAX(2*maxtimers,16);
+    resizeElms(timers,maxtimers);
+    }
+  t->next=(Timer*)head;
+  head=t;
+  t->index=ntimers++;
+  timers[t->index]=t;
+  placeTimer(t);
+  }
+
+
+// Remove timer from heap and timer table, and recycle it
+void FXDispatcher::removeTimer(Timer* t){
+  FXival pos=timertable.find(timerkey(t->cb));
+  Timer *h=(Timer*)timertable.data(pos);
+  if(h==t){
+    if(t->next) timertable.data(pos)=t->next; else timertable.erase(pos);
+    }
+  else{
+    while(h->next!=t){ h=h->next; }
+    h->next=t->next;
+    }
+  if(t->index<--ntimers){
+    timers[t->index]=timers[ntimers];
+    timers[t->index]->index=t->index;
+    placeTimer(timers[t->index]);
+    }
+  t->next=timerrecs;
+  timerrecs=t;
+  }
+
+
 // Add timeout callback cb at time due (ns since Epoch).
 void* FXDispatcher::addTimeout(TimeoutCallback cb,FXTime due,void* ptr){
   void* res=nullptr;
   if(isInitialized()){
-    Timer **tt=&timers,*t,*x;
-    while((x=*tt)!=nullptr){
-      if(x->cb==cb){
-        *tt=x->next;
-        res=x->ptr;
-        t=x;
-        goto a;
-        }
-      tt=&x->next;
+    Timer *t=findTimer(cb);
+    if(t){
+      res=t->ptr;
+      t->ptr=ptr;
+      t->due=due;
+      placeTimer(t);
+      return res;
       }
     if(timerrecs){
       t=timerrecs;
@@ -184,16 +273,10 @@ void* FXDispatcher::addTimeout(TimeoutCallback cb,FXTime due,void* ptr){
     else{
       t=new Timer;
       }
-a:  t->cb=cb;
+    t->cb=cb;
     t->due=due;
-    t->next=nullptr;
     t->ptr=ptr;
-    tt=&timers;
-    while((x=*tt) && x->due<=t->due){
-      tt=&x->next;
-      }
-    t->next=*tt;
-    *tt=t;
+    insertTimer(t);
     }
   return res;
   }
@@ -209,16 +292,10 @@ void* FXDispatcher::addInterval(TimeoutCallback cb,FXTime interval,void* ptr){
 void* FXDispatcher::remTimeout(TimeoutCallback cb){
   void* res=nullptr;
   if(isInitialized()){
-    Timer **tt=&timers,*t;
-    while((t=*tt)!=nullptr){
-      if(t->cb==cb){
-        *tt=t->next;
-        res=t->ptr;
-        t->next=timerrecs;
-        timerrecs=t;
-        continue;
-        }
-      tt=&t->next;
+    Timer *t=findTimer(cb);
+    if(t){
+      res=t->ptr;
+      removeTimer(t);
       }
     }
   return res;
@@ -227,35 +304,28 @@ void* FXDispatcher::remTimeout(TimeoutCallback cb){
 
 // Return the remaining time, in nanoseconds
 FXTime FXDispatcher::getTimeout(TimeoutCallback cb) const {
-  for(Timer *t=timers; t; t=t->next){
-    if(t->cb==cb) return t->due;
-    }
-  return forever;
+  Timer *t=findTimer(cb);
+  return t ? t->due : forever;
   }
 
 
 // Return timeout when something needs to happen
 FXTime FXDispatcher::nextTimeout(){
-  return timers ? timers->due : forever;
+  return ntimers ? timers[0]->due : forever;
   }
 
 
 // Return true if timeout callback cb been set.
 FXbool FXDispatcher::hasTimeout(TimeoutCallback cb) const {
-  for(Timer *t=timers; t; t=t->next){
-    if(t->cb==cb) return true;
-    }
-  return false;
+  return findTimer(cb)!=nullptr;
   }
 
 
 // Dispatch when timeout expires
 FXbool FXDispatcher::dispatchTimeout(FXTime due){
-  Timer *t=timers;
-  if(t && t->due<=due){
-    timers=t->next;
-    t->next=timerrecs;
-    timerrecs=t;
+  if(ntimers && timers[0]->due<=due){
+    Timer *t=timers[0];
+    removeTimer(t);
     return t->cb(this,t->due,t->ptr);
     }
   return false;
@@ -398,10 +468,11 @@ FXbool FXDispatcher::exit(){
       if(handles.empty(i)) continue;
       delete static_cast<Handle*>(handles.data(i));
       }
-    while((t=timers)!=nullptr){
-      timers=t->next;
-      delete t;
+    while(ntimers){
+      delete timers[--ntimers];
       }
+    freeElms(timers);
+    timertable.clear();
     while((t=timerrecs)!=nullptr){
       timerrecs=t->next;
       delete t;
@@ -420,6 +491,7 @@ FXbool FXDispatcher::exit(){
     freeElms(signals);
     handles.clear();
     timers=nullptr;
+    maxtimers=0;
     idles=nullptr;
     timerrecs=nullptr;
     idlerecs=nullptr;
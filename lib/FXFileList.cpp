@@ -34,12 +34,23 @@
 #include "FXHash.h"
 #include "FXStream.h"
 #include "FXObjectList.h"
+#include "FXPtrList.h"
+#include "FXAtomic.h"
+#include "FXSemaphore.h"
+#include "FXCompletion.h"
+#include "FXRunnable.h"
+#include "FXAutoThreadStorageKey.h"
+#include "FXThread.h"
+#include "FXLFQueue.h"
+#include "FXWSQueue.h"
+#include "FXThreadPool.h"
 #include "FXString.h"
 #include "FXSystem.h"
 #include "FXPath.h"
 #include "FXIO.h"
 #include "FXStat.h"
 #include "FXFile.h"
+#include "FXFileStream.h"
 #include "FXDir.h"
 #include "FXURL.h"
 #include "FXStringDictionary.h"
@@ -49,7 +60,9 @@
 #include "FXEvent.h"
 #include "FXWindow.h"
 #include "FXApp.h"
+#include "FXMessageChannel.h"
 #include "FXIcon.h"
+#include "FXQOIFIcon.h"
 #include "FXGIFIcon.h"
 #include "FXScrollBar.h"
 #include "FXIconSource.h"
@@ -64,6 +77,8 @@
 #include "FXMenuSeparator.h"
 #include "FXDictionary.h"
 #include "FXDictionaryOf.h"
+#include "FXReverseDictionary.h"
+#include "FXDirWatch.h"
 #include "FXIconCache.h"
 #include "FXFileAssociations.h"
 #include "FXHeader.h"
@@ -87,6 +102,32 @@
     icon isn't so great; this class shouldn't have to know about FXPNGIcon.
   - If you land in a large directory with images, things are a tad slow;
     need to speed this up some how.
+  - The current directory is watched with FXDirWatch; changes are collected in
+    the pending set, and applied after a short delay, so a burst of changes to
+    the same entry causes only a single update.  Only the changed entries are
+    re-examined; if too many entries changed, or if the directory itself changed,
+    the whole directory is re-scanned instead (unchanged items are kept).
+  - If the directory can't be watched, we fall back to polling the directory
+    every REFRESHINTERVAL, and forcing a full re-scan every REFRESHCOUNT-th time.
+  - Image previews (thumbnails) are made by the thread pool, if one was set;
+    otherwise, they're made one by one in a chore.  Items which may be visible are
+    done first; then the rest, in order.  To keep the visible items first even
+    when scrolling, only a few thumbnails (THUMBSPERTHREAD per thread) are handed
+    to the thread pool at a time; another one is started as each one is finished.
+  - Finished thumbnails are passed back through the message channel.  The item
+    may have been deleted by then, so the item is looked up again, and the
+    thumbnail used only if the file's name and time still match.
+  - When the directory changes, the outstanding thumbnails are cancelled and
+    handed over to the workers, without waiting for them; a cancelled thumbnail
+    is not made when the worker gets to it, and not passed back.  Each record is
+    shared by the file list and the worker, and deleted by whichever of the two
+    lets go of it last.
+  - Before the message channel goes away, we wait on the completion counter until
+    the workers are done with the outstanding thumbnails.
+  - The optional thumbnail cache directory holds thumbnails in QOI format, each
+    file named after a hash of the image's pathname, modified time, file size, and
+    thumbnail size; a changed image thus gets a new cache file.  Old cache files
+    are never removed; simply delete the cache directory to clean it out.
 */
 
 #define TOPIC_FILELIST 1002
@@ -95,6 +136,10 @@
 #define OPENDIRDELAY        700000000   // Delay before opening directory
 #define REFRESHINTERVAL     1000000000  // Interval between refreshes
 #define REFRESHCOUNT        30          // Refresh every REFRESHCOUNT-th time
+#define UPDATEDELAY         100000000   // Delay before applying changes
+#define UPDATEBATCH         256         // Re-scan if more changes than this
+#define THUMBSPERTHREAD     2           // Thumbnails handed to each thread
+#define THUMBMAGIC          0x424d4854  // Thumbnail cache file signature
 
 using namespace FX;
 
@@ -120,8 +165,13 @@ FXDEFMAP(FXFileList) FXFileListMap[]={
   FXMAPFUNC(SEL_CLIPBOARD_LOST,0,FXFileList::onClipboardLost),
   FXMAPFUNC(SEL_CLIPBOARD_REQUEST,0,FXFileList::onClipboardRequest),
   FXMAPFUNC(SEL_CHORE,FXFileList::ID_PREVIEWCHORE,FXFileList::onPreviewChore),
+  FXMAPFUNC(SEL_COMMAND,FXFileList::ID_THUMBNAIL,FXFileList::onThumbnail),
   FXMAPFUNC(SEL_TIMEOUT,FXFileList::ID_OPENTIMER,FXFileList::onOpenTimer),
   FXMAPFUNC(SEL_TIMEOUT,FXFileList::ID_REFRESHTIMER,FXFileList::onRefreshTimer),
+  FXMAPFUNC(SEL_TIMEOUT,FXFileList::ID_UPDATETIMER,FXFileList::onUpdateTimer),
+  FXMAPFUNC(SEL_INSERTED,FXFileList::ID_WATCH,FXFileList::onWatchChanged),
+  FXMAPFUNC(SEL_DELETED,FXFileList::ID_WATCH,FXFileList::onWatchChanged),
+  FXMAPFUNC(SEL_CHANGED,FXFileList::ID_WATCH,FXFileList::onWatchChanged),
   FXMAPFUNC(SEL_UPDATE,FXFileList::ID_DIRECTORY_UP,FXFileList::onUpdDirectoryUp),
   FXMAPFUNC(SEL_UPDATE,FXFileList::ID_SORT_BY_NAME,FXFileList::onUpdSortByName),
   FXMAPFUNC(SEL_UPDATE,FXFileList::ID_SORT_BY_TYPE,FXFileList::onUpdSortByType),
@@ -179,12 +229,128 @@ FXDEFMAP(FXFileList) FXFileListMap[]={
 FXIMPLEMENT(FXFileList,FXIconList,FXFileListMap,ARRAYNUMBER(FXFileListMap))
 
 
+// Thumbnail being made by worker thread
+struct FXFileList::Thumbnail : public FXRunnable {
+  FXFileList      *owner;       // File list wanting the thumbnail
+  FXFileItem      *item;        // Item wanting the thumbnail
+  Thumbnail       *next;        // Next outstanding thumbnail
+  FXIconSource    *loader;      // Icon loader
+  FXIcon          *icon;        // Resulting thumbnail
+  FXString         pathname;    // Image file
+  FXString         cachefile;   // Cache file, if any
+  FXTime           date;        // Modified time of image file
+  FXint            size;        // Thumbnail size
+  volatile FXbool  cancelled;   // Thumbnail no longer wanted
+  volatile FXbool  finished;    // Thumbnail has been made
+  volatile FXint   refs;        // File list and worker references
+public:
+  Thumbnail(FXFileList* own,FXFileItem* itm,const FXString& path);
+  void make();
+  void release();
+  virtual FXint run();
+  virtual ~Thumbnail();
+  };
+
+
+// Name of cache file for thumbnail; hash pathname, time, size, and thumbnail size
+static FXString thumbnailfile(const FXString& dir,const FXString& pathname,FXTime date,FXlong size,FXint imagesize){
+  FXulong hash=FXULONG(0xCBF29CE484222325);
+  FXulong vals[3]={(FXulong)date,(FXulong)size,(FXulong)imagesize};
+  for(FXint i=0; i<pathname.length(); ++i){
+    hash=(hash^(FXuchar)pathname[i])*FXULONG(0x100000001B3);
+    }
+  for(FXint i=0; i<3; ++i){
+    for(FXint b=0; b<64; b+=8){
+      hash=(hash^((vals[i]>>b)&255))*FXULONG(0x100000001B3);
+      }
+    }
+  return FXPath::absolute(dir,FXString::value(hash,16)+".thumb");
+  }
+
+
+// Create thumbnail record
+FXFileList::Thumbnail::Thumbnail(FXFileList* own,FXFileItem* itm,const FXString& path):owner(own),item(itm),next(nullptr),loader(own->iconloader),icon(nullptr),pathname(path),date(itm->getDate()),size(own->imagesize),cancelled(false),finished(false),refs(2){
+  if(!own->thumbdir.empty()){
+    cachefile=thumbnailfile(own->thumbdir,pathname,date,itm->getSize(),size);
+    }
+  }
+
+
+// Load thumbnail from cache, or load it from the image file and
+// save it to the cache; this may be done by a worker thread
+void FXFileList::Thumbnail::make(){
+  if(!cachefile.empty()){
+    FXFileStream store;
+    if(store.open(cachefile,FXStreamLoad)){
+      FXColor *pixels,transp;
+      FXuint magic,opts;
+      FXint w,h;
+      store >> magic >> opts >> transp;
+      if(magic==THUMBMAGIC && fxloadQOIF(store,pixels,w,h)){
+        icon=new FXIcon(owner->getApp(),nullptr,transp,opts&~IMAGE_OWNED);
+        icon->setData(pixels,IMAGE_OWNED,w,h);
+        return;
+        }
+      store.close();
+      }
+    }
+  icon=loader->loadScaledIconFile(owner->getApp(),pathname,size);
+  if(icon && !cachefile.empty()){
+    FXString tempfile(cachefile+"."+FXString::value((FXulong)FXThread::current(),16));
+    FXFileStream store;
+    if(store.open(tempfile,FXStreamSave)){
+      store << (FXuint)THUMBMAGIC << icon->getOptions() << icon->getTransparentColor();
+      if(fxsaveQOIF(store,icon->getData(),icon->getWidth(),icon->getHeight()) && store.close()){
+        FXFile::move(tempfile,cachefile,true);
+        return;
+        }
+      store.close();
+      FXFile::remove(tempfile);
+      }
+    }
+  }
+
+
+// Drop reference; the last one to let go deletes the record
+void FXFileList::Thumbnail::release(){
+  if(atomicAdd(&refs,-1)==1) delete this;
+  }
+
+
+// Make thumbnail in worker thread, and pass it back to the file list;
+// if cancelled by the time the worker gets to it, just drop it
+FXint FXFileList::Thumbnail::run(){
+  FXFileList *list=owner;
+  Thumbnail  *self=this;
+  if(!cancelled){
+    make();
+    finished=true;
+    if(!cancelled){
+      list->channel->message(list,FXSEL(SEL_COMMAND,ID_THUMBNAIL),&self,sizeof(self));
+      }
+    }
+  release();
+  list->thumbjobs.decrement();
+  return 0;
+  }
+
+
+// Delete thumbnail record
+FXFileList::Thumbnail::~Thumbnail(){
+  delete icon;
+  }
+
+
 // For serialization
 FXFileList::FXFileList(){
   dropEnable();
   associations=nullptr;
   iconloader=nullptr;
   list=nullptr;
+  watcher=nullptr;
+  threadpool=nullptr;
+  channel=nullptr;
+  thumbnails=nullptr;
   big_folder=nullptr;
   mini_folder=nullptr;
   big_doc=nullptr;
@@ -203,6 +369,9 @@ FXFileList::FXFileList(){
   imagesize=32;
   timestamp=0;
   counter=0;
+  thumbnext=0;
+  thumbbusy=0;
+  rescan=false;
   clipcut=false;
   draggable=true;
   }
@@ -225,6 +394,10 @@ FXFileList::FXFileList(FXComposite *p,FXObject* tgt,FXSelector sel,FXuint opts,F
   if(!(options&FILELIST_NO_OWN_ASSOC)) associations=new FXFileAssociations(getApp());
   iconloader=&FXIconSource::defaultIconSource;
   list=nullptr;
+  watcher=nullptr;
+  threadpool=nullptr;
+  channel=nullptr;
+  thumbnails=nullptr;
   big_folder=new FXGIFIcon(getApp(),bigfolder);
   mini_folder=new FXGIFIcon(getApp(),minifolder);
   big_doc=new FXGIFIcon(getApp(),bigdoc);
@@ -243,15 +416,20 @@ FXFileList::FXFileList(FXComposite *p,FXObject* tgt,FXSelector sel,FXuint opts,F
   imagesize=32;
   timestamp=0;
   counter=0;
+  thumbnext=0;
+  thumbbusy=0;
+  rescan=false;
   clipcut=false;
   draggable=true;
   }
 
 
-// Starts the timer
+// Starts watching the directory
 void FXFileList::create(){
   FXIconList::create();
-  getApp()->addTimeout(this,ID_REFRESHTIMER,REFRESHINTERVAL);
+  if(!watcher) watcher=new FXDirWatch(getApp(),this,ID_WATCH);
+  if(!channel) channel=new FXMessageChannel(getApp());
+  watchDirectory();
   big_folder->create();
   mini_folder->create();
   big_doc->create();
@@ -265,7 +443,15 @@ void FXFileList::create(){
 void FXFileList::detach(){
   FXIconList::detach();
   getApp()->removeTimeout(this,ID_REFRESHTIMER);
+  getApp()->removeTimeout(this,ID_UPDATETIMER);
   getApp()->removeTimeout(this,ID_OPENTIMER);
+  getApp()->removeChore(this);
+  stopThumbnails();
+  thumbjobs.wait();
+  delete channel;
+  delete watcher;
+  channel=nullptr;
+  watcher=nullptr;
   big_folder->detach();
   mini_folder->detach();
   big_doc->detach();
@@ -282,7 +468,15 @@ void FXFileList::detach(){
 void FXFileList::destroy(){
   FXIconList::destroy();
   getApp()->removeTimeout(this,ID_REFRESHTIMER);
+  getApp()->removeTimeout(this,ID_UPDATETIMER);
   getApp()->removeTimeout(this,ID_OPENTIMER);
+  getApp()->removeChore(this);
+  stopThumbnails();
+  thumbjobs.wait();
+  delete channel;
+  delete watcher;
+  channel=nullptr;
+  watcher=nullptr;
   big_folder->destroy();
   mini_folder->destroy();
   big_doc->destroy();
@@ -337,8 +531,8 @@ FXint FXFileList::compareSectionNatural(const FXchar* s1,const FXchar* s2,FXint
 
     // Get lower case
     if(ci){
-      c1=Ascii::toLower(c1);
-      c2=Ascii::toLower(c2);
+      c1=(FXuchar)Ascii::toLower(c1);
+      c2=(FXuchar)Ascii::toLower(c2);
       }
 
     // Characters differ
@@ -349,6 +543,9 @@ FXint FXFileList::compareSectionNatural(const FXchar* s1,const FXchar* s2,FXint
     s2++;
     }
 
+  // Loop may have stopped before reading c2
+  c2=(FXuchar)*s2;
+
   if(c1<' ') c1=0;
   if(c2<' ') c2=0;
 
@@ -529,6 +726,166 @@ FXint FXFileList::descendingGroup(const FXIconItem* a,const FXIconItem* b){
   return diff;
   }
 
+// Sort keys have directory flag in bit 56, above a 56-bit value which orders the
+// items the same way the corresponding sort function does; ties are left to the
+// sort function.  Keys from item text take up to 7 leading characters, stopping
+// at the first digit for natural compares, since numbers compare by value.
+#define KEYFILE FXLONG(0x0100000000000000)
+#define KEYMASK FXLONG(0x00FFFFFFFFFFFFFF)
+
+
+// Directory flag part of key
+static inline FXlong dirkey(const FXIconItem* a){
+  return static_cast<const FXFileItem*>(a)->isDirectory() ? 0 : KEYFILE;
+  }
+
+
+// Key from leading characters of name, natural compare
+static FXlong naturalkey(const FXchar* s,FXbool ci){
+  FXlong key=0;
+  FXint c,n=7;
+  while(n--){
+    c=(FXuchar)*s++;
+    if(c<' '){ key<<=8*(n+1); break; }
+    if('0'<=c && c<='9'){ key=(key<<8)|'0'; key<<=8*n; break; }
+    if(ci) c=(FXuchar)Ascii::toLower(c);
+    key=(key<<8)|c;
+    }
+  return key;
+  }
+
+
+// Key from leading characters of section, plain compare
+static FXlong sectionkey(const FXchar* s,FXint sec){
+  FXlong key=0;
+  FXint c,n=7;
+  while(sec && *s){ sec-=(*s++=='\t'); }
+  while(n--){
+    c=*s++;
+    if(c<' '){ key<<=8*(n+1); break; }
+    key=(key<<8)|c;
+    }
+  return key;
+  }
+
+
+// Key from file size or time, clamped to key range
+static inline FXlong valuekey(FXlong v){
+  return Math::iclamp(FXLONG(0),v,KEYMASK);
+  }
+
+
+// Key for file names
+FXlong FXFileList::ascendingKey(const FXIconItem* a){
+  return dirkey(a)|naturalkey(a->label.text(),false);
+  }
+
+
+// Key for reversed file names
+FXlong FXFileList::descendingKey(const FXIconItem* a){
+  return dirkey(a)|(KEYMASK-naturalkey(a->label.text(),false));
+  }
+
+
+// Key for file names, case insensitive
+FXlong FXFileList::ascendingCaseKey(const FXIconItem* a){
+  return dirkey(a)|naturalkey(a->label.text(),true);
+  }
+
+
+// Key for reversed file names, case insensitive
+FXlong FXFileList::descendingCaseKey(const FXIconItem* a){
+  return dirkey(a)|(KEYMASK-naturalkey(a->label.text(),true));
+  }
+
+
+// Key for file types
+FXlong FXFileList::ascendingTypeKey(const FXIconItem* a){
+  return dirkey(a)|sectionkey(a->label.text(),1);
+  }
+
+
+// Key for reversed file types
+FXlong FXFileList::descendingTypeKey(const FXIconItem* a){
+  return dirkey(a)|(KEYMASK-sectionkey(a->label.text(),1));
+  }
+
+
+// Key for file size
+FXlong FXFileList::ascendingSizeKey(const FXIconItem* a){
+  return dirkey(a)|valuekey(static_cast<const FXFileItem*>(a)->size);
+  }
+
+
+// Key for reversed file size
+FXlong FXFileList::descendingSizeKey(const FXIconItem* a){
+  return dirkey(a)|(KEYMASK-valuekey(static_cast<const FXFileItem*>(a)->size));
+  }
+
+
+// Key for file time; nanoseconds are coarsened to microseconds to fit
+FXlong FXFileList::ascendingTimeKey(const FXIconItem* a){
+  return dirkey(a)|valuekey(static_cast<const FXFileItem*>(a)->date/1000);
+  }
+
+
+// Key for reversed file time
+FXlong FXFileList::descendingTimeKey(const FXIconItem* a){
+  return dirkey(a)|(KEYMASK-valuekey(static_cast<const FXFileItem*>(a)->date/1000));
+  }
+
+
+// Key for file user
+FXlong FXFileList::ascendingUserKey(const FXIconItem* a){
+  return dirkey(a)|sectionkey(a->label.text(),4);
+  }
+
+
+// Key for reversed file user
+FXlong FXFileList::descendingUserKey(const FXIconItem* a){
+  return dirkey(a)|(KEYMASK-sectionkey(a->label.text(),4));
+  }
+
+
+// Key for file group
+FXlong FXFileList::ascendingGroupKey(const FXIconItem* a){
+  return dirkey(a)|sectionkey(a->label.text(),5);
+  }
+
+
+// Key for reversed file group
+FXlong FXFileList::descendingGroupKey(const FXIconItem* a){
+  return dirkey(a)|(KEYMASK-sectionkey(a->label.text(),5));
+  }
+
+
+// Sort functions and their sort keys
+static const struct { FXIconListSortFunc func; FXIconListSortKey key; } sortkeys[]={
+  {FXFileList::ascending,FXFileList::ascendingKey},
+  {FXFileList::descending,FXFileList::descendingKey},
+  {FXFileList::ascendingCase,FXFileList::ascendingCaseKey},
+  {FXFileList::descendingCase,FXFileList::descendingCaseKey},
+  {FXFileList::ascendingType,FXFileList::ascendingTypeKey},
+  {FXFileList::descendingType,FXFileList::descendingTypeKey},
+  {FXFileList::ascendingSize,FXFileList::ascendingSizeKey},
+  {FXFileList::descendingSize,FXFileList::descendingSizeKey},
+  {FXFileList::ascendingTime,FXFileList::ascendingTimeKey},
+  {FXFileList::descendingTime,FXFileList::descendingTimeKey},
+  {FXFileList::ascendingUser,FXFileList::ascendingUserKey},
+  {FXFileList::descendingUser,FXFileList::descendingUserKey},
+  {FXFileList::ascendingGroup,FXFileList::ascendingGroupKey},
+  {FXFileList::descendingGroup,FXFileList::descendingGroupKey}
+  };
+
+
+// Change sort function; use matching key for our own sort functions
+void FXFileList::setSortFunc(FXIconListSortFunc func,FXIconListSortKey key){
+  for(FXuint i=0; !key && i<ARRAYNUMBER(sortkeys); ++i){
+    if(sortkeys[i].func==func) key=sortkeys[i].key;
+    }
+  FXIconList::setSortFunc(func,key);
+  }
+
 /*******************************************************************************/
 
 // Select files matching wildcard pattern
@@ -1033,20 +1390,135 @@ long FXFileList::onEndDrag(FXObject* sender,FXSelector sel,void* ptr){
 
 /*******************************************************************************/
 
-// Cycle through items that represent images
-long FXFileList::onPreviewChore(FXObject*,FXSelector,void* ptr){
-  FXint index=(FXint)(FXival)ptr;
-  if(showImages() && iconloader && index<getNumItems()){
-    FXIcon *icon=iconloader->loadScaledIconFile(getApp(),getItemPathname(index),imagesize);
-    if(icon){
-      icon->create();
-      setItemBigIcon(index,icon,true);
-      setItemMiniIcon(index,icon,false);
+// Range of items which may currently be visible
+void FXFileList::getVisibleItems(FXint& lo,FXint& hi) const {
+  lo=hi=0;
+  if(0<itemWidth && 0<itemHeight){
+    if(options&(ICONLIST_BIG_ICONS|ICONLIST_MINI_ICONS)){
+      if(options&ICONLIST_COLUMNS){
+        lo=ncols*(-pos_y/itemHeight);
+        hi=ncols*((getVisibleHeight()-pos_y)/itemHeight+1);
+        }
+      else{
+        lo=nrows*(-pos_x/itemWidth);
+        hi=nrows*((getVisibleWidth()-pos_x)/itemWidth+1);
+        }
       }
-   if(++index<getNumItems()){
-     getApp()->addChore(this,ID_PREVIEWCHORE,(void*)(FXival)index);
-     }
-   }
+    else{
+      lo=-pos_y/itemHeight;
+      hi=(getVisibleHeight()-pos_y)/itemHeight+1;
+      }
+    lo=Math::iclamp(0,lo,getNumItems());
+    hi=Math::iclamp(lo,hi,getNumItems());
+    }
+  }
+
+
+// Find next item needing a thumbnail; visible items are done first,
+// then the remaining ones, in list order
+FXint FXFileList::nextThumbnail(){
+  FXint lo,hi,index;
+  getVisibleItems(lo,hi);
+  for(index=lo; index<hi; ++index){
+    if(((FXFileItem*)items[index])->isFile() && !(((FXFileItem*)items[index])->state&FXFileItem::PREVIEWED)) return index;
+    }
+  for(index=thumbnext; index<items.no(); ++index){
+    if(((FXFileItem*)items[index])->isFile() && !(((FXFileItem*)items[index])->state&FXFileItem::PREVIEWED)){ thumbnext=index+1; return index; }
+    }
+  thumbnext=items.no();
+  return -1;
+  }
+
+
+// Start making thumbnails; keep a few jobs per worker thread outstanding, so
+// the thumbnails for items scrolled into view don't wait behind all the others.
+// Without thread pool, make them one by one in a chore.
+void FXFileList::startThumbnails(){
+  if(showImages() && iconloader){
+    if(threadpool && threadpool->active() && channel){
+      Thumbnail *thumb;
+      FXint index;
+      while(thumbbusy<(FXint)(THUMBSPERTHREAD*threadpool->getMaximumThreads()) && 0<=(index=nextThumbnail())){
+        thumb=new Thumbnail(this,(FXFileItem*)items[index],getItemPathname(index));
+        ((FXFileItem*)items[index])->state|=FXFileItem::PREVIEWED;
+        thumb->next=thumbnails;
+        thumbnails=thumb;
+        thumbjobs.increment();
+        thumbbusy++;
+        if(!threadpool->execute(thumb,0)){
+          thumbjobs.decrement();
+          thumbbusy--;
+          thumbnails=thumb->next;
+          ((FXFileItem*)items[index])->state&=~FXFileItem::PREVIEWED;
+          delete thumb;
+          break;
+          }
+        }
+      if(thumbbusy==0 && 0<=nextThumbnail()){
+        getApp()->addChore(this,ID_PREVIEWCHORE);
+        }
+      }
+    else{
+      getApp()->addChore(this,ID_PREVIEWCHORE);
+      }
+    }
+  }
+
+
+// Cancel thumbnails being made; the worker threads drop them when they get to
+// them, so we don't have to wait for them here
+void FXFileList::stopThumbnails(){
+  Thumbnail *thumb;
+  while((thumb=thumbnails)!=nullptr){
+    thumbnails=thumb->next;
+    thumb->cancelled=true;
+    if(0<=items.find(thumb->item)) thumb->item->state&=~FXFileItem::PREVIEWED;
+    thumb->release();
+    }
+  thumbnext=0;
+  thumbbusy=0;
+  }
+
+
+// Place thumbnail on its item, if the item is still there and unchanged
+void FXFileList::showThumbnail(Thumbnail* thumb){
+  FXint index=items.find(thumb->item);
+  if(0<=index && thumb->icon && thumb->item->getDate()==thumb->date && thumb->size==imagesize && FXPath::absolute(directory,thumb->item->label.section('\t',0))==thumb->pathname){
+    thumb->icon->create();
+    setItemBigIcon(index,thumb->icon,true);
+    setItemMiniIcon(index,thumb->icon,false);
+    thumb->icon=nullptr;
+    }
+  }
+
+
+// Make thumbnails one at a time, if no thread pool
+long FXFileList::onPreviewChore(FXObject*,FXSelector,void*){
+  FXint index=nextThumbnail();
+  if(0<=index){
+    Thumbnail thumb(this,(FXFileItem*)items[index],getItemPathname(index));
+    ((FXFileItem*)items[index])->state|=FXFileItem::PREVIEWED;
+    thumb.make();
+    showThumbnail(&thumb);
+    startThumbnails();
+    }
+  return 1;
+  }
+
+
+// Thumbnail was made by worker thread
+long FXFileList::onThumbnail(FXObject*,FXSelector,void* ptr){
+  Thumbnail *thumb=*((Thumbnail**)ptr);
+  for(Thumbnail** pt=&thumbnails; *pt; pt=&(*pt)->next){
+    if(*pt==thumb && thumb->finished){
+      *pt=thumb->next;
+      thumbbusy--;
+      showThumbnail(thumb);
+      thumb->release();
+      startThumbnails();
+      break;
+      }
+    }
   return 1;
   }
 
@@ -1347,6 +1819,7 @@ long FXFileList::onUpdHeader(FXObject*,FXSelector,void*){
 /*******************************************************************************/
 
 // Periodically check to see if directory was changed, and update the list if it was.
+// This is only used if the directory could not be watched for changes.
 long FXFileList::onRefreshTimer(FXObject*,FXSelector,void*){
   if(flags&FLAG_UPDATE){
     counter+=1;
@@ -1359,6 +1832,45 @@ long FXFileList::onRefreshTimer(FXObject*,FXSelector,void*){
   }
 
 
+// Directory watcher reported a change; collect the names of the changed
+// entries, and schedule an update for a little while later
+long FXFileList::onWatchChanged(FXObject*,FXSelector,void* ptr){
+  FXString path((const FXchar*)ptr);
+  FXTRACE((TOPIC_FILELIST,"%s::onWatchChanged(%s)\n",getClassName(),path.text()));
+  if(path==directory){
+    rescan=true;
+    }
+  else if(FXPath::directory(path)==directory){
+    if(pending.used()<UPDATEBATCH){
+      pending[FXPath::name(path)]=FXString::null;
+      }
+    else{
+      rescan=true;
+      }
+    }
+  else{
+    return 0;
+    }
+  if(!getApp()->hasTimeout(this,ID_UPDATETIMER)){
+    getApp()->addTimeout(this,ID_UPDATETIMER,UPDATEDELAY);
+    }
+  return 1;
+  }
+
+
+// Apply changes reported by directory watcher
+long FXFileList::onUpdateTimer(FXObject*,FXSelector,void*){
+  if(!(flags&FLAG_UPDATE)){
+    getApp()->addTimeout(this,ID_UPDATETIMER,UPDATEDELAY);
+    return 0;
+    }
+  if(!updateItems(true)){
+    setDirectory(FXPath::validPath(directory),true);
+    }
+  return 1;
+  }
+
+
 // Force an immediate update of the list
 long FXFileList::onCmdRefresh(FXObject*,FXSelector,void*){
   listItems(true,true);
@@ -1378,6 +1890,133 @@ static FXbool fileequal(const FXchar* p1,const FXchar* p2){
   }
 
 
+// Return true if directory entry should be listed, and obtain its file information.
+// Skip item if it is hidden, if it is a directory and we want only files, if it is a
+// file and we want only directories, or if it is a file and it fails to match the
+// wildcard pattern.
+FXbool FXFileList::acceptItem(const FXString& name,const FXString& pathname,FXbool istop,FXStat& info,FXuint& mode) const {
+
+  // Suppress '.' if not showing navigational items or not at top directory
+  if(name[0]=='.'){
+    if(name[1]=='\0'){
+      if(!istop || (options&FILELIST_NO_PARENT)) return false;
+      }
+    else if(name[1]=='.' && name[2]=='\0'){
+      if(istop || (options&FILELIST_NO_PARENT)) return false;
+      }
+    else{
+      if(!(options&FILELIST_SHOWHIDDEN)) return false;
+      }
+    }
+
+#ifdef WIN32
+
+  // Get file/link info
+  if(!FXStat::statFile(pathname,info)) return false;
+
+  mode=info.mode();
+
+  // Suppress hidden files or directories
+  if((mode&FXIO::Hidden) && !(options&FILELIST_SHOWHIDDEN)) return false;
+#else
+
+  // Get file/link info
+  if(!FXStat::statLink(pathname,info)) return false;
+
+  mode=info.mode();
+
+  // If its a link, get file mode from target
+  if(info.isLink()){
+    mode=FXStat::mode(pathname) | FXIO::SymLink;
+    }
+
+#endif
+
+  // Check type and pattern
+  if(mode&FXIO::Directory){
+    if(options&FILELIST_SHOWFILES) return false;
+    }
+  else{
+    if(options&FILELIST_SHOWDIRS) return false;
+    if(!FXPath::match(name,pattern,matchmode)) return false;
+    }
+  return true;
+  }
+
+
+// Make new item for directory entry
+FXFileItem* FXFileList::buildItem(const FXString& name,const FXString& pathname,const FXStat& info,FXuint mode){
+  FXFileItem *newitem=(FXFileItem*)createItem(FXString::null,nullptr,nullptr,nullptr);
+  FXString    extension;
+  FXString    label;
+  FXString    grpid;
+  FXString    usrid;
+  FXString    attrs;
+  FXString    modtm;
+  FXString    lnknm;
+
+  // Obtain user name
+  usrid=FXSystem::userName(info.user());
+
+  // Obtain group name
+  grpid=FXSystem::groupName(info.group());
+
+  // Permissions
+  attrs=FXSystem::modeString(mode);
+
+  // Mod time
+  modtm=FXSystem::localTime(info.modified(),timeformat.text());
+
+  // Link name, if any
+  if(info.isLink()) lnknm=FXFile::symlink(pathname);
+
+  // Update item information
+  newitem->setDraggable(draggable);
+  newitem->setSize(info.size());
+  newitem->setDate(info.modified());
+  newitem->setMode(mode);
+  newitem->setAssoc(nullptr);
+
+  // Determine icons and type
+  if(newitem->isDirectory()){
+    extension=tr("Folder");
+    newitem->setBigIcon(big_folder);
+    newitem->setMiniIcon(mini_folder);
+    if(associations) newitem->setAssoc(associations->findDirBinding(pathname));
+    }
+  else if(newitem->isExecutable()){
+    extension=tr("Application");
+    newitem->setBigIcon(big_app);
+    newitem->setMiniIcon(mini_app);
+    if(associations) newitem->setAssoc(associations->findExecBinding(pathname));
+    }
+  else{
+    extension=tr("Document");
+    newitem->setBigIcon(big_doc);
+    newitem->setMiniIcon(mini_doc);
+    if(associations) newitem->setAssoc(associations->findFileBinding(pathname));
+    }
+
+  // If association is found, use it
+  if(newitem->getAssoc()){
+    extension=newitem->getAssoc()->extension;
+    if(newitem->getAssoc()->bigicon) newitem->setBigIcon(newitem->getAssoc()->bigicon);
+    if(newitem->getAssoc()->miniicon) newitem->setMiniIcon(newitem->getAssoc()->miniicon);
+    }
+
+  // Update item information
+  label.format("%s\t%s\t%'lld\t%s\t%s\t%s\t%s\t%s",name.text(),extension.text(),newitem->size,modtm.text(),usrid.text(),grpid.text(),attrs.text(),lnknm.text());
+
+  // New label
+  newitem->setText(label);
+
+  // Create item
+  if(id()) newitem->create();
+
+  return newitem;
+  }
+
+
 // List the items in the directory.
 // Regenerate the list if an update is forced or the directory timestamp was changed.
 // Add, remove, or update items as needed, generating the proper callbacks.
@@ -1404,14 +2043,7 @@ FXbool FXFileList::listItems(FXbool force,FXbool notify){
       FXFileItem  *newitem;
       FXFileItem  *link;
       FXString     pathname;
-      FXString     extension;
-      FXString     label;
       FXString     name;
-      FXString     grpid;
-      FXString     usrid;
-      FXString     attrs;
-      FXString     modtm;
-      FXString     lnknm;
       FXuint       mode;
       FXbool       istop;
       FXDir        dir;
@@ -1425,56 +2057,13 @@ FXbool FXFileList::listItems(FXbool force,FXbool notify){
         // Loop over directory entries
         while(dir.next(name)){
 
-          // Suppress '.' if not showing navigational items or not at top directory
-          if(name[0]=='.'){
-            if(name[1]=='\0'){
-              if(!istop || (options&FILELIST_NO_PARENT)) continue;
-              }
-            else if(name[1]=='.' && name[2]=='\0'){
-              if(istop || (options&FILELIST_NO_PARENT)) continue;
-              }
-            else{
-              if(!(options&FILELIST_SHOWHIDDEN)) continue;
-              }
-            }
-
           // Build full pathname
           pathname=directory;
           if(!ISPATHSEP(pathname.tail())) pathname+=PATHSEPSTRING;
           pathname+=name;
 
-#ifdef WIN32
-
-          // Get file/link info
-          if(!FXStat::statFile(pathname,info)) continue;
-
-          mode=info.mode();
-
-          // Suppress hidden files or directories
-          if((mode&FXIO::Hidden) && !(options&FILELIST_SHOWHIDDEN)) continue;
-#else
-
-          // Get file/link info
-          if(!FXStat::statLink(pathname,info)) continue;
-
-          mode=info.mode();
-
-          // If its a link, get file mode from target
-          if(info.isLink()){
-            mode=FXStat::mode(pathname) | FXIO::SymLink;
-            }
-
-#endif
-
-          // Skip item if it is a directory and we want only files, if it is a file and we want only directories,
-          // or if it is a file and it fails to match the wildcard pattern.
-          if(mode&FXIO::Directory){
-            if(options&FILELIST_SHOWFILES) continue;
-            }
-          else{
-            if(options&FILELIST_SHOWDIRS) continue;
-            if(!FXPath::match(name,pattern,matchmode)) continue;
-            }
+          // Skip item if not to be listed
+          if(!acceptItem(name,pathname,istop,info,mode)) continue;
 
           // Search for item in old list, unlink from old if found
           for(FXFileItem** pp=po; (olditem=*pp)!=nullptr; pp=&olditem->link){
@@ -1488,66 +2077,7 @@ FXbool FXFileList::listItems(FXbool force,FXbool notify){
           if(force || !olditem || olditem->getDate()!=info.modified() || olditem->getSize()!=info.size() || olditem->getMode()!=mode){
 
             // Make new item
-            newitem=(FXFileItem*)createItem(FXString::null,nullptr,nullptr,nullptr);
-
-            // Obtain user name
-            usrid=FXSystem::userName(info.user());
-
-            // Obtain group name
-            grpid=FXSystem::groupName(info.group());
-
-            // Permissions
-            attrs=FXSystem::modeString(mode);
-
-            // Mod time
-            modtm=FXSystem::localTime(info.modified(),timeformat.text());
-
-            // Link name, if any
-            lnknm=FXString::null;
-            if(info.isLink()) lnknm=FXFile::symlink(pathname);
-
-            // Update item information
-            newitem->setDraggable(draggable);
-            newitem->setSize(info.size());
-            newitem->setDate(info.modified());
-            newitem->setMode(mode);
-            newitem->setAssoc(nullptr);
-
-            // Determine icons and type
-            if(newitem->isDirectory()){
-              extension=tr("Folder");
-              newitem->setBigIcon(big_folder);
-              newitem->setMiniIcon(mini_folder);
-              if(associations) newitem->setAssoc(associations->findDirBinding(pathname));
-              }
-            else if(newitem->isExecutable()){
-              extension=tr("Application");
-              newitem->setBigIcon(big_app);
-              newitem->setMiniIcon(mini_app);
-              if(associations) newitem->setAssoc(associations->findExecBinding(pathname));
-              }
-            else{
-              extension=tr("Document");
-              newitem->setBigIcon(big_doc);
-              newitem->setMiniIcon(mini_doc);
-              if(associations) newitem->setAssoc(associations->findFileBinding(pathname));
-              }
-
-            // If association is found, use it
-            if(newitem->getAssoc()){
-              extension=newitem->getAssoc()->extension;
-              if(newitem->getAssoc()->bigicon) newitem->setBigIcon(newitem->getAssoc()->bigicon);
-              if(newitem->getAssoc()->miniicon) newitem->setMiniIcon(newitem->getAssoc()->miniicon);
-              }
-
-            // Update item information
-            label.format("%s\t%s\t%'lld\t%s\t%s\t%s\t%s\t%s",name.text(),extension.text(),newitem->size,modtm.text(),usrid.text(),grpid.text(),attrs.text(),lnknm.text());
-
-            // New label
-            newitem->setText(label);
-
-            // Create item
-            if(id()) newitem->create();
+            newitem=buildItem(name,pathname,info,mode);
 
             // Replace or add item
             if(olditem){
@@ -1565,11 +2095,6 @@ FXbool FXFileList::listItems(FXbool force,FXbool notify){
             }
           }
 
-        // Show thumbnails
-        if(showImages()){
-          getApp()->addChore(this,ID_PREVIEWCHORE,(void*)(FXival)0);
-          }
-
         // Close directory
         dir.close();
         }
@@ -1586,6 +2111,12 @@ FXbool FXFileList::listItems(FXbool force,FXbool notify){
       // Update sort order
       sortItems();
 
+      // Show thumbnails
+      if(showImages()){
+        thumbnext=0;
+        startThumbnails();
+        }
+
       // Update timestamp
       timestamp=time;
 
@@ -1597,6 +2128,103 @@ FXbool FXFileList::listItems(FXbool force,FXbool notify){
   return false;
   }
 
+
+// Update the item for a single entry of the current directory; add, remove,
+// or replace the item as needed, generating the proper callbacks.
+void FXFileList::updateItem(const FXString& name,FXbool notify){
+  FXString     pathname(FXPath::absolute(directory,name));
+  FXFileItem **pp=&list;
+  FXFileItem  *olditem;
+  FXFileItem  *newitem;
+  FXStat       info;
+  FXuint       mode;
+
+  FXTRACE((TOPIC_FILELIST,"%s::updateItem(%s,%d)\n",getClassName(),name.text(),notify));
+
+  // Search for item in list
+  while((olditem=*pp)!=nullptr && !fileequal(olditem->label.text(),name.text())){
+    pp=&olditem->link;
+    }
+
+  // Entry still to be listed
+  if(acceptItem(name,pathname,FXPath::isTopDirectory(directory),info,mode)){
+
+    // Keep old item if nothing changed
+    if(olditem && olditem->getDate()==info.modified() && olditem->getSize()==info.size() && olditem->getMode()==mode) return;
+
+    // Make new item
+    newitem=buildItem(name,pathname,info,mode);
+
+    // Replace or add item
+    if(olditem){
+      newitem->link=olditem->link;
+      *pp=newitem;
+      setItem(items.find(olditem),newitem,notify);
+      }
+    else{
+      *pp=newitem;
+      appendItem(newitem,notify);
+      }
+    }
+
+  // Entry was removed, or should no longer be listed
+  else if(olditem){
+    *pp=olditem->link;
+    removeItem(items.find(olditem),notify);
+    }
+  }
+
+
+// Apply changes collected by the directory watcher.
+// Update just the changed items, or re-scan the whole directory if the directory
+// itself was changed or too many items were changed.
+// Return false if the directory can not be accessed, true otherwise.
+FXbool FXFileList::updateItems(FXbool notify){
+  FXbool result=true;
+  FXTRACE((TOPIC_FILELIST,"%s::updateItems(%d) rescan=%d pending=%ld\n",getClassName(),notify,rescan,pending.used()));
+  if(rescan){
+    timestamp=0;
+    result=listItems(false,notify);
+    }
+  else if(pending.used()){
+    if(FXStat::isDirectory(directory)){
+      for(FXival i=0; i<pending.no(); ++i){
+        if(pending.empty(i)) continue;
+        updateItem(pending.key(i),notify);
+        }
+      sortItems();
+      if(showImages()){
+        thumbnext=0;
+        startThumbnails();
+        }
+      }
+    else{
+      result=false;
+      }
+    }
+  pending.clear();
+  rescan=false;
+  return result;
+  }
+
+
+// Watch current directory for changes; poll it if it can't be watched
+void FXFileList::watchDirectory(){
+  pending.clear();
+  rescan=false;
+  getApp()->removeTimeout(this,ID_UPDATETIMER);
+  if(watcher){
+    watcher->clearAll();
+    if(watcher->addWatch(directory)){
+      FXTRACE((TOPIC_FILELIST,"%s::watchDirectory(%s): watching\n",getClassName(),directory.text()));
+      getApp()->removeTimeout(this,ID_REFRESHTIMER);
+      return;
+      }
+    }
+  FXTRACE((TOPIC_FILELIST,"%s::watchDirectory(%s): polling\n",getClassName(),directory.text()));
+  getApp()->addTimeout(this,ID_REFRESHTIMER,REFRESHINTERVAL);
+  }
+
 /*******************************************************************************/
 
 // Set current file; return true if success
@@ -1631,9 +2259,12 @@ FXbool FXFileList::setDirectory(const FXString& pathname,FXbool notify){
   FXString path(FXPath::absolute(directory,pathname));
   if(FXStat::isDirectory(path)){
     if(directory==path) return true;
+    getApp()->removeChore(this,ID_PREVIEWCHORE);
+    stopThumbnails();
     clearItems(notify);
     directory=path;
     list=nullptr;
+    if(id()) watchDirectory();
     if(listItems(true,notify)){
       if(getNumItems()){
         makeItemVisible(0);
@@ -1864,6 +2495,29 @@ void FXFileList::setTimeFormat(const FXString& fmt,FXbool notify){
 
 /*******************************************************************************/
 
+// Change thread pool used to make thumbnails
+void FXFileList::setThreadPool(FXThreadPool* pool){
+  if(threadpool!=pool){
+    stopThumbnails();
+    threadpool=pool;
+    startThumbnails();
+    }
+  }
+
+
+// Change thumbnail cache directory
+void FXFileList::setThumbnailDirectory(const FXString& dir){
+  if(thumbdir!=dir){
+    stopThumbnails();
+    thumbdir=dir;
+    if(!thumbdir.empty() && !FXStat::isDirectory(thumbdir)){
+      FXDir::createDirectories(thumbdir);
+      }
+    startThumbnails();
+    }
+  }
+
+
 // Save data
 void FXFileList::save(FXStream& store) const {
   FXIconList::save(store);
@@ -1909,6 +2563,11 @@ FXFileList::~FXFileList(){
   getApp()->removeChore(this);
   getApp()->removeTimeout(this,ID_OPENTIMER);
   getApp()->removeTimeout(this,ID_REFRESHTIMER);
+  getApp()->removeTimeout(this,ID_UPDATETIMER);
+  stopThumbnails();
+  thumbjobs.wait();
+  delete channel;
+  delete watcher;
   if(!(options&FILELIST_NO_OWN_ASSOC)) delete associations;
   delete big_folder;
   delete mini_folder;
@@ -1919,6 +2578,10 @@ FXFileList::~FXFileList(){
   associations=(FXFileAssociations*)-1L;
   iconloader=(FXIconSource*)-1L;
   list=(FXFileItem*)-1L;
+  watcher=(FXDirWatch*)-1L;
+  threadpool=(FXThreadPool*)-1L;
+  channel=(FXMessageChannel*)-1L;
+  thumbnails=(Thumbnail*)-1L;
   big_folder=(FXIcon*)-1L;
   mini_folder=(FXIcon*)-1L;
   big_doc=(FXIcon*)-1L;
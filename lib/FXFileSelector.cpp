@@ -33,6 +33,8 @@
 #include "FXHash.h"
 #include "FXStream.h"
 #include "FXObjectList.h"
+#include "FXSemaphore.h"
+#include "FXCompletion.h"
 #include "FXString.h"
 #include "FXPath.h"
 #include "FXSystem.h"
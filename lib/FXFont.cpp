@@ -127,6 +127,17 @@
 
   - Get encoding from locale (see X11).
 
+  - Advance widths of glyphs are cached, as measuring them one by one (e.g.
+    XftTextExtents32() for each character) is slow, and FXText measures text
+    one character at a time.  Advances of BMP characters are kept in pages of
+    256, allocated the first time a character in the page is measured; those of
+    characters beyond the BMP are kept in a hash table.
+  - With Xft, getTextWidth() sums cached advances for unrotated fonts, instead of
+    calling XftTextExtentsUtf8(); runs of ASCII are checked 8 bytes at a time,
+    and summed straight from the first page, which is filled all at once.
+  - Rotated fonts are not cached, as their advances may be negative, and the
+    cache is dropped when the font is destroyed or detached.
+
 */
 
 #define TOPIC_CONSTRUCT 1000
@@ -143,6 +154,15 @@ static const FXint LEAD_OFFSET=0xD800-(0x10000>>10);
 static const FXint TAIL_OFFSET=0xDC00;
 
 
+// Cached glyph advance widths
+struct FXFont::Advances {
+  FXshort *page[256];           // Advances of BMP characters, -1 if not yet measured
+  FXHash   other;               // Advances plus one of characters beyond the BMP
+  Advances(){ clearElms(page,256); }
+ ~Advances(){ for(FXint i=0; i<256; ++i){ freeElms(page[i]); } }
+  };
+
+
 extern FXAPI FXint __snprintf(FXchar* string,FXint length,const FXchar* format,...);
 
 #if defined(WIN32) /////////////////////////// WIN32 ////////////////////////////
@@ -1051,6 +1071,7 @@ FXFont::FXFont(){
   flags=0;
   angle=0;
   font=nullptr;
+  advances=nullptr;
 #ifdef WIN32
   dc=nullptr;
 #endif
@@ -1074,6 +1095,7 @@ FXFont::FXFont(FXApp* a,const FXString& string):FXId(a){
   flags=0;
   angle=0;
   font=nullptr;
+  advances=nullptr;
 #ifdef WIN32
   dc=nullptr;
 #endif
@@ -1098,6 +1120,7 @@ FXFont::FXFont(FXApp* a,const FXString& face,FXuint size,FXuint weight,FXuint sl
   flags=0;
   angle=0;
   font=nullptr;
+  advances=nullptr;
 #ifdef WIN32
   dc=nullptr;
 #endif
@@ -1121,6 +1144,7 @@ FXFont::FXFont(FXApp* a,const FXFontDesc& fontdesc):FXId(a),wantedName(fontdesc.
   flags=0;
   angle=0;
   font=nullptr;
+  advances=nullptr;
 #ifdef WIN32
   dc=nullptr;
 #endif
@@ -1326,6 +1350,7 @@ void FXFont::detach(){
     actualEncoding=0;
     font=nullptr;
     xid=0;
+    clearAdvances();
     }
   }
 
@@ -1372,6 +1397,7 @@ void FXFont::destroy(){
     actualEncoding=0;
     font=nullptr;
     xid=0;
+    clearAdvances();
     }
   }
 
@@ -1622,8 +1648,8 @@ FXint FXFont::getFontDescent() const {
   }
 
 
-// Calculate width of single wide character in this font
-FXint FXFont::getCharWidth(const FXwchar ch) const {
+// Measure width of single wide character, bypassing cache
+FXint FXFont::measureChar(FXwchar ch) const {
   if(font){
 #if defined(WIN32)              ///// WIN32 /////
     FXnchar sbuffer[2];
@@ -1666,6 +1692,81 @@ FXint FXFont::getCharWidth(const FXwchar ch) const {
   }
 
 
+// Return cached advance width of character, measuring it if not yet known
+FXint FXFont::advance(FXwchar ch) const {
+  FXival w;
+  if(!advances){
+    ((FXFont*)this)->advances=new Advances;
+    }
+  if(ch<0x10000){
+    FXshort*& page=advances->page[ch>>8];
+    if(!page){
+      allocElms(page,256);
+      fillElms(page,(FXshort)-1,256);
+      }
+    if(page[ch&255]<0){
+      page[ch&255]=(FXshort)measureChar(ch);
+      }
+    return page[ch&255];
+    }
+  w=(FXival)advances->other.at((const void*)(FXuval)ch);
+  if(!w){
+    w=measureChar(ch)+1;
+    advances->other.at((const void*)(FXuval)ch)=(void*)w;
+    }
+  return (FXint)(w-1);
+  }
+
+
+// Sum cached advance widths of utf8 string
+FXint FXFont::sumAdvances(const FXchar* string,FXuint length) const {
+  const FXuchar* s=(const FXuchar*)string;
+  const FXshort* ascii;
+  FXint width=0;
+  FXuint p=0;
+  FXulong bytes;
+  FXwchar w;
+  if(!advances || !advances->page[0] || advances->page[0][127]<0){
+    for(w=0; w<128; ++w) advance(w);
+    }
+  ascii=advances->page[0];
+  while(p<length){
+    while(p+8<=length){
+      memcpy(&bytes,s+p,8);
+      if(bytes&FXULONG(0x8080808080808080)) break;
+      width+=ascii[s[p]]+ascii[s[p+1]]+ascii[s[p+2]]+ascii[s[p+3]]+ascii[s[p+4]]+ascii[s[p+5]]+ascii[s[p+6]]+ascii[s[p+7]];
+      p+=8;
+      }
+    if(p>=length) break;
+    if(s[p]<0x80){
+      width+=ascii[s[p++]];
+      continue;
+      }
+    w=wc(string+p);
+    p+=wclen(string+p);
+    width+=advance(w);
+    }
+  return width;
+  }
+
+
+// Drop cached advance widths
+void FXFont::clearAdvances(){
+  delete advances;
+  advances=nullptr;
+  }
+
+
+// Calculate width of single wide character in this font
+FXint FXFont::getCharWidth(const FXwchar ch) const {
+  if(font){
+    if(!angle) return advance(ch);
+    return measureChar(ch);
+    }
+  return 1;
+  }
+
+
 // Text width
 FXint FXFont::getTextWidth(const FXchar *string,FXuint length) const {
   if(!string && length){ fxerror("%s::getTextWidth: NULL string argument\n",getClassName()); }
@@ -1678,6 +1779,7 @@ FXint FXFont::getTextWidth(const FXchar *string,FXuint length) const {
     return size.cx;
 #elif defined(HAVE_XFT_H)       ///// XFT /////
     XGlyphInfo extents;
+    if(!angle){ return sumAdvances(string,length); }
     // This returns rotated metrics; FOX likes to work with unrotated metrics, so if angle
     // is not 0, we calculate the unrotated baseline; note however that the calculation is
     // not 100% pixel exact when the angle is not a multiple of 90 degrees.
@@ -2948,6 +3050,7 @@ void FXFont::load(FXStream& store){
 FXFont::~FXFont(){
   FXTRACE((TOPIC_CONSTRUCT,"FXFont::~FXFont %p\n",this));
   destroy();
+  clearAdvances();
   }
 
 }
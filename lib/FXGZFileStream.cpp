@@ -23,11 +23,22 @@
 #include "fxdefs.h"
 #include "fxmath.h"
 #include "FXElement.h"
+#include "FXArray.h"
 #include "FXMetaClass.h"
 #include "FXHash.h"
 #include "FXStream.h"
 #include "FXFile.h"
 #include "FXGZFileStream.h"
+#include "FXPtrList.h"
+#include "FXAtomic.h"
+#include "FXSemaphore.h"
+#include "FXCompletion.h"
+#include "FXRunnable.h"
+#include "FXAutoThreadStorageKey.h"
+#include "FXThread.h"
+#include "FXLFQueue.h"
+#include "FXWSQueue.h"
+#include "FXThreadPool.h"
 
 #ifdef HAVE_ZLIB_H
 #include "zlib.h"
@@ -37,9 +48,34 @@
   - Very basic compressed file I/O only.
   - Updated for new stream classes 2003/07/08.
   - Updated for FXFile 2005/09/03.
+  - With a thread pool, data is cut into blocks of the given size, each handed to
+    a worker and compressed as a raw deflate stream of its own, without preset
+    dictionary; only the last block may be shorter.  The buffer has a little room
+    past the block size, so values straddling the end of a block still fit; flush()
+    writes out whole blocks only, leaving the rest in the buffer.  The blocks
+    but the last end with a sync flush, so they end on a byte boundary and can
+    simply be concatenated.  The zlib header goes in front, and the
+    Adler-32 checksum of all data, combined from those of the blocks, after.
+  - Up to twice as many blocks as the thread pool has threads are in flight;
+    they are written in order as they finish, and if the thread pool is not
+    running, they are compressed on the calling thread.
+  - After the compressed stream follows an index: for each block, its size when
+    compressed and uncompressed, then the block size, the number of blocks, and a
+    magic number, all 32-bit little endian.  Inflate ignores anything after the end of the
+    stream, so such files can be read by zlib as usual.
+  - The index is trusted only if the sizes add up to the size of the file, and all
+    blocks but the last have the block size, the last no more than that; when
+    loading with a thread pool, the compressed blocks are read in order by the
+    calling thread, and inflated ahead by the workers.  The checksum is verified
+    before handing out the data of the last block.
 */
 
-#define BUFFERSIZE 8192
+#define BUFFERSIZE 8192         // Buffer for compressed data
+#define MINBLOCK   65536        // Minimum block size for block compression
+#define MAXBLOCK   1073741824   // Maximum block size for block compression
+#define MAXPARTS   64           // Maximum blocks in flight
+#define BLOCKSLACK 16           // Room in buffer past end of block
+#define INDEXMAGIC 0x58444E49   // Magic number of block index "INDX"
 
 /*******************************************************************************/
 
@@ -53,17 +89,179 @@ struct ZBlock {
   };
 
 
+// Block being compressed or decompressed by worker
+struct ZPart : public FXRunnable {
+  FXCompletion done;            // Signalled when worker finished
+  Bytef       *data;            // Uncompressed data
+  Bytef       *comp;            // Compressed data
+  FXuval       size;            // Size of uncompressed data
+  FXuval       csize;           // Size of compressed data
+  FXuval       dspace;          // Space for uncompressed data
+  FXuval       cspace;          // Space for compressed data
+  uLong        check;           // Adler-32 of uncompressed data
+  FXint        level;           // Compression level
+  FXbool       deflating;       // Compressing, or else decompressing
+  FXbool       last;            // Last block of stream
+  FXbool       ok;              // Worker succeeded
+public:
+  ZPart():data(nullptr),comp(nullptr),size(0),csize(0),dspace(0),cspace(0),check(0),level(Z_DEFAULT_COMPRESSION),deflating(true),last(false),ok(false){}
+  virtual FXint run();
+  FXbool compress();
+  FXbool decompress();
+  virtual ~ZPart();
+  };
+
+
+// Blocks in flight, and index of blocks
+struct ZQueue {
+  ZPart           parts[MAXPARTS];      // Ring of blocks
+  FXArray<FXuint> index;                // Compressed and uncompressed size of each block
+  uLong           check;                // Adler-32 of blocks retired so far
+  FXuval          blocksize;            // Size of blocks
+  FXint           nparts;               // Size of ring in use
+  FXint           head;                 // Oldest block in flight
+  FXint           count;                // Number of blocks in flight
+  FXint           next;                 // Next block to read, when loading
+  FXint           current;              // Block being loaded from, or -1
+  FXuval          offset;               // Offset of data not yet loaded from current block
+  FXbool          failed;               // Block failed to decompress
+  };
+
+
+// Compress or decompress block
+FXint ZPart::run(){
+  ok=deflating?compress():decompress();
+  done.decrement();
+  return 0;
+  }
+
+
+// Compress block as raw deflate stream; all but last block end with a sync flush
+FXbool ZPart::compress(){
+  z_stream stream;
+  FXbool result=false;
+  memset(&stream,0,sizeof(stream));
+  check=adler32(adler32(0L,Z_NULL,0),data,(uInt)size);
+  if(deflateInit2(&stream,level,Z_DEFLATED,-MAX_WBITS,8,Z_DEFAULT_STRATEGY)==Z_OK){
+    FXuval space=deflateBound(&stream,(uLong)size)+64;
+    if(space<=cspace || resizeElms(comp,space)){
+      cspace=FXMAX(cspace,space);
+      stream.next_in=data;
+      stream.avail_in=(uInt)size;
+      stream.next_out=comp;
+      stream.avail_out=(uInt)cspace;
+      if(last){
+        result=(deflate(&stream,Z_FINISH)==Z_STREAM_END);
+        }
+      else{
+        result=(deflate(&stream,Z_SYNC_FLUSH)==Z_OK && stream.avail_in==0 && stream.avail_out!=0);
+        }
+      csize=stream.total_out;
+      }
+    deflateEnd(&stream);
+    }
+  return result;
+  }
+
+
+// Decompress block; it must produce exactly the expected amount of data
+FXbool ZPart::decompress(){
+  z_stream stream;
+  FXbool result=false;
+  int zerror;
+  memset(&stream,0,sizeof(stream));
+  if(inflateInit2(&stream,-MAX_WBITS)==Z_OK){
+    stream.next_in=comp;
+    stream.avail_in=(uInt)csize;
+    stream.next_out=data;
+    stream.avail_out=(uInt)size;
+    zerror=inflate(&stream,Z_SYNC_FLUSH);
+    if(last){
+      result=(zerror==Z_STREAM_END && stream.total_out==size);
+      }
+    else{
+      result=((zerror==Z_OK || zerror==Z_BUF_ERROR) && stream.total_out==size && stream.avail_in==0);
+      }
+    check=adler32(adler32(0L,Z_NULL,0),data,(uInt)size);
+    inflateEnd(&stream);
+    }
+  return result;
+  }
+
+
+// Wait till worker is done, then free buffers
+ZPart::~ZPart(){
+  done.wait();
+  freeElms(data);
+  freeElms(comp);
+  }
+
+
+// Write 32-bit value, little endian
+static void putLE32(Bytef* p,FXuint v){
+  p[0]=(Bytef)v;
+  p[1]=(Bytef)(v>>8);
+  p[2]=(Bytef)(v>>16);
+  p[3]=(Bytef)(v>>24);
+  }
+
+
+// Read 32-bit value, little endian
+static FXuint getLE32(const Bytef* p){
+  return ((FXuint)p[3]<<24)|((FXuint)p[2]<<16)|((FXuint)p[1]<<8)|((FXuint)p[0]);
+  }
+
+
 // Create GZIP compressed file stream
-FXGZFileStream::FXGZFileStream(const FXObject* cont):FXFileStream(cont),gz(nullptr),ac(0){
+FXGZFileStream::FXGZFileStream(const FXObject* cont):FXFileStream(cont),gz(nullptr),pz(nullptr),pool(nullptr),ac(0),level(Z_DEFAULT_COMPRESSION){
   }
 
 
 // Create and open GZIP compressed file stream
-FXGZFileStream::FXGZFileStream(const FXString& filename,FXStreamDirection save_or_load,FXuval size):gz(nullptr),ac(0){
+FXGZFileStream::FXGZFileStream(const FXString& filename,FXStreamDirection save_or_load,FXuval size):gz(nullptr),pz(nullptr),pool(nullptr),ac(0),level(Z_DEFAULT_COMPRESSION){
   open(filename,save_or_load,size);
   }
 
 
+// Hand size bytes of buffer contents to worker as next block; if all
+// blocks are in flight, first retire the oldest one
+FXbool FXGZFileStream::submitPart(FXuval size,FXbool last){
+  if(pz->count>=pz->nparts && !retirePart()) return false;
+  ZPart& part=pz->parts[(pz->head+pz->count)%pz->nparts];
+  if(part.dspace<size){
+    if(!resizeElms(part.data,pz->blocksize)) return false;
+    part.dspace=pz->blocksize;
+    }
+  part.size=size;
+  memcpy(part.data,rdptr,part.size);
+  part.level=level;
+  part.deflating=true;
+  part.last=last;
+  part.ok=false;
+  part.done.increment();
+  if(!pool || !pool->execute(&part)) part.run();
+  pz->count++;
+  rdptr+=size;
+  return true;
+  }
+
+
+// Wait for oldest block in flight, and write it out
+FXbool FXGZFileStream::retirePart(){
+  ZPart& part=pz->parts[pz->head];
+  FXASSERT(0<pz->count);
+  if(!pool || !pool->waitFor(part.done)) part.done.wait();
+  pz->head=(pz->head+1)%pz->nparts;
+  pz->count--;
+  if(!part.ok) return false;
+  if(file.writeBlock(part.comp,part.csize)!=(FXival)part.csize) return false;
+  pz->check=adler32_combine(pz->check,part.check,(z_off_t)part.size);
+  pz->index.append((FXuint)part.csize);
+  pz->index.append((FXuint)part.size);
+  return true;
+  }
+
+
 // Save to a file
 FXuval FXGZFileStream::writeBuffer(FXuval){
   FXival m,n; int zerror;
@@ -71,6 +269,37 @@ FXuval FXGZFileStream::writeBuffer(FXuval){
   FXASSERT(begptr<=rdptr);
   FXASSERT(rdptr<=wrptr);
   FXASSERT(wrptr<=endptr);
+  if(pz){
+    if(code==FXStreamOK){
+      while(pz->blocksize<=(FXuval)(wrptr-rdptr) && code==FXStreamOK){
+        if(!submitPart(pz->blocksize,false)) code=FXStreamFull;
+        }
+      if(ac==Z_FINISH && code==FXStreamOK && !submitPart(wrptr-rdptr,true)){ code=FXStreamFull; }
+      if(ac==Z_FINISH || ac==Z_SYNC_FLUSH){
+        while(0<pz->count && code==FXStreamOK){
+          if(!retirePart()) code=FXStreamFull;
+          }
+        }
+      if(ac==Z_FINISH && code==FXStreamOK){             // Checksum, then index
+        FXArray<Bytef> trailer(4+4*pz->index.no()+12);
+        trailer[0]=(Bytef)(pz->check>>24);
+        trailer[1]=(Bytef)(pz->check>>16);
+        trailer[2]=(Bytef)(pz->check>>8);
+        trailer[3]=(Bytef)(pz->check);
+        for(FXint i=0; i<pz->index.no(); ++i){
+          putLE32(&trailer[4+4*i],pz->index[i]);
+          }
+        putLE32(&trailer[trailer.no()-12],(FXuint)pz->blocksize);
+        putLE32(&trailer[trailer.no()-8],pz->index.no()/2);
+        putLE32(&trailer[trailer.no()-4],INDEXMAGIC);
+        if(file.writeBlock(trailer.data(),trailer.no())!=trailer.no()){ code=FXStreamFull; }
+        }
+      }
+    if(rdptr<wrptr){memmove(begptr,rdptr,wrptr-rdptr);}
+    wrptr=begptr+(wrptr-rdptr);
+    rdptr=begptr;
+    return endptr-wrptr;
+    }
   while(rdptr<wrptr || ac==Z_FINISH || ac==Z_SYNC_FLUSH){
     gz->stream.next_in=(Bytef*)rdptr;
     gz->stream.avail_in=wrptr-rdptr;
@@ -91,6 +320,33 @@ FXuval FXGZFileStream::writeBuffer(FXuval){
   }
 
 
+// Read compressed data of next block, and hand it to worker
+FXbool FXGZFileStream::schedulePart(){
+  ZPart& part=pz->parts[(pz->head+pz->count)%pz->nparts];
+  FXuint csize=pz->index[2*pz->next];
+  FXuint size=pz->index[2*pz->next+1];
+  if(part.cspace<csize){
+    if(!resizeElms(part.comp,csize)) return false;
+    part.cspace=csize;
+    }
+  if(part.dspace<size){
+    if(!resizeElms(part.data,size)) return false;
+    part.dspace=size;
+    }
+  if(file.readBlock(part.comp,csize)!=(FXival)csize) return false;
+  part.csize=csize;
+  part.size=size;
+  part.deflating=false;
+  part.last=(pz->next+1==pz->index.no()/2);
+  part.ok=false;
+  part.done.increment();
+  if(!pool || !pool->execute(&part)) part.run();
+  pz->count++;
+  pz->next++;
+  return true;
+  }
+
+
 // Load from file
 FXuval FXGZFileStream::readBuffer(FXuval){
   FXival n; int zerror;
@@ -101,6 +357,38 @@ FXuval FXGZFileStream::readBuffer(FXuval){
   if(rdptr<wrptr){memmove(begptr,rdptr,wrptr-rdptr);}
   wrptr=begptr+(wrptr-rdptr);
   rdptr=begptr;
+  if(pz){
+    while(wrptr<endptr && !pz->failed){
+      if(0<=pz->current){                               // Copy from current block
+        ZPart& part=pz->parts[pz->current];
+        if(pz->offset<part.size){
+          n=FXMIN((FXuval)(endptr-wrptr),part.size-pz->offset);
+          memcpy(wrptr,part.data+pz->offset,n);
+          pz->offset+=n;
+          wrptr+=n;
+          continue;
+          }
+        pz->head=(pz->head+1)%pz->nparts;               // Done with current block
+        pz->count--;
+        pz->current=-1;
+        }
+      while(pz->count<pz->nparts && pz->next<pz->index.no()/2){
+        if(!schedulePart()) break;
+        }
+      if(pz->count<=0) break;                           // No more blocks
+      ZPart& part=pz->parts[pz->head];
+      if(!pool || !pool->waitFor(part.done)) part.done.wait();
+      if(!part.ok){ pz->failed=true; break; }           // Error occurred
+      pz->check=adler32_combine(pz->check,part.check,(z_off_t)part.size);
+      if(part.last){                                    // Verify checksum
+        Bytef trailer[4];
+        if(file.readBlock(trailer,4)!=4 || ((FXuint)trailer[0]<<24|(FXuint)trailer[1]<<16|(FXuint)trailer[2]<<8|(FXuint)trailer[3])!=(FXuint)pz->check){ pz->failed=true; break; }
+        }
+      pz->current=pz->head;
+      pz->offset=0;
+      }
+    return wrptr-rdptr;
+    }
   while(wrptr<endptr){
     if(gz->stream.avail_in<=0){                         // Read more input
       n=file.readBlock(gz->buffer,BUFFERSIZE);
@@ -119,9 +407,76 @@ FXuval FXGZFileStream::readBuffer(FXuval){
   }
 
 
+// Read block index at the end of the file, if any; check that the sizes
+// add up to the file size, that all blocks but the last have the block size
+// and the last not more, and that the file starts with a zlib header
+static FXbool readIndex(FXFile& file,FXArray<FXuint>& index){
+  FXlong filesize=file.size();
+  FXlong total=2+4+12;
+  Bytef buffer[12];
+  FXuint blocksize,nblocks,i;
+  if(filesize<total) return false;
+  if(file.position(filesize-12)<0 || file.readBlock(buffer,12)!=12) return false;
+  if(getLE32(buffer+8)!=INDEXMAGIC) return false;
+  blocksize=getLE32(buffer);
+  nblocks=getLE32(buffer+4);
+  if(blocksize<MINBLOCK || MAXBLOCK<blocksize) return false;
+  if(nblocks==0 || (FXlong)nblocks*8>filesize-total) return false;
+  if(!index.no(nblocks*2)) return false;
+  if(file.position(filesize-12-(FXlong)nblocks*8)<0 || file.readBlock(index.data(),(FXlong)nblocks*8)!=(FXlong)nblocks*8) return false;
+  for(i=0; i<nblocks*2; ++i){
+    index[i]=getLE32((const Bytef*)&index[i]);
+    if(i&1){
+      if(i+1<nblocks*2 ? index[i]!=blocksize : blocksize<index[i]) return false;
+      }
+    else{
+      total+=(FXlong)index[i]+8;
+      }
+    }
+  if(total!=filesize) return false;
+  if(file.position(0)<0 || file.readBlock(buffer,2)!=2) return false;
+  return (buffer[0]&15)==Z_DEFLATED && (buffer[1]&0x20)==0 && ((buffer[0]<<8)|buffer[1])%31==0;
+  }
+
+
 // Try open file stream
 FXbool FXGZFileStream::open(const FXString& filename,FXStreamDirection save_or_load,FXuval size){
-  if(FXFileStream::open(filename,save_or_load,size)){
+  FXuval bufsize=size;
+  if(pool){
+    size=FXCLAMP(MINBLOCK,size,MAXBLOCK);
+    bufsize=size+BLOCKSLACK;
+    }
+  if(FXFileStream::open(filename,save_or_load,bufsize)){
+    if(pool){
+      pz=new ZQueue;
+      pz->check=adler32(0L,Z_NULL,0);
+      pz->blocksize=size;
+      pz->nparts=FXCLAMP(2,2*(FXint)pool->getMaximumThreads(),MAXPARTS);
+      pz->head=0;
+      pz->count=0;
+      pz->next=0;
+      pz->current=-1;
+      pz->offset=0;
+      pz->failed=false;
+      if(save_or_load==FXStreamSave){                   // Write zlib header
+        Bytef header[2]={0x78,0};
+        header[1]=(level==1 || level==0)?0x00:(2<=level && level<=5)?0x40:(level==6 || level==Z_DEFAULT_COMPRESSION)?0x80:0xC0;
+        header[1]+=31-((header[0]<<8)|header[1])%31;
+        if(file.writeBlock(header,2)==2) return true;
+        code=FXStreamNoWrite;
+        }
+      else{
+        if(readIndex(file,pz->index)) return true;
+        pz->index.clear();                              // No index; inflate as one stream
+        if(file.position(0)!=0){ code=FXStreamNoRead; }
+        }
+      delete pz;
+      pz=nullptr;
+      if(code!=FXStreamOK){
+        FXFileStream::close();
+        return false;
+        }
+      }
     if(callocElms(gz,1)){
       int zerror;
       gz->stream.next_in=nullptr;
@@ -135,7 +490,7 @@ FXbool FXGZFileStream::open(const FXString& filename,FXStreamDirection save_or_l
         code=FXStreamNoRead;
         }
       else{
-        zerror=deflateInit(&gz->stream,Z_DEFAULT_COMPRESSION);
+        zerror=deflateInit(&gz->stream,level);
         if(zerror==Z_OK) return true;
         code=FXStreamNoWrite;
         }
@@ -162,6 +517,15 @@ FXbool FXGZFileStream::flush(){
 // Close file stream
 FXbool FXGZFileStream::close(){
   if(dir){
+    if(pz){
+      if(dir==FXStreamSave){
+        ac=Z_FINISH;
+        }
+      FXFileStream::close();
+      delete pz;
+      pz=nullptr;
+      return true;
+      }
     if(dir==FXStreamLoad){
       FXFileStream::close();
       inflateEnd(&gz->stream);
@@ -181,6 +545,7 @@ FXbool FXGZFileStream::close(){
 // Destructor
 FXGZFileStream::~FXGZFileStream(){
   close();
+  pool=(FXThreadPool*)-1L;
   }
 
 }
@@ -52,6 +52,7 @@
 #include "FXScrollArea.h"
 #include "FXHeader.h"
 #include "FXIconList.h"
+#include "fxsort.h"
 
 
 /*
@@ -82,6 +83,12 @@
     the visual stuff changed setListStyle().
   - Since '\0' is no longer special in FXString, perhaps we can replace the function
     of '\t' with '\0'.  This would be significantly more efficient.
+  - Sorting is a stable merge sort, so items comparing equal keep their relative order,
+    and re-sorting an already sorted list takes only about n comparisons.
+  - Comparing items may be expensive when the sort function has to parse the item text;
+    an optional sort key function maps each item to a 64-bit key once per sort, and the
+    sort function is only called when keys are equal.  The sort itself is shared with
+    FXList, in fxsort.h.
 */
 
 
@@ -577,6 +584,7 @@ FXIconList::FXIconList(){
   viewable=-1;
   font=(FXFont*)-1L;
   sortfunc=nullptr;
+  sortkey=nullptr;
   textColor=0;
   selbackColor=0;
   seltextColor=0;
@@ -607,6 +615,7 @@ FXIconList::FXIconList(FXComposite *p,FXObject* tgt,FXSelector sel,FXuint opts,F
   viewable=-1;
   font=getApp()->getNormalFont();
   sortfunc=nullptr;
+  sortkey=nullptr;
   textColor=getApp()->getForeColor();
   selbackColor=getApp()->getSelbackColor();
   seltextColor=getApp()->getSelforeColor();
@@ -1968,34 +1977,24 @@ FXint FXIconList::descendingCase(const FXIconItem* a,const FXIconItem* b){
   }
 
 
-// Sort the items based on the sort function
+// Sort the items based on the sort function; if there is a sort key
+// function, the keys are computed once, and the sort function is only
+// called to break ties between equal keys
 void FXIconList::sortItems(){
-  FXIconItem *v,*c=0;
-  FXbool exch=false;
-  FXint i,j,h;
-  if(sortfunc){
+  FXIconItem *c=nullptr;
+  FXival i;
+  if(sortfunc && 1<items.no()){
     if(0<=current){
       c=items[current];
       }
-    for(h=1; h<=items.no()/9; h=3*h+1){}
-    for(; h>0; h/=3){
-      for(i=h+1;i<=items.no();i++){
-        v=items[i-1];
-        j=i;
-        while(j>h && sortfunc(items[j-h-1],v)>0){
-          items[j-1]=items[j-h-1];
-          exch=true;
-          j-=h;
+    if(sortItemList(items.data(),items.no(),sortfunc,sortkey)){
+      if(0<=current){
+        for(i=0; i<items.no(); i++){
+          if(items[i]==c){ current=i; break; }
           }
-        items[j-1]=v;
         }
+      recalc();
       }
-    if(0<=current){
-      for(i=0; i<items.no(); i++){
-        if(items[i]==c){ current=i; break; }
-        }
-      }
-    if(exch) recalc();
     }
   }
 
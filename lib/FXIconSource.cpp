@@ -96,6 +96,13 @@
   - Either load an icon from a file, or load from already open stream.
   - Recognition of some image/icon types based on contents may be less
     certain due to poorly defined signature information in the file.
+  - Scaled loads let the image load its pixels at reduced size, if its format
+    allows this cheaply (only JPEG so far); then scale the rest of the
+    way, if needed.  Plain and scaled loads share private helpers to open the
+    file or data array, and to find the type; the plain ones still go through
+    loadIconStream() or loadImageStream(), and the scaled ones through
+    loadScaledIconStream() or loadScaledImageStream().  Subclasses adding types
+    override iconFromType() and friends, which both paths use.
 */
 
 
@@ -430,19 +437,57 @@ FXImage *FXIconSource::imageFromStream(FXApp* app,FXStream& store) const {
   }
 
 
-// Load from file
-FXIcon *FXIconSource::loadIconFile(FXApp* app,const FXString& filename,const FXString& type) const {
+// Make icon of given type, or else of the type found from the stream contents
+FXIcon *FXIconSource::iconOfType(FXApp* app,FXStream& store,const FXString& type) const {
+  FXIcon *icon=nullptr;
+  if(!type.empty()){
+    icon=iconFromType(app,type);
+    }
+  if(!icon){
+    icon=iconFromStream(app,store);
+    }
+  return icon;
+  }
+
+
+// Make image of given type, or else of the type found from the stream contents
+FXImage *FXIconSource::imageOfType(FXApp* app,FXStream& store,const FXString& type) const {
+  FXImage *image=nullptr;
+  if(!type.empty()){
+    image=imageFromType(app,type);
+    }
+  if(!image){
+    image=imageFromStream(app,store);
+    }
+  return image;
+  }
+
+
+// Load pixels; if size is given, load at reduced size if the format allows, then
+// scale the rest of the way; delete image if it fails to load
+FXImage *FXIconSource::loadScaledPixels(FXImage *image,FXStream& store,FXint size,FXint qual) const {
+  if(image){
+    if(0<size){
+      if(image->loadScaledPixels(store,size)) return scaleToSize(image,size,qual);
+      }
+    else{
+      if(image->loadPixels(store)) return image;
+      }
+    delete image;
+    }
+  return nullptr;
+  }
+
+
+// Open file and load icon from it, scaled if size is given
+FXIcon *FXIconSource::iconFromFile(FXApp* app,const FXString& filename,FXint size,FXint qual,const FXString& type) const {
   FXIcon *icon=nullptr;
   FXTRACE((150,"FXIconSource loadIcon(%s)\n",filename.text()));
   if(!filename.empty()){
     FXFileStream store;
     if(store.open(filename,FXStreamLoad,65536)){
-      if(type.empty()){
-        icon=loadIconStream(app,store,FXPath::extension(filename));
-        }
-      else{
-        icon=loadIconStream(app,store,type);
-        }
+      const FXString& ftype=type.empty()?FXPath::extension(filename):type;
+      icon=(0<size)?loadScaledIconStream(app,store,size,qual,ftype):loadIconStream(app,store,ftype);
       store.close();
       }
     }
@@ -450,49 +495,28 @@ FXIcon *FXIconSource::loadIconFile(FXApp* app,const FXString& filename,const FXS
   }
 
 
-// Load from data array
-FXIcon *FXIconSource::loadIconData(FXApp* app,const FXuchar *pixels,const FXString& type) const {
+// Open data array and load icon from it, scaled if size is given
+FXIcon *FXIconSource::iconFromData(FXApp* app,const FXuchar *pixels,FXint size,FXint qual,const FXString& type) const {
   FXIcon *icon=nullptr;
   if(pixels){
     FXMemoryStream store;
     store.open(FXStreamLoad,const_cast<FXuchar*>(pixels));
-    icon=loadIconStream(app,store,type);
+    icon=(0<size)?loadScaledIconStream(app,store,size,qual,type):loadIconStream(app,store,type);
     store.close();
     }
   return icon;
   }
 
 
-// Load from already open stream
-FXIcon *FXIconSource::loadIconStream(FXApp* app,FXStream& store,const FXString& type) const {
-  FXIcon *icon=nullptr;
-  if(!type.empty()){
-    icon=iconFromType(app,type);
-    }
-  if(!icon){
-    icon=iconFromStream(app,store);
-    }
-  if(icon){
-    if(icon->loadPixels(store)) return icon;
-    delete icon;
-    }
-  return nullptr;
-  }
-
-
-// Load from file
-FXImage *FXIconSource::loadImageFile(FXApp* app,const FXString& filename,const FXString& type) const {
+// Open file and load image from it, scaled if size is given
+FXImage *FXIconSource::imageFromFile(FXApp* app,const FXString& filename,FXint size,FXint qual,const FXString& type) const {
   FXImage *image=nullptr;
   FXTRACE((150,"FXIconSource loadImage(%s)\n",filename.text()));
   if(!filename.empty()){
     FXFileStream store;
     if(store.open(filename,FXStreamLoad,65536)){
-      if(type.empty()){
-        image=loadImageStream(app,store,FXPath::extension(filename));
-        }
-      else{
-        image=loadImageStream(app,store,type);
-        }
+      const FXString& ftype=type.empty()?FXPath::extension(filename):type;
+      image=(0<size)?loadScaledImageStream(app,store,size,qual,ftype):loadImageStream(app,store,ftype);
       store.close();
       }
     }
@@ -500,28 +524,57 @@ FXImage *FXIconSource::loadImageFile(FXApp* app,const FXString& filename,const F
   }
 
 
-// Load from data array
-FXImage *FXIconSource::loadImageData(FXApp* app,const FXuchar *pixels,const FXString& type) const {
+// Open data array and load image from it, scaled if size is given
+FXImage *FXIconSource::imageFromData(FXApp* app,const FXuchar *pixels,FXint size,FXint qual,const FXString& type) const {
   FXImage *image=nullptr;
   if(pixels){
     FXMemoryStream store;
     store.open(FXStreamLoad,const_cast<FXuchar*>(pixels));
-    image=loadImageStream(app,store,type);
+    image=(0<size)?loadScaledImageStream(app,store,size,qual,type):loadImageStream(app,store,type);
     store.close();
     }
   return image;
   }
 
 
+// Load from file
+FXIcon *FXIconSource::loadIconFile(FXApp* app,const FXString& filename,const FXString& type) const {
+  return iconFromFile(app,filename,0,0,type);
+  }
+
+
+// Load from data array
+FXIcon *FXIconSource::loadIconData(FXApp* app,const FXuchar *pixels,const FXString& type) const {
+  return iconFromData(app,pixels,0,0,type);
+  }
+
+
 // Load from already open stream
-FXImage *FXIconSource::loadImageStream(FXApp* app,FXStream& store,const FXString& type) const {
-  FXImage *image=nullptr;
-  if(!type.empty()){
-    image=imageFromType(app,type);
-    }
-  if(!image){
-    image=imageFromStream(app,store);
+FXIcon *FXIconSource::loadIconStream(FXApp* app,FXStream& store,const FXString& type) const {
+  FXIcon *icon=iconOfType(app,store,type);
+  if(icon){
+    if(icon->loadPixels(store)) return icon;
+    delete icon;
     }
+  return nullptr;
+  }
+
+
+// Load from file
+FXImage *FXIconSource::loadImageFile(FXApp* app,const FXString& filename,const FXString& type) const {
+  return imageFromFile(app,filename,0,0,type);
+  }
+
+
+// Load from data array
+FXImage *FXIconSource::loadImageData(FXApp* app,const FXuchar *pixels,const FXString& type) const {
+  return imageFromData(app,pixels,0,0,type);
+  }
+
+
+// Load from already open stream
+FXImage *FXIconSource::loadImageStream(FXApp* app,FXStream& store,const FXString& type) const {
+  FXImage *image=imageOfType(app,store,type);
   if(image){
     if(image->loadPixels(store)) return image;
     delete image;
@@ -532,37 +585,39 @@ FXImage *FXIconSource::loadImageStream(FXApp* app,FXStream& store,const FXString
 
 // Load icon and scale it such that its dimensions does not exceed given size
 FXIcon *FXIconSource::loadScaledIconFile(FXApp* app,const FXString& filename,FXint size,FXint qual,const FXString& type) const {
-  return (FXIcon*)scaleToSize(loadIconFile(app,filename,type),size,qual);
+  return iconFromFile(app,filename,size,qual,type);
   }
 
 
 // Load from data array
 FXIcon *FXIconSource::loadScaledIconData(FXApp* app,const FXuchar *pixels,FXint size,FXint qual,const FXString& type) const {
-  return (FXIcon*)scaleToSize(loadIconData(app,pixels,type),size,qual);
+  return iconFromData(app,pixels,size,qual,type);
   }
 
 
-// Load icon and scale it such that its dimensions does not exceed given size
+// Load icon and scale it such that its dimensions does not exceed given size;
+// formats which can load at reduced size do so first
 FXIcon *FXIconSource::loadScaledIconStream(FXApp* app,FXStream& store,FXint size,FXint qual,const FXString& type) const {
-  return (FXIcon*)scaleToSize(loadIconStream(app,store,type),size,qual);
+  return (FXIcon*)loadScaledPixels(iconOfType(app,store,type),store,size,qual);
   }
 
 
 // Load image and scale it such that its dimensions does not exceed given size
 FXImage *FXIconSource::loadScaledImageFile(FXApp* app,const FXString& filename,FXint size,FXint qual,const FXString& type) const {
-  return scaleToSize(loadImageFile(app,filename,type),size,qual);
+  return imageFromFile(app,filename,size,qual,type);
   }
 
 
 // Load from data array
 FXImage *FXIconSource::loadScaledImageData(FXApp* app,const FXuchar *pixels,FXint size,FXint qual,const FXString& type) const {
-  return (FXImage*)scaleToSize(loadImageData(app,pixels,type),size,qual);
+  return imageFromData(app,pixels,size,qual,type);
   }
 
 
-// Load image and scale it such that its dimensions does not exceed given size
+// Load image and scale it such that its dimensions does not exceed given size;
+// formats which can load at reduced size do so first
 FXImage *FXIconSource::loadScaledImageStream(FXApp* app,FXStream& store,FXint size,FXint qual,const FXString& type) const {
-  return scaleToSize(loadImageStream(app,store,type),size,qual);
+  return loadScaledPixels(imageOfType(app,store,type),store,size,qual);
   }
 
 }
@@ -0,0 +1,162 @@
+/********************************************************************************
+*                                                                               *
+*                        I m a g e   R e a d e r   C l a s s                    *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "fxmath.h"
+#include "FXElement.h"
+#include "FXHash.h"
+#include "FXStream.h"
+#include "FXImageReader.h"
+
+
+/*
+  Notes:
+
+  - PNG and JPEG readers are implemented in fxpngio.cpp and fxjpegio.cpp,
+    next to the rest of their decoders.
+
+  - When scaling, source and output are laid over each other, measuring
+    a source pixel as dw (or dh) units, and an output pixel as sw (or sh)
+    units; both then span sw*dw units.  As the output is no bigger than the
+    source, a source pixel covers at most two output pixels, and splits its
+    weight between them.
+
+  - Sums are kept as 64-bit integers; the sums of rows can get as big as
+    sw*sh*255, which is less than 2^39, and so convert exactly to double
+    when finally scaled by 1/(sw*sh).
+
+  - Each source row is first summed into one row of output pixels; source
+    pixels lying wholly inside an output pixel all have weight dw, so only
+    their plain sum needs to be weighted, while the one pixel which ends an
+    output pixel is split between it and the next.  Which pixels end an output
+    pixel, and their weights, are worked out once for each column.
+
+  - The row of output pixels is then added, with its vertical weight, into
+    the output row being built.  When the source row reaches the end of that
+    output row, it is divided by the total weight sw*sh and stored, and what
+    is left of the source row is carried into the next.
+*/
+
+using namespace FX;
+
+/*******************************************************************************/
+
+namespace FX {
+
+
+// Create image reader
+FXImageReader::FXImageReader():store(nullptr),width(0),height(0),row(0){
+  }
+
+
+// Read rest of image, scaled down to dw by dh
+FXbool FXImageReader::readScaled(FXColor* dst,FXint dw,FXint dh,FXint dstride){
+  FXColor *src=nullptr;
+  FXulong *hsum=nullptr;
+  FXulong *vsum=nullptr;
+  FXulong *xcut=nullptr;
+  FXbool result=false;
+  if(0<dw && 0<dh && dw<=width && dh<=height-row){
+    FXint sw=width,sh=height-row;
+    if(allocElms(src,sw) && allocElms(hsum,dw*4) && callocElms(vsum,dw*4) && allocElms(xcut,sw)){
+      FXdouble scale=1.0/((FXdouble)sw*(FXdouble)sh);
+      FXulong xbeg,xend,jend,ybeg,yend,kend,wa,wb;
+      FXulong s0,s1,s2,s3,c0,c1,c2,c3;
+      FXint x,y,j,k;
+
+      // Weight of each source pixel in the output pixel it ends, or zero
+      // if it lies wholly inside an output pixel without ending it
+      for(x=j=0; x<sw; ++x){
+        xbeg=(FXulong)x*dw;
+        xend=xbeg+dw;
+        jend=(FXulong)(j+1)*sw;
+        xcut[x]=0;
+        if(jend<=xend){ xcut[x]=jend-xbeg; ++j; }
+        }
+
+      // Sum rows
+      for(y=k=0; y<sh && read(src,1,sw)==1; ++y){
+
+        // Sum row horizontally into output pixels; whole source pixels are
+        // summed as they are, and weighted all at once when the output pixel
+        // is done, while a pixel cut in two is split over both
+        s0=s1=s2=s3=c0=c1=c2=c3=0;
+        for(x=j=0; x<sw; ++x){
+          const FXuchar* p=(const FXuchar*)&src[x];
+          wa=xcut[x];
+          if(wa==0){
+            s0+=p[0];
+            s1+=p[1];
+            s2+=p[2];
+            s3+=p[3];
+            continue;
+            }
+          wb=dw-wa;
+          hsum[j+0]=c0+s0*dw+wa*p[0];
+          hsum[j+1]=c1+s1*dw+wa*p[1];
+          hsum[j+2]=c2+s2*dw+wa*p[2];
+          hsum[j+3]=c3+s3*dw+wa*p[3];
+          c0=wb*p[0];
+          c1=wb*p[1];
+          c2=wb*p[2];
+          c3=wb*p[3];
+          s0=s1=s2=s3=0;
+          j+=4;
+          }
+
+        // Add into output row, and when it is complete, store it and carry
+        // the rest of the source row into the next
+        ybeg=(FXulong)y*dh;
+        yend=ybeg+dh;
+        kend=(FXulong)(k+1)*sh;
+        if(kend<=yend){
+          FXuchar* q=(FXuchar*)&dst[(FXival)k*dstride];
+          wa=kend-ybeg;
+          wb=yend-kend;
+          for(x=0; x<dw*4; ++x){
+            q[x]=(FXuchar)((FXdouble)(vsum[x]+wa*hsum[x])*scale+0.5);
+            vsum[x]=wb*hsum[x];
+            }
+          ++k;
+          }
+        else{
+          for(x=0; x<dw*4; ++x){
+            vsum[x]+=dh*hsum[x];
+            }
+          }
+        }
+      result=(y==sh);
+      }
+    freeElms(src);
+    freeElms(hsum);
+    freeElms(vsum);
+    freeElms(xcut);
+    }
+  return result;
+  }
+
+
+// Destroy image reader
+FXImageReader::~FXImageReader(){
+  }
+
+}
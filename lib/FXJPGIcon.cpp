@@ -92,6 +92,19 @@ FXbool FXJPGIcon::loadPixels(FXStream& store){
   }
 
 
+// Load pixels only, reduced to no less than size
+FXbool FXJPGIcon::loadScaledPixels(FXStream& store,FXint size){
+  FXColor *pixels; FXint w,h;
+  if(fxloadScaledJPG(store,pixels,w,h,quality,size)){
+    setData(pixels,IMAGE_OWNED,w,h);
+    if(options&IMAGE_ALPHAGUESS) setTransparentColor(guesstransp());
+    if(options&IMAGE_THRESGUESS) setThresholdValue(guessthresh());
+    return true;
+    }
+  return false;
+  }
+
+
 // Clean up
 FXJPGIcon::~FXJPGIcon(){
   }
@@ -90,6 +90,17 @@ FXbool FXJPGImage::loadPixels(FXStream& store){
   }
 
 
+// Load pixels only, reduced to no less than size
+FXbool FXJPGImage::loadScaledPixels(FXStream& store,FXint size){
+  FXColor *pixels; FXint w,h;
+  if(fxloadScaledJPG(store,pixels,w,h,quality,size)){
+    setData(pixels,IMAGE_OWNED,w,h);
+    return true;
+    }
+  return false;
+  }
+
+
 // Clean up
 FXJPGImage::~FXJPGImage(){
   }
@@ -47,6 +47,7 @@
 #include "FXIcon.h"
 #include "FXScrollBar.h"
 #include "FXList.h"
+#include "fxsort.h"
 
 
 
@@ -90,6 +91,7 @@
   - FIXME if no text, you're unable to see if an item is selected.
   - Should sortItems() have optional notify parameter to generate callback
     when current item index has changed?
+  - Sorting is a stable merge sort, with optional sort key function; see fxsort.h.
   - FIXME can we add another flag to FXListItem to support invisible items
     which are present but not drawn.  These would be skipped during keyboard
     navigation similar and not give rise to selection callbacks, etc.
@@ -352,6 +354,7 @@ FXList::FXList(){
   listHeight=0;
   visible=0;
   sortfunc=nullptr;
+  sortkey=nullptr;
   grabx=0;
   graby=0;
   state=false;
@@ -375,6 +378,7 @@ FXList::FXList(FXComposite *p,FXObject* tgt,FXSelector sel,FXuint opts,FXint x,F
   listHeight=0;
   visible=0;
   sortfunc=nullptr;
+  sortkey=nullptr;
   grabx=0;
   graby=0;
   state=false;
@@ -1484,34 +1488,24 @@ FXint FXList::descendingCase(const FXListItem* a,const FXListItem* b){
   }
 
 
-// Sort the items based on the sort function.
+// Sort the items based on the sort function; if there is a sort key
+// function, the keys are computed once, and the sort function is only
+// called to break ties between equal keys
 void FXList::sortItems(){
-  FXListItem *v,*c=0;
-  FXbool exch=false;
-  FXint i,j,h;
-  if(sortfunc){
+  FXListItem *c=nullptr;
+  FXival i;
+  if(sortfunc && 1<items.no()){
     if(0<=current){
       c=items[current];
       }
-    for(h=1; h<=items.no()/9; h=3*h+1){}
-    for(; h>0; h/=3){
-      for(i=h+1;i<=items.no();i++){
-        v=items[i-1];
-        j=i;
-        while(j>h && sortfunc(items[j-h-1],v)>0){
-          items[j-1]=items[j-h-1];
-          exch=true;
-          j-=h;
+    if(sortItemList(items.data(),items.no(),sortfunc,sortkey)){
+      if(0<=current){
+        for(i=0; i<items.no(); i++){
+          if(items[i]==c){ current=i; break; }
           }
-        items[j-1]=v;
         }
+      recalc();
       }
-    if(0<=current){
-      for(i=0; i<items.no(); i++){
-        if(items[i]==c){ current=i; break; }
-        }
-      }
-    if(exch) recalc();
     }
   }
 
@@ -292,6 +292,26 @@ FXbool FXMappedFile::flush(){
   }
 
 
+// Advise about access pattern of part of the map; the start
+// is rounded down to a page boundary as the system requires
+FXbool FXMappedFile::advise(FXuint hint,FXival off,FXival len){
+  if(mempointer && 0<=off && off<memlength){
+    if(len<=0 || memlength-off<len) len=memlength-off;
+#if defined(WIN32)
+    return false;
+#elif defined(HAVE_POSIX_MADVISE)
+    static const FXint advice[]={POSIX_MADV_NORMAL,POSIX_MADV_SEQUENTIAL,POSIX_MADV_RANDOM,POSIX_MADV_WILLNEED,POSIX_MADV_DONTNEED};
+    FXival page=granularity();
+    FXival start=off-off%page;
+    if(hint<ARRAYNUMBER(advice)){
+      return ::posix_madvise((FXuchar*)mempointer+start,len+off-start,advice[hint])==0;
+      }
+#endif
+    }
+  return false;
+  }
+
+
 // Close file, and also the map
 FXbool FXMappedFile::close(){
   if(mempointer){
@@ -0,0 +1,164 @@
+/********************************************************************************
+*                                                                               *
+*                M a p p e d   F i l e   S t r e a m   C l a s s                *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "fxmath.h"
+#include "FXElement.h"
+#include "FXHash.h"
+#include "FXString.h"
+#include "FXStream.h"
+#include "FXIODevice.h"
+#include "FXFile.h"
+#include "FXMappedFile.h"
+#include "FXMappedStream.h"
+
+
+/*
+  Notes:
+  - The whole file is mapped, and the stream buffer points into the map; loading
+    arrays copies directly from the map, and views hand out pointers into it.
+  - The end of the buffer is moved through the map one window at a time; this
+    way, readBuffer() is called as loading progresses, and each time, the system
+    is advised to start reading the next window, while the current one is being
+    loaded.  The system is also told the file will be read sequentially, so
+    that it can read further ahead, and drop pages behind.
+  - Since the end of the buffer is never beyond the data read so far, any attempt
+    to save will call writeBuffer(), which flags it as a programming error.
+  - Empty files can not be mapped, and fail to open.
+*/
+
+using namespace FX;
+
+
+/*******************************************************************************/
+
+namespace FX {
+
+
+// Create mapped file stream
+FXMappedStream::FXMappedStream(const FXObject* cont):FXStream(cont),window(4194304UL){
+  }
+
+
+// Create and open mapped file stream
+FXMappedStream::FXMappedStream(const FXString& filename,FXuval win):window(4194304UL){
+  open(filename,win);
+  }
+
+
+// Saving is not possible
+FXuval FXMappedStream::writeBuffer(FXuval){
+  fxerror("FXMappedStream::writeBuffer: wrong stream direction.\n");
+  return 0;
+  }
+
+
+// Make at least count more bytes available, or up to the end of the
+// next window; then advise the system to read the window after that
+FXuval FXMappedStream::readBuffer(FXuval count){
+  FXuval have=(FXuval)(wrptr-begptr);
+  FXuval rest=(FXuval)file.length()-have;
+  if(0<rest){
+    wrptr+=FXMIN(FXMAX(count,window),rest);
+    endptr=wrptr;
+    file.advise(FXMappedFile::WillNeed,wrptr-begptr,window);
+    }
+  return wrptr-rdptr;
+  }
+
+
+// Open mapped file stream
+FXbool FXMappedStream::open(const FXString& filename,FXuval win){
+  if(!dir){
+    if(!file.open(filename,FXIO::Reading)){
+      code=FXStreamNoRead;
+      return false;
+      }
+    if(FXStream::open(FXStreamLoad,(FXuchar*)file.data(),0,false)){
+      window=FXMAX(win,(FXuval)file.granularity());
+      file.advise(FXMappedFile::Sequential);
+      file.advise(FXMappedFile::WillNeed,0,window);
+      return true;
+      }
+    file.close();
+    }
+  return false;
+  }
+
+
+// Close mapped file stream
+FXbool FXMappedStream::close(){
+  if(dir){
+    FXbool result=FXStream::close();
+    file.close();
+    return result;
+    }
+  return false;
+  }
+
+
+// Move to position; when moving back, the data are already available,
+// otherwise, they will be made available when they're being loaded
+FXbool FXMappedStream::position(FXlong offset,FXWhence whence){
+  if(dir==FXStreamDead){ fxerror("FXMappedStream::position: stream is not open.\n"); }
+  if(code==FXStreamOK){
+    if(whence==FXFromCurrent) offset=offset+pos;
+    else if(whence==FXFromEnd) offset=offset+file.length();
+    if(offset<0 || file.length()<offset){ setError(FXStreamEnd); return false; }
+    rdptr=begptr+offset;
+    if(wrptr<rdptr){
+      wrptr=rdptr;
+      endptr=rdptr;
+      file.advise(FXMappedFile::WillNeed,offset,window);
+      }
+    pos=offset;
+    return true;
+    }
+  return false;
+  }
+
+
+// Obtain view of n items of given size, if they can be used in place
+FXbool FXMappedStream::viewBlock(const void*& p,FXuval n,FXuval size){
+  if(code==FXStreamOK){
+    FXASSERT(begptr<=rdptr);
+    FXASSERT(rdptr<=wrptr);
+    FXASSERT(wrptr<=endptr);
+    if(1<size && (swap || ((FXuval)rdptr&(size-1)))) return false;
+    if(size && (FXuval)(file.length()-pos)/size<n){ code=FXStreamEnd; return false; }
+    n*=size;
+    if((FXuval)(wrptr-rdptr)<n && readBuffer(n-(wrptr-rdptr))<n){ code=FXStreamEnd; return false; }
+    p=rdptr;
+    rdptr+=n;
+    pos+=n;
+    return true;
+    }
+  return false;
+  }
+
+
+// Close mapped file stream
+FXMappedStream::~FXMappedStream(){
+  close();
+  }
+
+}
@@ -32,7 +32,7 @@
 
 /*
   Notes:
-  - Also need memory mapped file stream.
+  - See FXMappedStream for loading from memory mapped files.
 */
 
 
@@ -23,11 +23,14 @@
 #include "fxdefs.h"
 #include "fxmath.h"
 #include "FXException.h"
+#include "FXAtomic.h"
 #include "FXElement.h"
 #include "FXArray.h"
 #include "FXMetaClass.h"
 #include "FXHash.h"
 #include "FXMutex.h"
+#include "FXAutoThreadStorageKey.h"
+#include "FXThread.h"
 #include "FXStream.h"
 #include "FXString.h"
 #include "FXSize.h"
@@ -45,21 +48,35 @@
 /*
   Notes:
   - Inter-thread messaging is handy to have.
-  - A pipe is used to pass data from worker thread to main GUI thread, so that
-    small messages may be sent from worker thread to main GUI thread asynchronously.
-  - On windows, an additional semaphore is needed to provide a watchable handle
-    for FXApp to block on, in MsgWaitForMultipleObjects().
-  - Main GUI thread blocks on a set of input sources, and wakes up and dispatches
-    to a handler when any one of them is raised.  For the message channel, control
-    will dispatch to onMessage(), which will pull the message from the pipe, and
-    invoke the handler read from the FXMessage struct.
+  - Messages are passed from worker threads to the main GUI thread through a
+    bounded, lock-free, multiple-producer single-consumer ring buffer.  Each slot
+    has a sequence number; a sender reserves a slot by advancing the write position
+    with compare-and-swap, fills it, then publishes it by bumping its sequence number.
+    The main GUI thread reads slots in order until it finds one not yet published,
+    and releases each slot by setting its sequence number one lap ahead.
+  - Small payloads are copied into the slot; larger ones (up to MAXMESSAGE bytes)
+    are copied into a heap block, which is allocated before the slot is reserved,
+    so that the reader is never held up by a sender allocating memory.  Payloads
+    passed to handoff() are not copied at all; the heap block is freed after the
+    handler returns.
+  - The wakeup handle (an eventfd on Linux, a pipe on other unices, and an event on
+    windows) only serves to wake up the main GUI thread; no data passes through it.
+    A flag records that a wakeup is pending, so only the first message after the
+    main GUI thread has started reading makes a system call.
+  - The main GUI thread first clears the wakeup handle, then the flag, and then takes
+    all published messages out of the ring.  A message published after that finds
+    the flag cleared, and raises the wakeup handle again; thus, no wakeup is lost.
+  - Messages are taken out of the ring before any of them is dispatched, as a handler
+    may send messages of its own, or even run a modal event loop.  The published
+    messages are counted first, so the batch is allocated once per wakeup.
+  - No more than a ring full of messages is taken out at once; if there may be more,
+    the wakeup handle is raised again, so other events get a chance in between.
+  - Coalescing messages are dropped if a newer coalescing message with the same
+    target and selector was taken out of the ring at the same time; the hash table
+    for this is only made if the batch has more than one coalescing message.
+  - When the ring is full, senders yield until the main GUI thread catches up.
   - Note that the handler may get called later than message(); it depends on when
     the main GUI thread returns to the event processing loop.
-  - Based on suggestion from Axel Schmidt <axel.schmidt@analytica-karlsruhe.de>,
-    the Event object was replaced by counting Semaphore.
-    This way, the number of calls to message() has to be equal to the number of calls
-    to MsgWaitForMultipleObjects.  Thus, each call to message() results in exactly
-    one callback in the GUI thread.
   - FIXME technically, FXMessageChannel should refer to an event loop instance (or
     FXDispatcher instance), not FXApp.  Not all applications are GUI applications.
 */
@@ -68,6 +85,12 @@
 // Maximum message size
 #define MAXMESSAGE 8192
 
+// Number of messages in ring buffer (power of two)
+#define RINGSIZE   2048
+
+// Bytes of payload kept in slot
+#define SLOTDATA   32
+
 // Bad handle value
 #if defined(WIN32)
 #define BadHandle  INVALID_HANDLE_VALUE
@@ -84,26 +107,33 @@ using namespace FX;
 namespace FX {
 
 
-// Structure of message
+// Message flags
+enum {
+  COALESCE = 1,                 // Superseded by newer message to same target
+  DROPPED  = 2                  // Superseded; not to be delivered
+  };
+
+
+// Message taken out of ring buffer
 struct FXMessage {
-  FXObject  *target;            // Message target
-  FXSelector message;           // Message type,id
-#if !(defined(__LP64__) || defined(_LP64) || (_MIPS_SZLONG == 64) || (__WORDSIZE == 64) || defined(_WIN64))
-  FXint      pad;               // Padding for 32-bit
-#endif
-  FXint      size;              // Message size
+  FXuint      flags;            // Flags
+  FXObject   *target;           // Message target
+  FXSelector  message;          // Message type,id
+  FXint       size;             // Message size
+  FXuchar    *heap;             // Payload on heap, if any
+  FXlong      data[SLOTDATA/sizeof(FXlong)];
   };
 
 
-// Structure of message+payload
-struct FXDataMessage {
-  FXObject  *target;            // Message target
-  FXSelector message;           // Message type,id
-#if !(defined(__LP64__) || defined(_LP64) || (_MIPS_SZLONG == 64) || (__WORDSIZE == 64) || defined(_WIN64))
-  FXint      pad;               // Padding for 32-bit
-#endif
-  FXint      size;              // Message size
-  FXlong     data[MAXMESSAGE/sizeof(FXlong)];
+// Message slot in ring buffer
+struct FXMessageChannel::Slot {
+  volatile FXuint seq;          // Sequence number; published when one past position
+  FXuint          flags;        // Flags
+  FXObject       *target;       // Message target
+  FXSelector      message;      // Message type,id
+  FXint           size;         // Message size
+  FXuchar        *heap;         // Payload on heap, if any
+  FXlong          data[SLOTDATA/sizeof(FXlong)];
   };
 
 
@@ -118,90 +148,220 @@ FXIMPLEMENT(FXMessageChannel,FXObject,FXMessageChannelMap,ARRAYNUMBER(FXMessageC
 
 
 // Initialize to empty
-FXMessageChannel::FXMessageChannel():app((FXApp*)-1L){
-  h[0]=h[1]=h[2]=BadHandle;
+FXMessageChannel::FXMessageChannel():app((FXApp*)-1L),slots(nullptr),mask(0),wpos(0),rpos(0),signaled(0){
+  h[0]=h[1]=BadHandle;
   }
 
 
 // Add handler to application
-FXMessageChannel::FXMessageChannel(FXApp* a):app(a){
+FXMessageChannel::FXMessageChannel(FXApp* a):app(a),slots(nullptr),mask(RINGSIZE-1),wpos(0),rpos(0),signaled(0){
+  if(!callocElms(slots,RINGSIZE)){ throw FXMemoryException("unable to allocate message channel."); }
+  for(FXuint i=0; i<RINGSIZE; ++i){
+    slots[i].seq=i;
+    }
 #if defined(WIN32)
-  if((h[2]=::CreateSemaphore(nullptr,0,2147483647,nullptr))==nullptr){ throw FXResourceException("unable to create semaphore."); }
-  if(::CreatePipe(&h[0],&h[1],nullptr,0)==0){ throw FXResourceException("unable to create pipe."); }
-  app->addInput(this,ID_IO_READ,h[2],INPUT_READ,nullptr);
+  if((h[0]=::CreateEvent(nullptr,false,false,nullptr))==nullptr){ throw FXResourceException("unable to create event."); }
+  h[1]=h[0];
+#elif defined(HAVE_SYS_EVENTFD_H)
+  if((h[0]=::eventfd(0,EFD_CLOEXEC|EFD_NONBLOCK))<0){ throw FXResourceException("unable to create eventfd."); }
+  h[1]=h[0];
 #else
   if(::pipe(h)!=0){ throw FXResourceException("unable to create pipe."); }
   ::fcntl(h[0],F_SETFD,FD_CLOEXEC);
   ::fcntl(h[1],F_SETFD,FD_CLOEXEC);
+  ::fcntl(h[0],F_SETFL,O_NONBLOCK);
+  ::fcntl(h[1],F_SETFL,O_NONBLOCK);
+#endif
   app->addInput(this,ID_IO_READ,h[0],INPUT_READ,nullptr);
+  }
+
+
+// Raise wakeup handle, unless already raised
+void FXMessageChannel::wakeup(){
+  if(atomicSet(&signaled,1)==0){
+#if defined(WIN32)
+    ::SetEvent(h[1]);
+#elif defined(HAVE_SYS_EVENTFD_H)
+    ::eventfd_write(h[1],1);
+#else
+    const FXuchar ch=0;
+    ::write(h[1],&ch,1);
 #endif
+    }
   }
 
 
-// Fire signal message to target
+// Fire all pending messages to their targets
 long FXMessageChannel::onMessage(FXObject*,FXSelector,void*){
-  FXDataMessage pkg;
+  FXArray<FXMessage> batch;
+  FXMessage *msg,*newer;
+  FXuval key;
+  Slot *slot;
+  FXival i,n;
+  FXint coalesced=0;
+  long result=0;
+
+  // Clear wakeup handle, then the flag
 #if defined(WIN32)
-  DWORD nread=-1;
-  if(::ReadFile(h[0],&pkg,sizeof(FXMessage),&nread,nullptr) && nread==sizeof(FXMessage)){
-    if(0<pkg.size && (::ReadFile(h[0],pkg.data,pkg.size,&nread,nullptr) && nread==pkg.size)){
-      return pkg.target && pkg.target->tryHandle(this,pkg.message,pkg.data);
+  // Auto-reset event was reset by waiting for it
+#elif defined(HAVE_SYS_EVENTFD_H)
+  eventfd_t count;
+  ::eventfd_read(h[0],&count);
+#else
+  FXuchar junk[64];
+  while(::read(h[0],junk,sizeof(junk))==sizeof(junk)){ }
+#endif
+  atomicSet(&signaled,0);
+
+  // Count published messages, up to a ring full, and make room for them at once
+  for(n=0; n<=(FXival)mask; ++n){
+    if(slots[(rpos+n)&mask].seq!=(FXuint)(rpos+n+1)) break;
+    }
+  if(!batch.no(n)) n=0;
+  atomicThreadFence();
+
+  // Take them out of the ring
+  for(i=0; i<n; ++i){
+    slot=&slots[rpos&mask];
+    msg=&batch[i];
+    msg->flags=slot->flags;
+    msg->target=slot->target;
+    msg->message=slot->message;
+    msg->size=slot->size;
+    msg->heap=slot->heap;
+    if(!slot->heap && 0<slot->size){
+      copyElms(msg->data,slot->data,ARRAYNUMBER(slot->data));
       }
-    return pkg.target && pkg.target->tryHandle(this,pkg.message,nullptr);
+    if(msg->flags&COALESCE) coalesced++;
+    atomicThreadFence();
+    slot->seq=rpos+mask+1;
+    rpos++;
     }
-#else
-  if(::read(h[0],&pkg,sizeof(FXMessage))==sizeof(FXMessage)){
-    if(0<pkg.size && (::read(h[0],pkg.data,pkg.size)==pkg.size)){
-      return pkg.target && pkg.target->tryHandle(this,pkg.message,pkg.data);
+
+  // If we stopped early, come back for the rest
+  if(slots[rpos&mask].seq==rpos+1){
+    wakeup();
+    }
+
+  // Drop coalescing messages if a newer one is in the same batch
+  if(1<coalesced){
+    FXHash latest;
+    for(i=n-1; 0<=i; --i){
+      msg=&batch[i];
+      if(msg->flags&COALESCE){
+        key=(((FXuval)msg->target)*31)^msg->message;
+        if(key==0 || key==(FXuval)-1L) key=2;
+        newer=(FXMessage*)latest[(const void*)key];
+        if(newer==nullptr){
+          latest[(const void*)key]=msg;
+          }
+        else if(newer->target==msg->target && newer->message==msg->message){
+          msg->flags|=DROPPED;
+          }
+        }
       }
-    return pkg.target && pkg.target->tryHandle(this,pkg.message,nullptr);
     }
-#endif
-  return 0;
+
+  // Dispatch messages in the order they were sent
+  for(i=0; i<n; ++i){
+    msg=&batch[i];
+    if(!(msg->flags&DROPPED) && msg->target){
+      result|=msg->target->tryHandle(this,msg->message,(0<msg->size)?(msg->heap?(void*)msg->heap:(void*)msg->data):nullptr);
+      }
+    freeElms(msg->heap);
+    }
+  return result;
+  }
+
+
+// Post a message, with payload either copied into slot or on heap
+FXbool FXMessageChannel::post(FXObject* tgt,FXSelector msg,const void* data,FXint size,FXuchar* heap,FXuint flags){
+  FXuint w=wpos;
+  Slot *slot;
+  FXint dif;
+  FXASSERT(heap || size<=SLOTDATA);
+
+  // Reserve a slot; if ring is full, wait for main thread to catch up
+  while(1){
+    slot=&slots[w&mask];
+    dif=(FXint)(slot->seq-w);
+    if(__likely(dif==0)){
+      if(atomicBoolCas(&wpos,w,w+1)) break;
+      }
+    else if(dif<0){
+      FXThread::yield();
+      }
+    w=wpos;
+    }
+
+  // Fill it
+  slot->flags=flags;
+  slot->target=tgt;
+  slot->message=msg;
+  slot->size=size;
+  slot->heap=heap;
+  if(!heap && 0<size){
+    copyElms((FXuchar*)slot->data,(const FXuchar*)data,size);
+    }
+
+  // Publish it
+  atomicThreadFence();
+  slot->seq=w+1;
+
+  // Wake up main thread
+  wakeup();
+  return true;
   }
 
 
 // Send a message to a target
 FXbool FXMessageChannel::message(FXObject* tgt,FXSelector msg,const void* data,FXint size){
-  FXScopedMutex locker(m);
-  FXMessage pkg;
-  pkg.target=tgt;
-  pkg.message=msg;
-#if !(defined(__LP64__) || defined(_LP64) || (_MIPS_SZLONG == 64) || (__WORDSIZE == 64) || defined(_WIN64))
-  pkg.pad=0;
-#endif
-  pkg.size=FXMIN(size,MAXMESSAGE);
-#if defined(WIN32)
-  DWORD nwritten=-1;
-  if(::WriteFile(h[1],&pkg,sizeof(FXMessage),&nwritten,nullptr) && nwritten==sizeof(FXMessage)){
-    if(pkg.size<=0 || (::WriteFile(h[1],data,pkg.size,&nwritten,nullptr) && nwritten==pkg.size)){
-      ::ReleaseSemaphore(h[2],1,nullptr);
-      return true;
-      }
+  FXuchar* heap=nullptr;
+  size=FXCLAMP(0,size,MAXMESSAGE);
+  if(SLOTDATA<size){
+    if(!allocElms(heap,size)) return false;
+    copyElms(heap,(const FXuchar*)data,size);
     }
-#else
-  if(::write(h[1],&pkg,sizeof(FXMessage))==sizeof(FXMessage)){
-    if(pkg.size<=0 || (::write(h[1],data,pkg.size)==pkg.size)){		// Write with one call...
-      return true;
-      }
+  return post(tgt,msg,data,size,heap,0);
+  }
+
+
+// Send a message to a target, superseding pending ones
+FXbool FXMessageChannel::coalesce(FXObject* tgt,FXSelector msg,const void* data,FXint size){
+  FXuchar* heap=nullptr;
+  size=FXCLAMP(0,size,MAXMESSAGE);
+  if(SLOTDATA<size){
+    if(!allocElms(heap,size)) return false;
+    copyElms(heap,(const FXuchar*)data,size);
     }
-#endif
-  return false;
+  return post(tgt,msg,data,size,heap,COALESCE);
+  }
+
+
+// Send a message to a target, handing off the data
+FXbool FXMessageChannel::handoff(FXObject* tgt,FXSelector msg,void* data,FXint size){
+  if(!data || size<=0){ freeElms(data); return post(tgt,msg,nullptr,0,nullptr,0); }
+  return post(tgt,msg,nullptr,size,(FXuchar*)data,0);
   }
 
 
 // Remove handler from application
 FXMessageChannel::~FXMessageChannel(){
+  app->removeInput(h[0],INPUT_READ);
 #if defined(WIN32)
-  app->removeInput(h[2],INPUT_READ);
   ::CloseHandle(h[0]);
-  ::CloseHandle(h[1]);
-  ::CloseHandle(h[2]);
+#elif defined(HAVE_SYS_EVENTFD_H)
+  ::close(h[0]);
 #else
-  app->removeInput(h[0],INPUT_READ);
   ::close(h[0]);
   ::close(h[1]);
 #endif
+  while(slots[rpos&mask].seq==rpos+1){
+    freeElms(slots[rpos&mask].heap);
+    rpos++;
+    }
+  freeElms(slots);
+  slots=(Slot*)-1L;
   app=(FXApp*)-1L;
   }
 
@@ -93,6 +93,19 @@ FXbool FXPNGIcon::loadPixels(FXStream& store){
   }
 
 
+// Load pixels only, scaled to fit in size
+FXbool FXPNGIcon::loadScaledPixels(FXStream& store,FXint size){
+  FXColor *pixels; FXint w,h;
+  if(fxloadScaledPNG(store,pixels,w,h,size)){
+    setData(pixels,IMAGE_OWNED,w,h);
+    if(options&IMAGE_ALPHAGUESS) setTransparentColor(guesstransp());
+    if(options&IMAGE_THRESGUESS) setThresholdValue(guessthresh());
+    return true;
+    }
+  return false;
+  }
+
+
 // Clean up
 FXPNGIcon::~FXPNGIcon(){
   }
@@ -94,6 +94,17 @@ FXbool FXPNGImage::loadPixels(FXStream& store){
   }
 
 
+// Load pixels only, scaled to fit in size
+FXbool FXPNGImage::loadScaledPixels(FXStream& store,FXint size){
+  FXColor *pixels; FXint w,h;
+  if(fxloadScaledPNG(store,pixels,w,h,size)){
+    setData(pixels,IMAGE_OWNED,w,h);
+    return true;
+    }
+  return false;
+  }
+
+
 // Clean up
 FXPNGImage::~FXPNGImage(){
   }
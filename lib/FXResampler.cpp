@@ -0,0 +1,576 @@
+/********************************************************************************
+*                                                                               *
+*                      I m a g e   R e s a m p l e r   C l a s s                *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "fxmath.h"
+#include "fxcpuid.h"
+#include "FXElement.h"
+#include "FXArray.h"
+#include "FXPtrList.h"
+#include "FXAtomic.h"
+#include "FXSpinLock.h"
+#include "FXSemaphore.h"
+#include "FXCompletion.h"
+#include "FXRunnable.h"
+#include "FXAutoThreadStorageKey.h"
+#include "FXThread.h"
+#include "FXLFQueue.h"
+#include "FXThreadPool.h"
+#include "FXTaskGroup.h"
+#include "FXParallel.h"
+#include "FXResampler.h"
+
+
+/*
+  Notes:
+
+  - Output pixel i is centered on (i+0.5)*sw/dw in the source.  When shrinking,
+    the filter is stretched by sw/dw, so that it covers all the source pixels
+    contributing to the output pixel; when enlarging, it is used as is.  The box
+    filter takes the fraction of each source pixel covered by the output pixel.
+
+  - Each output pixel takes the same number of taps, so the weights are kept in
+    one array.  Taps falling off the edge of the source are folded onto the edge
+    pixel, and the run of taps is moved inside the source; weights are then made
+    to add up to 1.  Scaling without changing size takes one tap, whatever the
+    filter, so that the image comes out the same.
+
+  - Pixels are converted to linear light by table lookup, and multiplied by
+    alpha; the four channels are then filtered as a vector of floats.  Alpha
+    is not gamma corrected.
+
+  - Going back, the table is indexed by the square root of the linear value;
+    this spends more of the table on the darker values, where a gamma of 2.2
+    changes fastest, so that 4096 entries are enough to get every pixel value
+    back unchanged.  Filters with negative lobes may overshoot, so values are
+    clamped first.
+
+  - The output is cut into tiles of 256x32 pixels.  For each tile, the source
+    rows under it are converted and filtered horizontally into a band of floats,
+    which is then filtered vertically into the output rows; rows under two tiles
+    are converted twice, but tiles need no locking, and the band stays small.
+
+  - With SSE2, a pixel is filtered in one multiply-add per tap; with AVX2, two
+    taps at a time horizontally, and two pixels at a time vertically.  The
+    kernels are picked at run time, from fxCPUFeatures().  Sums are
+    spread over several registers, so that the adds need not wait on each other.
+*/
+
+#define TILEWIDTH   256         // Output columns per tile
+#define TILEHEIGHT  32          // Output rows per tile
+#define ENCODESIZE  4096        // Steps in encode table
+
+// Byte of alpha in pixel
+#if (FOX_BIGENDIAN == 1)
+#define ALPHA 0
+#else
+#define ALPHA 3
+#endif
+
+using namespace FX;
+
+/*******************************************************************************/
+
+namespace FX {
+
+
+// Weights of filter along one axis
+struct FXResampler::Weights {
+  FXint   *first;               // First source pixel for each output pixel
+  FXfloat *weight;              // Weights of taps for each output pixel
+  FXint    taps;                // Taps per output pixel
+  FXint    src;                 // Source size
+  FXint    dst;                 // Destination size
+  FXuint   filter;              // Filter the weights are for
+  };
+
+
+// Lanczos filter with 3 lobes
+static FXdouble lanczos(FXdouble x){
+  x=Math::fabs(x);
+  if(x<1.0E-9) return 1.0;
+  if(x>=3.0) return 0.0;
+  return (3.0*Math::sin(PI*x)*Math::sin(PI*x/3.0))/(PI*PI*x*x);
+  }
+
+
+// Mitchell-Netravali filter, B=C=1/3
+static FXdouble mitchell(FXdouble x){
+  x=Math::fabs(x);
+  if(x<1.0) return ((7.0*x-12.0)*x*x+16.0/3.0)/6.0;
+  if(x<2.0) return (((-7.0/3.0)*x+12.0)*x*x-20.0*x+32.0/3.0)/6.0;
+  return 0.0;
+  }
+
+
+// Work out weights of filter for scaling from src to dst pixels
+FXbool FXResampler::weigh(Weights& wts,FXint src,FXint dst){
+  if(wts.src!=src || wts.dst!=dst || wts.filter!=filter){
+    FXdouble scale=(FXdouble)src/(FXdouble)dst;
+    FXdouble stretch=FXMAX(scale,1.0);
+    FXdouble support=(filter==Lanczos)?3.0*stretch:(filter==Mitchell)?2.0*stretch:0.5*scale;
+    FXdouble center,w,sum;
+    FXint taps,lo,hi,i,j,k;
+    FXfloat *wt;
+
+    // Most taps needed by any output pixel
+    taps=1;
+    if(src!=dst){
+      for(i=0; i<dst; ++i){
+        center=(i+0.5)*scale;
+        lo=(filter==Box)?(FXint)Math::floor(center-support):(FXint)Math::floor(center-support-0.5)+1;
+        hi=(FXint)Math::ceil(center+support-((filter==Box)?0.0:0.5))-1;
+        taps=FXMAX(taps,hi-lo+1);
+        }
+      taps=FXMIN(taps,src);
+      }
+
+    // Make room
+    wts.src=wts.dst=0;
+    if(!resizeElms(wts.first,dst)) return false;
+    if(!resizeElms(wts.weight,dst*taps)) return false;
+    wts.taps=taps;
+
+    // Weigh taps of each output pixel
+    for(i=0,wt=wts.weight; i<dst; ++i,wt+=taps){
+      clearElms(wt,taps);
+      if(src==dst){
+        wts.first[i]=i;
+        wt[0]=1.0f;
+        continue;
+        }
+      center=(i+0.5)*scale;
+      lo=(filter==Box)?(FXint)Math::floor(center-support):(FXint)Math::floor(center-support-0.5)+1;
+      hi=(FXint)Math::ceil(center+support-((filter==Box)?0.0:0.5))-1;
+      wts.first[i]=FXCLAMP(0,lo,src-taps);
+      sum=0.0;
+      for(j=lo; j<=hi; ++j){
+        if(filter==Lanczos){
+          w=lanczos((j+0.5-center)/stretch);
+          }
+        else if(filter==Mitchell){
+          w=mitchell((j+0.5-center)/stretch);
+          }
+        else{
+          w=FXMIN(j+1.0,center+support)-FXMAX((FXdouble)j,center-support);
+          }
+        k=FXCLAMP(0,j,src-1)-wts.first[i];
+        wt[k]+=(FXfloat)w;
+        sum+=w;
+        }
+      if(Math::fabs(sum)<1.0E-9){
+        clearElms(wt,taps);
+        wt[FXCLAMP(0,(FXint)center,src-1)-wts.first[i]]=1.0f;
+        continue;
+        }
+      for(k=0; k<taps; ++k){
+        wt[k]=(FXfloat)((FXdouble)wt[k]/sum);
+        }
+      }
+    wts.src=src;
+    wts.dst=dst;
+    wts.filter=filter;
+    }
+  return true;
+  }
+
+
+// Convert row of pixels to linear light, weighted by alpha
+static void decoderow(FXfloat* out,const FXColor* in,FXint n,const FXfloat* decode){
+  const FXuchar* p=(const FXuchar*)in;
+  FXfloat a;
+  while(0<n--){
+    a=p[ALPHA]*(1.0f/255.0f);
+    out[0]=decode[p[0]]*a;
+    out[1]=decode[p[1]]*a;
+    out[2]=decode[p[2]]*a;
+    out[3]=decode[p[3]]*a;
+    out[ALPHA]=a;
+    out+=4;
+    p+=4;
+    }
+  }
+
+
+// Vector kernels are compiled for their instruction set regardless of compiler
+// flags, and used only when the processor reports it supports them
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && defined(HAVE_IMMINTRIN_H)
+#define RESAMPLE_KERNELS
+#endif
+
+
+#if defined(RESAMPLE_KERNELS)
+
+// Filter row horizontally, two taps at a time
+__attribute__((target("avx2")))
+static void filterRowAVX2(FXfloat* out,const FXfloat* in,const FXint* first,const FXfloat* wt,FXint taps,FXint n,FXint base){
+  const FXfloat* p;
+  __m256 a0,a1;
+  __m128 acc;
+  FXint k;
+  while(0<n--){
+    p=in+4*(*first++-base);
+    a0=_mm256_setzero_ps();
+    a1=_mm256_setzero_ps();
+    for(k=0; k+3<taps; k+=4){
+      a0=_mm256_add_ps(a0,_mm256_mul_ps(_mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(wt[k])),_mm_set1_ps(wt[k+1]),1),_mm256_loadu_ps(p)));
+      a1=_mm256_add_ps(a1,_mm256_mul_ps(_mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(wt[k+2])),_mm_set1_ps(wt[k+3]),1),_mm256_loadu_ps(p+8)));
+      p+=16;
+      }
+    a0=_mm256_add_ps(a0,a1);
+    acc=_mm_add_ps(_mm256_castps256_ps128(a0),_mm256_extractf128_ps(a0,1));
+    for(; k<taps; ++k){
+      acc=_mm_add_ps(acc,_mm_mul_ps(_mm_set1_ps(wt[k]),_mm_loadu_ps(p)));
+      p+=4;
+      }
+    _mm_storeu_ps(out,acc);
+    wt+=taps;
+    out+=4;
+    }
+  }
+
+
+// Filter row horizontally, one tap at a time
+__attribute__((target("sse2")))
+static void filterRowSSE2(FXfloat* out,const FXfloat* in,const FXint* first,const FXfloat* wt,FXint taps,FXint n,FXint base){
+  const FXfloat* p;
+  __m128 a0,a1,a2,a3;
+  FXint k;
+  while(0<n--){
+    p=in+4*(*first++-base);
+    a0=_mm_setzero_ps();
+    a1=_mm_setzero_ps();
+    a2=_mm_setzero_ps();
+    a3=_mm_setzero_ps();
+    for(k=0; k+3<taps; k+=4){
+      a0=_mm_add_ps(a0,_mm_mul_ps(_mm_set1_ps(wt[k]),_mm_loadu_ps(p)));
+      a1=_mm_add_ps(a1,_mm_mul_ps(_mm_set1_ps(wt[k+1]),_mm_loadu_ps(p+4)));
+      a2=_mm_add_ps(a2,_mm_mul_ps(_mm_set1_ps(wt[k+2]),_mm_loadu_ps(p+8)));
+      a3=_mm_add_ps(a3,_mm_mul_ps(_mm_set1_ps(wt[k+3]),_mm_loadu_ps(p+12)));
+      p+=16;
+      }
+    for(; k<taps; ++k){
+      a0=_mm_add_ps(a0,_mm_mul_ps(_mm_set1_ps(wt[k]),_mm_loadu_ps(p)));
+      p+=4;
+      }
+    _mm_storeu_ps(out,_mm_add_ps(_mm_add_ps(a0,a1),_mm_add_ps(a2,a3)));
+    wt+=taps;
+    out+=4;
+    }
+  }
+
+
+// Filter floats vertically, 16 at a time; return floats done
+__attribute__((target("avx2")))
+static FXint filterColumnAVX2(FXfloat* out,const FXfloat* in,FXint stride,const FXfloat* wt,FXint taps,FXint n){
+  __m256 a0,a1,w;
+  FXint i=0,k;
+  for(; i+16<=n; i+=16){
+    a0=_mm256_setzero_ps();
+    a1=_mm256_setzero_ps();
+    for(k=0; k<taps; ++k){
+      w=_mm256_set1_ps(wt[k]);
+      a0=_mm256_add_ps(a0,_mm256_mul_ps(w,_mm256_loadu_ps(in+k*stride+i)));
+      a1=_mm256_add_ps(a1,_mm256_mul_ps(w,_mm256_loadu_ps(in+k*stride+i+8)));
+      }
+    _mm256_storeu_ps(out+i,a0);
+    _mm256_storeu_ps(out+i+8,a1);
+    }
+  return i;
+  }
+
+
+// Filter floats vertically, 16 and then 4 at a time; return floats done
+__attribute__((target("sse2")))
+static FXint filterColumnSSE2(FXfloat* out,const FXfloat* in,FXint stride,const FXfloat* wt,FXint taps,FXint n){
+  __m128 a0,a1,a2,a3,w;
+  FXint i=0,k;
+  for(; i+16<=n; i+=16){
+    a0=_mm_setzero_ps();
+    a1=_mm_setzero_ps();
+    a2=_mm_setzero_ps();
+    a3=_mm_setzero_ps();
+    for(k=0; k<taps; ++k){
+      w=_mm_set1_ps(wt[k]);
+      a0=_mm_add_ps(a0,_mm_mul_ps(w,_mm_loadu_ps(in+k*stride+i)));
+      a1=_mm_add_ps(a1,_mm_mul_ps(w,_mm_loadu_ps(in+k*stride+i+4)));
+      a2=_mm_add_ps(a2,_mm_mul_ps(w,_mm_loadu_ps(in+k*stride+i+8)));
+      a3=_mm_add_ps(a3,_mm_mul_ps(w,_mm_loadu_ps(in+k*stride+i+12)));
+      }
+    _mm_storeu_ps(out+i,a0);
+    _mm_storeu_ps(out+i+4,a1);
+    _mm_storeu_ps(out+i+8,a2);
+    _mm_storeu_ps(out+i+12,a3);
+    }
+  for(; i+4<=n; i+=4){
+    a0=_mm_setzero_ps();
+    for(k=0; k<taps; ++k){
+      a0=_mm_add_ps(a0,_mm_mul_ps(_mm_set1_ps(wt[k]),_mm_loadu_ps(in+k*stride+i)));
+      }
+    _mm_storeu_ps(out+i,a0);
+    }
+  return i;
+  }
+
+
+// Convert row of linear light back to pixels, a pixel per vector
+__attribute__((target("sse2")))
+static void encodeRowSSE2(FXColor* out,const FXfloat* in,FXint n,const FXuchar* encode){
+  const __m128 zero=_mm_setzero_ps();
+  const __m128 one=_mm_set1_ps(1.0f);
+  const __m128 tiny=_mm_set1_ps(1.0E-20f);
+  const __m128 steps=_mm_set1_ps((FXfloat)ENCODESIZE);
+  const __m128 half=_mm_set1_ps(0.5f);
+  const __m128 full=_mm_set_ss(255.0f);
+  FXuchar* q=(FXuchar*)out;
+  FXint idx[4];
+  __m128 v,a,c;
+  while(0<n--){
+    v=_mm_loadu_ps(in);
+    a=_mm_shuffle_ps(v,v,_MM_SHUFFLE(3,3,3,3));
+    a=_mm_min_ps(_mm_max_ps(a,zero),one);
+    c=_mm_div_ps(v,_mm_max_ps(a,tiny));
+    c=_mm_min_ps(_mm_max_ps(c,zero),one);
+    _mm_storeu_si128((__m128i*)idx,_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sqrt_ps(c),steps),half)));
+    q[0]=encode[idx[0]];
+    q[1]=encode[idx[1]];
+    q[2]=encode[idx[2]];
+    q[3]=(FXuchar)_mm_cvttss_si32(_mm_add_ss(_mm_mul_ss(a,full),half));
+    in+=4;
+    q+=4;
+    }
+  }
+
+#endif
+
+
+// Filter row horizontally; in starts at source pixel base
+static void filterrow(FXfloat* out,const FXfloat* in,const FXint* first,const FXfloat* wt,FXint taps,FXint n,FXint base,FXuint features){
+  const FXfloat* p;
+  FXfloat r0,r1,r2,r3;
+  FXint k;
+#if defined(RESAMPLE_KERNELS)
+  if(features&CPU_HAS_AVX2){ filterRowAVX2(out,in,first,wt,taps,n,base); return; }
+  if(features&CPU_HAS_SSE2){ filterRowSSE2(out,in,first,wt,taps,n,base); return; }
+#endif
+  while(0<n--){
+    p=in+4*(*first++-base);
+    r0=r1=r2=r3=0.0f;
+    for(k=0; k<taps; ++k){
+      r0+=wt[k]*p[0];
+      r1+=wt[k]*p[1];
+      r2+=wt[k]*p[2];
+      r3+=wt[k]*p[3];
+      p+=4;
+      }
+    out[0]=r0;
+    out[1]=r1;
+    out[2]=r2;
+    out[3]=r3;
+    wt+=taps;
+    out+=4;
+    }
+  }
+
+
+// Filter n floats vertically, from rows stride floats apart
+static void filtercolumn(FXfloat* out,const FXfloat* in,FXint stride,const FXfloat* wt,FXint taps,FXint n,FXuint features){
+  FXfloat acc;
+  FXint i=0,k;
+#if defined(RESAMPLE_KERNELS)
+  if(features&CPU_HAS_AVX2) i=filterColumnAVX2(out,in,stride,wt,taps,n);
+  if(features&CPU_HAS_SSE2) i+=filterColumnSSE2(out+i,in+i,stride,wt,taps,n-i);
+#endif
+  for(; i<n; ++i){
+    acc=0.0f;
+    for(k=0; k<taps; ++k){
+      acc+=wt[k]*in[k*stride+i];
+      }
+    out[i]=acc;
+    }
+  }
+
+
+// Convert row of linear light, weighted by alpha, back to pixels
+static void encoderow(FXColor* out,const FXfloat* in,FXint n,const FXuchar* encode,FXuint features){
+  FXuchar* q=(FXuchar*)out;
+  FXfloat a,c;
+  FXint i;
+#if defined(RESAMPLE_KERNELS) && (FOX_BIGENDIAN == 0)
+  if(features&CPU_HAS_SSE2){ encodeRowSSE2(out,in,n,encode); return; }
+#endif
+  while(0<n--){
+    a=FXCLAMP(0.0f,in[ALPHA],1.0f);
+    for(i=0; i<4; ++i){
+      c=in[i]/FXMAX(a,1.0E-20f);
+      c=FXCLAMP(0.0f,c,1.0f);
+      q[i]=encode[(FXint)(Math::sqrt(c)*ENCODESIZE+0.5f)];
+      }
+    q[ALPHA]=(FXuchar)(a*255.0f+0.5f);
+    in+=4;
+    q+=4;
+    }
+  }
+
+
+// Scales the tiles of an image
+struct FXResampleTiles {
+  FXColor       *dst;
+  FXint          dstride;
+  const FXColor *src;
+  FXint          sstride;
+  const FXint   *xfirst;
+  const FXfloat *xweight;
+  FXint          xtaps;
+  const FXint   *yfirst;
+  const FXfloat *yweight;
+  FXint          ytaps;
+  const FXfloat *decode;
+  const FXuchar *encode;
+  FXuint         features;
+  volatile FXint*failed;
+  void operator()(FXint xf,FXint xt,FXint yf,FXint yt) const;
+  };
+
+
+// Scale output pixels xf...xt-1 of rows yf...yt-1
+void FXResampleTiles::operator()(FXint xf,FXint xt,FXint yf,FXint yt) const {
+  FXint sx0=xfirst[xf];
+  FXint sx1=xfirst[xt-1]+xtaps;
+  FXint sy0=yfirst[yf];
+  FXint sy1=yfirst[yt-1]+ytaps;
+  FXint bw=4*(xt-xf);
+  FXfloat *row=nullptr;
+  FXfloat *band=nullptr;
+  FXfloat *acc=nullptr;
+  FXint y;
+  if(allocElms(row,4*(sx1-sx0)) && allocElms(band,bw*(sy1-sy0)) && allocElms(acc,bw)){
+
+    // Filter source rows under tile horizontally
+    for(y=sy0; y<sy1; ++y){
+      decoderow(row,src+(FXival)y*sstride+sx0,sx1-sx0,decode);
+      filterrow(band+(FXival)bw*(y-sy0),row,xfirst+xf,xweight+(FXival)xf*xtaps,xtaps,xt-xf,sx0,features);
+      }
+
+    // Filter band vertically into output rows
+    for(y=yf; y<yt; ++y){
+      filtercolumn(acc,band+(FXival)bw*(yfirst[y]-sy0),bw,yweight+(FXival)y*ytaps,ytaps,bw,features);
+      encoderow(dst+(FXival)y*dstride+xf,acc,xt-xf,encode,features);
+      }
+    }
+  else{
+    atomicSet(failed,1);
+    }
+  freeElms(acc);
+  freeElms(band);
+  freeElms(row);
+  }
+
+
+// Create resampler; if the tables can't be allocated, scale() fails
+FXResampler::FXResampler(FXuint filt,FXfloat gam,FXThreadPool* p):xweights(nullptr),yweights(nullptr),decode(nullptr),encode(nullptr),pool(p),filter(filt),gamma(0.0f){
+  if(!callocElms(xweights,1) || !callocElms(yweights,1) || !allocElms(decode,256) || !allocElms(encode,ENCODESIZE+1)){
+    freeElms(xweights);
+    freeElms(yweights);
+    freeElms(decode);
+    freeElms(encode);
+    }
+  if(!pool) pool=FXThreadPool::instance();
+  setGamma(gam);
+  }
+
+
+// Change filter
+void FXResampler::setFilter(FXuint filt){
+  filter=filt;
+  }
+
+
+// Change gamma, and redo tables
+void FXResampler::setGamma(FXfloat gam){
+  if(gam<=0.0f) gam=1.0f;
+  if(gamma!=gam && decode && encode){
+    for(FXint i=0; i<256; ++i){
+      decode[i]=(FXfloat)Math::pow(i/255.0,(FXdouble)gam);
+      }
+    for(FXint k=0; k<=ENCODESIZE; ++k){
+      encode[k]=(FXuchar)(255.0*Math::pow((FXdouble)k/ENCODESIZE,2.0/(FXdouble)gam)+0.5);
+      }
+    gamma=gam;
+    }
+  }
+
+
+// Scale source image to destination image
+FXbool FXResampler::scale(FXColor* dst,FXint dw,FXint dh,FXint dstride,const FXColor* src,FXint sw,FXint sh,FXint sstride){
+  if(dst && src && 0<dw && 0<dh && 0<sw && 0<sh && dw<=dstride && sw<=sstride && xweights && yweights && decode && encode){
+    if(weigh(*xweights,sw,dw) && weigh(*yweights,sh,dh)){
+      volatile FXint failed=0;
+      FXResampleTiles tiles;
+      tiles.dst=dst;
+      tiles.dstride=dstride;
+      tiles.src=src;
+      tiles.sstride=sstride;
+      tiles.xfirst=xweights->first;
+      tiles.xweight=xweights->weight;
+      tiles.xtaps=xweights->taps;
+      tiles.yfirst=yweights->first;
+      tiles.yweight=yweights->weight;
+      tiles.ytaps=yweights->taps;
+      tiles.decode=decode;
+      tiles.encode=encode;
+      tiles.features=fxCPUFeatures();
+      tiles.failed=&failed;
+      if(pool && pool->active()){
+        FXParallelForTiles(pool,0,dw,0,dh,TILEWIDTH,TILEHEIGHT,tiles);
+        }
+      else{
+        for(FXint y=0; y<dh; y+=TILEHEIGHT){
+          for(FXint x=0; x<dw; x+=TILEWIDTH){
+            tiles(x,FXMIN(x+TILEWIDTH,dw),y,FXMIN(y+TILEHEIGHT,dh));
+            }
+          }
+        }
+      return !failed;
+      }
+    }
+  return false;
+  }
+
+
+// Destroy resampler
+FXResampler::~FXResampler(){
+  if(xweights){
+    freeElms(xweights->first);
+    freeElms(xweights->weight);
+    }
+  if(yweights){
+    freeElms(yweights->first);
+    freeElms(yweights->weight);
+    }
+  freeElms(xweights);
+  freeElms(yweights);
+  freeElms(decode);
+  freeElms(encode);
+  }
+
+}
@@ -23,6 +23,7 @@
 #include "fxdefs.h"
 #include "fxchar.h"
 #include "fxmath.h"
+#include "fxendian.h"
 #include "fxascii.h"
 #include "fxunicode.h"
 #include "FXElement.h"
@@ -197,6 +198,41 @@
       and scans backward.
 
 
+  Searching
+  =========
+
+  Trying a match at every position of the subject string is slow, so after compiling, the
+  program is examined for what any match must start with: a literal string (skipping over
+  captures, assertions, and look-arounds in front of it), or failing that, the set of possible
+  first characters.  This is kept alongside the program, and search() only tries a match at
+  places where the string or character is found.  The first character is found with memchr(),
+  or with SSE2 when case is ignored; longer strings switch to Horspool's method when their
+  first character turns up too often.  Anchored patterns (\A, ^) are handled as before.
+
+
+  Linear-time Matching
+  ====================
+
+  The backtracking matcher may take exponential time on patterns like (a|aa)*b or (a*)*b
+  when there is no match.  So the program is also translated, where possible, into the
+  instructions of a Pike VM: a Thompson NFA simulation, which advances all threads of the
+  match in lock-step one character at a time, keeping only one thread per instruction, and
+  carrying the capture positions along with each thread.  Threads are kept in priority order,
+  which is the order in which the backtracker would try them, and when a thread matches the
+  lower priority ones are cut; thus it finds the same match, in O(n*m) time for a subject of
+  n characters and m instructions.
+
+  Not everything can be translated: back references, look-arounds, atomic groups, possessive
+  repeats, counted repeats of groups, and unicode are left to the backtracker only.  Simple
+  counted repeats are unrolled, up to a limit on the number of instructions.
+
+  The backtracker still runs first, since it is much faster on ordinary patterns; but when
+  there is a Pike VM program, it gets a budget of work proportional to the subject length,
+  and if it runs out (or recursion gets too deep), the search is done over with the Pike VM.
+  The match flags Backtrack and Linear force the one or the other.  Should the Pike VM
+  fail to allocate its thread lists, the backtracker runs once more, without a budget.
+
+
   Grammar:
   ========
 
@@ -535,6 +571,24 @@
 // Maximum number of pieces reversed
 #define MAXPIECES     256
 
+// Maximum length of literal prefix used to speed up search
+#define MAXPREFIX     255
+
+// Maximum number of opcodes examined to find first characters of a match
+#define MAXSTEPS      100
+
+// Literal prefixes this long or longer may be searched using Horspool's method,
+// after their first character has been found in the wrong place this many times
+#define MINHORSPOOL   4
+#define MINMISSES     16
+
+// Maximum number of Pike VM instructions
+#define MAXINST       8192
+
+// Work allowed to backtracker before switching to Pike VM: base, and per character
+#define MINBUDGET     100000
+#define BUDGET        32
+
 // Access to opcode
 #define SETOP(p,op)   (*(p)=(op))
 
@@ -576,6 +630,28 @@ enum {
   };
 
 
+// Ways to find possible match locations
+enum {
+  SCAN_CHARS    = 1,        // Match starts with literal string
+  SCAN_CHARS_CI = 2,        // Match starts with literal string, case insensitive
+  SCAN_PAIR     = 3,        // Match starts with one of two characters
+  SCAN_SET      = 4         // Match starts with character in set
+  };
+
+
+// Pike VM instructions
+enum {
+  VM_MATCH      = 0,        // Match found
+  VM_CHAR       = 1,        // Character x
+  VM_CHAR_CI    = 2,        // Character x, case insensitive
+  VM_SET        = 3,        // Character in set x
+  VM_SPLIT      = 4,        // Continue at x, and with lower priority at y
+  VM_JUMP       = 5,        // Continue at x
+  VM_SAVE       = 6,        // Save position in capture slot x
+  VM_ASSERT     = 7         // Zero-width assertion, opcode x
+  };
+
+
 // Opcodes of the engine; these are numbered in a certain way so that
 // its easy to determine if these are asserts, simple single character matches,
 // unicode matches, and so on.
@@ -2475,6 +2551,265 @@ FXRex::Error FXReverse::charset(){
 
 /*******************************************************************************/
 
+// Size of single-character opcode at prog, or 0 if its something else
+static FXint onechar(const FXchar* prog){
+  switch((FXuchar)prog[0]){
+    case OP_ANY:
+    case OP_ANY_NL:
+    case OP_UPPER:
+    case OP_LOWER:
+    case OP_SPACE:
+    case OP_SPACE_NL:
+    case OP_NOT_SPACE:
+    case OP_DIGIT:
+    case OP_NOT_DIGIT:
+    case OP_NOT_DIGIT_NL:
+    case OP_HEX:
+    case OP_NOT_HEX:
+    case OP_NOT_HEX_NL:
+    case OP_LETTER:
+    case OP_NOT_LETTER:
+    case OP_NOT_LETTER_NL:
+    case OP_PUNCT:
+    case OP_NOT_PUNCT:
+    case OP_NOT_PUNCT_NL:
+    case OP_WORD:
+    case OP_NOT_WORD:
+    case OP_NOT_WORD_NL:
+      return 1;
+    case OP_CHAR:
+    case OP_CHAR_CI:
+      return 2;
+    case OP_RNG:
+    case OP_NOT_RNG:
+      return 3;
+    case OP_IN:
+    case OP_NOT_IN:
+      return 33;
+    case OP_ANY_OF:
+    case OP_ANY_BUT:
+      return 2+(FXuchar)prog[1];
+    }
+  return 0;
+  }
+
+
+// Check if single-character opcode at prog would match character ch
+static FXbool onematch(const FXchar* prog,FXuchar ch){
+  switch((FXuchar)prog[0]){
+    case OP_ANY: return ch!='\n';
+    case OP_ANY_NL: return true;
+    case OP_UPPER: return Ascii::isUpper(ch);
+    case OP_LOWER: return Ascii::isLower(ch);
+    case OP_SPACE: return ch!='\n' && Ascii::isSpace(ch);
+    case OP_SPACE_NL: return Ascii::isSpace(ch);
+    case OP_NOT_SPACE: return !Ascii::isSpace(ch);
+    case OP_DIGIT: return Ascii::isDigit(ch);
+    case OP_NOT_DIGIT: return ch!='\n' && !Ascii::isDigit(ch);
+    case OP_NOT_DIGIT_NL: return !Ascii::isDigit(ch);
+    case OP_HEX: return Ascii::isHexDigit(ch);
+    case OP_NOT_HEX: return ch!='\n' && !Ascii::isHexDigit(ch);
+    case OP_NOT_HEX_NL: return !Ascii::isHexDigit(ch);
+    case OP_LETTER: return Ascii::isLetter(ch);
+    case OP_NOT_LETTER: return ch!='\n' && !Ascii::isLetter(ch);
+    case OP_NOT_LETTER_NL: return !Ascii::isLetter(ch);
+    case OP_PUNCT: return Ascii::isDelim(ch);
+    case OP_NOT_PUNCT: return ch!='\n' && !Ascii::isDelim(ch);
+    case OP_NOT_PUNCT_NL: return !Ascii::isDelim(ch);
+    case OP_WORD: return Ascii::isWord(ch);
+    case OP_NOT_WORD: return ch!='\n' && !Ascii::isWord(ch);
+    case OP_NOT_WORD_NL: return !Ascii::isWord(ch);
+    case OP_CHAR: return (FXuchar)prog[1]==ch;
+    case OP_CHAR_CI: return prog[1]==Ascii::toLower(ch);
+    case OP_RNG: return (FXuchar)prog[1]<=ch && ch<=(FXuchar)prog[2];
+    case OP_IN: return ISIN(prog+1,ch)!=0;
+    case OP_NOT_IN: return ISIN(prog+1,ch)==0;
+    case OP_ANY_OF: return LIST(prog+1,ch);
+    case OP_ANY_BUT: return !LIST(prog+1,ch);
+    }
+  return true;
+  }
+
+
+// Add characters matched by single-character opcode at prog to set
+static void onechars(const FXchar* prog,FXuchar set[]){
+  for(FXint ch=0; ch<256; ++ch){
+    if(onematch(prog,(FXuchar)ch)) INCL(set,(FXuchar)ch);
+    }
+  }
+
+
+// Collect literal string with which every match of prog must start;
+// zero-width assertions and look-arounds in between are skipped.
+// Case-insensitive pieces make the whole string case-insensitive.
+static FXint prefixchars(const FXchar* prog,FXchar lit[],FXbool& ci){
+  FXint n=0,no,i;
+  ci=false;
+  while(n<MAXPREFIX){
+    switch((FXuchar)prog[0]){
+      case OP_NOT_EMPTY:
+      case OP_STR_BEG:
+      case OP_STR_END:
+      case OP_LINE_BEG:
+      case OP_LINE_END:
+      case OP_WORD_BEG:
+      case OP_WORD_END:
+      case OP_WORD_BND:
+      case OP_WORD_INT:
+      case OP_SUB_BEG_0: case OP_SUB_BEG_1: case OP_SUB_BEG_2: case OP_SUB_BEG_3: case OP_SUB_BEG_4:
+      case OP_SUB_BEG_5: case OP_SUB_BEG_6: case OP_SUB_BEG_7: case OP_SUB_BEG_8: case OP_SUB_BEG_9:
+      case OP_SUB_END_0: case OP_SUB_END_1: case OP_SUB_END_2: case OP_SUB_END_3: case OP_SUB_END_4:
+      case OP_SUB_END_5: case OP_SUB_END_6: case OP_SUB_END_7: case OP_SUB_END_8: case OP_SUB_END_9:
+        prog+=1;
+        continue;
+      case OP_AHEAD_NEG:
+      case OP_AHEAD_POS:
+      case OP_BEHIND_NEG:
+      case OP_BEHIND_POS:
+        prog+=1+GETARG(prog+1);
+        continue;
+      case OP_CHAR_CI:
+        ci=true;
+        /*FALL*/
+      case OP_CHAR:
+        lit[n++]=prog[1];
+        prog+=2;
+        continue;
+      case OP_CHARS_CI:
+        ci=true;
+        /*FALL*/
+      case OP_CHARS:
+        no=GETARG(prog+1);
+        for(i=0; i<no && n<MAXPREFIX; ++i){ lit[n++]=prog[3+i]; }
+        prog+=3+no;
+        continue;
+      }
+    break;
+    }
+  if(ci){
+    for(i=0; i<n; ++i){ lit[i]=Ascii::toLower(lit[i]); }
+    }
+  return n;
+  }
+
+
+// Collect characters with which a match of prog may start into set; return false if
+// a match could be empty, or the program is too complicated to figure it out.
+static FXbool firstchars(const FXchar* prog,FXuchar set[],FXint& steps){
+  while(++steps<MAXSTEPS){
+    switch((FXuchar)prog[0]){
+      case OP_BRANCH:
+      case OP_BRANCHREV:
+        if(!firstchars(prog+3,set,steps)) return false;
+        prog+=1+GETARG(prog+1);
+        continue;
+      case OP_JUMP:
+        prog+=1+GETARG(prog+1);
+        continue;
+      case OP_ATOMIC:
+        return firstchars(prog+3,set,steps);
+      case OP_AHEAD_NEG:
+      case OP_AHEAD_POS:
+      case OP_BEHIND_NEG:
+      case OP_BEHIND_POS:
+        prog+=1+GETARG(prog+1);
+        continue;
+      case OP_NOT_EMPTY:
+      case OP_STR_BEG:
+      case OP_STR_END:
+      case OP_LINE_BEG:
+      case OP_LINE_END:
+      case OP_WORD_BEG:
+      case OP_WORD_END:
+      case OP_WORD_BND:
+      case OP_WORD_INT:
+      case OP_SUB_BEG_0: case OP_SUB_BEG_1: case OP_SUB_BEG_2: case OP_SUB_BEG_3: case OP_SUB_BEG_4:
+      case OP_SUB_BEG_5: case OP_SUB_BEG_6: case OP_SUB_BEG_7: case OP_SUB_BEG_8: case OP_SUB_BEG_9:
+      case OP_SUB_END_0: case OP_SUB_END_1: case OP_SUB_END_2: case OP_SUB_END_3: case OP_SUB_END_4:
+      case OP_SUB_END_5: case OP_SUB_END_6: case OP_SUB_END_7: case OP_SUB_END_8: case OP_SUB_END_9:
+      case OP_ZERO_0: case OP_ZERO_1: case OP_ZERO_2: case OP_ZERO_3: case OP_ZERO_4:
+      case OP_ZERO_5: case OP_ZERO_6: case OP_ZERO_7: case OP_ZERO_8: case OP_ZERO_9:
+        prog+=1;
+        continue;
+      case OP_CHARS:
+        INCL(set,prog[3]);
+        return true;
+      case OP_CHARS_CI:
+        INCL(set,prog[3]);
+        INCL(set,Ascii::toUpper(prog[3]));
+        return true;
+      case OP_STAR:
+      case OP_MIN_STAR:
+      case OP_POS_STAR:
+      case OP_QUEST:
+      case OP_MIN_QUEST:
+      case OP_POS_QUEST:
+        if(!onechar(prog+1)) return false;
+        onechars(prog+1,set);
+        prog+=1+onechar(prog+1);
+        continue;
+      case OP_PLUS:
+      case OP_MIN_PLUS:
+      case OP_POS_PLUS:
+        if(!onechar(prog+1)) return false;
+        onechars(prog+1,set);
+        return true;
+      case OP_REP:
+      case OP_MIN_REP:
+      case OP_POS_REP:
+        if(!onechar(prog+5)) return false;
+        onechars(prog+5,set);
+        if(0<GETARG(prog+1)) return true;
+        prog+=5+onechar(prog+5);
+        continue;
+      }
+    if(!onechar(prog)) return false;
+    onechars(prog,set);
+    return true;
+    }
+  return false;
+  }
+
+
+// Work out how to find places where a match of prog could start, before trying
+// the full match there: a literal string every match starts with, else the set
+// of characters a match starts with.  Left empty when nothing can be skipped.
+static void prefilter(FXString& scan,const FXchar* prog){
+  FXchar buffer[MAXPREFIX+1];
+  FXuchar set[32];
+  FXint steps=0,n,ch;
+  FXbool ci;
+  scan.clear();
+  if(prog[0]){
+    if((n=prefixchars(prog,buffer+1,ci))>0){
+      buffer[0]=ci?SCAN_CHARS_CI:SCAN_CHARS;
+      scan.assign(buffer,n+1);
+      return;
+      }
+    clearElms(set,32);
+    if(firstchars(prog,set,steps)){
+      for(ch=n=0; ch<256; ++ch){
+        if(ISIN(set,(FXuchar)ch)){ if(n<2){ buffer[1+n]=(FXchar)ch; } n++; }
+        }
+      if(n==1){
+        buffer[0]=SCAN_CHARS;
+        scan.assign(buffer,2);
+        }
+      else if(n==2){
+        buffer[0]=SCAN_PAIR;
+        scan.assign(buffer,3);
+        }
+      else if(n<256){
+        buffer[0]=SCAN_SET;
+        memcpy(buffer+1,set,32);
+        scan.assign(buffer,33);
+        }
+      }
+    }
+  }
+
+/*******************************************************************************/
+
 // Structure used during matching
 class FXExecute {
   const FXchar  *anc;               // Anchor point
@@ -2486,19 +2821,33 @@ class FXExecute {
   FXint         *sub_beg;           // Begin of substring i
   FXint         *sub_end;           // End of substring i
   FXint          count[NSUBEXP];    // Counters for counted repeats
+  FXival         budget;            // Work left before giving up
   FXint          npar;              // Number of capturing parentheses
   FXint          recs;              // Recursions
   FXint          mode;              // Match mode
+  FXbool         overflow;          // Gave up on budget or recursion
 public:
 
   // Construct match engine
   FXExecute(const FXchar* sbeg,const FXchar* send,FXint* b,FXint* e,FXint p,FXint m);
 
+  // Limit work done before giving up
+  void limit(FXival b){ budget=b; }
+
+  // Return true if gave up somewhere, so the result may be wrong
+  FXbool exceeded() const { return overflow; }
+
   // Attempt to match
   FXbool attempt(const FXchar* prog,const FXchar* ptr);
 
   // Search in string, starting at ptr
-  FXint search(const FXchar* prog,const FXchar* fm,const FXchar* to);
+  FXint search(const FXchar* prog,const FXchar* scan,FXint nscan,const FXchar* fm,const FXchar* to);
+
+  // Search for literal string every match starts with
+  FXint searchchars(const FXchar* prog,const FXuchar* lit,FXint m,FXbool ci,const FXchar* fm,const FXchar* to);
+
+  // Search for character every match starts with
+  FXint searchset(const FXchar* prog,const FXuchar* set,FXbool pair,const FXchar* fm,const FXchar* to);
 
   // Match at current string position
   FXbool match(const FXchar* prog);
@@ -2510,7 +2859,7 @@ public:
 
 
 // Construct match engine
-FXExecute::FXExecute(const FXchar* sbeg,const FXchar* send,FXint* b,FXint* e,FXint p,FXint m):anc(nullptr),str(nullptr),str_beg(sbeg),str_end(send),sub_beg(b),sub_end(e),npar(p),recs(0),mode(m){
+FXExecute::FXExecute(const FXchar* sbeg,const FXchar* send,FXint* b,FXint* e,FXint p,FXint m):anc(nullptr),str(nullptr),str_beg(sbeg),str_end(send),sub_beg(b),sub_end(e),budget((FXival)(~(FXuval)0>>1)),npar(p),recs(0),mode(m),overflow(false){
   bak_beg[0]=bak_end[0]=nullptr;
   bak_beg[1]=bak_end[1]=nullptr;
   bak_beg[2]=bak_end[2]=nullptr;
@@ -2540,7 +2889,7 @@ FXExecute::FXExecute(const FXchar* sbeg,const FXchar* send,FXint* b,FXint* e,FXi
 
 // The workhorse
 FXbool FXExecute::match(const FXchar* prog){
-  if(recs<MAXRECURSION){
+  if(recs<MAXRECURSION && 0<budget){
     FXint no,keep,rep_min,rep_max,greediness;
     const FXchar *ptr,*save,*beg,*end;
     FXuchar op;
@@ -2548,6 +2897,7 @@ FXbool FXExecute::match(const FXchar* prog){
 
     // Recurse deeper
     ++recs;
+    --budget;
 
     // Process expression
 nxt:op=*prog++;
@@ -3420,7 +3770,8 @@ rep:    if(str+rep_min>str_end) goto f;         // Can't possibly succeed
           }
 
         // Unicode match
-uni:    if(no<rep_min) goto f;
+uni:    budget-=no;
+        if(no<rep_min) goto f;
 
         // Greedy match
         if(greediness==GREEDY){
@@ -3450,7 +3801,8 @@ uni:    if(no<rep_min) goto f;
         goto nxt;
 
         // Ascii match
-asc:    if(no<rep_min) goto f;
+asc:    budget-=no;
+        if(no<rep_min) goto f;
 
         // Greedy match
         if(greediness==GREEDY){
@@ -3663,7 +4015,9 @@ t:  --recs;
 
     // Return with failure
 f:  --recs;
+    return false;
     }
+  overflow=true;
   return false;
   }
 
@@ -4787,9 +5141,196 @@ FXbool FXExecute::attempt(const FXchar* prog,const FXchar* ptr){
 
 /*******************************************************************************/
 
+// Find first of characters a or b in [p,e)
+static const FXuchar* findpair(const FXuchar* p,const FXuchar* e,FXuchar a,FXuchar b){
+#if defined(FOX_HAS_SSE2)
+  const __m128i aa=_mm_set1_epi8((FXchar)a);
+  const __m128i bb=_mm_set1_epi8((FXchar)b);
+  __m128i x;
+  FXuint bits;
+  while(16<=e-p){
+    x=_mm_loadu_si128((const __m128i*)p);
+    bits=_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x,aa),_mm_cmpeq_epi8(x,bb)));
+    if(bits) return p+ctz32(bits);
+    p+=16;
+    }
+#endif
+  while(p<e){
+    if(*p==a || *p==b) return p;
+    p++;
+    }
+  return nullptr;
+  }
+
+
+// Find last of characters a or b in [p,e)
+static const FXuchar* findpairrev(const FXuchar* p,const FXuchar* e,FXuchar a,FXuchar b){
+#if defined(FOX_HAS_SSE2)
+  const __m128i aa=_mm_set1_epi8((FXchar)a);
+  const __m128i bb=_mm_set1_epi8((FXchar)b);
+  __m128i x;
+  FXuint bits;
+  while(16<=e-p){
+    x=_mm_loadu_si128((const __m128i*)(e-16));
+    bits=_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x,aa),_mm_cmpeq_epi8(x,bb)));
+    if(bits) return e-16+(31-clz32(bits));
+    e-=16;
+    }
+#endif
+  while(p<e){
+    e--;
+    if(*e==a || *e==b) return e;
+    }
+  return nullptr;
+  }
+
+
+// Compare n characters at p against literal string, which is lower case if ci
+static inline FXbool matchchars(const FXuchar* p,const FXuchar* lit,FXint n,FXbool ci){
+  FXint i=0;
+  if(ci){
+    while(i<n && (FXuchar)Ascii::toLower(p[i])==lit[i]) ++i;
+    }
+  else{
+    while(i<n && p[i]==lit[i]) ++i;
+    }
+  return i==n;
+  }
+
+
+// Search for literal string lit of length m, which every match starts with, and try
+// the full match only where it is found.  The string is found by its first character,
+// using memchr() or SSE2; if that character turns up too often, longer strings switch
+// to Horspool's method, skipping by up to m characters based on the character under
+// the end (or start, when searching backwards) of the string.
+FXint FXExecute::searchchars(const FXchar* prog,const FXuchar* lit,FXint m,FXbool ci,const FXchar* fm,const FXchar* to){
+  const FXuchar* s=(const FXuchar*)str_beg;
+  const FXuchar* p;
+  const FXuchar  a=lit[0];
+  const FXuchar  b=ci?Ascii::toUpper(a):a;
+  FXival last=(str_end-str_beg)-m;
+  FXival pos=fm-str_beg;
+  FXival stop=to-str_beg;
+  FXival start=pos;
+  FXint misses=0;
+  FXuchar skip[256];
+  FXuchar c;
+  FXint i;
+
+  // Search forwards
+  if(pos<=stop){
+    if(last<stop) stop=last;
+
+    // Find first character
+    while(pos<=stop){
+      if(a==b)
+        p=(const FXuchar*)memchr(s+pos,a,stop-pos+1);
+      else
+        p=findpair(s+pos,s+stop+1,a,b);
+      if(!p) return -1;
+      pos=p-s;
+      if(matchchars(p+1,lit+1,m-1,ci)){
+        if(attempt(prog,str_beg+pos)) return pos;
+        }
+      else if(MINHORSPOOL<=m && MINMISSES<++misses && pos-start<misses*m){
+        break;
+        }
+      pos++;
+      }
+
+    // Skip by last character
+    memset(skip,m,sizeof(skip));
+    for(i=0; i<m-1; ++i){
+      skip[lit[i]]=m-1-i;
+      if(ci) skip[(FXuchar)Ascii::toUpper(lit[i])]=m-1-i;
+      }
+    while(pos<=stop){
+      c=s[pos+m-1];
+      if(matchchars(&c,lit+m-1,1,ci) && matchchars(s+pos,lit,m-1,ci) && attempt(prog,str_beg+pos)) return pos;
+      pos+=skip[c];
+      }
+    return -1;
+    }
+
+  // Search backwards
+  if(last<pos) pos=start=last;
+
+  // Find first character
+  while(stop<=pos){
+    if(!(p=findpairrev(s+stop,s+pos+1,a,b))) return -1;
+    pos=p-s;
+    if(matchchars(p+1,lit+1,m-1,ci)){
+      if(attempt(prog,str_beg+pos)) return pos;
+      }
+    else if(MINHORSPOOL<=m && MINMISSES<++misses && start-pos<misses*m){
+      break;
+      }
+    pos--;
+    }
+
+  // Skip by first character
+  memset(skip,m,sizeof(skip));
+  for(i=m-1; 0<i; --i){
+    skip[lit[i]]=i;
+    if(ci) skip[(FXuchar)Ascii::toUpper(lit[i])]=i;
+    }
+  while(stop<=pos){
+    c=s[pos];
+    if(matchchars(s+pos,lit,m,ci) && attempt(prog,str_beg+pos)) return pos;
+    pos-=skip[c];
+    }
+  return -1;
+  }
+
+
+// Search for character every match starts with: either one of a pair
+// of characters, or any character in a set; try the full match there.
+FXint FXExecute::searchset(const FXchar* prog,const FXuchar* set,FXbool pair,const FXchar* fm,const FXchar* to){
+  const FXuchar* s=(const FXuchar*)str_beg;
+  const FXuchar* p;
+  FXival last=(str_end-str_beg)-1;
+  FXival pos=fm-str_beg;
+  FXival stop=to-str_beg;
+
+  // Search forwards
+  if(pos<=stop){
+    if(last<stop) stop=last;
+    while(pos<=stop){
+      if(pair){
+        if(!(p=findpair(s+pos,s+stop+1,set[0],set[1]))) break;
+        pos=p-s;
+        }
+      else{
+        while(pos<=stop && !ISIN(set,s[pos])) pos++;
+        if(stop<pos) break;
+        }
+      if(attempt(prog,str_beg+pos)) return pos;
+      pos++;
+      }
+    return -1;
+    }
+
+  // Search backwards
+  if(last<pos) pos=last;
+  while(stop<=pos){
+    if(pair){
+      if(!(p=findpairrev(s+stop,s+pos+1,set[0],set[1]))) break;
+      pos=p-s;
+      }
+    else{
+      while(stop<=pos && !ISIN(set,s[pos])) pos--;
+      if(pos<stop) break;
+      }
+    if(attempt(prog,str_beg+pos)) return pos;
+    pos--;
+    }
+  return -1;
+  }
+
+/*******************************************************************************/
+
 // Search in string, starting at ptr
-FXint FXExecute::search(const FXchar* prog,const FXchar* fm,const FXchar* to){
-  FXchar ch;
+FXint FXExecute::search(const FXchar* prog,const FXchar* scan,FXint nscan,const FXchar* fm,const FXchar* to){
 
   // Must be true
   FXASSERT(str_beg<=fm && fm<=str_end);
@@ -4820,26 +5361,12 @@ FXint FXExecute::search(const FXchar* prog,const FXchar* fm,const FXchar* to){
         return -1;
         }
 
-      // Known starting character
-      if(prog[0]==OP_CHAR || prog[0]==OP_CHARS){
-        ch=(prog[0]==OP_CHAR)?prog[1]:prog[3];
-        if(to==str_end) to--;
-        while(fm<=to){
-          if((*fm==ch) && attempt(prog,fm)) return fm-str_beg;
-          fm++;
-          }
-        return -1;
-        }
-
-      // Known starting character, ignoring case
-      if(prog[0]==OP_CHAR_CI || prog[0]==OP_CHARS_CI){
-        ch=(prog[0]==OP_CHAR_CI)?prog[1]:prog[3];
-        if(to==str_end) to--;
-        while(fm<=to){
-          if((Ascii::toLower(*fm)==ch) && attempt(prog,fm)) return fm-str_beg;
-          fm++;
+      // Known literal string or characters at start
+      if(0<nscan){
+        if(scan[0]==SCAN_CHARS || scan[0]==SCAN_CHARS_CI){
+          return searchchars(prog,(const FXuchar*)scan+1,nscan-1,scan[0]==SCAN_CHARS_CI,fm,to);
           }
-        return -1;
+        return searchset(prog,(const FXuchar*)scan+1,scan[0]==SCAN_PAIR,fm,to);
         }
 
       // General case
@@ -4860,36 +5387,22 @@ FXint FXExecute::search(const FXchar* prog,const FXchar* fm,const FXchar* to){
 
       // Anchored at BOL
       if(prog[0]==OP_LINE_BEG){
-        while(to<fm){
+        while(to<=fm && str_beg<fm){
           if((*(fm-1)=='\n') && attempt(prog,fm)) return fm-str_beg;
           fm--;
           }
-        if(fm==str_beg){
+        if(to<=fm && fm==str_beg){
           if(!(mode&FXRex::NotBol) && attempt(prog,fm)) return 0;
           }
         return -1;
         }
 
-      // Known starting character
-      if(prog[0]==OP_CHAR || prog[0]==OP_CHARS){
-        ch=(prog[0]==OP_CHAR)?prog[1]:prog[3];
-        if(fm==str_end) fm--;
-        while(to<=fm){
-          if((*fm==ch) && attempt(prog,fm)) return fm-str_beg;
-          fm--;
-          }
-        return -1;
-        }
-
-      // Known starting character, ignoring case
-      if(prog[0]==OP_CHAR_CI || prog[0]==OP_CHARS_CI){
-        ch=(prog[0]==OP_CHAR_CI)?prog[1]:prog[3];
-        if(fm==str_end) fm--;
-        while(to<=fm){
-          if((Ascii::toLower(*fm)==ch) && attempt(prog,fm)) return fm-str_beg;
-          fm--;
+      // Known literal string or characters at start
+      if(0<nscan){
+        if(scan[0]==SCAN_CHARS || scan[0]==SCAN_CHARS_CI){
+          return searchchars(prog,(const FXuchar*)scan+1,nscan-1,scan[0]==SCAN_CHARS_CI,fm,to);
           }
-        return -1;
+        return searchset(prog,(const FXuchar*)scan+1,scan[0]==SCAN_PAIR,fm,to);
         }
 
       // General case
@@ -4944,11 +5457,11 @@ FXint FXExecute::search(const FXchar* prog,const FXchar* fm,const FXchar* to){
 
     // Anchored at BOL
     if(prog[0]==OP_LINE_BEG){
-      while(to<fm){
+      while(to<=fm && str_beg<fm){
         if((*(fm-1)=='\n') && attempt(prog,fm)) return fm-str_beg;
         fm=wcdec(fm);
         }
-      if(fm==str_beg){
+      if(to<=fm && fm==str_beg){
         if(!(mode&FXRex::NotBol) && attempt(prog,fm)) return 0;
         }
       return -1;
@@ -4964,6 +5477,572 @@ FXint FXExecute::search(const FXchar* prog,const FXchar* fm,const FXchar* to){
   return -1;
   }
 
+/*******************************************************************************/
+
+// Translate program into Pike VM instructions
+class FXTranslate {
+  FXchar        *nfa;               // Instructions, or NULL when just counting
+  FXuchar       *sets;              // Character sets following the instructions
+  const FXchar  *code;              // Program
+  const FXchar  *end;               // End of program
+  FXint         *map;               // Instruction for each location in program
+  FXint          ninst;             // Number of instructions
+  FXint          nsets;             // Number of character sets
+  FXbool         notempty;          // Empty matches are rejected
+public:
+
+  // Construct translator for program
+  FXTranslate(const FXchar* prog,FXint size);
+
+  // Translate into dst, or just count if NULL; return false if not possible
+  FXbool translate(FXchar* dst);
+
+  // Size of instructions and character sets
+  FXint size() const { return 4+5*ninst+32*nsets; }
+
+  // Delete translator
+ ~FXTranslate();
+
+private:
+
+  // Append instruction
+  void emit(FXuchar op,FXint x,FXint y);
+
+  // Instruction for single character match at prog
+  FXbool single(const FXchar* prog,FXuchar& op,FXint& x);
+
+  // Instruction translated from program location prog
+  FXint target(const FXchar* prog) const;
+  };
+
+
+// Construct translator for program
+FXTranslate::FXTranslate(const FXchar* prog,FXint size):nfa(nullptr),sets(nullptr),code(prog),end(prog+size),map(nullptr),ninst(0),nsets(0),notempty(false){
+  allocElms(map,size+1);
+  fillElms(map,-1,size+1);
+  }
+
+
+// Append instruction
+void FXTranslate::emit(FXuchar op,FXint x,FXint y){
+  if(nfa){
+    FXchar* p=nfa+4+5*ninst;
+    p[0]=op;
+    SETARG(p+1,x);
+    SETARG(p+3,y);
+    }
+  ninst++;
+  }
+
+
+// Instruction for single character match at prog; characters in classes go into a new set
+FXbool FXTranslate::single(const FXchar* prog,FXuchar& op,FXint& x){
+  switch((FXuchar)prog[0]){
+    case OP_CHAR:
+      op=VM_CHAR;
+      x=(FXuchar)prog[1];
+      return true;
+    case OP_CHAR_CI:
+      op=VM_CHAR_CI;
+      x=(FXuchar)prog[1];
+      return true;
+    case OP_NOT_RNG:
+      return false;
+    }
+  if(!onechar(prog)) return false;
+  if(sets){
+    clearElms(sets+32*nsets,32);
+    onechars(prog,sets+32*nsets);
+    }
+  op=VM_SET;
+  x=nsets++;
+  return true;
+  }
+
+
+// Instruction translated from program location prog; only known when it has
+// been passed already, or when emitting, from the counting pass before.
+FXint FXTranslate::target(const FXchar* prog) const {
+  return (code<=prog && prog<end) ? map[prog-code] : -1;
+  }
+
+
+// Translate program, or just count instructions and sets if dst is NULL
+FXbool FXTranslate::translate(FXchar* dst){
+  const FXchar *prog=code;
+  FXint rep_min,rep_max,greediness,no,i,x,y;
+  FXuchar op;
+  nfa=dst;
+  sets=dst?(FXuchar*)dst+4+5*ninst:nullptr;
+  ninst=nsets=0;
+  notempty=false;
+
+  // Match starts here
+  emit(VM_SAVE,0,0);
+
+  // Translate each opcode
+  while(prog<end){
+    if(MAXINST<ninst) return false;
+    map[prog-code]=ninst;
+    switch((FXuchar)prog[0]){
+      case OP_FAIL:
+        emit(VM_ASSERT,OP_FAIL,0);
+        prog+=1;
+        continue;
+      case OP_PASS:
+        emit(VM_SAVE,1,0);
+        emit(VM_MATCH,0,0);
+        prog+=1;
+        continue;
+      case OP_JUMP:
+        x=target(prog+1+GETARG(prog+1));
+        if(dst && x<0) return false;
+        emit(VM_JUMP,x,0);
+        prog+=3;
+        continue;
+      case OP_BRANCH:
+        x=target(prog+3);
+        y=target(prog+1+GETARG(prog+1));
+        if(dst && (x<0 || y<0)) return false;
+        emit(VM_SPLIT,x,y);
+        prog+=3;
+        continue;
+      case OP_BRANCHREV:
+        x=target(prog+1+GETARG(prog+1));
+        y=target(prog+3);
+        if(dst && (x<0 || y<0)) return false;
+        emit(VM_SPLIT,x,y);
+        prog+=3;
+        continue;
+      case OP_NOT_EMPTY:
+        notempty=true;
+        /*FALL*/
+      case OP_STR_BEG:
+      case OP_STR_END:
+      case OP_LINE_BEG:
+      case OP_LINE_END:
+      case OP_WORD_BEG:
+      case OP_WORD_END:
+      case OP_WORD_BND:
+      case OP_WORD_INT:
+        emit(VM_ASSERT,(FXuchar)prog[0],0);
+        prog+=1;
+        continue;
+      case OP_SUB_BEG_0: case OP_SUB_BEG_1: case OP_SUB_BEG_2: case OP_SUB_BEG_3: case OP_SUB_BEG_4:
+      case OP_SUB_BEG_5: case OP_SUB_BEG_6: case OP_SUB_BEG_7: case OP_SUB_BEG_8: case OP_SUB_BEG_9:
+        emit(VM_SAVE,2*((FXuchar)prog[0]-OP_SUB_BEG_0),0);
+        prog+=1;
+        continue;
+      case OP_SUB_END_0: case OP_SUB_END_1: case OP_SUB_END_2: case OP_SUB_END_3: case OP_SUB_END_4:
+      case OP_SUB_END_5: case OP_SUB_END_6: case OP_SUB_END_7: case OP_SUB_END_8: case OP_SUB_END_9:
+        emit(VM_SAVE,2*((FXuchar)prog[0]-OP_SUB_END_0)+1,0);
+        prog+=1;
+        continue;
+      case OP_CHARS:
+      case OP_CHARS_CI:
+        op=((FXuchar)prog[0]==OP_CHARS)?VM_CHAR:VM_CHAR_CI;
+        no=GETARG(prog+1);
+        if(MAXINST<ninst+no) return false;
+        for(i=0; i<no; ++i){ emit(op,(FXuchar)prog[3+i],0); }
+        prog+=3+no;
+        continue;
+      case OP_STAR:
+      case OP_MIN_STAR:
+        greediness=((FXuchar)prog[0]==OP_STAR)?GREEDY:LAZY;
+        rep_min=0;
+        rep_max=ONEINDIG;
+        prog+=1;
+        goto rep;
+      case OP_PLUS:
+      case OP_MIN_PLUS:
+        greediness=((FXuchar)prog[0]==OP_PLUS)?GREEDY:LAZY;
+        rep_min=1;
+        rep_max=ONEINDIG;
+        prog+=1;
+        goto rep;
+      case OP_QUEST:
+      case OP_MIN_QUEST:
+        greediness=((FXuchar)prog[0]==OP_QUEST)?GREEDY:LAZY;
+        rep_min=0;
+        rep_max=1;
+        prog+=1;
+        goto rep;
+      case OP_REP:
+      case OP_MIN_REP:
+        greediness=((FXuchar)prog[0]==OP_REP)?GREEDY:LAZY;
+        rep_min=GETARG(prog+1);
+        rep_max=GETARG(prog+3);
+        prog+=5;
+        goto rep;
+      }
+
+    // Single character, or something we can't do
+    if(!single(prog,op,x)) return false;
+    emit(op,x,0);
+    prog+=onechar(prog);
+    continue;
+
+    // Simple repeats are unrolled; lazy ones prefer to stop, greedy ones to go on
+rep:if(!single(prog,op,x)) return false;
+    prog+=onechar(prog);
+    if(MAXINST<ninst+rep_min+((rep_max<ONEINDIG)?2*(rep_max-rep_min):3)) return false;
+    for(i=0; i<rep_min; ++i){
+      emit(op,x,0);
+      }
+    if(rep_max<ONEINDIG){
+      y=ninst+2*(rep_max-rep_min);
+      for(i=rep_min; i<rep_max; ++i){
+        if(greediness==GREEDY) emit(VM_SPLIT,ninst+1,y); else emit(VM_SPLIT,y,ninst+1);
+        emit(op,x,0);
+        }
+      }
+    else{
+      i=ninst;
+      if(greediness==GREEDY) emit(VM_SPLIT,i+1,i+3); else emit(VM_SPLIT,i+3,i+1);
+      emit(op,x,0);
+      emit(VM_JUMP,i,0);
+      }
+    }
+
+  // Number of instructions, and whether empty matches are rejected, in front
+  if(dst){
+    SETARG(dst,ninst);
+    SETARG(dst+2,notempty);
+    }
+  return ninst<=MAXINST;
+  }
+
+
+// Delete translator
+FXTranslate::~FXTranslate(){
+  freeElms(map);
+  }
+
+
+// Translate program into Pike VM instructions, if it can be done; else leave empty
+static void translate(FXString& nfa,const FXString& code){
+  nfa.clear();
+  if(!code.empty()){
+    FXTranslate ts(code.text(),code.length());
+    if(ts.translate(nullptr) && nfa.length(ts.size())){
+      if(!ts.translate(nfa.text())) nfa.clear();
+      }
+    }
+  }
+
+/*******************************************************************************/
+
+// Threads of Pike VM
+struct FXThreads {
+  FXint         *dense;             // Instruction of each thread, in priority order
+  FXint         *sparse;            // Index into dense for each instruction
+  FXint         *caps;              // Capture slots of each thread
+  FXint          count;             // Number of threads
+  };
+
+
+// Pike VM, matching in time linear in the length of the subject string
+class FXPike {
+  const FXchar  *str_beg;           // Begin of string
+  const FXchar  *str_end;           // End of string
+  const FXchar  *inst;              // Instructions
+  const FXuchar *sets;              // Character sets
+  FXint         *sub_beg;           // Begin of substring i
+  FXint         *sub_end;           // End of substring i
+  FXint         *memory;            // Memory for the below
+  FXint         *stack;             // Stack of instructions to follow, and slots to restore
+  FXint         *slots;             // Capture slots while following instructions
+  FXint         *found;             // Capture slots of match found
+  FXThreads      threads[2];        // Current and next threads
+  FXint          npar;              // Number of capturing parentheses
+  FXint          nslots;            // Number of capture slots
+  FXint          ninst;             // Number of instructions
+  FXint          fresh;             // Added to instruction for threads yet to match a character
+  FXint          mode;              // Match mode
+public:
+
+  // Construct Pike VM for instructions nfa
+  FXPike(const FXchar* sbeg,const FXchar* send,FXint* b,FXint* e,FXint p,FXint m,const FXchar* nfa);
+
+  // Return true if memory for the threads could be allocated
+  FXbool ready() const { return memory!=nullptr; }
+
+  // Attempt to match at ptr
+  FXbool attempt(const FXchar* ptr);
+
+  // Search in string, from fm to to
+  FXint search(const FXchar* scan,FXint nscan,const FXchar* fm,const FXchar* to);
+
+  // Delete Pike VM
+ ~FXPike();
+
+private:
+
+  // Instruction parts
+  FXuchar op(FXint pc) const { return (FXuchar)inst[5*pc]; }
+  FXint argx(FXint pc) const { return GETARG(inst+5*pc+1); }
+  FXint argy(FXint pc) const { return GETARG(inst+5*pc+3); }
+
+  // Check zero-width assertion at pos
+  FXbool check(FXint op,FXint pos) const;
+
+  // Check if a match could start at pos
+  FXbool candidate(const FXchar* scan,FXint pos) const;
+
+  // Find first place in [pos,hi] where a match could start, or -1
+  FXint skip(const FXchar* scan,FXint pos,FXint hi) const;
+
+  // Add thread, and all those it leads to without consuming a character
+  void add(FXThreads& list,FXint pc,FXint pos,FXint off);
+  };
+
+
+// Construct Pike VM for instructions nfa
+FXPike::FXPike(const FXchar* sbeg,const FXchar* send,FXint* b,FXint* e,FXint p,FXint m,const FXchar* nfa):str_beg(sbeg),str_end(send),inst(nfa+4),sub_beg(b),sub_end(e),memory(nullptr),npar(p),mode(m){
+  ninst=GETARG(nfa);
+  fresh=GETARG(nfa+2)?ninst:0;
+  nslots=2*FXCLAMP(1,npar,NSUBEXP);
+  sets=(const FXuchar*)nfa+4+5*ninst;
+  stack=slots=found=nullptr;
+  threads[0].dense=threads[0].sparse=threads[0].caps=nullptr;
+  threads[1].dense=threads[1].sparse=threads[1].caps=nullptr;
+  threads[0].count=threads[1].count=0;
+  if(callocElms(memory,(2*ninst+2)+2*nslots+2*(ninst+fresh)*(2+nslots))){
+    stack=memory;
+    slots=stack+2*ninst+2;
+    found=slots+nslots;
+    threads[0].dense=found+nslots;
+    threads[0].sparse=threads[0].dense+ninst+fresh;
+    threads[0].caps=threads[0].sparse+ninst+fresh;
+    threads[1].dense=threads[0].caps+(ninst+fresh)*nslots;
+    threads[1].sparse=threads[1].dense+ninst+fresh;
+    threads[1].caps=threads[1].sparse+ninst+fresh;
+    }
+  for(FXint i=0; i<npar; ++i){ sub_beg[i]=sub_end[i]=-1; }
+  }
+
+
+// Check zero-width assertion at pos, as match() does
+FXbool FXPike::check(FXint op,FXint pos) const {
+  const FXchar* str=str_beg+pos;
+  switch(op){
+    case OP_NOT_EMPTY:
+      return pos!=slots[0];
+    case OP_STR_BEG:
+      return str==str_beg;
+    case OP_STR_END:
+      return str==str_end;
+    case OP_LINE_BEG:
+      return (str_beg<str) ? *(str-1)=='\n' : !(mode&FXRex::NotBol);
+    case OP_LINE_END:
+      return (str<str_end) ? *str=='\n' : !(mode&FXRex::NotEol);
+    case OP_WORD_BEG:
+      return str<str_end && Ascii::isWord(*str) && (str<=str_beg || !Ascii::isWord(*(str-1)));
+    case OP_WORD_END:
+      return str_beg<str && Ascii::isWord(*(str-1)) && (str_end<=str || !Ascii::isWord(*str));
+    case OP_WORD_BND:
+      return (str<str_end && Ascii::isWord(*str)) != (str_beg<str && Ascii::isWord(*(str-1)));
+    case OP_WORD_INT:
+      return str_beg<str && str<str_end && Ascii::isWord(*str) && Ascii::isWord(*(str-1));
+    }
+  return false;
+  }
+
+
+// Check if a match could start at pos, going by its first character
+FXbool FXPike::candidate(const FXchar* scan,FXint pos) const {
+  FXuchar ch;
+  if(str_beg+pos<str_end){
+    ch=str_beg[pos];
+    switch(scan[0]){
+      case SCAN_CHARS:
+        return ch==(FXuchar)scan[1];
+      case SCAN_CHARS_CI:
+        return (FXuchar)Ascii::toLower(ch)==(FXuchar)scan[1];
+      case SCAN_PAIR:
+        return ch==(FXuchar)scan[1] || ch==(FXuchar)scan[2];
+      case SCAN_SET:
+        return ISIN((const FXuchar*)scan+1,ch)!=0;
+      }
+    }
+  return false;
+  }
+
+
+// Find first place in [pos,hi] where a match could start, or -1
+FXint FXPike::skip(const FXchar* scan,FXint pos,FXint hi) const {
+  const FXuchar* s=(const FXuchar*)str_beg;
+  const FXuchar* e=s+FXMIN(hi+1,(FXint)(str_end-str_beg));
+  const FXuchar* p=s+pos;
+  if(p<e){
+    switch(scan[0]){
+      case SCAN_CHARS:
+        p=(const FXuchar*)memchr(p,(FXuchar)scan[1],e-p);
+        break;
+      case SCAN_CHARS_CI:
+        p=findpair(p,e,(FXuchar)scan[1],(FXuchar)Ascii::toUpper(scan[1]));
+        break;
+      case SCAN_PAIR:
+        p=findpair(p,e,(FXuchar)scan[1],(FXuchar)scan[2]);
+        break;
+      default:
+        while(p<e && !ISIN((const FXuchar*)scan+1,*p)) ++p;
+        if(p==e) p=nullptr;
+        break;
+      }
+    if(p) return (FXint)(p-s);
+    }
+  return -1;
+  }
+
+
+// Add thread at instruction pc to list, and follow jumps, splits, saves, and assertions
+// from there in order of priority, without consuming a character; each instruction is
+// added only once, by the thread with the highest priority.  Capture slots being set along
+// the way are in slots, and restored afterwards, so slots are unchanged when done.
+// When empty matches are rejected, threads which have not matched a character yet may
+// fail where others succeed, so they're kept apart, at instruction plus off.
+void FXPike::add(FXThreads& list,FXint pc,FXint pos,FXint off){
+  FXint sp=0,i,x;
+  stack[sp++]=pc;
+  while(0<sp){
+    pc=stack[--sp];
+    if(pc<0){                           // Restore slot
+      slots[-pc-1]=stack[--sp];
+      continue;
+      }
+    while(1){
+      i=list.sparse[pc+off];
+      if(i<list.count && list.dense[i]==pc+off) break;
+      list.sparse[pc+off]=list.count;
+      list.dense[list.count++]=pc+off;
+      switch(op(pc)){
+        case VM_JUMP:
+          pc=argx(pc);
+          continue;
+        case VM_SPLIT:
+          stack[sp++]=argy(pc);
+          pc=argx(pc);
+          continue;
+        case VM_SAVE:
+          x=argx(pc);
+          if(x<nslots){
+            stack[sp++]=slots[x];
+            stack[sp++]=-x-1;
+            slots[x]=pos;
+            }
+          pc++;
+          continue;
+        case VM_ASSERT:
+          if(!check(argx(pc),pos)) break;
+          pc++;
+          continue;
+        default:                        // Thread waits here for next character
+          copyElms(list.caps+(list.count-1)*nslots,slots,nslots);
+          break;
+        }
+      break;
+      }
+    }
+  }
+
+
+// Search for the same match the backtracker would find, starting in [fm,to], or [to,fm] when
+// going backward.  The threads are advanced through the string one character at a time.  Going
+// forward, a new thread is started at each place, with the lowest priority, until a match is
+// found; then lower priority threads are cut, and the rest run until none are left.  Going
+// backward, new threads have the highest priority instead, and are started up to the end of
+// the range; the last match found is the one starting closest to fm.
+FXint FXPike::search(const FXchar* scan,FXint nscan,const FXchar* fm,const FXchar* to){
+  FXThreads *cur=&threads[0];
+  FXThreads *nxt=&threads[1];
+  FXThreads *tmp;
+  FXint len=(FXint)(str_end-str_beg);
+  FXint lo=(FXint)(FXMIN(fm,to)-str_beg);
+  FXint hi=(FXint)(FXMAX(fm,to)-str_beg);
+  FXbool backward=(to<fm);
+  FXbool matched=false;
+  FXint pos,pc,i;
+  FXint *caps;
+  FXuchar ch;
+
+  cur->count=0;
+  for(pos=lo; ; ++pos){
+
+    // Start a new thread here
+    if(cur->count==0){
+      if((matched && !backward) || hi<pos) break;
+      if(nscan && (pos=skip(scan,pos,hi))<0) break;
+      fillElms(slots,-1,nslots);
+      add(*cur,0,pos,fresh);
+      }
+    else if(!backward && !matched && pos<=hi && (!nscan || candidate(scan,pos))){
+      fillElms(slots,-1,nslots);
+      add(*cur,0,pos,fresh);
+      }
+
+    // Going backward, threads started at the next place come first
+    nxt->count=0;
+    if(backward && pos<hi && (!nscan || candidate(scan,pos+1))){
+      fillElms(slots,-1,nslots);
+      add(*nxt,0,pos+1,fresh);
+      }
+
+    // Advance threads in order of priority
+    ch=(pos<len)?str_beg[pos]:0;
+    for(i=0; i<cur->count; ++i){
+      pc=cur->dense[i];
+      if(ninst<=pc) pc-=ninst;
+      caps=cur->caps+i*nslots;
+      switch(op(pc)){
+        case VM_MATCH:
+          copyElms(found,caps,nslots);
+          matched=true;
+          goto cut;
+        case VM_CHAR:
+          if(len<=pos || ch!=argx(pc)) continue;
+          break;
+        case VM_CHAR_CI:
+          if(len<=pos || (FXuchar)Ascii::toLower(ch)!=argx(pc)) continue;
+          break;
+        case VM_SET:
+          if(len<=pos || !ISIN(sets+32*argx(pc),ch)) continue;
+          break;
+        default:
+          continue;
+        }
+      copyElms(slots,caps,nslots);
+      add(*nxt,pc+1,pos+1,0);
+      }
+cut:tmp=cur;
+    cur=nxt;
+    nxt=tmp;
+    if(len<=pos) break;
+    }
+
+  // Report match
+  if(matched){
+    for(i=0; i<npar; ++i){
+      sub_beg[i]=found[2*i];
+      sub_end[i]=found[2*i+1];
+      }
+    return found[0];
+    }
+  return -1;
+  }
+
+
+// Attempt to match at ptr
+FXbool FXPike::attempt(const FXchar* ptr){
+  return 0<=search(nullptr,0,ptr,ptr);
+  }
+
+
+// Delete Pike VM
+FXPike::~FXPike(){
+  freeElms(memory);
+  }
+
 }
 
 /*******************************************************************************/
@@ -4999,7 +6078,7 @@ FXRex::FXRex(){
 
 
 // Copy regex object
-FXRex::FXRex(const FXRex& orig):code(orig.code){
+FXRex::FXRex(const FXRex& orig):code(orig.code),scan(orig.scan),nfa(orig.nfa){
   FXTRACE((TOPIC_CONSTRUCT,"FXRex::FXRex(FXRex)\n"));
   }
 
@@ -5064,6 +6143,12 @@ FXRex::Error FXRex::parse(const FXchar* pattern,FXint mode){
 
                 FXTRACE((TOPIC_DETAIL,"FXRex::parse: cs.compile size: %lu\n",cs.size()));
 
+                // Find out how to skip ahead when searching
+                prefilter(scan,code.text());
+
+                // Translate for linear-time matching, if possible
+                translate(nfa,code);
+
 #ifdef TOPIC_REXDUMP
                 if(getTraceTopic(TOPIC_REXDUMP)){ dump(adjustedpattern.text(),code.text(),code.text()+code.length()); }
 #endif
@@ -5089,8 +6174,21 @@ FXRex::Error FXRex::parse(const FXString& pattern,FXint mode){
 
 /*******************************************************************************/
 
-// Match pattern in string at position pos
+// Match pattern in string at position pos; when the backtracker gives up, or if asked,
+// use the Pike VM instead, unless the pattern can't be done that way; if the Pike VM
+// can't get its memory, fall back to the backtracker without a budget
 FXbool FXRex::amatch(const FXchar* string,FXint len,FXint pos,FXint mode,FXint* beg,FXint* end,FXint npar) const {
+  if(!nfa.empty() && !(mode&(Unicode|Backtrack))){
+    if(!(mode&Linear)){
+      FXExecute ms(string,string+len,beg,end,npar,mode);
+      FXbool result;
+      ms.limit(MINBUDGET+BUDGET*(FXival)len);
+      result=ms.attempt(code.text(),string+pos);
+      if(!ms.exceeded()) return result;
+      }
+    FXPike vm(string,string+len,beg,end,npar,mode,nfa.text());
+    if(vm.ready()) return vm.attempt(string+pos);
+    }
   FXExecute ms(string,string+len,beg,end,npar,mode);
   return ms.attempt(code.text(),string+pos);
   }
@@ -5098,23 +6196,35 @@ FXbool FXRex::amatch(const FXchar* string,FXint len,FXint pos,FXint mode,FXint*
 
 // Match pattern in string at position pos
 FXbool FXRex::amatch(const FXString& string,FXint pos,FXint mode,FXint* beg,FXint* end,FXint npar) const {
-  FXExecute ms(string.text(),string.text()+string.length(),beg,end,npar,mode);
-  return ms.attempt(code.text(),string.text()+pos);
+  return amatch(string.text(),string.length(),pos,mode,beg,end,npar);
   }
 
 /*******************************************************************************/
 
-// Search for pattern in string, starting at fm; return position or -1
+// Search for pattern in string, starting at fm; return position or -1.  When the
+// backtracker gives up, or if asked, use the Pike VM instead, unless the pattern
+// can't be done that way; if the Pike VM can't get its memory, fall back to the
+// backtracker without a budget
 FXint FXRex::search(const FXchar* string,FXint len,FXint fm,FXint to,FXint mode,FXint* beg,FXint* end,FXint npar) const {
+  if(!nfa.empty() && !(mode&(Unicode|Backtrack))){
+    if(!(mode&Linear)){
+      FXExecute ms(string,string+len,beg,end,npar,mode);
+      FXint result;
+      ms.limit(MINBUDGET+BUDGET*(FXival)len);
+      result=ms.search(code.text(),scan.text(),scan.length(),string+fm,string+to);
+      if(!ms.exceeded()) return result;
+      }
+    FXPike vm(string,string+len,beg,end,npar,mode,nfa.text());
+    if(vm.ready()) return vm.search(scan.text(),scan.length(),string+fm,string+to);
+    }
   FXExecute ms(string,string+len,beg,end,npar,mode);
-  return ms.search(code.text(),string+fm,string+to);
+  return ms.search(code.text(),scan.text(),scan.length(),string+fm,string+to);
   }
 
 
 // Search for pattern in string, starting at fm; return position or -1
 FXint FXRex::search(const FXString& string,FXint fm,FXint to,FXint mode,FXint* beg,FXint* end,FXint npar) const {
-  FXExecute ms(string.text(),string.text()+string.length(),beg,end,npar,mode);
-  return ms.search(code.text(),string.text()+fm,string.text()+to);
+  return search(string.text(),string.length(),fm,to,mode,beg,end,npar);
   }
 
 /*******************************************************************************/
@@ -5280,6 +6390,8 @@ FXString FXRex::escape(const FXString& str){
 // Assignment
 FXRex& FXRex::operator=(const FXRex& orig){
   code=orig.code;
+  scan=orig.scan;
+  nfa=orig.nfa;
   return *this;
   }
 
@@ -5306,6 +6418,8 @@ FXStream& operator<<(FXStream& store,const FXRex& s){
 // Load
 FXStream& operator>>(FXStream& store,FXRex& s){
   store >> s.code;
+  prefilter(s.scan,s.code.text());
+  translate(s.nfa,s.code);
   return store;
   }
 
@@ -5313,6 +6427,8 @@ FXStream& operator>>(FXStream& store,FXRex& s){
 // Clear program
 void FXRex::clear(){
   code.clear();
+  scan.clear();
+  nfa.clear();
   }
 
 
@@ -22,6 +22,8 @@
 #include "fxver.h"
 #include "fxdefs.h"
 #include "fxmath.h"
+#include "fxendian.h"
+#include "fxcpuid.h"
 #include "FXElement.h"
 #include "FXArray.h"
 #include "FXMetaClass.h"
@@ -41,8 +43,11 @@
     writing to full disk, running out of memory, and so on.
   - Single character insert/extract operators are virtual so subclasses can
     overload these specific cases for greater speed.
-  - Copy byte at a time because don't know about alignment of stream buffer;
-    unaligned accesses are disallowed on some RISC cpus.
+  - Copy single values byte at a time because don't know about alignment of
+    stream buffer; unaligned accesses are disallowed on some RISC cpus.
+  - Arrays are copied in bulk with memcpy() as far as the buffer allows, or when
+    byte swapping, by copySwapped(); this picks SSSE3 or AVX2 byte shuffles if the
+    processor has them, checked once at run time, and finishes with scalar swaps.
   - Buffer can not be written till after first call to writeBuffer().
   - Need to haul some memory stream stuff up (buffer mgmt).
   - Need to have load() and save() API's return number of elements ACTUALLY
@@ -360,10 +365,155 @@ FXStream& FXStream::operator<<(const FXdouble& v){
   }
 
 
+/**********************  Byte Swapping Array Kernels  **************************/
+
+// Vector kernels are compiled for their instruction set regardless of compiler
+// flags, and used only when the processor reports it supports them
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && defined(HAVE_IMMINTRIN_H)
+#define FXSTREAM_SWAP_KERNELS
+#endif
+
+
+// Swap n bytes of 2-byte elements
+static void copySwapped2(FXuchar* dst,const FXuchar* src,FXuval n){
+  FXushort w;
+  while(2<=n){
+    memcpy(&w,src,2);
+    w=swap16(w);
+    memcpy(dst,&w,2);
+    dst+=2;
+    src+=2;
+    n-=2;
+    }
+  }
+
+
+// Swap n bytes of 4-byte elements
+static void copySwapped4(FXuchar* dst,const FXuchar* src,FXuval n){
+  FXuint w;
+  while(4<=n){
+    memcpy(&w,src,4);
+    w=swap32(w);
+    memcpy(dst,&w,4);
+    dst+=4;
+    src+=4;
+    n-=4;
+    }
+  }
+
+
+// Swap n bytes of 8-byte elements
+static void copySwapped8(FXuchar* dst,const FXuchar* src,FXuval n){
+  FXulong w;
+  while(8<=n){
+    memcpy(&w,src,8);
+    w=swap64(w);
+    memcpy(dst,&w,8);
+    dst+=8;
+    src+=8;
+    n-=8;
+    }
+  }
+
+
+#if defined(FXSTREAM_SWAP_KERNELS)
+
+// Shuffle masks reversing bytes of 2-, 4-, and 8-byte elements
+static const FXuchar swapmask[3][16] __attribute__((aligned(16)))={
+  { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8,11,10,13,12,15,14},
+  { 3, 2, 1, 0, 7, 6, 5, 4,11,10, 9, 8,15,14,13,12},
+  { 7, 6, 5, 4, 3, 2, 1, 0,15,14,13,12,11,10, 9, 8}
+  };
+
+
+// Swap multiple of 16 bytes using SSSE3 byte shuffle
+__attribute__((target("ssse3")))
+static void copySwappedSSSE3(FXuchar* dst,const FXuchar* src,FXuval n,const FXuchar* msk){
+  __m128i mask=_mm_load_si128((const __m128i*)msk);
+  while(64<=n){
+    __m128i a=_mm_loadu_si128((const __m128i*)(src+0));
+    __m128i b=_mm_loadu_si128((const __m128i*)(src+16));
+    __m128i c=_mm_loadu_si128((const __m128i*)(src+32));
+    __m128i d=_mm_loadu_si128((const __m128i*)(src+48));
+    _mm_storeu_si128((__m128i*)(dst+0),_mm_shuffle_epi8(a,mask));
+    _mm_storeu_si128((__m128i*)(dst+16),_mm_shuffle_epi8(b,mask));
+    _mm_storeu_si128((__m128i*)(dst+32),_mm_shuffle_epi8(c,mask));
+    _mm_storeu_si128((__m128i*)(dst+48),_mm_shuffle_epi8(d,mask));
+    dst+=64;
+    src+=64;
+    n-=64;
+    }
+  while(16<=n){
+    _mm_storeu_si128((__m128i*)dst,_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src),mask));
+    dst+=16;
+    src+=16;
+    n-=16;
+    }
+  }
+
+
+// Swap multiple of 32 bytes using AVX2 byte shuffle
+__attribute__((target("avx2")))
+static void copySwappedAVX2(FXuchar* dst,const FXuchar* src,FXuval n,const FXuchar* msk){
+  __m256i mask=_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)msk));
+  while(128<=n){
+    __m256i a=_mm256_loadu_si256((const __m256i*)(src+0));
+    __m256i b=_mm256_loadu_si256((const __m256i*)(src+32));
+    __m256i c=_mm256_loadu_si256((const __m256i*)(src+64));
+    __m256i d=_mm256_loadu_si256((const __m256i*)(src+96));
+    _mm256_storeu_si256((__m256i*)(dst+0),_mm256_shuffle_epi8(a,mask));
+    _mm256_storeu_si256((__m256i*)(dst+32),_mm256_shuffle_epi8(b,mask));
+    _mm256_storeu_si256((__m256i*)(dst+64),_mm256_shuffle_epi8(c,mask));
+    _mm256_storeu_si256((__m256i*)(dst+96),_mm256_shuffle_epi8(d,mask));
+    dst+=128;
+    src+=128;
+    n-=128;
+    }
+  while(32<=n){
+    _mm256_storeu_si256((__m256i*)dst,_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)src),mask));
+    dst+=32;
+    src+=32;
+    n-=32;
+    }
+  }
+
+#endif
+
+
+// Copy n bytes of elements of given size from src to dst, reversing
+// the bytes of each element; n is a multiple of the element size
+static void copySwapped(FXuchar* dst,const FXuchar* src,FXuval n,FXuint size){
+#if defined(FXSTREAM_SWAP_KERNELS)
+  static const FXuint features=fxCPUFeatures();
+  FXuval m;
+  if(features&CPU_HAS_AVX2){
+    m=n&~((FXuval)31);
+    copySwappedAVX2(dst,src,m,swapmask[size>>2]);
+    dst+=m;
+    src+=m;
+    n-=m;
+    }
+  if(features&CPU_HAS_SSSE3){
+    m=n&~((FXuval)15);
+    copySwappedSSSE3(dst,src,m,swapmask[size>>2]);
+    dst+=m;
+    src+=m;
+    n-=m;
+    }
+#endif
+  switch(size){
+    case 2: copySwapped2(dst,src,n); break;
+    case 4: copySwapped4(dst,src,n); break;
+    case 8: copySwapped8(dst,src,n); break;
+    }
+  }
+
+
 /************************  Save Blocks of Basic Types  *************************/
 
 // Write array of bytes
 FXStream& FXStream::save(const FXuchar* p,FXuval n){
+  FXuval m;
   if(code==FXStreamOK){
     FXASSERT(begptr<=rdptr);
     FXASSERT(rdptr<=wrptr);
@@ -371,12 +521,12 @@ FXStream& FXStream::save(const FXuchar* p,FXuval n){
     while(0<n){
       if(wrptr+n>endptr && writeBuffer((wrptr-endptr)+n)<1){ code=FXStreamFull; return *this; }
       FXASSERT(wrptr<endptr);
-      do{
-        *wrptr++=*p++;
-        pos++;
-        n--;
-        }
-      while(0<n && wrptr<endptr);
+      m=FXMIN(n,(FXuval)(endptr-wrptr));
+      memcpy(wrptr,p,m);
+      wrptr+=m;
+      pos+=m;
+      p+=m;
+      n-=m;
       }
     }
   return *this;
@@ -407,40 +557,26 @@ FXStream& FXStream::save(const FXbool* p,FXuval n){
 // Write array of shorts
 FXStream& FXStream::save(const FXushort* p,FXuval n){
   const FXuchar *q=(const FXuchar*)p;
+  FXuval m;
   if(code==FXStreamOK){
     n<<=1;
     FXASSERT(begptr<=rdptr);
     FXASSERT(rdptr<=wrptr);
     FXASSERT(wrptr<=endptr);
-    if(swap){
-      while(0<n){
-        if(wrptr+n>endptr && writeBuffer((wrptr-endptr)+n)<2){ code=FXStreamFull; return *this; }
-        FXASSERT(wrptr+2<=endptr);
-        do{
-          wrptr[0]=q[1];
-          wrptr[1]=q[0];
-          wrptr+=2;
-          pos+=2;
-          q+=2;
-          n-=2;
-          }
-        while(0<n && wrptr+2<=endptr);
+    while(0<n){
+      if(wrptr+n>endptr && writeBuffer((wrptr-endptr)+n)<2){ code=FXStreamFull; return *this; }
+      FXASSERT(wrptr+2<=endptr);
+      m=FXMIN(n,(FXuval)(endptr-wrptr))&~((FXuval)1);
+      if(swap){
+        copySwapped(wrptr,q,m,2);
         }
-      }
-    else{
-      while(0<n){
-        if(wrptr+n>endptr && writeBuffer((wrptr-endptr)+n)<2){ code=FXStreamFull; return *this; }
-        FXASSERT(wrptr+2<=endptr);
-        do{
-          wrptr[0]=q[0];
-          wrptr[1]=q[1];
-          wrptr+=2;
-          pos+=2;
-          q+=2;
-          n-=2;
-          }
-        while(0<n && wrptr+2<=endptr);
+      else{
+        memcpy(wrptr,q,m);
         }
+      wrptr+=m;
+      pos+=m;
+      q+=m;
+      n-=m;
       }
     }
   return *this;
@@ -450,44 +586,26 @@ FXStream& FXStream::save(const FXushort* p,FXuval n){
 // Write array of ints
 FXStream& FXStream::save(const FXuint* p,FXuval n){
   const FXuchar *q=(const FXuchar*)p;
+  FXuval m;
   if(code==FXStreamOK){
     n<<=2;
     FXASSERT(begptr<=rdptr);
     FXASSERT(rdptr<=wrptr);
     FXASSERT(wrptr<=endptr);
-    if(swap){
-      while(0<n){
-        if(wrptr+n>endptr && writeBuffer((wrptr-endptr)+n)<4){ code=FXStreamFull; return *this; }
-        FXASSERT(wrptr+4<=endptr);
-        do{
-          wrptr[0]=q[3];
-          wrptr[1]=q[2];
-          wrptr[2]=q[1];
-          wrptr[3]=q[0];
-          wrptr+=4;
-          pos+=4;
-          q+=4;
-          n-=4;
-          }
-        while(0<n && wrptr+4<=endptr);
+    while(0<n){
+      if(wrptr+n>endptr && writeBuffer((wrptr-endptr)+n)<4){ code=FXStreamFull; return *this; }
+      FXASSERT(wrptr+4<=endptr);
+      m=FXMIN(n,(FXuval)(endptr-wrptr))&~((FXuval)3);
+      if(swap){
+        copySwapped(wrptr,q,m,4);
         }
-      }
-    else{
-      while(0<n){
-        if(wrptr+n>endptr && writeBuffer((wrptr-endptr)+n)<4){ code=FXStreamFull; return *this; }
-        FXASSERT(wrptr+4<=endptr);
-        do{
-          wrptr[0]=q[0];
-          wrptr[1]=q[1];
-          wrptr[2]=q[2];
-          wrptr[3]=q[3];
-          wrptr+=4;
-          pos+=4;
-          q+=4;
-          n-=4;
-          }
-        while(0<n && wrptr+4<=endptr);
+      else{
+        memcpy(wrptr,q,m);
         }
+      wrptr+=m;
+      pos+=m;
+      q+=m;
+      n-=m;
       }
     }
   return *this;
@@ -497,52 +615,26 @@ FXStream& FXStream::save(const FXuint* p,FXuval n){
 // Write array of doubles
 FXStream& FXStream::save(const FXdouble* p,FXuval n){
   const FXuchar *q=(const FXuchar*)p;
+  FXuval m;
   if(code==FXStreamOK){
     n<<=3;
     FXASSERT(begptr<=rdptr);
     FXASSERT(rdptr<=wrptr);
     FXASSERT(wrptr<=endptr);
-    if(swap){
-      while(0<n){
-        if(wrptr+n>endptr && writeBuffer((wrptr-endptr)+n)<8){ code=FXStreamFull; return *this; }
-        FXASSERT(wrptr+8<=endptr);
-        do{
-          wrptr[0]=q[7];
-          wrptr[1]=q[6];
-          wrptr[2]=q[5];
-          wrptr[3]=q[4];
-          wrptr[4]=q[3];
-          wrptr[5]=q[2];
-          wrptr[6]=q[1];
-          wrptr[7]=q[0];
-          wrptr+=8;
-          pos+=8;
-          q+=8;
-          n-=8;
-          }
-        while(0<n && wrptr+8<=endptr);
+    while(0<n){
+      if(wrptr+n>endptr && writeBuffer((wrptr-endptr)+n)<8){ code=FXStreamFull; return *this; }
+      FXASSERT(wrptr+8<=endptr);
+      m=FXMIN(n,(FXuval)(endptr-wrptr))&~((FXuval)7);
+      if(swap){
+        copySwapped(wrptr,q,m,8);
         }
-      }
-    else{
-      while(0<n){
-        if(wrptr+n>endptr && writeBuffer((wrptr-endptr)+n)<8){ code=FXStreamFull; return *this; }
-        FXASSERT(wrptr+8<=endptr);
-        do{
-          wrptr[0]=q[0];
-          wrptr[1]=q[1];
-          wrptr[2]=q[2];
-          wrptr[3]=q[3];
-          wrptr[4]=q[4];
-          wrptr[5]=q[5];
-          wrptr[6]=q[6];
-          wrptr[7]=q[7];
-          wrptr+=8;
-          pos+=8;
-          q+=8;
-          n-=8;
-          }
-        while(0<n && wrptr+8<=endptr);
+      else{
+        memcpy(wrptr,q,m);
         }
+      wrptr+=m;
+      pos+=m;
+      q+=m;
+      n-=m;
       }
     }
   return *this;
@@ -670,6 +762,7 @@ FXStream& FXStream::operator>>(FXdouble& v){
 
 // Read array of bytes
 FXStream& FXStream::load(FXuchar* p,FXuval n){
+  FXuval m;
   if(code==FXStreamOK){
     FXASSERT(begptr<=rdptr);
     FXASSERT(rdptr<=wrptr);
@@ -677,12 +770,12 @@ FXStream& FXStream::load(FXuchar* p,FXuval n){
     while(0<n){
       if(rdptr+n>wrptr && readBuffer((rdptr-wrptr)+n)<1){ code=FXStreamEnd; return *this; }
       FXASSERT(rdptr<wrptr);
-      do{
-        *p++=*rdptr++;
-        pos++;
-        n--;
-        }
-      while(0<n && rdptr<wrptr);
+      m=FXMIN(n,(FXuval)(wrptr-rdptr));
+      memcpy(p,rdptr,m);
+      rdptr+=m;
+      pos+=m;
+      p+=m;
+      n-=m;
       }
     }
   return *this;
@@ -713,40 +806,26 @@ FXStream& FXStream::load(FXbool* p,FXuval n){
 // Read array of shorts
 FXStream& FXStream::load(FXushort* p,FXuval n){
   FXuchar *q=(FXuchar*)p;
+  FXuval m;
   if(code==FXStreamOK){
     n<<=1;
     FXASSERT(begptr<=rdptr);
     FXASSERT(rdptr<=wrptr);
     FXASSERT(wrptr<=endptr);
-    if(swap){
-      while(0<n){
-        if(rdptr+n>wrptr && readBuffer((rdptr-wrptr)+n)<2){ code=FXStreamEnd; return *this; }
-        FXASSERT(rdptr+2<=wrptr);
-        do{
-          q[1]=rdptr[0];
-          q[0]=rdptr[1];
-          rdptr+=2;
-          pos+=2;
-          q+=2;
-          n-=2;
-          }
-        while(0<n && rdptr+2<=wrptr);
+    while(0<n){
+      if(rdptr+n>wrptr && readBuffer((rdptr-wrptr)+n)<2){ code=FXStreamEnd; return *this; }
+      FXASSERT(rdptr+2<=wrptr);
+      m=FXMIN(n,(FXuval)(wrptr-rdptr))&~((FXuval)1);
+      if(swap){
+        copySwapped(q,rdptr,m,2);
         }
-      }
-    else{
-      while(0<n){
-        if(rdptr+n>wrptr && readBuffer((rdptr-wrptr)+n)<2){ code=FXStreamEnd; return *this; }
-        FXASSERT(rdptr+2<=wrptr);
-        do{
-          q[0]=rdptr[0];
-          q[1]=rdptr[1];
-          rdptr+=2;
-          pos+=2;
-          q+=2;
-          n-=2;
-          }
-        while(0<n && rdptr+2<=wrptr);
+      else{
+        memcpy(q,rdptr,m);
         }
+      rdptr+=m;
+      pos+=m;
+      q+=m;
+      n-=m;
       }
     }
   return *this;
@@ -756,44 +835,26 @@ FXStream& FXStream::load(FXushort* p,FXuval n){
 // Read array of ints
 FXStream& FXStream::load(FXuint* p,FXuval n){
   FXuchar *q=(FXuchar*)p;
+  FXuval m;
   if(code==FXStreamOK){
     n<<=2;
     FXASSERT(begptr<=rdptr);
     FXASSERT(rdptr<=wrptr);
     FXASSERT(wrptr<=endptr);
-    if(swap){
-      while(0<n){
-        if(rdptr+n>wrptr && readBuffer((rdptr-wrptr)+n)<4){ code=FXStreamEnd; return *this; }
-        FXASSERT(rdptr+4<=wrptr);
-        do{
-          q[3]=rdptr[0];
-          q[2]=rdptr[1];
-          q[1]=rdptr[2];
-          q[0]=rdptr[3];
-          rdptr+=4;
-          pos+=4;
-          q+=4;
-          n-=4;
-          }
-        while(0<n && rdptr+4<=wrptr);
+    while(0<n){
+      if(rdptr+n>wrptr && readBuffer((rdptr-wrptr)+n)<4){ code=FXStreamEnd; return *this; }
+      FXASSERT(rdptr+4<=wrptr);
+      m=FXMIN(n,(FXuval)(wrptr-rdptr))&~((FXuval)3);
+      if(swap){
+        copySwapped(q,rdptr,m,4);
         }
-      }
-    else{
-      while(0<n){
-        if(rdptr+n>wrptr && readBuffer((rdptr-wrptr)+n)<4){ code=FXStreamEnd; return *this; }
-        FXASSERT(rdptr+4<=wrptr);
-        do{
-          q[0]=rdptr[0];
-          q[1]=rdptr[1];
-          q[2]=rdptr[2];
-          q[3]=rdptr[3];
-          rdptr+=4;
-          pos+=4;
-          q+=4;
-          n-=4;
-          }
-        while(0<n && rdptr+4<=wrptr);
+      else{
+        memcpy(q,rdptr,m);
         }
+      rdptr+=m;
+      pos+=m;
+      q+=m;
+      n-=m;
       }
     }
   return *this;
@@ -803,52 +864,26 @@ FXStream& FXStream::load(FXuint* p,FXuval n){
 // Read array of doubles
 FXStream& FXStream::load(FXdouble* p,FXuval n){
   FXuchar *q=(FXuchar*)p;
+  FXuval m;
   if(code==FXStreamOK){
     n<<=3;
     FXASSERT(begptr<=rdptr);
     FXASSERT(rdptr<=wrptr);
     FXASSERT(wrptr<=endptr);
-    if(swap){
-      while(0<n){
-        if(rdptr+n>wrptr && readBuffer((rdptr-wrptr)+n)<8){ code=FXStreamEnd; return *this; }
-        FXASSERT(rdptr+4<=wrptr);
-        do{
-          q[7]=rdptr[0];
-          q[6]=rdptr[1];
-          q[5]=rdptr[2];
-          q[4]=rdptr[3];
-          q[3]=rdptr[4];
-          q[2]=rdptr[5];
-          q[1]=rdptr[6];
-          q[0]=rdptr[7];
-          rdptr+=8;
-          pos+=8;
-          q+=8;
-          n-=8;
-          }
-        while(0<n && rdptr+8<=wrptr);
+    while(0<n){
+      if(rdptr+n>wrptr && readBuffer((rdptr-wrptr)+n)<8){ code=FXStreamEnd; return *this; }
+      FXASSERT(rdptr+8<=wrptr);
+      m=FXMIN(n,(FXuval)(wrptr-rdptr))&~((FXuval)7);
+      if(swap){
+        copySwapped(q,rdptr,m,8);
         }
-      }
-    else{
-      while(0<n){
-        if(rdptr+n>wrptr && readBuffer((rdptr-wrptr)+n)<8){ code=FXStreamEnd; return *this; }
-        FXASSERT(rdptr+4<=wrptr);
-        do{
-          q[0]=rdptr[0];
-          q[1]=rdptr[1];
-          q[2]=rdptr[2];
-          q[3]=rdptr[3];
-          q[4]=rdptr[4];
-          q[5]=rdptr[5];
-          q[6]=rdptr[6];
-          q[7]=rdptr[7];
-          rdptr+=8;
-          pos+=8;
-          q+=8;
-          n-=8;
-          }
-        while(0<n && rdptr+8<=wrptr);
+      else{
+        memcpy(q,rdptr,m);
         }
+      rdptr+=m;
+      pos+=m;
+      q+=m;
+      n-=m;
       }
     }
   return *this;
@@ -27,6 +27,7 @@
 #include "FXArray.h"
 #include "FXPtrList.h"
 #include "FXAtomic.h"
+#include "FXSpinLock.h"
 #include "FXSemaphore.h"
 #include "FXCompletion.h"
 #include "FXRunnable.h"
@@ -52,20 +53,31 @@
     queue is empty will the calling thread drop out of the FXThreadPoll's processing loop to
     actually block for the completion semaphore.
 
-  - Possible improvements:
-
-      o For FXParallel, we could have a special flavor of FXTaskGroup::Task that does not wrap
-        a FXRunnable but has a more streamlined implementation, thus avoiding allocs and frees.
-
-      o We would like some kind of early termination capability.  For instance, in a parallel
-        search algorithm we would like to stop (or never even start) tasks when one of them is
-        successful.
-
-      o Another case of early termination would be the throwing of exceptions from one of the
-        tasks.
-
-      o For now, we don't have a good mechanism for this; we do want to keep this light-weight
-        since FXTaskGroup is created on the stack in FXParallel.
+  - FXTaskNode adds dependencies between tasks.  Each task node counts its pending
+    predecessors, plus one extra count which is dropped when the node is scheduled; so
+    a node can not start before it is scheduled, no matter how quickly its predecessors
+    finish.  Whichever thread drops the count to zero enters the node into the thread
+    pool's queue; no thread ever blocks waiting for a dependency.
+
+  - When a task node completes, it marks itself done while holding the spinlock of
+    its successor list; a later call to after() will find the predecessor already done
+    and won't count it.  Thereafter the successor list won't change, and successors are
+    released without holding the lock.
+
+  - The group's completion counter is incremented when a task node is scheduled, and
+    decremented after the task node has released its successors; thus, waiting for the
+    group also waits for the task graph.  Since successors are scheduled before the
+    count is decremented, the count can not drop to zero while parts of the task graph
+    are still pending.
+
+  - Cancellation is cooperative: cancelled tasks or task nodes that haven't started yet
+    are skipped, but they still complete normally so the completion count stays correct.
+    Cancellation of a task node carries over to its successors; so does an exception
+    thrown by a task node's runnable.
+
+  - A task node which the thread pool refuses to queue, for example because the pool
+    was stopped, is treated as cancelled: it is finished on the spot, cancelling its
+    successors in turn, so that waiting for the group won't hang.
 */
 
 using namespace FX;
@@ -76,13 +88,13 @@ namespace FX {
 
 
 // Create new group of tasks
-FXTaskGroup::FXTaskGroup():threadpool(FXThreadPool::instance()){
+FXTaskGroup::FXTaskGroup():threadpool(FXThreadPool::instance()),cancelled(false){
   if(!threadpool){ fxerror("FXTaskGroup::FXTaskGroup: No thread pool was set."); }
   }
 
 
 // Create new group of tasks
-FXTaskGroup::FXTaskGroup(FXThreadPool* p):threadpool(p){
+FXTaskGroup::FXTaskGroup(FXThreadPool* p):threadpool(p),cancelled(false){
   if(!threadpool){ fxerror("FXTaskGroup::FXTaskGroup: No thread pool was set."); }
   }
 
@@ -99,25 +111,17 @@ FXTaskGroup::Task::~Task(){
   }
 
 
-// Process task group task
+// Process task group task, unless group was cancelled
 FXint FXTaskGroup::Task::run(){
-  try{
-    runnable->run();
-    }
-  catch(...){
-    delete this;
-    throw;
-    }
-/*
-  if(!group->isCancelled()){
+  if(!taskgroup->isCancelled()){
     try{
       runnable->run();
       }
-    catch(const FXResourceException&){         // FIXME perhaps dedicated FXException type to cancel the group, and another FXException type to cancel everything recursively...
-      group->setCancelled(true);
+    catch(...){
+      delete this;
+      throw;
       }
     }
-*/
   delete this;
   return 0;
   }
@@ -134,6 +138,19 @@ FXbool FXTaskGroup::execute(FXRunnable* task){
   }
 
 
+// Schedule task node; start it if it has no pending predecessors
+FXbool FXTaskGroup::schedule(FXTaskNode* node){
+  if(__likely(node && node->state==0)){
+    node->taskgroup=this;
+    node->state=1;
+    completion.increment();
+    node->release();
+    return true;
+    }
+  return false;
+  }
+
+
 // Start task in this task group, then wait till done
 FXbool FXTaskGroup::executeAndWait(FXRunnable* task){
   if(__likely(task)){
@@ -159,4 +176,87 @@ FXTaskGroup::~FXTaskGroup(){
   wait();
   }
 
+/*******************************************************************************/
+
+// Create task node
+FXTaskNode::FXTaskNode(FXRunnable* task):taskgroup(nullptr),runnable(task),pending(1),state(0),cancelled(false){
+  }
+
+
+// Add dependency on predecessor
+FXbool FXTaskNode::after(FXTaskNode* pred){
+  if(__likely(pred && pred!=this && state==0)){
+    pred->spinlock.lock();
+    if(pred->state==2){
+      if(pred->cancelled) cancelled=true;
+      }
+    else{
+      pred->successors.append(this);
+      atomicAdd(&pending,1);
+      }
+    pred->spinlock.unlock();
+    return true;
+    }
+  return false;
+  }
+
+
+// Add dependencies on all predecessors
+FXbool FXTaskNode::after(FXTaskNode* const* preds,FXuint n){
+  for(FXuint i=0; i<n; ++i){
+    if(!after(preds[i])) return false;
+    }
+  return true;
+  }
+
+
+// Drop a pending count; enter task node into queue when none are left.
+// If the thread pool won't take it, the node is cancelled and finished
+// right away, so its successors and the group are still released.
+void FXTaskNode::release(){
+  if(atomicAdd(&pending,-1)==1){
+    if(!taskgroup->threadpool->execute(this)){
+      cancelled=true;
+      finish();
+      }
+    }
+  }
+
+
+// Mark task node as done, and release its successors
+void FXTaskNode::finish(){
+  FXTaskGroup* group=taskgroup;
+  spinlock.lock();
+  state=2;
+  spinlock.unlock();
+  for(FXint i=0; i<successors.no(); ++i){
+    if(cancelled) successors[i]->cancelled=true;
+    successors[i]->release();
+    }
+  group->completion.decrement();
+  }
+
+
+// Run task node, unless cancelled
+FXint FXTaskNode::run(){
+  if(runnable && !cancelled && !taskgroup->isCancelled()){
+    try{
+      runnable->run();
+      }
+    catch(...){
+      cancelled=true;
+      finish();
+      throw;
+      }
+    }
+  finish();
+  return 0;
+  }
+
+
+// Destroy task node
+FXTaskNode::~FXTaskNode(){
+  runnable=(FXRunnable*)-1L;
+  }
+
 }
@@ -154,6 +154,22 @@
   - Possible (minor) improvement to wrap(): don't break after space unless
     at least non-space was seen before that space.  This will cause a line
     to have at least some non-blank characters on it.
+
+  - Line index: the text is divided into blocks of whole lines, of about LINEBLOCK
+    bytes each; each block records its number of bytes, newlines, and rows, and a
+    Fenwick tree over the blocks yields the position, line, and row at the start of
+    any block in O(log n).  Thus, the line or row containing a position, or the
+    position of a line or row, is found by a tree descent followed by a scan of no
+    more than a block.
+    Since blocks start at line starts, wrapping within a block does not depend on
+    the text before it, and the block's row count is simply the number of rows of
+    its lines.
+  - Edits in replace() adjust the block(s) containing the change; when the change
+    spans blocks, or makes a block too big, the affected blocks are rebuilt and the
+    tree is summed again.  The row counts are remeasured in recompute(); while
+    FLAG_RECALC is set, they may be stale, and rows are counted by scanning.
+  - Line and row navigation scan the buffer as before when the answer is nearby,
+    and switch to the index once the scan exceeds LINEBLOCK bytes.
 */
 
 #define TOPIC_KEYBOARD  1009
@@ -164,6 +180,7 @@
 #define MAXSIZE         4000            // Minimum gap size
 #define NVISROWS        20              // Initial visible rows
 #define MAXTABCOLUMNS   32              // Maximum tab column setting
+#define LINEBLOCK       4096            // Target size of line blocks
 
 #define TEXT_MASK       (TEXT_FIXEDWRAP|TEXT_WORDWRAP|TEXT_OVERSTRIKE|TEXT_READONLY|TEXT_NO_TABS|TEXT_AUTOINDENT|TEXT_SHOWACTIVE|TEXT_SHOWMATCH)
 
@@ -396,6 +413,9 @@ FXText::FXText(){
   graby=0;
   mode=MOUSE_NONE;
   modified=false;
+  callocElms(blocks,1);
+  callocElms(blocksums,2);
+  nblocks=1;
   }
 
 
@@ -467,6 +487,9 @@ FXText::FXText(FXComposite *p,FXObject* tgt,FXSelector sel,FXuint opts,FXint x,F
   graby=0;
   mode=MOUSE_NONE;
   modified=false;
+  callocElms(blocks,1);
+  callocElms(blocksums,2);
+  nblocks=1;
   }
 
 
@@ -706,6 +729,223 @@ FXint FXText::inc(FXint pos) const {
 
 /*******************************************************************************/
 
+// Block of whole lines
+struct FXText::LineBlock {
+  FXint bytes;                          // Number of bytes
+  FXint lines;                          // Number of newlines
+  FXint rows;                           // Number of rows
+  };
+
+
+// Find first newline at or after pos, or return end if there is none;
+// the parts of the range below and above the gap are searched separately
+FXint FXText::findNewline(FXint pos,FXint end) const {
+  const FXchar *ptr,*hit;
+  FXint e;
+  FXASSERT(0<=pos && pos<=end && end<=length);
+  while(pos<end){
+    e=(pos<gapbeg)?Math::imin(gapbeg,end):end;
+    ptr=&buffer[(((~pos+gapbeg)>>31)&gaplen)+pos];
+    if((hit=(const FXchar*)memchr(ptr,'\n',e-pos))!=nullptr) return pos+(FXint)(hit-ptr);
+    pos=e;
+    }
+  return end;
+  }
+
+
+// Count newlines in range
+FXint FXText::countNewlines(FXint start,FXint end) const {
+  FXint result=0;
+  FXASSERT(0<=start && start<=end && end<=length);
+  while((start=findNewline(start,end))<end){
+    result++;
+    start++;
+    }
+  return result;
+  }
+
+
+// Find the block where the running sum of field reaches value, by descending the
+// Fenwick tree; also return the sums over the blocks before it.  Returns nblocks
+// if the sum over all blocks is less than value.
+FXint FXText::findBlock(FXint LineBlock::* field,FXint value,LineBlock& before) const {
+  FXint bit=1,b=0;
+  before.bytes=before.lines=before.rows=0;
+  while(bit<=nblocks) bit<<=1;
+  while(bit>>=1){
+    if(b+bit<=nblocks && before.*field+blocksums[b+bit].*field<value){
+      b+=bit;
+      before.bytes+=blocksums[b].bytes;
+      before.lines+=blocksums[b].lines;
+      before.rows+=blocksums[b].rows;
+      }
+    }
+  return b;
+  }
+
+
+// Find block containing position, and sums over the blocks before it;
+// the end of the text is in the last block
+FXint FXText::blockOfPos(FXint pos,LineBlock& before) const {
+  FXint b=findBlock(&LineBlock::bytes,pos+1,before);
+  FXASSERT(0<nblocks);
+  if(b>=nblocks){
+    b=nblocks-1;
+    before.bytes-=blocks[b].bytes;
+    before.lines-=blocks[b].lines;
+    before.rows-=blocks[b].rows;
+    }
+  return b;
+  }
+
+
+// Return number of newlines before position, i.e. the line containing it
+FXint FXText::linesBefore(FXint pos) const {
+  LineBlock before;
+  FXASSERT(0<=pos && pos<=length);
+  blockOfPos(pos,before);
+  return before.lines+countNewlines(before.bytes,pos);
+  }
+
+
+// Return start of line, i.e. the position just past the given number of
+// newlines, or the end of the text if there are not that many
+FXint FXText::posOfLine(FXint line) const {
+  LineBlock before;
+  FXint pos;
+  if(line<=0) return 0;
+  if(findBlock(&LineBlock::lines,line,before)>=nblocks) return length;
+  pos=before.bytes;
+  while(before.lines<line){
+    pos=findNewline(pos,length)+1;
+    before.lines++;
+    }
+  FXASSERT(0<=pos && pos<=length);
+  return pos;
+  }
+
+
+// Return number of rows before position, which should be on a row start;
+// the row counts of the blocks must be up to date
+FXint FXText::rowsBefore(FXint pos) const {
+  LineBlock before;
+  FXint start;
+  FXASSERT(0<=pos && pos<=length);
+  FXASSERT(!(flags&FLAG_RECALC));
+  blockOfPos(pos,before);
+  start=before.bytes;
+  while(start<pos){
+    start=wrap(start);
+    before.rows++;
+    }
+  return before.rows;
+  }
+
+
+// Return start of row, or the end of the text if there are not that many
+// rows; the row counts of the blocks must be up to date
+FXint FXText::posOfRow(FXint row) const {
+  LineBlock before;
+  FXint pos;
+  FXASSERT(!(flags&FLAG_RECALC));
+  if(row<=0) return 0;
+  if(findBlock(&LineBlock::rows,row,before)>=nblocks) return length;
+  pos=before.bytes;
+  while(before.rows<row && pos<length){
+    pos=wrap(pos);
+    before.rows++;
+    }
+  FXASSERT(0<=pos && pos<=length);
+  return pos;
+  }
+
+
+// Sum blocks into Fenwick tree
+void FXText::sumBlocks(){
+  FXint b,p;
+  for(b=1; b<=nblocks; ++b){
+    blocksums[b]=blocks[b-1];
+    }
+  for(b=1; b<=nblocks; ++b){
+    if((p=b+(b&-b))<=nblocks){
+      blocksums[p].bytes+=blocksums[b].bytes;
+      blocksums[p].lines+=blocksums[b].lines;
+      blocksums[p].rows+=blocksums[b].rows;
+      }
+    }
+  }
+
+
+// Replace n blocks starting at block b with new blocks covering the text
+// from start to end, which should be on line starts.  Blocks end after the
+// first newline past LINEBLOCK bytes, so very long lines make big blocks.
+void FXText::makeBlocks(FXint b,FXint n,FXint start,FXint end){
+  FXbool measure=(options&TEXT_WORDWRAP) && !(flags&FLAG_RECALC);
+  FXArray<LineBlock> made;
+  LineBlock block;
+  FXint p,m,w,h;
+  FXASSERT(0<=b && 0<=n && b+n<=nblocks);
+  FXASSERT(0<=start && start<=end && end<=length);
+  while(start<end){
+    p=end;
+    if(start+LINEBLOCK<end){
+      p=findNewline(start+LINEBLOCK,end);
+      if(p<end) p++;
+      }
+    block.bytes=p-start;
+    block.lines=countNewlines(start,p);
+    block.rows=measure?measureText(start,p,w,h):block.lines;
+    made.append(block);
+    start=p;
+    }
+  if(nblocks-n+made.no()<1){
+    block.bytes=block.lines=block.rows=0;
+    made.append(block);
+    }
+  m=(FXint)made.no();
+  if(n<m){
+    if(!resizeElms(blocks,nblocks-n+m)){ fxerror("%s::makeBlocks: out of memory.\n",getClassName()); }
+    moveElms(&blocks[b+m],&blocks[b+n],nblocks-b-n);
+    }
+  else{
+    moveElms(&blocks[b+m],&blocks[b+n],nblocks-b-n);
+    if(!resizeElms(blocks,nblocks-n+m)){ fxerror("%s::makeBlocks: out of memory.\n",getClassName()); }
+    }
+  copyElms(&blocks[b],made.data(),m);
+  nblocks=nblocks-n+m;
+  if(!resizeElms(blocksums,nblocks+1)){ fxerror("%s::makeBlocks: out of memory.\n",getClassName()); }
+  sumBlocks();
+  }
+
+
+// Update blocks for replacement of del bytes at pos by ins bytes, which changed
+// the number of newlines by nldelta and the number of rows by nrdelta.  Called
+// after the buffer has changed, but the blocks still describe the old text.
+// A change inside one block updates it in place; otherwise, the blocks from
+// the one containing the start to the one containing the end are rebuilt.
+void FXText::changeBlocks(FXint pos,FXint del,FXint ins,FXint nldelta,FXint nrdelta){
+  LineBlock before,after;
+  FXint b=blockOfPos(pos,before);
+  FXint e=blockOfPos(pos+del,after);
+  FXint bytes=blocks[b].bytes+ins-del;
+  FXint lines=blocks[b].lines+nldelta;
+  FXint p;
+  if(b==e && (0<bytes || nblocks==1) && (bytes<=2*LINEBLOCK || lines<=1 || ins<=del)){
+    blocks[b].bytes=bytes;
+    blocks[b].lines=lines;
+    blocks[b].rows+=nrdelta;
+    for(p=b+1; p<=nblocks; p+=p&-p){
+      blocksums[p].bytes+=ins-del;
+      blocksums[p].lines+=nldelta;
+      blocksums[p].rows+=nrdelta;
+      }
+    return;
+    }
+  makeBlocks(b,e-b+1,before.bytes,after.bytes+blocks[e].bytes+ins-del);
+  }
+
+/*******************************************************************************/
+
 // Its a little bit more complex than this:
 // We need to deal with diacritics, i.e. non-spacing stuff.  When wrapping, scan till
 // the next starter-character [the one with charCombining(c)==0].  Then measure the
@@ -844,8 +1084,10 @@ FXint FXText::indentOfLine(FXint start,FXint pos) const {
 
 // Return position of begin of paragraph
 FXint FXText::lineStart(FXint pos) const {
+  FXint p=pos;
   FXASSERT(0<=pos && pos<=length);
   while(0<pos && getByte(pos-1)!='\n'){
+    if(__unlikely(LINEBLOCK<p-pos)) return posOfLine(linesBefore(p));
     --pos;
     }
   FXASSERT(0<=pos && pos<=length);
@@ -856,19 +1098,19 @@ FXint FXText::lineStart(FXint pos) const {
 // Return position of end of paragraph
 FXint FXText::lineEnd(FXint pos) const {
   FXASSERT(0<=pos && pos<=length);
-  while(pos<length && getByte(pos)!='\n'){
-    ++pos;
-    }
+  pos=findNewline(pos,length);
   FXASSERT(0<=pos && pos<=length);
   return pos;
   }
 
 
-// Return start of next line
+// Return start of next line; if far away, look it up in the line index
 FXint FXText::nextLine(FXint pos,FXint nl) const {
+  FXint p=pos;
   FXASSERT(0<=pos && pos<=length);
   if(0<nl){
     while(pos<length){
+      if(__unlikely(LINEBLOCK<pos-p)) return (length-pos<nl) ? length : posOfLine(linesBefore(pos)+nl);
       if(getByte(pos++)=='\n' && --nl<=0) break;
       }
     }
@@ -877,11 +1119,13 @@ FXint FXText::nextLine(FXint pos,FXint nl) const {
   }
 
 
-// Return start of previous line
+// Return start of previous line; if far away, look it up in the line index
 FXint FXText::prevLine(FXint pos,FXint nl) const {
+  FXint p=pos;
   FXASSERT(0<=pos && pos<=length);
   if(0<nl){
     while(0<pos){
+      if(__unlikely(LINEBLOCK<p-pos)) return posOfLine(linesBefore(pos)-nl);
       if(getByte(pos-1)=='\n' && --nl<0) break;
       pos--;
       }
@@ -898,17 +1142,13 @@ FXint FXText::rowStart(FXint pos) const {
   FXASSERT(0<=pos && pos<=length);
   if(options&TEXT_WORDWRAP){
     p=pos;
-    while(0<pos && getByte(pos-1)!='\n'){               // Find line start first
-      --pos;
-      }
+    pos=lineStart(pos);                                 // Find line start first
     while(pos<p && (t=wrap(pos))<=p && t<length){       // Find row containing position, except if last row
       pos=t;
       }
     }
   else{
-    while(0<pos && getByte(pos-1)!='\n'){               // Find line start
-      --pos;
-      }
+    pos=lineStart(pos);                                 // Find line start
     }
   FXASSERT(0<=pos && pos<=length);
   return pos;
@@ -921,9 +1161,7 @@ FXint FXText::rowEnd(FXint pos) const {
   FXASSERT(0<=pos && pos<=length);
   if(options&TEXT_WORDWRAP){
     p=pos;
-    while(0<pos && getByte(pos-1)!='\n'){               // Find line start first
-      --pos;
-      }
+    pos=lineStart(pos);                                 // Find line start first
     while(pos<=p && pos<length){                        // Find row past position
       pos=wrap(pos);
       }
@@ -933,9 +1171,7 @@ FXint FXText::rowEnd(FXint pos) const {
       }
     }
   else{
-    while(pos<length && getByte(pos)!='\n'){            // Hunt for end of line
-      ++pos;
-      }
+    pos=lineEnd(pos);                                   // Hunt for end of line
     }
   FXASSERT(0<=pos && pos<=length);
   return pos;
@@ -949,21 +1185,21 @@ FXint FXText::nextRow(FXint pos,FXint nr) const {
   if(0<nr){
     if(options&TEXT_WORDWRAP){
       p=pos;
-      while(0<pos && getByte(pos-1)!='\n'){             // Find line start first
-        --pos;
-        }
+      pos=lineStart(pos);                               // Find line start first
       while(pos<p && (t=wrap(pos))<=p && t<length){     // Find row containing pos
         pos=t;
         }
+      p=pos;
       while(pos<length){                                // Then wrap until nth row after
+        if(__unlikely(LINEBLOCK<pos-p) && !(flags&FLAG_RECALC)){
+          return (length-pos<nr) ? length : posOfRow(rowsBefore(pos)+nr);
+          }
         pos=wrap(pos);
         if(--nr<=0) break;
         }
       }
     else{
-      while(pos<length){                                // Hunt for begin of nth next line
-        if(getByte(pos++)=='\n' && --nr<=0) break;
-        }
+      pos=nextLine(pos,nr);                             // Hunt for begin of nth next line
       }
     }
   FXASSERT(0<=pos && pos<=length);
@@ -973,15 +1209,13 @@ FXint FXText::nextRow(FXint pos,FXint nr) const {
 
 // Move to previous row given start of line
 FXint FXText::prevRow(FXint pos,FXint nr) const {
-  FXint p,q,t;
+  FXint p,q,t,s=pos;
   FXASSERT(0<=pos && pos<=length);
   if(0<nr){
     if(options&TEXT_WORDWRAP){
       while(0<pos){
         p=pos;
-        while(0<pos && getByte(pos-1)!='\n'){           // Find line start first
-          --pos;
-          }
+        pos=lineStart(pos);                             // Find line start first
         FXASSERT(0<=pos);
         q=pos;
         while(q<p && (t=wrap(q))<=p && t<length){       // Decrement number of rows to this point
@@ -995,15 +1229,15 @@ FXint FXText::prevRow(FXint pos,FXint nr) const {
         FXASSERT(0<=nr);
         if(nr==0) break;
         if(pos==0) break;
+        if(__unlikely(LINEBLOCK<s-pos) && !(flags&FLAG_RECALC)){
+          return posOfRow(rowsBefore(pos)-nr);          // Far away; look it up
+          }
         --pos;                                          // Skip over newline
         --nr;                                           // Which also counts as a row
         }
       }
     else{
-      while(0<pos){                                     // Find previous line start
-        if(getByte(pos-1)=='\n' && --nr<0) break;
-        --pos;
-        }
+      pos=prevLine(pos,nr);                             // Find previous line start
       }
     }
   FXASSERT(0<=pos && pos<=length);
@@ -1158,20 +1392,19 @@ FXint FXText::countCols(FXint start,FXint end) const {
 
 // Count number of rows; start and end should be on a row start
 FXint FXText::countRows(FXint start,FXint end) const {
-  FXint result=0;
+  FXint result=0,p=start;
   FXASSERT(0<=start && start<=end && end<=length);
   if(options&TEXT_WORDWRAP){
     while(start<end){
+      if(__unlikely(LINEBLOCK<start-p) && !(flags&FLAG_RECALC)){
+        return result+rowsBefore(end)-rowsBefore(start);
+        }
       start=wrap(start);
       result++;
       }
     }
   else{
-    while(start<end){
-      if(getByte(start++)=='\n'){
-        result++;
-        }
-      }
+    result=countLines(start,end);
     }
   return result;
   }
@@ -1179,14 +1412,11 @@ FXint FXText::countRows(FXint start,FXint end) const {
 
 // Count number of newlines
 FXint FXText::countLines(FXint start,FXint end) const {
-  FXint result=0;
   FXASSERT(0<=start && start<=end && end<=length);
-  while(start<end){
-    if(getByte(start++)=='\n'){
-      result++;
-      }
+  if(LINEBLOCK<end-start){
+    return linesBefore(end)-linesBefore(start);
     }
-  return result;
+  return countNewlines(start,end);
   }
 
 /*******************************************************************************/
@@ -1274,7 +1504,8 @@ void FXText::calcVisRows(FXint startline,FXint endline){
 // and line numbers, so if any of these things change it has to be redone.
 void FXText::recompute(){
   FXint hh=font->getFontHeight();
-  FXint botrow,ww1,hh1,ww2,hh2;
+  FXint b,tb,start,rows,ww,hh1;
+  LineBlock before;
 
   // The keep position is where we want to have the top of the buffer be;
   // make sure this is still inside the text buffer!
@@ -1285,23 +1516,34 @@ void FXText::recompute(){
   // the window repeatedly, toppos will not wander away indiscriminately.
   toppos=rowStart(keeppos);
 
-  // Remeasure the text; first, the part above the visible buffer, then
-  // the rest.  This avoids measuring the entire text twice, which is
-  // quite expensive.
-  toprow=measureText(0,toppos,ww1,hh1);
-
-  FXTRACE((TOPIC_LAYOUT,"measureText(%d,%d,%d,%d) = %d\n",0,toppos,ww1,hh1,toprow));
-
-  botrow=measureText(toppos,length,ww2,hh2);
+  // Remeasure the text block by block, updating the row count of each
+  // line block; the block containing the top of the visible buffer is
+  // measured in two parts, which yields the top row number as well.
+  // This avoids measuring the entire text twice, which is quite expensive.
+  tb=blockOfPos(toppos,before);
+  textWidth=0;
+  rows=0;
+  for(b=0,start=0; b<nblocks; start+=blocks[b++].bytes){
+    if(b==tb){
+      toprow=rows+measureText(start,toppos,ww,hh1);
+      textWidth=Math::imax(textWidth,ww);
+      blocks[b].rows=toprow-rows+measureText(toppos,start+blocks[b].bytes,ww,hh1);
+      }
+    else{
+      blocks[b].rows=measureText(start,start+blocks[b].bytes,ww,hh1);
+      }
+    textWidth=Math::imax(textWidth,ww);
+    rows+=blocks[b].rows;
+    }
+  sumBlocks();
 
-  FXTRACE((TOPIC_LAYOUT,"measureText(%d,%d,%d,%d) = %d\n",toppos,length,ww2,hh2,botrow));
+  FXTRACE((TOPIC_LAYOUT,"measureText(%d,%d) = %d, toprow=%d\n",0,length,rows,toprow));
 
   // Update text dimensions in terms of pixels and rows; note one extra
   // row always added, as there is always at least one row, even though
   // it may be empty of any characters.
-  textWidth=Math::imax(ww1,ww2);
-  textHeight=hh1+hh2+hh;
-  nrows=toprow+botrow+1;
+  textHeight=rows*hh+hh;
+  nrows=rows+1;
 
   // Adjust position, keeping same fractional position. Do this AFTER having
   // determined toprow, which may have changed due to wrapping changes.
@@ -2289,7 +2531,8 @@ FXint FXText::changeEnd(FXint pos) const {
 
 // Replace #del characters at pos by #ins characters
 void FXText::replace(FXint pos,FXint del,const FXchar *text,FXint ins,FXint style){
-  FXint dif,nrdel,nrins,ncdel,ncins,wbeg,wend,wdel,hdel,wins,hins,cursorstartpos,anchorstartpos;
+  FXint dif,nrdel,nrins,ncdel,ncins,nldel,nlins,wbeg,wend,wdel,hdel,wins,hins,cursorstartpos,anchorstartpos;
+  const FXchar *nl;
 
   // Inviolate
   FXASSERT(pos_x<=0 && pos_y<=0);
@@ -2309,6 +2552,12 @@ void FXText::replace(FXint pos,FXint del,const FXchar *text,FXint ins,FXint styl
 
   FXTRACE((TOPIC_TEXT,"wbeg=%d wend=%d nrdel=%d ncdel=%d length=%d nrows=%d wdel=%d hdel=%d\n",wbeg,wend,nrdel,ncdel,length,nrows,wdel,hdel));
 
+  // Count newlines deleted and inserted
+  nldel=countNewlines(pos,pos+del);
+  for(nlins=0,nl=text; nl<text+ins && (nl=(const FXchar*)memchr(nl,'\n',text+ins-nl))!=nullptr; ++nl){
+    nlins++;
+    }
+
   // Move the gap to current position
   movegap(pos);
 
@@ -2333,6 +2582,9 @@ void FXText::replace(FXint pos,FXint del,const FXchar *text,FXint ins,FXint styl
   // Adjust number of rows now
   nrows+=nrins-nrdel;
 
+  // Update line index
+  changeBlocks(pos,del,ins,nlins-nldel,nrins-nrdel);
+
   FXTRACE((TOPIC_TEXT,"wbeg=%d wend+dif=%d nrins=%d ncins=%d length=%d nrows=%d wins=%d hins=%d\n",wbeg,wend+dif,nrins,ncins,length,nrows,wins,hins));
 
   // Update visrows array and other stuff
@@ -2459,6 +2711,7 @@ FXint FXText::setStyledText(const FXchar* text,FXint num,FXint style,FXbool noti
     target->tryHandle(this,FXSEL(SEL_CHANGED,message),(void*)(FXival)cursorpos);
     }
   recalc();
+  makeBlocks(0,nblocks,0,length);
   layout();
   update();
   return num;
@@ -6737,6 +6990,8 @@ void FXText::load(FXStream& store){
   store >> help;
   store >> tip;
   store >> matchtime;
+  recalc();
+  makeBlocks(0,nblocks,0,length);
   }
 
 
@@ -6748,9 +7003,13 @@ FXText::~FXText(){
   freeElms(buffer);
   freeElms(sbuffer);
   freeElms(visrows);
+  freeElms(blocks);
+  freeElms(blocksums);
   buffer=(FXchar*)-1L;
   sbuffer=(FXchar*)-1L;
   visrows=(FXint*)-1L;
+  blocks=(LineBlock*)-1L;
+  blocksums=(LineBlock*)-1L;
   font=(FXFont*)-1L;
   delimiters=(const FXchar*)-1L;
   hilitestyles=(FXHiliteStyle*)-1L;
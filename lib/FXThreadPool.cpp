@@ -34,6 +34,7 @@
 #include "FXThread.h"
 #include "FXWorker.h"
 #include "FXLFQueue.h"
+#include "FXWSQueue.h"
 #include "FXThreadPool.h"
 
 
@@ -73,6 +74,26 @@
   - No new tasks can be posted when about to shut down; so when queue becomes empty, it
     will stay empty.
 
+  - In work-stealing mode, each worker thread claims a private deque (FXWSQueue) when
+    it starts, and releases it when it exits.  Tasks started by a worker are pushed
+    onto its own deque, without touching the shared queue or the freeslots semaphore;
+    only tasks from outside the thread pool go through the shared queue.
+
+  - A worker looks for work in its own deque first (LIFO, so nested task groups are
+    processed depth-first and cache-warm), then in the shared queue, and finally tries
+    to steal (FIFO) from the other workers' deques.
+
+  - The usedslots semaphore still counts available tasks, local or shared; a thread
+    which obtains a token searches all queues until it finds a task, or until all queues
+    are observed to be empty.  When the owner pops a task from its own deque, it tries
+    to take a token as well; if none is left, some other thread holding a token will
+    simply find nothing and go back to waiting.  Thus, there are never fewer tokens
+    (plus searching threads) than unclaimed tasks, and no task gets stranded.
+
+  - A worker's deque is always empty when it blocks on the semaphore, since it pops
+    its own deque before waiting; so a deque can be released safely when the worker
+    expires.
+
 */
 
 using namespace FX;
@@ -82,12 +103,23 @@ using namespace FX;
 namespace FX {
 
 
+// Per-worker task deque, padded to keep deques on separate cache lines
+struct FXThreadPool::Deque {
+  FXWSQueue       tasks;        // Tasks started by the owning worker
+  volatile FXuint owned;        // Claimed by a worker
+  FXuchar         pad[64];      // Padding
+  };
+
+
 // Locate thread pool to which worker thread belongs
 FXAutoThreadStorageKey FXThreadPool::reference;
 
+// Locate worker thread's own task deque
+FXAutoThreadStorageKey FXThreadPool::owndeque;
+
 
 // Create thread pool
-FXThreadPool::FXThreadPool(FXuint sz):queue(sz),freeslots(sz),usedslots(0),stacksize(0),expiration(forever),maximum(FXThread::processors()),minimum(1),workers(0),running(0){
+FXThreadPool::FXThreadPool(FXuint sz):queue(sz),deques(nullptr),freeslots(sz),usedslots(0),stacksize(0),expiration(forever),maximum(FXThread::processors()),minimum(1),workers(0),running(0),ndeques(0),stealing(false){
   FXTRACE((100,"FXThreadPool::FXThreadPool(%d)\n",sz));
   }
 
@@ -153,6 +185,17 @@ FXbool FXThreadPool::setStackSize(FXuval sz){
   }
 
 
+// Enable or disable work-stealing
+FXbool FXThreadPool::setWorkStealing(FXbool flag){
+  if(atomicBoolCas(&running,0,2)){
+    stealing=flag;
+    running=0;
+    return true;
+    }
+  return false;
+  }
+
+
 // Return calling thread's thread pool
 FXThreadPool* FXThreadPool::instance(){
   return (FXThreadPool*)reference.get();
@@ -165,6 +208,28 @@ void FXThreadPool::instance(FXThreadPool *pool){
   }
 
 
+// Claim unused deque for calling worker thread, if any
+FXThreadPool::Deque* FXThreadPool::claimDeque(){
+  for(FXuint d=0; d<ndeques; ++d){
+    if(atomicBoolCas(&deques[d].owned,0,1)){
+      owndeque.set(&deques[d]);
+      return &deques[d];
+      }
+    }
+  return nullptr;
+  }
+
+
+// Release deque owned by calling worker thread
+void FXThreadPool::releaseDeque(Deque* deque){
+  if(deque){
+    FXASSERT(deque->tasks.isEmpty());
+    owndeque.set(nullptr);
+    deque->owned=0;
+    }
+  }
+
+
 // Start a worker and reset semaphore
 FXbool FXThreadPool::startWorker(){
   threads.increment();
@@ -182,6 +247,16 @@ FXuint FXThreadPool::start(FXuint count){
   FXTRACE((150,"FXThreadPool::start(%u)\n",count));
   if(atomicBoolCas(&running,0,2)){
 
+    // One deque for each potential worker
+    if(stealing){
+      deques=new Deque[maximum];
+      for(FXuint d=0; d<maximum; ++d){
+        deques[d].tasks.setSize(queue.getSize());
+        deques[d].owned=0;
+        }
+      ndeques=maximum;
+      }
+
     // Start number of workers
     while(result<count && startWorker()){
       result++;
@@ -197,11 +272,48 @@ FXuint FXThreadPool::start(FXuint count){
   }
 
 
+// Obtain next task to run, waiting for at most timeout for one to become available.
+// In work-stealing mode, try own deque first, then the shared queue, and then try
+// to steal from the other worker's deques.  Having obtained a token but finding
+// all queues empty is not an error unless the thread pool is shutting down.
+FXbool FXThreadPool::nextTask(FXRunnable*& task,FXTime timeout){
+  if(ndeques){
+    Deque* own=(Deque*)owndeque.get();
+    FXuint d,v,busy;
+    if(own && own->tasks.pop((FXptr&)task)){
+      usedslots.trywait();
+      return true;
+      }
+    while(usedslots.wait(timeout)){
+      v=own?(FXuint)(own-deques):0;
+      do{
+        if(queue.pop(task)){
+          freeslots.post();
+          return true;
+          }
+        for(d=busy=0; d<ndeques; ++d){
+          if(++v>=ndeques) v=0;
+          if(deques[v].tasks.take((FXptr&)task)) return true;
+          busy|=!deques[v].tasks.isEmpty();
+          }
+        }
+      while(busy || !queue.isEmpty());
+      if(running!=1) break;
+      }
+    return false;
+    }
+  if(usedslots.wait(timeout) && queue.pop(task)){
+    freeslots.post();
+    return true;
+    }
+  return false;
+  }
+
+
 // Wait until counter becomes zero, return if no new tasks posted within timeout
 void FXThreadPool::runWhile(FXCompletion& comp,FXTime timeout){
   FXRunnable* task;
-  while(!comp.done() && usedslots.wait(timeout) && queue.pop(task)){
-    freeslots.post();
+  while(!comp.done() && nextTask(task,timeout)){
     try{
       task->run();
       }
@@ -221,17 +333,20 @@ void FXThreadPool::runWhile(FXCompletion& comp,FXTime timeout){
 // the current count of workers.
 FXint FXThreadPool::run(){
   FXuint w=atomicAdd(&workers,1);
+  Deque* own=claimDeque();
   instance(this);
   try{
     runWhile(threads,(w<minimum)?forever:expiration);
     }
   catch(...){
     instance(nullptr);
+    releaseDeque(own);
     atomicAdd(&workers,-1);
     threads.decrement();
     throw;
     }
   instance(nullptr);
+  releaseDeque(own);
   atomicAdd(&workers,-1);
   threads.decrement();
   return 0;
@@ -242,6 +357,15 @@ FXint FXThreadPool::run(){
 FXbool FXThreadPool::execute(FXRunnable* task,FXTime blocking){
   if(__likely(running==1 && task)){
     if(tasks.count()<threads.count() || maximum<=threads.count() || startWorker()){
+      Deque* own=(Deque*)owndeque.get();
+      if(own && instance()==this){
+        tasks.increment();
+        if(own->tasks.push(task)){
+          usedslots.post();
+          return true;
+          }
+        tasks.decrement();
+        }
       if(freeslots.wait(blocking)){
         tasks.increment();
         queue.push(task);
@@ -319,6 +443,11 @@ FXbool FXThreadPool::stop(){
     // Reset usedslots semaphore to zero
     while(usedslots.trywait()){ }
 
+    // Delete worker deques
+    delete [] deques;
+    deques=nullptr;
+    ndeques=0;
+
     // Unset context reference if set to this context
     if(instance()==this) instance(nullptr);
 
@@ -0,0 +1,1814 @@
+/********************************************************************************
+*                                                                               *
+*                    V i r t u a l   T a b l e   W i d g e t                    *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "fxmath.h"
+#include "fxkeys.h"
+#include "FXElement.h"
+#include "FXArray.h"
+#include "FXMetaClass.h"
+#include "FXHash.h"
+#include "FXMutex.h"
+#include "FXStream.h"
+#include "FXString.h"
+#include "FXSize.h"
+#include "FXPoint.h"
+#include "FXRectangle.h"
+#include "FXObjectList.h"
+#include "FXStringDictionary.h"
+#include "FXSettings.h"
+#include "FXRegistry.h"
+#include "FXAccelTable.h"
+#include "FXColors.h"
+#include "FXFont.h"
+#include "FXEvent.h"
+#include "FXWindow.h"
+#include "FXDCWindow.h"
+#include "FXApp.h"
+#include "FXIcon.h"
+#include "FXScrollBar.h"
+#include "FXHeader.h"
+#include "FXTable.h"
+#include "FXVirtualTable.h"
+
+
+/*
+  Notes:
+
+  - Virtual table looks like FXTable, except that the row labels are drawn by the
+    table itself rather than by a row header control, since a header control would
+    need an item for each row:
+
+    +--------+--------+--------+--------+
+    |        | ColHdr | ColHdr | ColHdr |
+    +--------+--------+--------+--------+
+    |      1 |    3.14|        |Pi      |
+    +--------+--------+--------+--------+
+    |      2 |        |        |        |
+    +--------+--------+--------+--------+
+
+  - Cells are not stored; the table asks the provider for the text, icon, and style
+    of each cell in a row when the row is first drawn, and keeps it in a cache.
+  - The cache is direct-mapped: row r goes into slot r%cachesize.  Since the cache
+    holds a few times more rows than fit in the window, all visible rows are always
+    in the cache at the same time, and rows scrolled just out of view are likely
+    still there when they scroll back in.  The cache grows when the window becomes
+    taller, but never shrinks.
+  - All rows have the same height, so the position of a row is simply its index
+    times the row height; no per-row storage is needed at all.
+  - The content height for a hundred million rows or more exceeds what fits in the
+    scroll bar's range and the window's coordinates.  We keep the actual vertical
+    scroll offset as a 64-bit number, and when the table is taller than MAXCONTENT,
+    the scroll bar position is scaled linearly onto the offset.  The screen is still
+    blitted by the actual number of pixels scrolled, so scrolling remains smooth.
+    Programmatic scrolling, like making the current cell visible, sets the offset
+    exactly, rather than going via the scaled scroll bar position.
+  - When the provider's rows change, rowsInserted(), rowsRemoved(), rowsMoved(),
+    and rowsChanged() adjust the current cell, anchor, and selection, and flush
+    affected rows from the cache; the cost depends only on the size of the cache,
+    never on the number of rows.
+  - Selection is a single rectangular range; selection changes are reported once
+    for the whole range, not once for each cell, since a selection may span many
+    millions of cells.
+  - Cells are not edited in place; there is no item to hold the edited value.
+*/
+
+
+#define DEFAULTCOLWIDTH     100         // Initial column width
+#define DEFAULTROWHEIGHT    20          // Initial row height
+#define MINCACHESIZE        64          // Minimum number of rows in cache
+#define MAXCONTENT          (1<<30)     // Maximum scrollable content height
+
+#define TABLE_MASK          (TABLE_COL_SIZABLE|TABLE_NO_COLSELECT)
+
+using namespace FX;
+
+/*******************************************************************************/
+
+namespace FX {
+
+
+// Cached cell
+struct FXVirtualTable::Cell {
+  FXString text;        // Cell text
+  FXIcon  *icon;        // Cell icon
+  FXuint   style;       // Justification, icon position, borders, stipple
+  Cell():icon(nullptr),style(FXTableItem::RIGHT){}
+  };
+
+
+// Map row after removing count rows at row; removed rows map to row
+static FXint removedRow(FXint r,FXint row,FXint count){
+  if(r<row) return r;
+  if(r<row+count) return row;
+  return r-count;
+  }
+
+
+// Map row after moving count rows at from to just before row to
+static FXint movedRow(FXint r,FXint from,FXint to,FXint count){
+  if(from<=r && r<from+count) return (to<from) ? r-from+to : r-from+to-count;
+  if(to<=r && r<from) return r+count;
+  if(from+count<=r && r<to) return r-count;
+  return r;
+  }
+
+/*******************************************************************************/
+
+// Default icon is none
+FXIcon* FXTableProvider::getCellIcon(FXint,FXint) const {
+  return nullptr;
+  }
+
+
+// Default style is right-justified
+FXuint FXTableProvider::getCellStyle(FXint,FXint) const {
+  return FXTableItem::RIGHT;
+  }
+
+
+// Default row label is row number
+FXString FXTableProvider::getRowLabel(FXint row) const {
+  return FXString::value(row+1);
+  }
+
+
+// Destroy provider
+FXTableProvider::~FXTableProvider(){
+  }
+
+/*******************************************************************************/
+
+// Map
+FXDEFMAP(FXVirtualTable) FXVirtualTableMap[]={
+  FXMAPFUNC(SEL_PAINT,0,FXVirtualTable::onPaint),
+  FXMAPFUNC(SEL_MOTION,0,FXVirtualTable::onMotion),
+  FXMAPFUNC(SEL_TIMEOUT,FXVirtualTable::ID_AUTOSCROLL,FXVirtualTable::onAutoScroll),
+  FXMAPFUNC(SEL_UNGRABBED,0,FXVirtualTable::onUngrabbed),
+  FXMAPFUNC(SEL_LEFTBUTTONPRESS,0,FXVirtualTable::onLeftBtnPress),
+  FXMAPFUNC(SEL_LEFTBUTTONRELEASE,0,FXVirtualTable::onLeftBtnRelease),
+  FXMAPFUNC(SEL_RIGHTBUTTONPRESS,0,FXVirtualTable::onRightBtnPress),
+  FXMAPFUNC(SEL_RIGHTBUTTONRELEASE,0,FXVirtualTable::onRightBtnRelease),
+  FXMAPFUNC(SEL_KEYPRESS,0,FXVirtualTable::onKeyPress),
+  FXMAPFUNC(SEL_KEYRELEASE,0,FXVirtualTable::onKeyRelease),
+  FXMAPFUNC(SEL_FOCUSIN,0,FXVirtualTable::onFocusIn),
+  FXMAPFUNC(SEL_FOCUSOUT,0,FXVirtualTable::onFocusOut),
+  FXMAPFUNC(SEL_CLICKED,0,FXVirtualTable::onClicked),
+  FXMAPFUNC(SEL_DOUBLECLICKED,0,FXVirtualTable::onDoubleClicked),
+  FXMAPFUNC(SEL_TRIPLECLICKED,0,FXVirtualTable::onTripleClicked),
+  FXMAPFUNC(SEL_COMMAND,0,FXVirtualTable::onCommand),
+  FXMAPFUNC(SEL_QUERY_HELP,0,FXVirtualTable::onQueryHelp),
+  FXMAPFUNC(SEL_COMMAND,FXVirtualTable::ID_SELECT_COLUMN_INDEX,FXVirtualTable::onCmdSelectColumnIndex),
+  FXMAPFUNC(SEL_COMMAND,FXVirtualTable::ID_SELECT_ALL,FXVirtualTable::onCmdSelectAll),
+  FXMAPFUNC(SEL_COMMAND,FXVirtualTable::ID_DESELECT_ALL,FXVirtualTable::onCmdDeselectAll),
+  };
+
+
+// Object implementation
+FXIMPLEMENT(FXVirtualTable,FXScrollArea,FXVirtualTableMap,ARRAYNUMBER(FXVirtualTableMap))
+
+
+// Serialization
+FXVirtualTable::FXVirtualTable(){
+  flags|=FLAG_ENABLED;
+  colHeader=nullptr;
+  provider=nullptr;
+  cells=nullptr;
+  cachedrows=nullptr;
+  cachesize=0;
+  offset=0;
+  font=nullptr;
+  nrows=0;
+  ncols=0;
+  rowHeight=DEFAULTROWHEIGHT;
+  rowLabelWidth=0;
+  visiblerows=0;
+  visiblecols=0;
+  margintop=0;
+  marginbottom=0;
+  marginleft=0;
+  marginright=0;
+  textColor=0;
+  baseColor=0;
+  hiliteColor=0;
+  shadowColor=0;
+  selbackColor=0;
+  seltextColor=0;
+  gridColor=0;
+  stippleColor=0;
+  cellBorderColor=0;
+  cellBorderWidth=0;
+  cellBackColor[0][0]=0;
+  cellBackColor[0][1]=0;
+  cellBackColor[1][0]=0;
+  cellBackColor[1][1]=0;
+  current.row=-1;
+  current.col=-1;
+  anchor.row=-1;
+  anchor.col=-1;
+  selection.fm.row=-1;
+  selection.fm.col=-1;
+  selection.to.row=-1;
+  selection.to.col=-1;
+  mode=MOUSE_NONE;
+  hgrid=true;
+  vgrid=true;
+  grabx=0;
+  graby=0;
+  }
+
+
+// Build virtual table
+FXVirtualTable::FXVirtualTable(FXComposite *p,FXObject* tgt,FXSelector sel,FXuint opts,FXint x,FXint y,FXint w,FXint h,FXint pl,FXint pr,FXint pt,FXint pb):FXScrollArea(p,opts,x,y,w,h){
+  FXuint colhs=HEADER_HORIZONTAL|HEADER_TRACKING|HEADER_BUTTON|FRAME_RAISED|FRAME_THICK|LAYOUT_FIX_HEIGHT;
+  if(options&TABLE_COL_SIZABLE) colhs|=HEADER_RESIZE;
+  if(options&TABLE_NO_COLSELECT) colhs&=~HEADER_BUTTON;
+  colHeader=new FXHeader(this,this,FXVirtualTable::ID_SELECT_COLUMN_INDEX,colhs,0,0,0,DEFAULTROWHEIGHT);
+  flags|=FLAG_ENABLED;
+  target=tgt;
+  message=sel;
+  provider=nullptr;
+  cells=nullptr;
+  cachedrows=nullptr;
+  cachesize=0;
+  offset=0;
+  font=getApp()->getNormalFont();
+  nrows=0;
+  ncols=0;
+  rowHeight=DEFAULTROWHEIGHT;
+  rowLabelWidth=0;
+  visiblerows=0;
+  visiblecols=0;
+  margintop=pt;
+  marginbottom=pb;
+  marginleft=pl;
+  marginright=pr;
+  textColor=getApp()->getForeColor();
+  baseColor=getApp()->getBaseColor();
+  hiliteColor=getApp()->getHiliteColor();
+  shadowColor=getApp()->getShadowColor();
+  selbackColor=getApp()->getSelbackColor();
+  seltextColor=getApp()->getSelforeColor();
+  gridColor=makeShadowColor(getApp()->getBackColor());
+  stippleColor=FXRGB(255,0,0);
+  cellBorderColor=getApp()->getBorderColor();
+  cellBorderWidth=2;
+  cellBackColor[0][0]=getApp()->getBackColor();
+  cellBackColor[0][1]=getApp()->getBackColor();
+  cellBackColor[1][0]=getApp()->getBackColor();
+  cellBackColor[1][1]=getApp()->getBackColor();
+  current.row=-1;
+  current.col=-1;
+  anchor.row=-1;
+  anchor.col=-1;
+  selection.fm.row=-1;
+  selection.fm.col=-1;
+  selection.to.row=-1;
+  selection.to.col=-1;
+  mode=MOUSE_NONE;
+  hgrid=true;
+  vgrid=true;
+  grabx=0;
+  graby=0;
+  resizeCache(MINCACHESIZE);
+  }
+
+
+// Create window
+void FXVirtualTable::create(){
+  FXScrollArea::create();
+  font->create();
+  }
+
+
+// Detach window
+void FXVirtualTable::detach(){
+  FXScrollArea::detach();
+  font->detach();
+  }
+
+
+// Can have focus
+FXbool FXVirtualTable::canFocus() const { return true; }
+
+
+// Into focus chain
+void FXVirtualTable::setFocus(){
+  FXScrollArea::setFocus();
+  setDefault(true);
+  }
+
+
+// Out of focus chain
+void FXVirtualTable::killFocus(){
+  FXScrollArea::killFocus();
+  setDefault(maybe);
+  }
+
+
+// Propagate size change
+void FXVirtualTable::recalc(){
+  FXScrollArea::recalc();
+  flags|=FLAG_RECALC;
+  }
+
+
+// Get default width
+FXint FXVirtualTable::getDefaultWidth(){
+  return 0<visiblecols ? visiblecols*DEFAULTCOLWIDTH+vgrid+rowLabelWidth : FXScrollArea::getDefaultWidth()+rowLabelWidth;
+  }
+
+
+// Get default height
+FXint FXVirtualTable::getDefaultHeight(){
+  FXint ch=(colHeader->getLayoutHints()&LAYOUT_FIX_HEIGHT) ? colHeader->getHeight() : colHeader->getDefaultHeight();
+  return 0<visiblerows ? visiblerows*rowHeight+hgrid+ch : FXScrollArea::getDefaultHeight()+ch;
+  }
+
+
+// Return visible scroll-area x position
+FXint FXVirtualTable::getVisibleX() const {
+  return colHeader->getX();
+  }
+
+
+// Return visible scroll-area y position
+FXint FXVirtualTable::getVisibleY() const {
+  return colHeader->getY()+colHeader->getHeight();
+  }
+
+
+// Return visible scroll-area width
+FXint FXVirtualTable::getVisibleWidth() const {
+  return width-vertical->getWidth()-colHeader->getX();
+  }
+
+
+// Return visible scroll-area height
+FXint FXVirtualTable::getVisibleHeight() const {
+  return height-horizontal->getHeight()-getVisibleY();
+  }
+
+
+// Determine scrollable content width
+FXint FXVirtualTable::getContentWidth(){
+  return colHeader->getTotalSize()+vgrid;
+  }
+
+
+// Determine scrollable content height, limited to what the scroll bar can handle
+FXint FXVirtualTable::getContentHeight(){
+  FXlong total=getTotalHeight();
+  return (total<MAXCONTENT) ? (FXint)total : MAXCONTENT;
+  }
+
+
+// Actual height of all rows, including bottom grid line
+FXlong FXVirtualTable::getTotalHeight() const {
+  return (FXlong)nrows*rowHeight+hgrid;
+  }
+
+
+// Map scroll position to vertical scroll offset
+FXlong FXVirtualTable::positionToOffset(FXint y) const {
+  FXlong total=getTotalHeight();
+  if(MAXCONTENT<total){
+    FXint range=vertical->getRange()-vertical->getPage();
+    if(0<range) return (FXlong)(-y*((FXdouble)(total-vertical->getPage())/range)+0.5);
+    return 0;
+    }
+  return -y;
+  }
+
+
+// Map vertical scroll offset to scroll position
+FXint FXVirtualTable::offsetToPosition(FXlong off) const {
+  FXlong total=getTotalHeight();
+  if(MAXCONTENT<total){
+    FXint range=vertical->getRange()-vertical->getPage();
+    if(0<range) return -(FXint)(off*((FXdouble)range/(total-vertical->getPage()))+0.5);
+    return 0;
+    }
+  return -(FXint)off;
+  }
+
+
+// Blit rows and row labels by the given amount
+void FXVirtualTable::scrollRows(FXint dx,FXint dy) const {
+  scroll(getVisibleX(),getVisibleY(),getVisibleWidth(),getVisibleHeight(),dx,dy);
+  if(rowLabelWidth){
+    scroll(0,getVisibleY(),rowLabelWidth,getVisibleHeight(),0,dy);
+    }
+  }
+
+
+// Move content; the vertical offset follows the scroll bar position
+void FXVirtualTable::moveContents(FXint x,FXint y){
+  FXlong old=offset;
+  if(y!=pos_y) offset=positionToOffset(y);
+  scrollRows(x-pos_x,(FXint)FXCLAMP(-height,old-offset,height));
+  pos_x=x;
+  pos_y=y;
+  colHeader->setPosition(x);
+  }
+
+
+// Change vertical scroll offset; set exactly even if the scroll bar is scaled
+void FXVirtualTable::setScrollOffset(FXlong off){
+  FXlong maxoff=getTotalHeight()-getVisibleHeight();
+  if(off>maxoff) off=maxoff;
+  if(off<0) off=0;
+  setPosition(pos_x,offsetToPosition(off));
+  if(offset!=off){
+    scrollRows(0,(FXint)FXCLAMP(-height,offset-off,height));
+    offset=off;
+    }
+  }
+
+
+// Recalculate layout
+void FXVirtualTable::layout(){
+  FXint colh,size;
+
+  // Size up column header height
+  colh=(colHeader->getLayoutHints()&LAYOUT_FIX_HEIGHT) ? colHeader->getHeight() : colHeader->getDefaultHeight();
+
+  // Place header
+  colHeader->position(rowLabelWidth,0,width-rowLabelWidth,colh);
+  colHeader->raise();
+
+  // Place scroll bars
+  placeScrollBars(width-rowLabelWidth,height-colh);
+
+  // Line size for scroll bars; one row, even if the scroll bar is scaled
+  vertical->setLine(FXMAX(-offsetToPosition(rowHeight),1));
+  horizontal->setLine(DEFAULTCOLWIDTH);
+
+  // Grow cache to hold a few windows full of rows
+  size=3*(getVisibleHeight()/rowHeight+2);
+  if(size>cachesize) resizeCache(size);
+
+  // Keep offset in range
+  setScrollOffset(offset);
+
+  // Force repaint
+  update();
+
+  // No more dirty
+  flags&=~FLAG_DIRTY;
+  }
+
+/*******************************************************************************/
+
+// Reallocate cache, and empty it
+void FXVirtualTable::resizeCache(FXint size){
+  delete [] cells;
+  cells=new Cell[size*(ncols+1)];
+  resizeElms(cachedrows,size);
+  for(FXint slot=0; slot<size; ++slot) cachedrows[slot]=-1;
+  cachesize=size;
+  }
+
+
+// Return cells of row, asking the provider if not in cache; the cell after
+// the last column holds the row label
+const FXVirtualTable::Cell* FXVirtualTable::getCachedRow(FXint row){
+  FXint slot=row%cachesize;
+  Cell* cell=cells+slot*(ncols+1);
+  if(cachedrows[slot]!=row){
+    for(FXint col=0; col<ncols; ++col){
+      if(provider){
+        cell[col].text=provider->getCellText(row,col);
+        cell[col].icon=provider->getCellIcon(row,col);
+        cell[col].style=provider->getCellStyle(row,col);
+        }
+      else{
+        cell[col].text=FXString::null;
+        cell[col].icon=nullptr;
+        cell[col].style=FXTableItem::RIGHT;
+        }
+      }
+    cell[ncols].text=(provider && rowLabelWidth) ? provider->getRowLabel(row) : FXString::null;
+    cachedrows[slot]=row;
+    }
+  return cell;
+  }
+
+
+// Flush rows fr...lr from cache
+void FXVirtualTable::flushRows(FXint fr,FXint lr){
+  FXint slot,row;
+  if(lr-fr<cachesize){
+    for(row=fr; row<=lr; ++row){
+      slot=row%cachesize;
+      if(cachedrows[slot]==row) cachedrows[slot]=-1;
+      }
+    }
+  else{
+    for(slot=0; slot<cachesize; ++slot){
+      if(fr<=cachedrows[slot] && cachedrows[slot]<=lr) cachedrows[slot]=-1;
+      }
+    }
+  }
+
+/*******************************************************************************/
+
+// Window y-coordinate of row
+FXlong FXVirtualTable::getRowY(FXint row) const {
+  return getVisibleY()+(FXlong)row*rowHeight-offset;
+  }
+
+
+// Window x-coordinate of column
+FXint FXVirtualTable::getColumnX(FXint col) const {
+  return colHeader->getX()+colHeader->getItemOffset(col);
+  }
+
+
+// Get row containing y
+FXint FXVirtualTable::rowAtY(FXint y) const {
+  FXlong off=offset+y-getVisibleY();
+  if(off<0) return -1;
+  off/=rowHeight;
+  return (off<nrows) ? (FXint)off : nrows;
+  }
+
+
+// Get column containing x
+FXint FXVirtualTable::colAtX(FXint x) const {
+  return colHeader->getItemAt(x-colHeader->getX());
+  }
+
+
+// True if item (partially) visible
+FXbool FXVirtualTable::isItemVisible(FXint row,FXint col) const {
+  FXint xl,xr,vx,vy; FXlong yt;
+  if(row<0 || col<0 || nrows<=row || ncols<=col){ fxerror("%s::isItemVisible: index out of range.\n",getClassName()); }
+  vx=getVisibleX();
+  vy=getVisibleY();
+  xl=getColumnX(col);
+  xr=xl+colHeader->getItemSize(col);
+  yt=getRowY(row);
+  return vx<xr && vy<yt+rowHeight && xl<vx+getVisibleWidth() && yt<vy+getVisibleHeight();
+  }
+
+
+// Force position to become fully visible
+void FXVirtualTable::makePositionVisible(FXint row,FXint col){
+  FXint xlo,xhi,px,vw,vh;
+  FXlong ylo,yhi,off;
+  if(0<=col && col<ncols){
+    px=pos_x;
+    vw=getVisibleWidth();
+    xlo=colHeader->getItemOffset(col)-colHeader->getPosition();
+    xhi=colHeader->getItemSize(col)+xlo+vgrid;
+    if(px+xhi>=vw) px=vw-xhi;
+    if(px+xlo<=0) px=-xlo;
+    setPosition(px,pos_y);
+    }
+  if(0<=row && row<nrows){
+    off=offset;
+    vh=getVisibleHeight();
+    ylo=(FXlong)row*rowHeight;
+    yhi=ylo+rowHeight+hgrid;
+    if(yhi-off>=vh) off=yhi-vh;
+    if(ylo-off<=0) off=ylo;
+    setScrollOffset(off);
+    }
+  }
+
+
+// Repaint rows fr...lr, as far as they're visible
+void FXVirtualTable::updateRows(FXint fr,FXint lr) const {
+  FXint vy=getVisibleY();
+  FXint vh=getVisibleHeight();
+  FXlong yt=getRowY(fr);
+  FXlong yb=getRowY(lr+1)+hgrid;
+  if(yt<vy) yt=vy;
+  if(yb>vy+vh) yb=vy+vh;
+  if(yt<yb){
+    update(0,(FXint)yt,width,(FXint)(yb-yt));
+    }
+  }
+
+
+// Repaint cell
+void FXVirtualTable::updateItem(FXint row,FXint col) const {
+  FXint vy=getVisibleY();
+  FXint vh=getVisibleHeight();
+  FXlong yt,yb;
+  if(row<0 || col<0 || nrows<=row || ncols<=col){ fxerror("%s::updateItem: index out of range.\n",getClassName()); }
+  yt=getRowY(row);
+  yb=yt+rowHeight+hgrid;
+  if(yt<vy) yt=vy;
+  if(yb>vy+vh) yb=vy+vh;
+  if(yt<yb){
+    update(getColumnX(col),(FXint)yt,colHeader->getItemSize(col)+vgrid,(FXint)(yb-yt));
+    }
+  }
+
+/*******************************************************************************/
+
+// Change provider
+void FXVirtualTable::setProvider(FXTableProvider* prov){
+  if(provider!=prov){
+    provider=prov;
+    contentsChanged();
+    }
+  }
+
+
+// Change number of rows
+void FXVirtualTable::setNumRows(FXint rows,FXbool notify){
+  if(rows<0) rows=0;
+  if(rows<nrows){
+    rowsRemoved(rows,nrows-rows,notify);
+    }
+  else if(rows>nrows){
+    rowsInserted(nrows,rows-nrows,notify);
+    }
+  }
+
+
+// Change number of columns
+void FXVirtualTable::setNumColumns(FXint cols,FXbool notify){
+  if(cols<0) cols=0;
+  if(cols!=ncols){
+    while(colHeader->getNumItems()<cols){
+      colHeader->appendItem(FXString::null,nullptr,DEFAULTCOLWIDTH,nullptr,notify);
+      }
+    while(colHeader->getNumItems()>cols){
+      colHeader->removeItem(colHeader->getNumItems()-1,notify);
+      }
+    ncols=cols;
+    if(current.col>=ncols){ current.col=ncols-1; if(current.col<0) current.row=-1; }
+    if(anchor.col>=ncols){ anchor.col=ncols-1; if(anchor.col<0) anchor.row=-1; }
+    if(selection.fm.col>=ncols){
+      selection.fm.row=selection.fm.col=selection.to.row=selection.to.col=-1;
+      }
+    else if(selection.to.col>=ncols){
+      selection.to.col=ncols-1;
+      }
+    resizeCache(cachesize);
+    recalc();
+    update();
+    }
+  }
+
+
+// Rows were inserted; rows at or after row move down
+void FXVirtualTable::rowsInserted(FXint row,FXint count,FXbool notify){
+  if(row<0 || nrows<row || count<0 || 2147483647-nrows<count){ fxerror("%s::rowsInserted: index out of range.\n",getClassName()); }
+  if(0<count){
+    FXTablePos old=current;
+    flushRows(row,nrows-1);
+    nrows+=count;
+    if(row<=current.row) current.row+=count;
+    if(row<=anchor.row) anchor.row+=count;
+    if(row<=selection.fm.row) selection.fm.row+=count;
+    if(row<=selection.to.row) selection.to.row+=count;
+    updateRows(row,nrows-1);
+    recalc();
+    if(notify && target && (old.row!=current.row || old.col!=current.col)){
+      target->tryHandle(this,FXSEL(SEL_CHANGED,message),(void*)&current);
+      }
+    }
+  }
+
+
+// Rows were removed; rows after them move up
+void FXVirtualTable::rowsRemoved(FXint row,FXint count,FXbool notify){
+  if(row<0 || count<0 || nrows-count<row){ fxerror("%s::rowsRemoved: index out of range.\n",getClassName()); }
+  if(0<count){
+    FXTablePos old=current;
+    flushRows(row,nrows-1);
+    updateRows(row,nrows-1);
+    nrows-=count;
+    if(0<=current.row){
+      current.row=FXMIN(removedRow(current.row,row,count),nrows-1);
+      if(current.row<0) current.col=-1;
+      }
+    if(0<=anchor.row){
+      anchor.row=FXMIN(removedRow(anchor.row,row,count),nrows-1);
+      if(anchor.row<0) anchor.col=-1;
+      }
+    if(0<=selection.fm.row){
+      selection.fm.row=removedRow(selection.fm.row,row,count);
+      selection.to.row=(selection.to.row<row+count) ? FXMIN(selection.to.row,row-1) : selection.to.row-count;
+      if(selection.to.row<selection.fm.row){
+        selection.fm.row=selection.fm.col=selection.to.row=selection.to.col=-1;
+        }
+      }
+    recalc();
+    if(notify && target && (old.row!=current.row || old.col!=current.col)){
+      target->tryHandle(this,FXSEL(SEL_CHANGED,message),(void*)&current);
+      }
+    }
+  }
+
+
+// Rows from...from+count-1 were moved to just before row to
+void FXVirtualTable::rowsMoved(FXint from,FXint to,FXint count,FXbool notify){
+  if(from<0 || count<0 || nrows-count<from || to<0 || nrows<to){ fxerror("%s::rowsMoved: index out of range.\n",getClassName()); }
+  if(0<count && (to<from || from+count<to)){
+    FXint lo=FXMIN(from,to);
+    FXint hi=FXMAX(from+count,to)-1;
+    FXTablePos old=current;
+    if(0<=current.row) current.row=movedRow(current.row,from,to,count);
+    if(0<=anchor.row) anchor.row=movedRow(anchor.row,from,to,count);
+    if(0<=selection.fm.row){
+      FXint fm=movedRow(selection.fm.row,from,to,count);
+      FXint tt=movedRow(selection.to.row,from,to,count);
+      if(tt-fm==selection.to.row-selection.fm.row){
+        selection.fm.row=fm;
+        selection.to.row=tt;
+        }
+      else{
+        selection.fm.row=selection.fm.col=selection.to.row=selection.to.col=-1;
+        }
+      }
+    flushRows(lo,hi);
+    updateRows(lo,hi);
+    if(notify && target && (old.row!=current.row || old.col!=current.col)){
+      target->tryHandle(this,FXSEL(SEL_CHANGED,message),(void*)&current);
+      }
+    }
+  }
+
+
+// Contents of rows changed
+void FXVirtualTable::rowsChanged(FXint row,FXint count){
+  if(row<0 || count<0 || nrows-count<row){ fxerror("%s::rowsChanged: index out of range.\n",getClassName()); }
+  if(0<count){
+    flushRows(row,row+count-1);
+    updateRows(row,row+count-1);
+    }
+  }
+
+
+// All contents changed
+void FXVirtualTable::contentsChanged(){
+  for(FXint slot=0; slot<cachesize; ++slot) cachedrows[slot]=-1;
+  update();
+  }
+
+/*******************************************************************************/
+
+// Set current item
+void FXVirtualTable::setCurrentItem(FXint row,FXint col,FXbool notify){
+  row=FXCLAMP(-1,row,nrows-1);
+  col=FXCLAMP(-1,col,ncols-1);
+  if(row!=current.row || col!=current.col){
+    if(0<=current.row && 0<=current.col){
+      updateItem(current.row,current.col);
+      }
+    current.row=row;
+    current.col=col;
+    if(0<=current.row && 0<=current.col){
+      updateItem(current.row,current.col);
+      }
+    if(notify && target){
+      target->tryHandle(this,FXSEL(SEL_CHANGED,message),(void*)&current);
+      }
+    }
+  }
+
+
+// Set anchor item
+void FXVirtualTable::setAnchorItem(FXint row,FXint col){
+  anchor.row=FXCLAMP(-1,row,nrows-1);
+  anchor.col=FXCLAMP(-1,col,ncols-1);
+  }
+
+
+// True if item is selected
+FXbool FXVirtualTable::isItemSelected(FXint row,FXint col) const {
+  return selection.fm.row<=row && row<=selection.to.row && selection.fm.col<=col && col<=selection.to.col;
+  }
+
+
+// Is anything selected
+FXbool FXVirtualTable::isAnythingSelected() const {
+  return 0<=selection.fm.row && 0<=selection.to.row && 0<=selection.fm.col && 0<=selection.to.col;
+  }
+
+
+// Return selected range
+FXbool FXVirtualTable::getSelection(FXTableRange& range) const {
+  range=selection;
+  return isAnythingSelected();
+  }
+
+
+// Select range; only the rows of the old and new selection are repainted
+FXbool FXVirtualTable::selectRange(FXint startrow,FXint endrow,FXint startcol,FXint endcol,FXbool notify){
+  if(0<=startrow && startrow<=endrow && endrow<nrows && 0<=startcol && startcol<=endcol && endcol<ncols){
+    if(startrow!=selection.fm.row || endrow!=selection.to.row || startcol!=selection.fm.col || endcol!=selection.to.col){
+      if(isAnythingSelected()){
+        updateRows(selection.fm.row,selection.to.row);
+        }
+      selection.fm.row=startrow;
+      selection.fm.col=startcol;
+      selection.to.row=endrow;
+      selection.to.col=endcol;
+      updateRows(startrow,endrow);
+      if(notify && target){
+        target->tryHandle(this,FXSEL(SEL_SELECTED,message),(void*)&selection);
+        }
+      }
+    return true;
+    }
+  return false;
+  }
+
+
+// Select rows
+FXbool FXVirtualTable::selectRows(FXint startrow,FXint endrow,FXbool notify){
+  return selectRange(startrow,endrow,0,ncols-1,notify);
+  }
+
+
+// Extend selection
+FXbool FXVirtualTable::extendSelection(FXint row,FXint col,FXbool notify){
+  return selectRange(FXMIN(anchor.row,row),FXMAX(anchor.row,row),FXMIN(anchor.col,col),FXMAX(anchor.col,col),notify);
+  }
+
+
+// Kill selection
+FXbool FXVirtualTable::killSelection(FXbool notify){
+  if(isAnythingSelected()){
+    FXTableRange old=selection;
+    updateRows(selection.fm.row,selection.to.row);
+    selection.fm.row=-1;
+    selection.fm.col=-1;
+    selection.to.row=-1;
+    selection.to.col=-1;
+    if(notify && target){
+      target->tryHandle(this,FXSEL(SEL_DESELECTED,message),(void*)&old);
+      }
+    return true;
+    }
+  return false;
+  }
+
+/*******************************************************************************/
+
+// Draw cell; grid lines count on left/top side but not on right/bottom side
+void FXVirtualTable::drawCell(FXDC& dc,const Cell& cell,FXint row,FXint col,FXint x,FXint y,FXint w,FXint h){
+  FXint tx,ty,tw,th,ix,iy,iw,ih,s,beg,end,t,xx,yy,bb;
+  FXint ml=marginleft+vgrid;
+  FXint mt=margintop+hgrid;
+  FXint mr=marginright;
+  FXint mb=marginbottom;
+  FXuint style=cell.style;
+  const FXString& lbl=cell.text;
+  FXbool selected=isItemSelected(row,col);
+
+  // Clip against cell, and visible part of table
+  dc.setClipRectangle(FXRectangle(x,y,w+vgrid,h+hgrid)*FXRectangle(getVisibleX(),getVisibleY(),getVisibleWidth(),getVisibleHeight()));
+
+  // Background
+  dc.setForeground(selected ? selbackColor : cellBackColor[row&1][col&1]);
+  dc.fillRectangle(x+vgrid,y+hgrid,w-vgrid,h-hgrid);
+
+  // Hatch pattern
+  if(style&0x1f00){
+    dc.setStipple((FXStipplePattern)((style&0x1f00)>>8),x,y);
+    dc.setFillStyle(FILL_STIPPLED);
+    dc.setForeground(stippleColor);
+    dc.fillRectangle(x+vgrid,y+hgrid,w-vgrid,h-hgrid);
+    dc.setFillStyle(FILL_SOLID);
+    }
+
+  // Text width and height
+  beg=tw=th=0;
+  do{
+    end=beg;
+    while(end<lbl.length() && lbl[end]!='\n') end++;
+    if((t=font->getTextWidth(&lbl[beg],end-beg))>tw) tw=t;
+    th+=font->getFontHeight();
+    beg=end+1;
+    }
+  while(end<lbl.length());
+
+  // Icon size
+  iw=ih=0;
+  if(cell.icon){
+    iw=cell.icon->getWidth();
+    ih=cell.icon->getHeight();
+    }
+
+  // Icon-text spacing
+  s=0;
+  if(iw && tw) s=4;
+
+  // Fix x coordinate
+  if(style&FXTableItem::LEFT){
+    if(style&FXTableItem::BEFORE){ ix=x+ml; tx=ix+iw+s; }
+    else if(style&FXTableItem::AFTER){ tx=x+ml; ix=tx+tw+s; }
+    else{ ix=x+ml; tx=x+ml; }
+    }
+  else if(style&FXTableItem::RIGHT){
+    if(style&FXTableItem::BEFORE){ tx=x+w-mr-tw; ix=tx-iw-s; }
+    else if(style&FXTableItem::AFTER){ ix=x+w-mr-iw; tx=ix-tw-s; }
+    else{ ix=x+w-mr-iw; tx=x+w-mr-tw; }
+    }
+  else{
+    if(style&FXTableItem::BEFORE){ ix=x+(ml+w-mr)/2-(tw+iw+s)/2; tx=ix+iw+s; }
+    else if(style&FXTableItem::AFTER){ tx=x+(ml+w-mr)/2-(tw+iw+s)/2; ix=tx+tw+s; }
+    else{ ix=x+(ml+w-mr)/2-iw/2; tx=x+(ml+w-mr)/2-tw/2; }
+    }
+
+  // Fix y coordinate
+  if(style&FXTableItem::TOP){
+    if(style&FXTableItem::ABOVE){ iy=y+mt; ty=iy+ih; }
+    else if(style&FXTableItem::BELOW){ ty=y+mt; iy=ty+th; }
+    else{ iy=y+mt; ty=y+mt; }
+    }
+  else if(style&FXTableItem::BOTTOM){
+    if(style&FXTableItem::ABOVE){ ty=y+h-mb-th; iy=ty-ih; }
+    else if(style&FXTableItem::BELOW){ iy=y+h-mb-ih; ty=iy-th; }
+    else{ iy=y+h-mb-ih; ty=y+h-mb-th; }
+    }
+  else{
+    if(style&FXTableItem::ABOVE){ iy=y+(mt+h-mb)/2-(th+ih)/2; ty=iy+ih; }
+    else if(style&FXTableItem::BELOW){ ty=y+(mt+h-mb)/2-(th+ih)/2; iy=ty+th; }
+    else{ iy=y+(mt+h-mb)/2-ih/2; ty=y+(mt+h-mb)/2-th/2; }
+    }
+
+  // Paint icon
+  if(cell.icon){
+    dc.drawIcon(cell.icon,ix,iy);
+    }
+
+  // Draw text
+  dc.setForeground(selected ? seltextColor : textColor);
+  yy=ty+font->getFontAscent();
+  beg=0;
+  do{
+    end=beg;
+    while(end<lbl.length() && lbl[end]!='\n') end++;
+    if(style&FXTableItem::LEFT) xx=tx;
+    else if(style&FXTableItem::RIGHT) xx=tx+tw-font->getTextWidth(&lbl[beg],end-beg);
+    else xx=tx+(tw-font->getTextWidth(&lbl[beg],end-beg))/2;
+    dc.drawText(xx,yy,&lbl[beg],end-beg);
+    yy+=font->getFontHeight();
+    beg=end+1;
+    }
+  while(end<lbl.length());
+
+  // Borders
+  if(style&(FXTableItem::LBORDER|FXTableItem::RBORDER|FXTableItem::TBORDER|FXTableItem::BBORDER)){
+    bb=cellBorderWidth;
+    dc.setForeground(cellBorderColor);
+    if(style&FXTableItem::LBORDER) dc.fillRectangle(x,y,bb,h+hgrid);
+    if(style&FXTableItem::RBORDER) dc.fillRectangle(x+w+vgrid-bb,y,bb,h+hgrid);
+    if(style&FXTableItem::TBORDER) dc.fillRectangle(x,y,w+vgrid,bb);
+    if(style&FXTableItem::BBORDER) dc.fillRectangle(x,y+h+hgrid-bb,w+vgrid,bb);
+    }
+
+  // Focus on current cell
+  if(hasFocus() && row==current.row && col==current.col){
+    dc.drawFocusRectangle(x+2,y+2,w+vgrid-4,h+hgrid-4);
+    }
+  }
+
+
+// Draw row label, like a raised header button
+void FXVirtualTable::drawRowLabel(FXDC& dc,const Cell& cell,FXint y,FXint h){
+  FXint vy=getVisibleY();
+  dc.setClipRectangle(FXRectangle(0,y,rowLabelWidth,h)*FXRectangle(0,vy,rowLabelWidth,getVisibleHeight()));
+  dc.setForeground(baseColor);
+  dc.fillRectangle(0,y,rowLabelWidth,h);
+  dc.setForeground(hiliteColor);
+  dc.fillRectangle(0,y,rowLabelWidth,1);
+  dc.fillRectangle(0,y,1,h);
+  dc.setForeground(shadowColor);
+  dc.fillRectangle(0,y+h-1,rowLabelWidth,1);
+  dc.fillRectangle(rowLabelWidth-1,y,1,h);
+  dc.setForeground(textColor);
+  dc.drawText(rowLabelWidth-marginright-font->getTextWidth(cell.text),y+(h-font->getFontHeight())/2+font->getFontAscent(),cell.text);
+  }
+
+
+// Draw exposed part of table
+long FXVirtualTable::onPaint(FXObject*,FXSelector,void* ptr){
+  FXEvent* event=(FXEvent*)ptr;
+  FXDCWindow dc(this,event);
+  FXint vx=getVisibleX();
+  FXint vy=getVisibleY();
+  FXint vw=getVisibleWidth();
+  FXint vh=getVisibleHeight();
+  FXint tablew=vx,tableh,fr,lr,fc,lc,r,c,xl,xr,yt,yb,x;
+  const Cell* cell;
+
+  // Set font
+  dc.setFont(font);
+
+  // Right and bottom edges of table
+  if(0<ncols) tablew=getColumnX(ncols-1)+colHeader->getItemSize(ncols-1)+vgrid;
+  tableh=(FXint)FXMIN(getRowY(nrows)+hgrid,height);
+
+  // Fill background right and below the table
+  dc.setForeground(backColor);
+  dc.fillRectangle(tablew,0,width-tablew,height);
+  dc.fillRectangle(0,tableh,tablew,height-tableh);
+
+  // Corner above row labels
+  if(rowLabelWidth){
+    dc.setForeground(baseColor);
+    dc.fillRectangle(0,0,rowLabelWidth,vy);
+    }
+
+  // Range of rows and columns to be drawn; back up by one for
+  // cell borders which overlap the grid lines
+  if(0<nrows && 0<ncols){
+    fr=FXMAX(rowAtY(FXMAX(event->rect.y,vy))-1,0);
+    lr=FXMIN(rowAtY(FXMIN(event->rect.y+event->rect.h,vy+vh)-1),nrows-1);
+    fc=FXMAX(colAtX(FXMAX(event->rect.x,vx))-1,0);
+    lc=FXMIN(colAtX(event->rect.x+event->rect.w-1),ncols-1);
+    if(fr<=lr && fc<=lc){
+
+      // Bounds of range
+      xl=getColumnX(fc);
+      xr=getColumnX(lc)+colHeader->getItemSize(lc);
+      yt=(FXint)getRowY(fr);
+      yb=(FXint)getRowY(lr+1);
+
+      // Grid lines
+      dc.setClipRectangle(vx,vy,vw,vh);
+      dc.setForeground(gridColor);
+      if(hgrid){
+        for(r=fr; r<=lr+1; ++r){
+          dc.fillRectangle(xl,(FXint)getRowY(r),xr-xl+vgrid,1);
+          }
+        }
+      if(vgrid){
+        for(c=fc; c<=lc; ++c){
+          dc.fillRectangle(getColumnX(c),yt,1,yb-yt+hgrid);
+          }
+        dc.fillRectangle(xr,yt,1,yb-yt+hgrid);
+        }
+
+      // Cells
+      for(r=fr; r<=lr; ++r){
+        cell=getCachedRow(r);
+        yt=(FXint)getRowY(r);
+        for(c=fc; c<=lc; ++c){
+          x=getColumnX(c);
+          drawCell(dc,cell[c],r,c,x,yt,colHeader->getItemSize(c),rowHeight);
+          }
+        if(rowLabelWidth){
+          drawRowLabel(dc,cell[ncols],yt,rowHeight+hgrid);
+          }
+        }
+      }
+    }
+  return 1;
+  }
+
+/*******************************************************************************/
+
+// Move current cell, extending selection if shift is held
+void FXVirtualTable::moveTo(FXint row,FXint col,FXuint state){
+  if(0<nrows && 0<ncols){
+    row=FXCLAMP(0,row,nrows-1);
+    col=FXCLAMP(0,col,ncols-1);
+    if(state&SHIFTMASK){
+      if(anchor.row<0 || anchor.col<0){
+        setAnchorItem(0<=current.row ? current.row : row,0<=current.col ? current.col : col);
+        }
+      setCurrentItem(row,col,true);
+      extendSelection(row,col,true);
+      }
+    else{
+      killSelection(true);
+      setCurrentItem(row,col,true);
+      setAnchorItem(row,col);
+      }
+    makePositionVisible(row,col);
+    }
+  }
+
+
+// Key Press
+long FXVirtualTable::onKeyPress(FXObject*,FXSelector,void* ptr){
+  FXEvent* event=(FXEvent*)ptr;
+  FXint page=FXMAX(getVisibleHeight()/rowHeight-1,1);
+  flags&=~FLAG_TIP;
+  if(!isEnabled()) return 0;
+  if(target && target->tryHandle(this,FXSEL(SEL_KEYPRESS,message),ptr)) return 1;
+  switch(event->code){
+    case KEY_Control_L:
+    case KEY_Control_R:
+    case KEY_Shift_L:
+    case KEY_Shift_R:
+    case KEY_Alt_L:
+    case KEY_Alt_R:
+      return 1;
+    case KEY_Home:
+    case KEY_KP_Home:
+      if(event->state&CONTROLMASK)
+        moveTo(0,current.col,event->state);
+      else
+        moveTo(current.row,0,event->state);
+      return 1;
+    case KEY_End:
+    case KEY_KP_End:
+      if(event->state&CONTROLMASK)
+        moveTo(nrows-1,current.col,event->state);
+      else
+        moveTo(current.row,ncols-1,event->state);
+      return 1;
+    case KEY_Page_Up:
+    case KEY_KP_Page_Up:
+      moveTo(current.row-page,current.col,event->state);
+      return 1;
+    case KEY_Page_Down:
+    case KEY_KP_Page_Down:
+      moveTo(current.row+page,current.col,event->state);
+      return 1;
+    case KEY_Up:
+    case KEY_KP_Up:
+      moveTo(current.row-1,current.col,event->state);
+      return 1;
+    case KEY_Down:
+    case KEY_KP_Down:
+      moveTo(current.row+1,current.col,event->state);
+      return 1;
+    case KEY_Left:
+    case KEY_KP_Left:
+      moveTo(current.row,current.col-1,event->state);
+      return 1;
+    case KEY_Right:
+    case KEY_KP_Right:
+      moveTo(current.row,current.col+1,event->state);
+      return 1;
+    case KEY_Tab:
+      if(event->state&SHIFTMASK)
+        moveTo(current.row,current.col-1,0);
+      else
+        moveTo(current.row,current.col+1,0);
+      return 1;
+    case KEY_ISO_Left_Tab:
+      moveTo(current.row,current.col-1,0);
+      return 1;
+    case KEY_Return:
+    case KEY_KP_Enter:
+      handle(this,FXSEL(SEL_DOUBLECLICKED,0),(void*)&current);
+      if(0<=current.row && 0<=current.col){
+        handle(this,FXSEL(SEL_COMMAND,0),(void*)&current);
+        }
+      return 1;
+    case KEY_a:
+      if(!(event->state&CONTROLMASK)) return 0;
+      handle(this,FXSEL(SEL_COMMAND,ID_SELECT_ALL),nullptr);
+      return 1;
+    }
+  return 0;
+  }
+
+
+// Key Release
+long FXVirtualTable::onKeyRelease(FXObject*,FXSelector,void* ptr){
+  FXEvent* event=(FXEvent*)ptr;
+  if(!isEnabled()) return 0;
+  flags|=FLAG_UPDATE;
+  if(target && target->tryHandle(this,FXSEL(SEL_KEYRELEASE,message),ptr)) return 1;
+  switch(event->code){
+    case KEY_Control_L:
+    case KEY_Control_R:
+    case KEY_Shift_L:
+    case KEY_Shift_R:
+    case KEY_Alt_L:
+    case KEY_Alt_R:
+    case KEY_Home:
+    case KEY_KP_Home:
+    case KEY_End:
+    case KEY_KP_End:
+    case KEY_Page_Up:
+    case KEY_KP_Page_Up:
+    case KEY_Page_Down:
+    case KEY_KP_Page_Down:
+    case KEY_Left:
+    case KEY_KP_Left:
+    case KEY_Right:
+    case KEY_KP_Right:
+    case KEY_Up:
+    case KEY_KP_Up:
+    case KEY_Down:
+    case KEY_KP_Down:
+    case KEY_Tab:
+    case KEY_ISO_Left_Tab:
+    case KEY_Return:
+    case KEY_KP_Enter:
+      return 1;
+    case KEY_a:
+      if(event->state&CONTROLMASK) return 1;
+      return 0;
+    }
+  return 0;
+  }
+
+
+// Gained focus
+long FXVirtualTable::onFocusIn(FXObject* sender,FXSelector sel,void* ptr){
+  FXScrollArea::onFocusIn(sender,sel,ptr);
+  if(0<=current.row && 0<=current.col){
+    updateItem(current.row,current.col);
+    }
+  return 1;
+  }
+
+
+// Lost focus
+long FXVirtualTable::onFocusOut(FXObject* sender,FXSelector sel,void* ptr){
+  FXScrollArea::onFocusOut(sender,sel,ptr);
+  if(0<=current.row && 0<=current.col){
+    updateItem(current.row,current.col);
+    }
+  return 1;
+  }
+
+
+// We were asked about status text
+long FXVirtualTable::onQueryHelp(FXObject* sender,FXSelector sel,void* ptr){
+  if(FXScrollArea::onQueryHelp(sender,sel,ptr)) return 1;
+  if((flags&FLAG_HELP) && !help.empty()){
+    sender->handle(this,FXSEL(SEL_COMMAND,ID_SETSTRINGVALUE),(void*)&help);
+    return 1;
+    }
+  return 0;
+  }
+
+
+// Automatic scroll
+long FXVirtualTable::onAutoScroll(FXObject* sender,FXSelector sel,void* ptr){
+  FXEvent* event=(FXEvent*)ptr;
+  FXScrollArea::onAutoScroll(sender,sel,ptr);
+  if(mode==MOUSE_SELECT && 0<nrows && 0<ncols){
+    FXint r=FXCLAMP(0,rowAtY(event->win_y),nrows-1);
+    FXint c=FXCLAMP(0,colAtX(event->win_x),ncols-1);
+    if(current.row!=r || current.col!=c){
+      extendSelection(r,c,true);
+      setCurrentItem(r,c,true);
+      }
+    }
+  return 1;
+  }
+
+
+// Mouse moved
+long FXVirtualTable::onMotion(FXObject*,FXSelector,void* ptr){
+  FXEvent* event=(FXEvent*)ptr;
+  FXint r,c;
+  if(isEnabled()){
+    switch(mode){
+      case MOUSE_NONE:
+        return 0;
+      case MOUSE_SCROLL:
+        setPosition(event->win_x-grabx,event->win_y-graby);
+        return 1;
+      case MOUSE_SELECT:
+        if(startAutoScroll(event,false)) return 1;
+        if(0<nrows && 0<ncols){
+          r=FXCLAMP(0,rowAtY(event->win_y),nrows-1);
+          c=FXCLAMP(0,colAtX(event->win_x),ncols-1);
+          if(current.row!=r || current.col!=c){
+            extendSelection(r,c,true);
+            setCurrentItem(r,c,true);
+            }
+          }
+        return 1;
+      }
+    }
+  return 0;
+  }
+
+
+// Pressed button
+long FXVirtualTable::onLeftBtnPress(FXObject*,FXSelector,void* ptr){
+  FXEvent* event=(FXEvent*)ptr;
+  FXint r,c;
+  handle(this,FXSEL(SEL_FOCUS_SELF,0),ptr);
+  if(isEnabled()){
+    grab();
+    if(target && target->tryHandle(this,FXSEL(SEL_LEFTBUTTONPRESS,message),ptr)) return 1;
+
+    // Cell being clicked on
+    r=rowAtY(event->win_y);
+    c=colAtX(event->win_x);
+
+    // Outside table
+    if(r<0 || r>=nrows || c<0 || c>=ncols || event->win_x<getVisibleX()){
+      return 1;
+      }
+
+    // Change current item
+    setCurrentItem(r,c,true);
+
+    // Select or extend
+    if(event->state&SHIFTMASK){
+      if(anchor.row<0 || anchor.col<0) setAnchorItem(r,c);
+      extendSelection(r,c,true);
+      }
+    else{
+      killSelection(true);
+      setAnchorItem(r,c);
+      extendSelection(r,c,true);
+      }
+    mode=MOUSE_SELECT;
+    flags&=~FLAG_UPDATE;
+    flags|=FLAG_PRESSED;
+    return 1;
+    }
+  return 0;
+  }
+
+
+// Released button
+long FXVirtualTable::onLeftBtnRelease(FXObject*,FXSelector,void* ptr){
+  FXEvent* event=(FXEvent*)ptr;
+  if(isEnabled()){
+    ungrab();
+    flags&=~FLAG_PRESSED;
+    flags|=FLAG_UPDATE;
+    mode=MOUSE_NONE;
+    stopAutoScroll();
+    if(target && target->tryHandle(this,FXSEL(SEL_LEFTBUTTONRELEASE,message),ptr)) return 1;
+
+    // Scroll to make item visible
+    makePositionVisible(current.row,current.col);
+
+    // Generate clicked callbacks
+    if(event->click_count==1){
+      handle(this,FXSEL(SEL_CLICKED,0),(void*)&current);
+      }
+    else if(event->click_count==2){
+      handle(this,FXSEL(SEL_DOUBLECLICKED,0),(void*)&current);
+      }
+    else if(event->click_count==3){
+      handle(this,FXSEL(SEL_TRIPLECLICKED,0),(void*)&current);
+      }
+
+    // Command callback only when clicked on item
+    if(0<=current.row && 0<=current.col){
+      handle(this,FXSEL(SEL_COMMAND,0),(void*)&current);
+      }
+    return 1;
+    }
+  return 0;
+  }
+
+
+// Pressed right button
+long FXVirtualTable::onRightBtnPress(FXObject*,FXSelector,void* ptr){
+  FXEvent* event=(FXEvent*)ptr;
+  handle(this,FXSEL(SEL_FOCUS_SELF,0),ptr);
+  if(isEnabled()){
+    grab();
+    if(target && target->tryHandle(this,FXSEL(SEL_RIGHTBUTTONPRESS,message),ptr)) return 1;
+    flags&=~FLAG_UPDATE;
+    flags|=FLAG_PRESSED;
+    grabx=event->win_x-pos_x;
+    graby=event->win_y-pos_y;
+    mode=MOUSE_SCROLL;
+    return 1;
+    }
+  return 0;
+  }
+
+
+// Released right button
+long FXVirtualTable::onRightBtnRelease(FXObject*,FXSelector,void* ptr){
+  if(isEnabled()){
+    ungrab();
+    flags&=~FLAG_PRESSED;
+    flags|=FLAG_UPDATE;
+    mode=MOUSE_NONE;
+    if(target && target->tryHandle(this,FXSEL(SEL_RIGHTBUTTONRELEASE,message),ptr)) return 1;
+    return 1;
+    }
+  return 0;
+  }
+
+
+// The widget lost the grab for some reason
+long FXVirtualTable::onUngrabbed(FXObject* sender,FXSelector sel,void* ptr){
+  FXScrollArea::onUngrabbed(sender,sel,ptr);
+  flags&=~(FLAG_DODRAG|FLAG_TRYDRAG|FLAG_PRESSED|FLAG_CHANGED|FLAG_SCROLLING);
+  flags|=FLAG_UPDATE;
+  mode=MOUSE_NONE;
+  stopAutoScroll();
+  return 1;
+  }
+
+
+// Command message
+long FXVirtualTable::onCommand(FXObject*,FXSelector,void* ptr){
+  return target && target->tryHandle(this,FXSEL(SEL_COMMAND,message),ptr);
+  }
+
+
+// Clicked in table
+long FXVirtualTable::onClicked(FXObject*,FXSelector,void* ptr){
+  return target && target->tryHandle(this,FXSEL(SEL_CLICKED,message),ptr);
+  }
+
+
+// Double clicked in table
+long FXVirtualTable::onDoubleClicked(FXObject*,FXSelector,void* ptr){
+  return target && target->tryHandle(this,FXSEL(SEL_DOUBLECLICKED,message),ptr);
+  }
+
+
+// Triple clicked in table
+long FXVirtualTable::onTripleClicked(FXObject*,FXSelector,void* ptr){
+  return target && target->tryHandle(this,FXSEL(SEL_TRIPLECLICKED,message),ptr);
+  }
+
+
+// Select column with index
+long FXVirtualTable::onCmdSelectColumnIndex(FXObject*,FXSelector,void* ptr){
+  if(!(options&TABLE_NO_COLSELECT)){
+    selectRange(0,nrows-1,(FXint)(FXival)ptr,(FXint)(FXival)ptr,true);
+    }
+  return 1;
+  }
+
+
+// Select all cells
+long FXVirtualTable::onCmdSelectAll(FXObject*,FXSelector,void*){
+  setAnchorItem(0,0);
+  extendSelection(nrows-1,ncols-1,true);
+  return 1;
+  }
+
+
+// Deselect all cells
+long FXVirtualTable::onCmdDeselectAll(FXObject*,FXSelector,void*){
+  killSelection(true);
+  return 1;
+  }
+
+/*******************************************************************************/
+
+// Change column caption
+void FXVirtualTable::setColumnText(FXint col,const FXString& text){
+  colHeader->setItemText(col,text);
+  }
+
+
+// Return column caption
+FXString FXVirtualTable::getColumnText(FXint col) const {
+  return colHeader->getItemText(col);
+  }
+
+
+// Change column width
+void FXVirtualTable::setColumnWidth(FXint col,FXint cwidth){
+  if(colHeader->getItemSize(col)!=cwidth){
+    colHeader->setItemSize(col,cwidth);
+    update();
+    }
+  }
+
+
+// Return column width
+FXint FXVirtualTable::getColumnWidth(FXint col) const {
+  return colHeader->getItemSize(col);
+  }
+
+
+// Change height of all rows, keeping the top row in place
+void FXVirtualTable::setRowHeight(FXint rheight){
+  if(rheight<1) rheight=1;
+  if(rowHeight!=rheight){
+    offset=offset/rowHeight*rheight;
+    rowHeight=rheight;
+    recalc();
+    update();
+    }
+  }
+
+
+// Change width of row labels
+void FXVirtualTable::setRowLabelWidth(FXint lwidth){
+  if(lwidth<0) lwidth=0;
+  if(rowLabelWidth!=lwidth){
+    if(!rowLabelWidth) contentsChanged();
+    rowLabelWidth=lwidth;
+    recalc();
+    update();
+    }
+  }
+
+
+// Change visible rows
+void FXVirtualTable::setVisibleRows(FXint nvrows){
+  if(nvrows<0) nvrows=0;
+  if(visiblerows!=nvrows){
+    visiblerows=nvrows;
+    recalc();
+    }
+  }
+
+
+// Change visible columns
+void FXVirtualTable::setVisibleColumns(FXint nvcols){
+  if(nvcols<0) nvcols=0;
+  if(visiblecols!=nvcols){
+    visiblecols=nvcols;
+    recalc();
+    }
+  }
+
+
+// Change table style
+void FXVirtualTable::setTableStyle(FXuint style){
+  FXuint opts=((style^options)&TABLE_MASK)^options;
+  FXuint hs;
+  if(opts!=options){
+    hs=HEADER_HORIZONTAL|HEADER_TRACKING|HEADER_BUTTON;
+    if(opts&TABLE_COL_SIZABLE) hs|=HEADER_RESIZE;
+    if(opts&TABLE_NO_COLSELECT) hs&=~HEADER_BUTTON;
+    colHeader->setHeaderStyle(hs);
+    options=opts;
+    }
+  }
+
+
+// Get table style
+FXuint FXVirtualTable::getTableStyle() const {
+  return (options&TABLE_MASK);
+  }
+
+
+// Change font
+void FXVirtualTable::setFont(FXFont* fnt){
+  if(!fnt){ fxerror("%s::setFont: NULL font specified.\n",getClassName()); }
+  if(font!=fnt){
+    font=fnt;
+    recalc();
+    update();
+    }
+  }
+
+
+// Change top margin
+void FXVirtualTable::setMarginTop(FXint mt){
+  if(margintop!=mt){
+    margintop=mt;
+    update();
+    }
+  }
+
+
+// Change bottom margin
+void FXVirtualTable::setMarginBottom(FXint mb){
+  if(marginbottom!=mb){
+    marginbottom=mb;
+    update();
+    }
+  }
+
+
+// Change left margin
+void FXVirtualTable::setMarginLeft(FXint ml){
+  if(marginleft!=ml){
+    marginleft=ml;
+    update();
+    }
+  }
+
+
+// Change right margin
+void FXVirtualTable::setMarginRight(FXint mr){
+  if(marginright!=mr){
+    marginright=mr;
+    update();
+    }
+  }
+
+
+// Show or hide horizontal grid
+void FXVirtualTable::showHorzGrid(FXbool on){
+  if(hgrid!=on){
+    hgrid=on;
+    recalc();
+    }
+  }
+
+
+// Show or hide vertical grid
+void FXVirtualTable::showVertGrid(FXbool on){
+  if(vgrid!=on){
+    vgrid=on;
+    recalc();
+    }
+  }
+
+
+// Set text color
+void FXVirtualTable::setTextColor(FXColor clr){
+  if(clr!=textColor){
+    textColor=clr;
+    update();
+    }
+  }
+
+
+// Set base color
+void FXVirtualTable::setBaseColor(FXColor clr){
+  if(clr!=baseColor){
+    baseColor=clr;
+    update();
+    }
+  }
+
+
+// Set highlight color
+void FXVirtualTable::setHiliteColor(FXColor clr){
+  if(clr!=hiliteColor){
+    hiliteColor=clr;
+    update();
+    }
+  }
+
+
+// Set shadow color
+void FXVirtualTable::setShadowColor(FXColor clr){
+  if(clr!=shadowColor){
+    shadowColor=clr;
+    update();
+    }
+  }
+
+
+// Set select background color
+void FXVirtualTable::setSelBackColor(FXColor clr){
+  if(clr!=selbackColor){
+    selbackColor=clr;
+    update();
+    }
+  }
+
+
+// Set selected text color
+void FXVirtualTable::setSelTextColor(FXColor clr){
+  if(clr!=seltextColor){
+    seltextColor=clr;
+    update();
+    }
+  }
+
+
+// Change grid color
+void FXVirtualTable::setGridColor(FXColor clr){
+  if(clr!=gridColor){
+    gridColor=clr;
+    update();
+    }
+  }
+
+
+// Change stipple color
+void FXVirtualTable::setStippleColor(FXColor clr){
+  if(clr!=stippleColor){
+    stippleColor=clr;
+    update();
+    }
+  }
+
+
+// Change cell border color
+void FXVirtualTable::setCellBorderColor(FXColor clr){
+  if(clr!=cellBorderColor){
+    cellBorderColor=clr;
+    update();
+    }
+  }
+
+
+// Set cell color
+void FXVirtualTable::setCellColor(FXint row,FXint col,FXColor clr){
+  if(clr!=cellBackColor[row&1][col&1]){
+    cellBackColor[row&1][col&1]=clr;
+    update();
+    }
+  }
+
+
+// Get cell color
+FXColor FXVirtualTable::getCellColor(FXint row,FXint col) const {
+  return cellBackColor[row&1][col&1];
+  }
+
+
+// Change cell border width
+void FXVirtualTable::setCellBorderWidth(FXint borderwidth){
+  if(borderwidth!=cellBorderWidth){
+    cellBorderWidth=borderwidth;
+    update();
+    }
+  }
+
+
+// Save data
+void FXVirtualTable::save(FXStream& store) const {
+  FXScrollArea::save(store);
+  store << colHeader;
+  store << nrows;
+  store << ncols;
+  store << rowHeight;
+  store << rowLabelWidth;
+  store << visiblerows;
+  store << visiblecols;
+  store << margintop;
+  store << marginbottom;
+  store << marginleft;
+  store << marginright;
+  store << textColor;
+  store << baseColor;
+  store << hiliteColor;
+  store << shadowColor;
+  store << selbackColor;
+  store << seltextColor;
+  store << gridColor;
+  store << stippleColor;
+  store << cellBorderColor;
+  store << cellBorderWidth;
+  store << cellBackColor[0][0];
+  store << cellBackColor[0][1];
+  store << cellBackColor[1][0];
+  store << cellBackColor[1][1];
+  store << font;
+  store << help;
+  }
+
+
+// Load data
+void FXVirtualTable::load(FXStream& store){
+  FXScrollArea::load(store);
+  store >> colHeader;
+  store >> nrows;
+  store >> ncols;
+  store >> rowHeight;
+  store >> rowLabelWidth;
+  store >> visiblerows;
+  store >> visiblecols;
+  store >> margintop;
+  store >> marginbottom;
+  store >> marginleft;
+  store >> marginright;
+  store >> textColor;
+  store >> baseColor;
+  store >> hiliteColor;
+  store >> shadowColor;
+  store >> selbackColor;
+  store >> seltextColor;
+  store >> gridColor;
+  store >> stippleColor;
+  store >> cellBorderColor;
+  store >> cellBorderWidth;
+  store >> cellBackColor[0][0];
+  store >> cellBackColor[0][1];
+  store >> cellBackColor[1][0];
+  store >> cellBackColor[1][1];
+  store >> font;
+  store >> help;
+  resizeCache(MINCACHESIZE);
+  }
+
+
+// Clean up
+FXVirtualTable::~FXVirtualTable(){
+  delete [] cells;
+  freeElms(cachedrows);
+  font=(FXFont*)-1L;
+  cells=(Cell*)-1L;
+  cachedrows=(FXint*)-1L;
+  colHeader=(FXHeader*)-1L;
+  provider=(FXTableProvider*)-1L;
+  }
+
+}
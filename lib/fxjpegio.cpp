@@ -27,6 +27,7 @@
 #include "FXHash.h"
 #include "FXElement.h"
 #include "FXStream.h"
+#include "FXImageReader.h"
 #ifdef HAVE_JPEG_H
 #include <setjmp.h>
 #undef FAR
@@ -65,6 +66,13 @@ typedef int INT32;
   - Compression rationale for optimize_coding=true flag:
 
      https://github.com/bither/bither-android-lib/blob/master/REASON.md
+
+  - When loading scaled, libjpeg is asked to scale by 1/2, 1/4, or 1/8 when
+    doing so still leaves the image at least size pixels in its largest
+    dimension.  The scaling is done in the inverse DCT, which then has less
+    work to do, and the color conversion and upsampling after it too; so
+    a thumbnail of a big photo loads many times faster than the full image.
+    The caller scales what comes back the rest of the way.
 */
 
 #define JPEG_BUFFER_SIZE 4096
@@ -80,6 +88,7 @@ namespace FX {
 #ifndef FXLOADJPG
 extern FXAPI FXbool fxcheckJPG(FXStream& store);
 extern FXAPI FXbool fxloadJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint& quality);
+extern FXAPI FXbool fxloadScaledJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint& quality,FXint size);
 extern FXAPI FXbool fxsaveJPG(FXStream& store,const FXColor* data,FXint width,FXint height,FXint quality);
 #endif
 
@@ -167,6 +176,77 @@ static void term_source(j_decompress_ptr){
   }
 
 
+// Set up source manager reading from store
+static void setSource(jpeg_decompress_struct& srcinfo,FOX_jpeg_source_mgr& src,FXStream& store){
+  src.pub.init_source=init_source;
+  src.pub.fill_input_buffer=fill_input_buffer;
+  src.pub.resync_to_restart=jpeg_resync_to_restart;   // Use the default method
+  src.pub.skip_input_data=skip_input_data;
+  src.pub.term_source=term_source;
+  src.pub.bytes_in_buffer=0;
+  src.pub.next_input_byte=nullptr;
+  src.stream=&store;
+  srcinfo.src=&src.pub;
+  }
+
+
+// Pick output color space, and largest reduction leaving at least size
+// pixels; return false if color space is not supported
+static FXbool setOutput(jpeg_decompress_struct& srcinfo,FXint size){
+  switch (srcinfo.jpeg_color_space) {
+    case JCS_GRAYSCALE: // 1
+    case JCS_RGB:       // 2
+    case JCS_YCbCr:     // 3
+      srcinfo.out_color_space=JCS_RGB;
+      break;
+    case JCS_CMYK:      // 4
+    case JCS_YCCK:      // 5
+      srcinfo.out_color_space=JCS_CMYK;
+      break;
+    default:
+      return false;
+    }
+  if(0<size){
+    srcinfo.scale_num=1;
+    srcinfo.scale_denom=8;
+    while(1<srcinfo.scale_denom && (FXint)(FXMAX(srcinfo.image_width,srcinfo.image_height)/srcinfo.scale_denom)<size){
+      srcinfo.scale_denom>>=1;
+      }
+    }
+  return true;
+  }
+
+
+// Convert row of RGB or CMYK samples to pixels
+static void convertRow(FXColor* pp,const JSAMPLE* qq,FXint width,int color){
+  FXint i;
+  if(color==JCS_RGB){
+    for(i=0; i<width; i++,pp++){
+      ((FXuchar*)pp)[3]=255;
+      ((FXuchar*)pp)[2]=*qq++;
+      ((FXuchar*)pp)[1]=*qq++;
+      ((FXuchar*)pp)[0]=*qq++;
+      }
+    }
+  else{
+    for(i=0; i<width; i++,pp++){
+      ((FXuchar*)pp)[3]=255;
+      if(qq[3]==255){
+        ((FXuchar*)pp)[2]=qq[0];                      // No black
+        ((FXuchar*)pp)[1]=qq[1];
+        ((FXuchar*)pp)[0]=qq[2];
+        }
+      else{
+        ((FXuchar*)pp)[2]=(qq[0]*qq[3])/255;          // Approximated CMYK -> RGB
+        ((FXuchar*)pp)[1]=(qq[1]*qq[3])/255;
+        ((FXuchar*)pp)[0]=(qq[2]*qq[3])/255;
+        }
+      qq+=4;
+      }
+    }
+  }
+
+
 // Check if stream contains a JPG
 FXbool fxcheckJPG(FXStream& store){
   FXuchar signature[3];
@@ -176,15 +256,14 @@ FXbool fxcheckJPG(FXStream& store){
   }
 
 
-// Load a JPEG image
-FXbool fxloadJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint&){
+// Load a JPEG image, reduced by up to 1/8 but no smaller than size
+FXbool fxloadScaledJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint&,FXint size){
   jpeg_decompress_struct srcinfo;
   FOX_jpeg_error_mgr jerr;
   FOX_jpeg_source_mgr src;
   JSAMPLE *buffer[1];
   FXColor *pp;
-  JSAMPLE *qq;
-  int row_stride,color,i;
+  int row_stride,color;
 
   // Null out
   data=nullptr;
@@ -208,35 +287,16 @@ FXbool fxloadJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint
     return false;
     }
 
-  // setup our src manager
-  src.pub.init_source=init_source;
-  src.pub.fill_input_buffer=fill_input_buffer;
-  src.pub.resync_to_restart=jpeg_resync_to_restart;   // Use the default method
-  src.pub.skip_input_data=skip_input_data;
-  src.pub.term_source=term_source;
-  src.pub.bytes_in_buffer=0;
-  src.pub.next_input_byte=nullptr;
-  src.stream=&store;
-
   // Set our src manager
-  srcinfo.src=&src.pub;
+  setSource(srcinfo,src,store);
 
   // read the header from the jpg;
   jpeg_read_header(&srcinfo,TRUE);
 
   // Output format supported by libjpeg
-  switch (srcinfo.jpeg_color_space) {
-    case JCS_GRAYSCALE: // 1
-    case JCS_RGB:       // 2
-    case JCS_YCbCr:     // 3
-      srcinfo.out_color_space=JCS_RGB;
-      break;
-    case JCS_CMYK:      // 4
-    case JCS_YCCK:      // 5
-      srcinfo.out_color_space=JCS_CMYK;
-      break;
-    default:
-      return false;
+  if(!setOutput(srcinfo,size)){
+    jpeg_destroy_decompress(&srcinfo);
+    return false;
     }
 
   jpeg_start_decompress(&srcinfo);
@@ -244,13 +304,13 @@ FXbool fxloadJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint
   row_stride=srcinfo.output_width*srcinfo.output_components;
 
   // Data to receive
-  if(!allocElms(data,srcinfo.image_height*srcinfo.image_width)){
+  if(!allocElms(data,srcinfo.output_height*srcinfo.output_width)){
     jpeg_destroy_decompress(&srcinfo);
     return false;
     }
 
-  height=srcinfo.image_height;
-  width=srcinfo.image_width;
+  height=srcinfo.output_height;
+  width=srcinfo.output_width;
 
   // Sample buffer
   if(!allocElms(buffer[0],row_stride)){
@@ -264,31 +324,8 @@ FXbool fxloadJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint
   color=srcinfo.out_color_space;
   while(srcinfo.output_scanline<srcinfo.output_height){
     jpeg_read_scanlines(&srcinfo,buffer,1);
-    qq=buffer[0];
-    if(color==JCS_RGB){
-      for(i=0; i<width; i++,pp++){
-        ((FXuchar*)pp)[3]=255;
-        ((FXuchar*)pp)[2]=*qq++;
-        ((FXuchar*)pp)[1]=*qq++;
-        ((FXuchar*)pp)[0]=*qq++;
-        }
-      }
-    else{
-      for(i=0; i<width; i++,pp++){
-        ((FXuchar*)pp)[3]=255;
-        if(qq[3]==255){
-          ((FXuchar*)pp)[2]=qq[0];                      // No black
-          ((FXuchar*)pp)[1]=qq[1];
-          ((FXuchar*)pp)[0]=qq[2];
-          }
-        else{
-          ((FXuchar*)pp)[2]=(qq[0]*qq[3])/255;          // Approximated CMYK -> RGB
-          ((FXuchar*)pp)[1]=(qq[1]*qq[3])/255;
-          ((FXuchar*)pp)[0]=(qq[2]*qq[3])/255;
-          }
-        qq+=4;
-        }
-      }
+    convertRow(pp,buffer[0],width,color);
+    pp+=width;
     }
 
   // Clean up
@@ -299,6 +336,122 @@ FXbool fxloadJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint
   }
 
 
+// Load a JPEG image
+FXbool fxloadJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint& quality){
+  return fxloadScaledJPG(store,data,width,height,quality,0);
+  }
+
+/*******************************************************************************/
+
+// JPEG reader state
+// Errors longjmp back into start(), read(), or finish(), which each set
+// up the jump buffer; buffer holds one row of samples.
+struct FXJPGReader::Decoder {
+  jpeg_decompress_struct srcinfo;
+  FOX_jpeg_error_mgr     jerr;
+  FOX_jpeg_source_mgr    src;
+  JSAMPLE               *buffer[1];
+  };
+
+
+// Create JPEG reader
+FXJPGReader::FXJPGReader(FXint sz):decoder(nullptr),size(sz){
+  }
+
+
+// Start reading JPEG image
+FXbool FXJPGReader::start(FXStream& str){
+  delete decoder;
+  decoder=nullptr;
+  store=nullptr;
+  width=height=row=0;
+  if(str.direction()==FXStreamLoad){
+    decoder=new Decoder;
+    memset(&decoder->srcinfo,0,sizeof(decoder->srcinfo));
+    decoder->buffer[0]=nullptr;
+    jpeg_create_decompress(&decoder->srcinfo);
+    decoder->srcinfo.err=jpeg_std_error(&decoder->jerr.error_mgr);
+    decoder->jerr.error_mgr.error_exit=fatal_error;
+    if(setjmp(decoder->jerr.jmpbuf)){
+      freeElms(decoder->buffer[0]);
+      jpeg_destroy_decompress(&decoder->srcinfo);
+      delete decoder;
+      decoder=nullptr;
+      return false;
+      }
+    setSource(decoder->srcinfo,decoder->src,str);
+    jpeg_read_header(&decoder->srcinfo,TRUE);
+    if(setOutput(decoder->srcinfo,size)){
+      jpeg_start_decompress(&decoder->srcinfo);
+      if(allocElms(decoder->buffer[0],decoder->srcinfo.output_width*decoder->srcinfo.output_components)){
+        store=&str;
+        width=decoder->srcinfo.output_width;
+        height=decoder->srcinfo.output_height;
+        return true;
+        }
+      }
+    jpeg_destroy_decompress(&decoder->srcinfo);
+    delete decoder;
+    decoder=nullptr;
+    }
+  return false;
+  }
+
+
+// Read up to n rows
+FXint FXJPGReader::read(FXColor* buffer,FXint n,FXint stride){
+  volatile FXint count=0;
+  if(decoder){
+    if(setjmp(decoder->jerr.jmpbuf)){
+      row=height;
+      return count;
+      }
+    while(count<n && row<height){
+      jpeg_read_scanlines(&decoder->srcinfo,decoder->buffer,1);
+      convertRow(buffer+(FXival)count*stride,decoder->buffer[0],width,decoder->srcinfo.out_color_space);
+      count=count+1;
+      ++row;
+      }
+    }
+  return count;
+  }
+
+
+// Finish reading JPEG image
+// Rows left unread are decoded and dropped, to get to the end of the image.
+FXbool FXJPGReader::finish(){
+  FXbool result=false;
+  if(decoder){
+    if(setjmp(decoder->jerr.jmpbuf)){
+      result=false;
+      }
+    else{
+      while(decoder->srcinfo.output_scanline<decoder->srcinfo.output_height){
+        jpeg_read_scanlines(&decoder->srcinfo,decoder->buffer,1);
+        }
+      jpeg_finish_decompress(&decoder->srcinfo);
+      result=true;
+      }
+    freeElms(decoder->buffer[0]);
+    jpeg_destroy_decompress(&decoder->srcinfo);
+    delete decoder;
+    decoder=nullptr;
+    store=nullptr;
+    }
+  return result;
+  }
+
+
+// Destroy JPEG reader
+FXJPGReader::~FXJPGReader(){
+  if(decoder){
+    freeElms(decoder->buffer[0]);
+    jpeg_destroy_decompress(&decoder->srcinfo);
+    delete decoder;
+    }
+  }
+
+
 /*******************************************************************************/
 
 
@@ -437,6 +590,40 @@ FXbool fxloadJPG(FXStream&,FXColor*& data,FXint& width,FXint& height,FXint& qual
   }
 
 
+// Stub routine
+FXbool fxloadScaledJPG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint& quality,FXint){
+  return fxloadJPG(store,data,width,height,quality);
+  }
+
+
+// Stub JPEG reader
+FXJPGReader::FXJPGReader(FXint sz):decoder(nullptr),size(sz){
+  }
+
+
+// Stub routine
+FXbool FXJPGReader::start(FXStream&){
+  return false;
+  }
+
+
+// Stub routine
+FXint FXJPGReader::read(FXColor*,FXint,FXint){
+  return 0;
+  }
+
+
+// Stub routine
+FXbool FXJPGReader::finish(){
+  return false;
+  }
+
+
+// Stub JPEG reader
+FXJPGReader::~FXJPGReader(){
+  }
+
+
 // Stub routine
 FXbool fxsaveJPG(FXStream&,const FXColor*,FXint,FXint,FXint){
   return false;
@@ -24,15 +24,28 @@
 #include "fxcrc.h"
 #include "fxmath.h"
 #include "fxendian.h"
+#include "fxcpuid.h"
 #include "FXElement.h"
+#include "FXArray.h"
 #include "FXMetaClass.h"
 #include "FXHash.h"
 #include "FXStream.h"
+#include "FXPtrList.h"
+#include "FXAtomic.h"
+#include "FXSpinLock.h"
+#include "FXSemaphore.h"
+#include "FXCompletion.h"
 #include "FXRunnable.h"
 #include "FXAutoThreadStorageKey.h"
 #include "FXThread.h"
+#include "FXLFQueue.h"
+#include "FXThreadPool.h"
+#include "FXTaskGroup.h"
+#include "FXParallel.h"
 #include "FXPerformance.h"
 #include "FXPNGImage.h"
+#include "FXImageReader.h"
+#include "fxpngpriv.h"
 
 #ifdef HAVE_ZLIB_H
 #include <zlib.h>
@@ -85,6 +98,23 @@
                         lower, to 4-, 2-, or 1-bit per pixel, depending
                         on how many colors are in image.
 
+    Writing in parallel:
+
+      PNG_PARALLEL      Filter and compress strips of the image at the
+                        same time, on the thread pool of the calling
+                        thread; if there is none, or the image is small,
+                        this flag is ignored.
+
+  - With PNG_PARALLEL, the image is cut into strips of about STRIPSIZE bytes
+    of filtered data.  Each strip is filtered on its own, the line above its
+    first row being packed again so filtering is the same as in one pass.
+    Then each strip is deflated as a raw stream, primed with the 32K of data
+    preceding it as a dictionary, and ended with Z_FULL_FLUSH (which aligns
+    to a byte boundary); the last strip with Z_FINISH.  Strung together,
+    behind a zlib header and followed by an Adler-32 combined from those of
+    the strips, they form one valid zlib stream in one IDAT chunk.
+    Cost of this is a few bytes per strip.
+
   - We handle ADAM7 interlaced PNG images, but will only return fully decoded
     images.  Adam7 interlace pattern:
 
@@ -99,6 +129,21 @@
       . . . . . . . . . . .
       . . . . . . . . . . .
 
+  - When decoding, filters are undone, and samples expanded to FXColor, with
+    SSE2, SSSE3, or AVX2 code, as the processor allows [checked at run time].
+    Sub is undone with a prefix sum in each vector; Avg and Paeth a pixel at
+    a time, for pixels of 3 bytes or more.  Samples of 16 bits are narrowed
+    to 8 bits first, and samples of 1, 2, or 4 bits unpacked to bytes first.
+    Passes of interlaced images, which fill every other pixel or so, are
+    still expanded a pixel at a time.
+    The tests mask the processor features the decoder may use, through
+    __pngfeatures() from the private header fxpngpriv.h, to check the older
+    code paths on newer processors.  Each decoder reads the mask once, when
+    it is made.
+
+  - A transparent color from tRNS chunk, for gray or RGB images, is applied
+    after decoding, by clearing alpha of pixels of that color.
+
   - Prior to feeding through Zlib compression library, entropy-reduction
     filter can detect horizontal or vertical gradients, etc., and yield
     markedly better compression ratios.  This make take slightly more
@@ -174,6 +219,16 @@ using namespace FX;
 
 namespace FX {
 
+// Processor features the PNG decoder may use
+static volatile FXuint pngfeatures=~0U;
+
+
+// Limit processor features used by the PNG decoder to mask; for testing only.
+// Return previous mask.
+FXuint __pngfeatures(FXuint mask){
+  return atomicSet(&pngfeatures,mask);
+  }
+
 #ifdef HAVE_ZLIB_H  /////////////////////////////////////////////////////////////
 
 union RGBAPixel {
@@ -329,19 +384,22 @@ public:
   FXuint        intbytes[7];            // Number of bytes for each interlace pass
   FXushort      backcolor[3];           // Background color spec
   FXushort      alfacolor[3];           // Alpha color spec
+  FXbool        hasalfa;                // Have alpha color spec
+  FXuint        features;               // Processor features
 public:
   FXbool header(FXStream& store);
   FXbool palette(FXStream& store,FXuint length);
   FXbool background(FXStream& store,FXuint length);
   FXbool transparency(FXStream& store,FXuint length);
-  void applyTransparency();
+  void applyTransparency(FXColor* pix,FXuval n);
   FXbool decode();
   FXbool data(FXStream& store,FXuint length);
   FXbool end(FXStream& store,FXuint length);
+  FXbool chunks(FXStream& store);
 public:
 
   // Initialize decoder
-  PNGDecoder():image(nullptr),buffer(nullptr),buffersize(0),width(0),height(0),imagetype(Indexed),bitdepth(8),compression(Deflate),filter(FiltNone),interlace(NoInterlace),stride(0),numbytes(0),totbytes(0),ncolormap(0){
+  PNGDecoder():image(nullptr),buffer(nullptr),buffersize(0),width(0),height(0),imagetype(Indexed),bitdepth(8),compression(Deflate),filter(FiltNone),interlace(NoInterlace),stride(0),numbytes(0),totbytes(0),ncolormap(0),hasalfa(false),features(fxCPUFeatures()&pngfeatures){
     backcolor[0]=backcolor[1]=backcolor[2]=0;
     alfacolor[0]=alfacolor[1]=alfacolor[2]=0;
     clearElms(&stream,1);
@@ -628,6 +686,7 @@ FXbool PNGDecoder::transparency(FXStream& store,FXuint length){
     alfacolor[0]=r;
     alfacolor[1]=g;
     alfacolor[2]=b;
+    hasalfa=true;
     FXTRACE((TOPIC_DETAIL,"fxloadPNG: tRNS = (%3u %3u %3u)\n",alfacolor[0],alfacolor[1],alfacolor[2]));
     break;
   case Gray:
@@ -641,6 +700,7 @@ FXbool PNGDecoder::transparency(FXStream& store,FXuint length){
     alfacolor[0]=g;
     alfacolor[1]=g;
     alfacolor[2]=g;
+    hasalfa=true;
     FXTRACE((TOPIC_DETAIL,"fxloadPNG: tRNS = (%3u %3u %3u)\n",alfacolor[0],alfacolor[1],alfacolor[2]));
     break;
   default:
@@ -657,22 +717,621 @@ FXbool PNGDecoder::transparency(FXStream& store,FXuint length){
   }
 
 
+/*******************************************************************************/
+
+// Vector kernels are compiled for their instruction set regardless of compiler
+// flags, and used only when the processor reports it supports them
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && defined(HAVE_IMMINTRIN_H)
+#define PNG_DECODE_KERNELS
+#endif
+
+
+// Pixels expanded at a time from 16-bit or packed samples
+const FXuval CHUNK=256;
+
+
+#if defined(PNG_DECODE_KERNELS)
+
+// Loading 16 bytes at shiftmask+16-k gives shuffle moving bytes up by k
+static const FXuchar shiftmask[32]={
+  0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80,
+  0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15
+  };
+
+
+// Load pixel of 3, 4, 6, or 8 bytes into low bytes of vector; odd sizes are
+// put together in a register, as partial copies through memory would stall
+template<FXuval STEP>
+__attribute__((target("sse2")))
+static inline __m128i loadPixel(const FXuchar* p){
+  FXushort s; FXuint v; FXulong w;
+  switch(STEP){
+    case 3: memcpy(&s,p,2); return _mm_cvtsi32_si128((FXint)(s|((FXuint)p[2]<<16)));
+    case 4: memcpy(&v,p,4); return _mm_cvtsi32_si128((FXint)v);
+    case 6: memcpy(&v,p,4); memcpy(&s,p+4,2); w=v|((FXulong)s<<32); return _mm_loadl_epi64((const __m128i*)&w);
+    default: return _mm_loadl_epi64((const __m128i*)p);
+    }
+  }
+
+
+// Store pixel of 3, 4, 6, or 8 bytes from low bytes of vector
+template<FXuval STEP>
+__attribute__((target("sse2")))
+static inline void storePixel(FXuchar* p,__m128i x){
+  FXushort s; FXuint v; FXulong w;
+  switch(STEP){
+    case 3: v=(FXuint)_mm_cvtsi128_si32(x); s=(FXushort)v; memcpy(p,&s,2); p[2]=(FXuchar)(v>>16); return;
+    case 4: v=(FXuint)_mm_cvtsi128_si32(x); memcpy(p,&v,4); return;
+    case 6: _mm_storel_epi64((__m128i*)&w,x); v=(FXuint)w; s=(FXushort)(w>>32); memcpy(p,&v,4); memcpy(p+4,&s,2); return;
+    default: _mm_storel_epi64((__m128i*)p,x); return;
+    }
+  }
+
+
+// Paeth predictor of eight 16-bit lanes
+__attribute__((target("sse2")))
+static inline __m128i predictor8(__m128i a,__m128i b,__m128i c){
+  __m128i zero=_mm_setzero_si128();
+  __m128i A=_mm_sub_epi16(b,c);
+  __m128i B=_mm_sub_epi16(a,c);
+  __m128i C=_mm_add_epi16(A,B);
+  __m128i m;
+  A=_mm_max_epi16(A,_mm_sub_epi16(zero,A));
+  B=_mm_max_epi16(B,_mm_sub_epi16(zero,B));
+  C=_mm_max_epi16(C,_mm_sub_epi16(zero,C));
+  m=_mm_cmplt_epi16(B,A);
+  a=_mm_or_si128(_mm_and_si128(m,b),_mm_andnot_si128(m,a));
+  A=_mm_min_epi16(A,B);
+  m=_mm_cmplt_epi16(C,A);
+  a=_mm_or_si128(_mm_and_si128(m,c),_mm_andnot_si128(m,a));
+  return a;
+  }
+
+
+// Undo Up filter 16 bytes at a time; return bytes done
+__attribute__((target("sse2")))
+static FXuval defilterUpSSE2(FXuchar* cur,const FXuchar* prv,FXuval count){
+  FXuval i=0;
+  while(i+16<=count){
+    _mm_storeu_si128((__m128i*)(cur+i),_mm_add_epi8(_mm_loadu_si128((const __m128i*)(cur+i)),_mm_loadu_si128((const __m128i*)(prv+i))));
+    i+=16;
+    }
+  return i;
+  }
+
+
+// Undo Up filter 64 bytes at a time; return bytes done
+__attribute__((target("avx2")))
+static FXuval defilterUpAVX2(FXuchar* cur,const FXuchar* prv,FXuval count){
+  FXuval i=0;
+  while(i+64<=count){
+    __m256i a=_mm256_add_epi8(_mm256_loadu_si256((const __m256i*)(cur+i)),_mm256_loadu_si256((const __m256i*)(prv+i)));
+    __m256i b=_mm256_add_epi8(_mm256_loadu_si256((const __m256i*)(cur+i+32)),_mm256_loadu_si256((const __m256i*)(prv+i+32)));
+    _mm256_storeu_si256((__m256i*)(cur+i),a);
+    _mm256_storeu_si256((__m256i*)(cur+i+32),b);
+    i+=64;
+    }
+  return i;
+  }
+
+
+// Undo Sub filter 16 bytes at a time, starting at byte 16; each byte gets
+// the sum of the bytes of its channel to its left in the vector, by shifting
+// and adding, plus the matching byte of the last pixel before the vector,
+// which is the same whatever the phase of the pixels in the vector
+__attribute__((target("ssse3")))
+static FXuval defilterSubSSSE3(FXuchar* cur,FXuval count,FXuval step){
+  FXuchar rotate[16] __attribute__((aligned(16)));
+  __m128i s1,s2,s4,s8,r,x;
+  FXuval i=16;
+  for(FXuval j=0; j<16; ++j){ rotate[j]=(FXuchar)(16-step+j%step); }
+  r=_mm_load_si128((const __m128i*)rotate);
+  s1=_mm_loadu_si128((const __m128i*)(shiftmask+16-step));
+  s2=_mm_loadu_si128((const __m128i*)(shiftmask+16-FXMIN(step*2,16)));
+  s4=_mm_loadu_si128((const __m128i*)(shiftmask+16-FXMIN(step*4,16)));
+  s8=_mm_loadu_si128((const __m128i*)(shiftmask+16-FXMIN(step*8,16)));
+  while(i+16<=count){
+    x=_mm_loadu_si128((const __m128i*)(cur+i));
+    x=_mm_add_epi8(x,_mm_shuffle_epi8(x,s1));
+    x=_mm_add_epi8(x,_mm_shuffle_epi8(x,s2));
+    x=_mm_add_epi8(x,_mm_shuffle_epi8(x,s4));
+    x=_mm_add_epi8(x,_mm_shuffle_epi8(x,s8));
+    x=_mm_add_epi8(x,_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(cur+i-16)),r));
+    _mm_storeu_si128((__m128i*)(cur+i),x);
+    i+=16;
+    }
+  return i;
+  }
+
+
+// Undo Avg filter one pixel of STEP bytes at a time, after the first
+template<FXuval STEP>
+__attribute__((target("sse2")))
+static void defilterAvgPixels(FXuchar* cur,const FXuchar* prv,FXuval count){
+  const __m128i one=_mm_set1_epi8(1);
+  __m128i a=loadPixel<STEP>(cur);
+  __m128i b=_mm_setzero_si128();
+  for(FXuval i=STEP; i<count; i+=STEP){
+    if(prv) b=loadPixel<STEP>(prv+i);
+    a=_mm_add_epi8(loadPixel<STEP>(cur+i),_mm_sub_epi8(_mm_avg_epu8(a,b),_mm_and_si128(_mm_xor_si128(a,b),one)));
+    storePixel<STEP>(cur+i,a);
+    }
+  }
+
+
+// Undo Paeth filter one pixel of STEP bytes at a time, after the first
+template<FXuval STEP>
+__attribute__((target("sse2")))
+static void defilterPaethPixels(FXuchar* cur,const FXuchar* prv,FXuval count){
+  const __m128i zero=_mm_setzero_si128();
+  __m128i a=_mm_unpacklo_epi8(loadPixel<STEP>(cur),zero);
+  __m128i c=_mm_unpacklo_epi8(loadPixel<STEP>(prv),zero);
+  __m128i b,x;
+  for(FXuval i=STEP; i<count; i+=STEP){
+    b=_mm_unpacklo_epi8(loadPixel<STEP>(prv+i),zero);
+    x=_mm_add_epi8(loadPixel<STEP>(cur+i),_mm_packus_epi16(predictor8(a,b,c),zero));
+    storePixel<STEP>(cur+i,x);
+    a=_mm_unpacklo_epi8(x,zero);
+    c=b;
+    }
+  }
+
+
+// Undo Avg filter for pixels of 3, 4, 6, or 8 bytes
+__attribute__((target("sse2")))
+static void defilterAvgSSE2(FXuchar* cur,const FXuchar* prv,FXuval count,FXuval step){
+  switch(step){
+    case 3: defilterAvgPixels<3>(cur,prv,count); return;
+    case 4: defilterAvgPixels<4>(cur,prv,count); return;
+    case 6: defilterAvgPixels<6>(cur,prv,count); return;
+    default: defilterAvgPixels<8>(cur,prv,count); return;
+    }
+  }
+
+
+// Undo Paeth filter for pixels of 3, 4, 6, or 8 bytes
+__attribute__((target("sse2")))
+static void defilterPaethSSE2(FXuchar* cur,const FXuchar* prv,FXuval count,FXuval step){
+  switch(step){
+    case 3: defilterPaethPixels<3>(cur,prv,count); return;
+    case 4: defilterPaethPixels<4>(cur,prv,count); return;
+    case 6: defilterPaethPixels<6>(cur,prv,count); return;
+    default: defilterPaethPixels<8>(cur,prv,count); return;
+    }
+  }
+
+
+// Narrow big-endian 16-bit samples to 8 bits, x/257 being (x*0xFF01)>>24
+// exactly for all 16-bit x; return samples done
+__attribute__((target("sse2")))
+static FXuval narrowSSE2(FXuchar* dst,const FXuchar* src,FXuval n){
+  const __m128i m=_mm_set1_epi16((FXshort)0xFF01);
+  __m128i a,b;
+  FXuval i=0;
+  while(i+16<=n){
+    a=_mm_loadu_si128((const __m128i*)(src+2*i));
+    b=_mm_loadu_si128((const __m128i*)(src+2*i+16));
+    a=_mm_or_si128(_mm_slli_epi16(a,8),_mm_srli_epi16(a,8));
+    b=_mm_or_si128(_mm_slli_epi16(b,8),_mm_srli_epi16(b,8));
+    a=_mm_srli_epi16(_mm_mulhi_epu16(a,m),8);
+    b=_mm_srli_epi16(_mm_mulhi_epu16(b,m),8);
+    _mm_storeu_si128((__m128i*)(dst+i),_mm_packus_epi16(a,b));
+    i+=16;
+    }
+  return i;
+  }
+
+
+// Narrow big-endian 16-bit samples to 8 bits, 32 at a time
+__attribute__((target("avx2")))
+static FXuval narrowAVX2(FXuchar* dst,const FXuchar* src,FXuval n){
+  const __m256i m=_mm256_set1_epi16((FXshort)0xFF01);
+  __m256i a,b;
+  FXuval i=0;
+  while(i+32<=n){
+    a=_mm256_loadu_si256((const __m256i*)(src+2*i));
+    b=_mm256_loadu_si256((const __m256i*)(src+2*i+32));
+    a=_mm256_or_si256(_mm256_slli_epi16(a,8),_mm256_srli_epi16(a,8));
+    b=_mm256_or_si256(_mm256_slli_epi16(b,8),_mm256_srli_epi16(b,8));
+    a=_mm256_srli_epi16(_mm256_mulhi_epu16(a,m),8);
+    b=_mm256_srli_epi16(_mm256_mulhi_epu16(b,m),8);
+    _mm256_storeu_si256((__m256i*)(dst+i),_mm256_permute4x64_epi64(_mm256_packus_epi16(a,b),0xD8));
+    i+=32;
+    }
+  return i;
+  }
+
+
+// Unpack 1-, 2-, or 4-bit samples to bytes, 16 source bytes at a time;
+// return samples done
+__attribute__((target("sse2")))
+static FXuval unpackSSE2(FXuchar* dst,const FXuchar* src,FXuval n,FXuint bits){
+  const __m128i m1=_mm_set1_epi8(1);
+  const __m128i m3=_mm_set1_epi8(3);
+  const __m128i m15=_mm_set1_epi8(15);
+  const __m128i bit=_mm_set_epi8(1,2,4,8,16,32,64,-128,1,2,4,8,16,32,64,-128);
+  FXuval per=128/bits;
+  FXuval i=0;
+  __m128i x,a,b,c,d;
+  while(i+per<=n){
+    switch(bits){
+      case 1:
+        for(FXuint j=0; j<16; j+=2){
+          x=_mm_cvtsi32_si128(src[j]|(src[j+1]<<8));
+          x=_mm_unpacklo_epi8(x,x);
+          x=_mm_unpacklo_epi16(x,x);
+          x=_mm_unpacklo_epi32(x,x);
+          x=_mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(x,bit),bit),m1);
+          _mm_storeu_si128((__m128i*)(dst+i+j*8),x);
+          }
+        break;
+      case 2:
+        x=_mm_loadu_si128((const __m128i*)src);
+        a=_mm_and_si128(_mm_srli_epi16(x,6),m3);
+        b=_mm_and_si128(_mm_srli_epi16(x,4),m3);
+        c=_mm_and_si128(_mm_srli_epi16(x,2),m3);
+        d=_mm_and_si128(x,m3);
+        x=_mm_unpacklo_epi8(a,b);
+        a=_mm_unpackhi_epi8(a,b);
+        b=_mm_unpacklo_epi8(c,d);
+        c=_mm_unpackhi_epi8(c,d);
+        _mm_storeu_si128((__m128i*)(dst+i),_mm_unpacklo_epi16(x,b));
+        _mm_storeu_si128((__m128i*)(dst+i+16),_mm_unpackhi_epi16(x,b));
+        _mm_storeu_si128((__m128i*)(dst+i+32),_mm_unpacklo_epi16(a,c));
+        _mm_storeu_si128((__m128i*)(dst+i+48),_mm_unpackhi_epi16(a,c));
+        break;
+      default:
+        x=_mm_loadu_si128((const __m128i*)src);
+        a=_mm_and_si128(_mm_srli_epi16(x,4),m15);
+        b=_mm_and_si128(x,m15);
+        _mm_storeu_si128((__m128i*)(dst+i),_mm_unpacklo_epi8(a,b));
+        _mm_storeu_si128((__m128i*)(dst+i+16),_mm_unpackhi_epi8(a,b));
+        break;
+      }
+    src+=16;
+    i+=per;
+    }
+  return i;
+  }
+
+
+// Expand gray to opaque pixels, 16 at a time; return pixels done
+__attribute__((target("sse2")))
+static FXuval expandGraySSE2(FXColor* dst,const FXuchar* src,FXuval n){
+  const __m128i ff=_mm_set1_epi8(-1);
+  __m128i x,gg,ga;
+  FXuval i=0;
+  while(i+16<=n){
+    x=_mm_loadu_si128((const __m128i*)(src+i));
+    gg=_mm_unpacklo_epi8(x,x);
+    ga=_mm_unpacklo_epi8(x,ff);
+    _mm_storeu_si128((__m128i*)(dst+i),_mm_unpacklo_epi16(gg,ga));
+    _mm_storeu_si128((__m128i*)(dst+i+4),_mm_unpackhi_epi16(gg,ga));
+    gg=_mm_unpackhi_epi8(x,x);
+    ga=_mm_unpackhi_epi8(x,ff);
+    _mm_storeu_si128((__m128i*)(dst+i+8),_mm_unpacklo_epi16(gg,ga));
+    _mm_storeu_si128((__m128i*)(dst+i+12),_mm_unpackhi_epi16(gg,ga));
+    i+=16;
+    }
+  return i;
+  }
+
+
+// Expand gray-alpha to pixels, 8 at a time; return pixels done
+__attribute__((target("sse2")))
+static FXuval expandGrayAlfaSSE2(FXColor* dst,const FXuchar* src,FXuval n){
+  const __m128i lo=_mm_set1_epi16(0x00FF);
+  __m128i x,g;
+  FXuval i=0;
+  while(i+8<=n){
+    x=_mm_loadu_si128((const __m128i*)(src+2*i));
+    g=_mm_and_si128(x,lo);
+    g=_mm_or_si128(g,_mm_slli_epi16(g,8));
+    _mm_storeu_si128((__m128i*)(dst+i),_mm_unpacklo_epi16(g,x));
+    _mm_storeu_si128((__m128i*)(dst+i+4),_mm_unpackhi_epi16(g,x));
+    i+=8;
+    }
+  return i;
+  }
+
+
+// Expand rgb to opaque pixels, 16 at a time; return pixels done
+__attribute__((target("ssse3")))
+static FXuval expandRGBSSSE3(FXColor* dst,const FXuchar* src,FXuval n){
+  const __m128i shuf=_mm_set_epi8(-1,9,10,11,-1,6,7,8,-1,3,4,5,-1,0,1,2);
+  const __m128i alfa=_mm_set1_epi32(0xFF000000);
+  __m128i a,b,c;
+  FXuval i=0;
+  while(i+16<=n){
+    a=_mm_loadu_si128((const __m128i*)(src+3*i));
+    b=_mm_loadu_si128((const __m128i*)(src+3*i+16));
+    c=_mm_loadu_si128((const __m128i*)(src+3*i+32));
+    _mm_storeu_si128((__m128i*)(dst+i),_mm_or_si128(_mm_shuffle_epi8(a,shuf),alfa));
+    _mm_storeu_si128((__m128i*)(dst+i+4),_mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b,a,12),shuf),alfa));
+    _mm_storeu_si128((__m128i*)(dst+i+8),_mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c,b,8),shuf),alfa));
+    _mm_storeu_si128((__m128i*)(dst+i+12),_mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c,c,4),shuf),alfa));
+    i+=16;
+    }
+  return i;
+  }
+
+
+// Expand rgb to opaque pixels, 8 at a time, loading each lane from 12 bytes
+// further along; stops while 30 bytes remain, as the last load reads 28
+__attribute__((target("avx2")))
+static FXuval expandRGBAVX2(FXColor* dst,const FXuchar* src,FXuval n){
+  const __m256i shuf=_mm256_set_epi8(-1,9,10,11,-1,6,7,8,-1,3,4,5,-1,0,1,2,-1,9,10,11,-1,6,7,8,-1,3,4,5,-1,0,1,2);
+  const __m256i alfa=_mm256_set1_epi32(0xFF000000);
+  __m256i x;
+  FXuval i=0;
+  while(i+10<=n){
+    x=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(src+3*i))),_mm_loadu_si128((const __m128i*)(src+3*i+12)),1);
+    _mm256_storeu_si256((__m256i*)(dst+i),_mm256_or_si256(_mm256_shuffle_epi8(x,shuf),alfa));
+    i+=8;
+    }
+  return i;
+  }
+
+
+// Swap red and blue of rgba, 4 pixels at a time; return pixels done
+__attribute__((target("sse2")))
+static FXuval expandRGBASSE2(FXColor* dst,const FXuchar* src,FXuval n){
+  const __m128i ga=_mm_set1_epi32(0xFF00FF00);
+  const __m128i rb=_mm_set1_epi32(0x00FF00FF);
+  __m128i x,y;
+  FXuval i=0;
+  while(i+4<=n){
+    x=_mm_loadu_si128((const __m128i*)(src+4*i));
+    y=_mm_and_si128(x,rb);
+    y=_mm_or_si128(_mm_slli_epi32(y,16),_mm_srli_epi32(y,16));
+    _mm_storeu_si128((__m128i*)(dst+i),_mm_or_si128(_mm_and_si128(x,ga),y));
+    i+=4;
+    }
+  return i;
+  }
+
+
+// Swap red and blue of rgba, 8 pixels at a time; return pixels done
+__attribute__((target("ssse3")))
+static FXuval expandRGBASSSE3(FXColor* dst,const FXuchar* src,FXuval n){
+  const __m128i bgra=_mm_set_epi8(15,12,13,14,11,8,9,10,7,4,5,6,3,0,1,2);
+  FXuval i=0;
+  while(i+8<=n){
+    _mm_storeu_si128((__m128i*)(dst+i),_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src+4*i)),bgra));
+    _mm_storeu_si128((__m128i*)(dst+i+4),_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src+4*i+16)),bgra));
+    i+=8;
+    }
+  return i;
+  }
+
+
+// Swap red and blue of rgba, 16 pixels at a time; return pixels done
+__attribute__((target("avx2")))
+static FXuval expandRGBAAVX2(FXColor* dst,const FXuchar* src,FXuval n){
+  const __m256i bgra=_mm256_set_epi8(15,12,13,14,11,8,9,10,7,4,5,6,3,0,1,2,15,12,13,14,11,8,9,10,7,4,5,6,3,0,1,2);
+  FXuval i=0;
+  while(i+16<=n){
+    _mm256_storeu_si256((__m256i*)(dst+i),_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src+4*i)),bgra));
+    _mm256_storeu_si256((__m256i*)(dst+i+8),_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(src+4*i+32)),bgra));
+    i+=16;
+    }
+  return i;
+  }
+
+
+// Look up 8 indexes at a time in colormap; return pixels done
+__attribute__((target("avx2")))
+static FXuval expandIndexAVX2(FXColor* dst,const FXColor* map,const FXuchar* src,FXuval n){
+  __m256i x;
+  FXuval i=0;
+  while(i+8<=n){
+    x=_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src+i)));
+    _mm256_storeu_si256((__m256i*)(dst+i),_mm256_i32gather_epi32((const int*)map,x,4));
+    i+=8;
+    }
+  return i;
+  }
+
+
+// Clear alpha of pixels equal to key, 4 at a time; return pixels done
+__attribute__((target("sse2")))
+static FXuval clearKeySSE2(FXColor* pix,FXColor key,FXuval n){
+  const __m128i k=_mm_set1_epi32(key);
+  const __m128i a=_mm_set1_epi32(0xFF000000);
+  __m128i x;
+  FXuval i=0;
+  while(i+4<=n){
+    x=_mm_loadu_si128((const __m128i*)(pix+i));
+    _mm_storeu_si128((__m128i*)(pix+i),_mm_andnot_si128(_mm_and_si128(_mm_cmpeq_epi32(x,k),a),x));
+    i+=4;
+    }
+  return i;
+  }
+
+
+// Clear alpha of pixels equal to key, 8 at a time; return pixels done
+__attribute__((target("avx2")))
+static FXuval clearKeyAVX2(FXColor* pix,FXColor key,FXuval n){
+  const __m256i k=_mm256_set1_epi32(key);
+  const __m256i a=_mm256_set1_epi32(0xFF000000);
+  __m256i x;
+  FXuval i=0;
+  while(i+8<=n){
+    x=_mm256_loadu_si256((const __m256i*)(pix+i));
+    _mm256_storeu_si256((__m256i*)(pix+i),_mm256_andnot_si256(_mm256_and_si256(_mm256_cmpeq_epi32(x,k),a),x));
+    i+=8;
+    }
+  return i;
+  }
+
+#endif
+
+
+// Narrow n big-endian 16-bit samples to 8 bits
+static void narrow(FXuchar* dst,const FXuchar* src,FXuval n,FXuint features){
+  FXuval i=0;
+#if defined(PNG_DECODE_KERNELS)
+  if(features&CPU_HAS_AVX2) i=narrowAVX2(dst,src,n);
+  if(features&CPU_HAS_SSE2) i+=narrowSSE2(dst+i,src+2*i,n-i);
+#endif
+  while(i<n){
+    dst[i]=((src[2*i]<<8)|src[2*i+1])/257;
+    ++i;
+    }
+  }
+
+
+// Unpack n 1-, 2-, or 4-bit samples to bytes
+static void unpack(FXuchar* dst,const FXuchar* src,FXuval n,FXuint bits,FXuint features){
+  const FXuint mask=(1<<bits)-1;
+  FXuval i=0;
+#if defined(PNG_DECODE_KERNELS)
+  if(features&CPU_HAS_SSE2) i=unpackSSE2(dst,src,n,bits);
+#endif
+  src+=(i*bits)>>3;
+  while(i<n){
+    dst[i]=(src[0]>>(8-bits-((i*bits)&7)))&mask;
+    if(((++i)*bits&7)==0) ++src;
+    }
+  }
+
+
+// Look up n indexes in map
+static void expandIndex(FXColor* dst,const FXColor* map,const FXuchar* src,FXuval n,FXuint features){
+  FXuval i=0;
+#if defined(PNG_DECODE_KERNELS)
+  if(features&CPU_HAS_AVX2) i=expandIndexAVX2(dst,map,src,n);
+#endif
+  while(i<n){
+    dst[i]=map[src[i]];
+    ++i;
+    }
+  }
+
+
+// Expand n gray samples to opaque pixels
+static void expandGray(FXColor* dst,const FXuchar* src,FXuval n,FXuint features){
+  FXuval i=0;
+#if defined(PNG_DECODE_KERNELS)
+  if(features&CPU_HAS_SSE2) i=expandGraySSE2(dst,src,n);
+#endif
+  while(i<n){
+    dst[i]=FXRGB(src[i],src[i],src[i]);
+    ++i;
+    }
+  }
+
+
+// Expand n gray-alpha samples to pixels
+static void expandGrayAlfa(FXColor* dst,const FXuchar* src,FXuval n,FXuint features){
+  FXuval i=0;
+#if defined(PNG_DECODE_KERNELS)
+  if(features&CPU_HAS_SSE2) i=expandGrayAlfaSSE2(dst,src,n);
+#endif
+  while(i<n){
+    dst[i]=FXRGBA(src[2*i],src[2*i],src[2*i],src[2*i+1]);
+    ++i;
+    }
+  }
+
+
+// Expand n rgb samples to opaque pixels
+static void expandRGB(FXColor* dst,const FXuchar* src,FXuval n,FXuint features){
+  FXuval i=0;
+#if defined(PNG_DECODE_KERNELS)
+  if(features&CPU_HAS_AVX2) i=expandRGBAVX2(dst,src,n);
+  if(features&CPU_HAS_SSSE3) i+=expandRGBSSSE3(dst+i,src+3*i,n-i);
+#endif
+  while(i<n){
+    dst[i]=FXRGB(src[3*i],src[3*i+1],src[3*i+2]);
+    ++i;
+    }
+  }
+
+
+// Expand n rgba samples to pixels
+static void expandRGBA(FXColor* dst,const FXuchar* src,FXuval n,FXuint features){
+  FXuval i=0;
+#if defined(PNG_DECODE_KERNELS)
+  if(features&CPU_HAS_AVX2) i=expandRGBAAVX2(dst,src,n);
+  if(features&CPU_HAS_SSSE3) i+=expandRGBASSSE3(dst+i,src+4*i,n-i);
+  if(features&CPU_HAS_SSE2) i+=expandRGBASSE2(dst+i,src+4*i,n-i);
+#endif
+  while(i<n){
+    dst[i]=FXRGBA(src[4*i],src[4*i+1],src[4*i+2],src[4*i+3]);
+    ++i;
+    }
+  }
+
+
+// Clear alpha of n pixels equal to key
+static void clearKey(FXColor* pix,FXColor key,FXuval n,FXuint features){
+  FXuval i=0;
+#if defined(PNG_DECODE_KERNELS)
+  if(features&CPU_HAS_AVX2) i=clearKeyAVX2(pix,key,n);
+  if(features&CPU_HAS_SSE2) i+=clearKeySSE2(pix+i,key,n-i);
+#endif
+  while(i<n){
+    if(pix[i]==key) pix[i]&=FXRGBA(255,255,255,0);
+    ++i;
+    }
+  }
+
+
+// Expand n packed 1-, 2-, or 4-bit samples through map
+static void expandPacked(FXColor* dst,const FXColor* map,const FXuchar* src,FXuval n,FXuint bits,FXuint features){
+  FXuchar tmp[CHUNK];
+  FXuval m;
+  while(n){
+    m=FXMIN(n,CHUNK);
+    unpack(tmp,src,m,bits,features);
+    expandIndex(dst,map,tmp,m,features);
+    src+=(m*bits)>>3;
+    dst+=m;
+    n-=m;
+    }
+  }
+
+
+// Narrow n pixels of ch 16-bit channels, then expand them
+static void expandWide(FXColor* dst,const FXuchar* src,FXuval n,FXuint ch,FXuint features){
+  FXuchar tmp[CHUNK*4];
+  FXuval m;
+  while(n){
+    m=FXMIN(n,CHUNK);
+    narrow(tmp,src,m*ch,features);
+    switch(ch){
+      case 1: expandGray(dst,tmp,m,features); break;
+      case 2: expandGrayAlfa(dst,tmp,m,features); break;
+      case 3: expandRGB(dst,tmp,m,features); break;
+      default: expandRGBA(dst,tmp,m,features); break;
+      }
+    src+=m*ch*2;
+    dst+=m;
+    n-=m;
+    }
+  }
+
+PERFORMANCE_RECORDER(PNGDecoder_applyTransparency);
+
+
 // Apply transparancy, i.e. a special color designated to be
 // used as fully transparent.
-// FIXME Technically, this should be made to work for
-// bitdepth==16 but right now, it doesn't; reason: we don't
-// store bitdepth==16 images, but only up to 8.
-void PNGDecoder::applyTransparency(){
-/* FIXME before copyPixels
-  const FXColor CLEARALPHA=FXRGBA(255,255,255,0);
-  if(alfacolor[0] && alfacolor[1] && alfacolor[2]  && (imagetype==RGB || imagetype==Gray)){
-    FXuint npixels=width*height;
-    FXColor color;
-    for(FXuint i=0; i<npixels; ++i){
-      if((color=image[i])==transparency){ image[i]=color&CLEARALPHA; }
+// The color is compared after conversion to FXColor; for images
+// with bitdepth==16, this clears a few more pixels than it should.
+void PNGDecoder::applyTransparency(FXColor* pix,FXuval n){
+  PERFORMANCE_COUNTER(PNGDecoder_applyTransparency);
+  if(hasalfa && (imagetype==Gray || imagetype==RGB)){
+    FXuint maxval=(1<<bitdepth)-1;
+    FXuint r=alfacolor[0];
+    FXuint g=alfacolor[1];
+    FXuint b=alfacolor[2];
+    if(r<=maxval && g<=maxval && b<=maxval){
+      if(bitdepth==16){ r/=257; g/=257; b/=257; }
+      else if(bitdepth<8){ r*=255/maxval; g*=255/maxval; b*=255/maxval; }
+      clearKey(pix,FXRGB(r,g,b),n,features);
       }
     }
-*/
   }
 
 /*******************************************************************************/
@@ -698,6 +1357,7 @@ PERFORMANCE_RECORDER(PNGDecoder_decodeRGBA16BPP);
 static void decodeIndex1BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeIndex1BPP);
   FXuchar w;
+  if(s==1){ expandPacked(dst,&dec->colormap[0].c,src,n,1,dec->features); return; }
   while(8<=n){
     w=*src++;
     *dst=dec->colormap[w>>7].c;     dst+=s;
@@ -724,6 +1384,7 @@ static void decodeIndex1BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* sr
 static void decodeIndex2BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeIndex2BPP);
   FXuchar w;
+  if(s==1){ expandPacked(dst,&dec->colormap[0].c,src,n,2,dec->features); return; }
   while(4<=n){
     w=*src++;
     *dst=dec->colormap[w>>6].c;     dst+=s;
@@ -742,6 +1403,7 @@ static void decodeIndex2BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* sr
 static void decodeIndex4BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeIndex4BPP);
   FXuchar w;
+  if(s==1){ expandPacked(dst,&dec->colormap[0].c,src,n,4,dec->features); return; }
   while(2<=n){
     w=*src++;
     *dst=dec->colormap[w>>4].c; dst+=s;
@@ -756,6 +1418,7 @@ static void decodeIndex4BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* sr
 static void decodeIndex8BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeIndex8BPP);
   FXuchar w;
+  if(s==1){ expandIndex(dst,&dec->colormap[0].c,src,n,dec->features); return; }
   while(n){
     w=*src++;
     *dst=dec->colormap[w].c;
@@ -766,9 +1429,10 @@ static void decodeIndex8BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* sr
 
 
 // Decode 1 bit/pixel gray
-static void decodeGray1BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXuval n,FXuval s){
+static void decodeGray1BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeGray1BPP);
   FXuchar w;
+  if(s==1){ expandPacked(dst,map1Bit,src,n,1,dec->features); return; }
   while(8<=n){
     w=*src++;
     *dst=map1Bit[w>>7];     dst+=s;
@@ -792,9 +1456,10 @@ static void decodeGray1BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FX
 
 
 // Decode 2 bit/pixel gray
-static void decodeGray2BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXuval n,FXuval s){
+static void decodeGray2BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeGray2BPP);
   FXuchar w;
+  if(s==1){ expandPacked(dst,map2Bit,src,n,2,dec->features); return; }
   while(4<=n){
     w=*src++;
     *dst=map2Bit[w>>6];     dst+=s;
@@ -810,9 +1475,10 @@ static void decodeGray2BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FX
 
 
 // Decode 4 bit/pixel gray
-static void decodeGray4BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXuval n,FXuval s){
+static void decodeGray4BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeGray4BPP);
   FXuchar w;
+  if(s==1){ expandPacked(dst,map4Bit,src,n,4,dec->features); return; }
   while(2<=n){
     w=*src++;
     *dst=map4Bit[w>>4]; dst+=s;
@@ -824,29 +1490,10 @@ static void decodeGray4BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FX
 
 
 // Decode 8 bit/pixel gray
-static void decodeGray8BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXuval n,FXuval s){
+static void decodeGray8BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeGray8BPP);
   FXuchar g;
-#if defined(__SSE__) && defined(__SSE2__) && defined(__SSE3__) && defined(__SSSE3__) && defined(__SSE4_1__)
-  const __m128i gr1=_mm_set_epi8(-1, 3, 3, 3, -1, 2, 2, 2, -1, 1, 1, 1,-1, 0, 0, 0);
-  const __m128i gr2=_mm_set_epi8(-1, 7, 7, 7, -1, 6, 6, 6, -1, 5, 5, 5,-1, 4, 4, 4);
-  const __m128i alfa=_mm_set_epi8(255,0,0,0, 255,0,0,0, 255,0,0,0, 255,0,0,0);
-  __m128i xxxx,aaaa,bbbb;
-  while(8<=n){
-    xxxx=_mm_loadu_si64(src); src+=8;
-    aaaa=_mm_or_si128(_mm_shuffle_epi8(xxxx,gr1),alfa);
-    *dst=_mm_extract_epi32(aaaa,0); dst+=s;
-    *dst=_mm_extract_epi32(aaaa,1); dst+=s;
-    *dst=_mm_extract_epi32(aaaa,2); dst+=s;
-    *dst=_mm_extract_epi32(aaaa,3); dst+=s;
-    bbbb=_mm_or_si128(_mm_shuffle_epi8(xxxx,gr2),alfa);
-    *dst=_mm_extract_epi32(bbbb,0); dst+=s;
-    *dst=_mm_extract_epi32(bbbb,1); dst+=s;
-    *dst=_mm_extract_epi32(bbbb,2); dst+=s;
-    *dst=_mm_extract_epi32(bbbb,3); dst+=s;
-    n-=8;
-    }
-#endif
+  if(s==1){ expandGray(dst,src,n,dec->features); return; }
   while(n){
     g=src[0];
     *dst=FXRGB(g,g,g);
@@ -857,9 +1504,10 @@ static void decodeGray8BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FX
   }
 
 // Decode 16 bit/pixel gray
-static void decodeGray16BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXuval n,FXuval s){
+static void decodeGray16BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeGray16BPP);
   FXushort g;
+  if(s==1){ expandWide(dst,src,n,1,dec->features); return; }
   while(n){
     g=((src[0]<<8)|src[1])/257;
     *dst=FXRGBA(g,g,g,255);
@@ -871,28 +1519,10 @@ static void decodeGray16BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,F
 
 
 // Decode 8 bit/pixel gray-alpha
-static void decodeGrayAlfa8BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXuval n,FXuval s){
+static void decodeGrayAlfa8BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeGrayAlfa8BPP);
   FXuchar g,a;
-#if defined(__SSE__) && defined(__SSE2__) && defined(__SSE3__) && defined(__SSSE3__) && defined(__SSE4_1__)
-  const __m128i gr1=_mm_set_epi8( 7, 6, 6, 6,  5, 4, 4, 4,  3, 2, 2, 2, 1, 0, 0, 0);
-  const __m128i gr2=_mm_set_epi8(15,14,14,14, 13,12,12,12, 11,10,10,10, 9, 8, 8, 8);
-  __m128i xxxx,aaaa,bbbb;
-  while(8<=n){
-    xxxx=_mm_loadu_si128((const __m128i*)src); src+=16;
-    aaaa=_mm_shuffle_epi8(xxxx,gr1);
-    *dst=_mm_extract_epi32(aaaa,0); dst+=s;
-    *dst=_mm_extract_epi32(aaaa,1); dst+=s;
-    *dst=_mm_extract_epi32(aaaa,2); dst+=s;
-    *dst=_mm_extract_epi32(aaaa,3); dst+=s;
-    bbbb=_mm_shuffle_epi8(xxxx,gr2);
-    *dst=_mm_extract_epi32(bbbb,0); dst+=s;
-    *dst=_mm_extract_epi32(bbbb,1); dst+=s;
-    *dst=_mm_extract_epi32(bbbb,2); dst+=s;
-    *dst=_mm_extract_epi32(bbbb,3); dst+=s;
-    n-=8;
-    }
-#endif
+  if(s==1){ expandGrayAlfa(dst,src,n,dec->features); return; }
   while(n){
     g=src[0];
     a=src[1];
@@ -905,9 +1535,10 @@ static void decodeGrayAlfa8BPP(FXColor* dst,const PNGDecoder *,const FXuchar* sr
 
 
 // Decode 16 bit/pixel gray-alpha
-static void decodeGrayAlfa16BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXuval n,FXuval s){
+static void decodeGrayAlfa16BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeGrayAlfa16BPP);
   FXushort g,a;
+  if(s==1){ expandWide(dst,src,n,2,dec->features); return; }
   while(n){
     g=((src[0]<<8)|src[1])/257;
     a=((src[2]<<8)|src[3])/257;
@@ -920,40 +1551,10 @@ static void decodeGrayAlfa16BPP(FXColor* dst,const PNGDecoder *,const FXuchar* s
 
 
 // Decode 8 bit/pixel rgb
-static void decodeRGB8BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXuval n,FXuval s){
+static void decodeRGB8BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeRGB8BPP);
   FXuchar r,g,b;
-#if defined(__SSE__) && defined(__SSE2__) && defined(__SSE3__) && defined(__SSSE3__) && defined(__SSE4_1__)
-  const __m128i shuf=_mm_set_epi8(-1, 9,10,11, -1, 6, 7, 8, -1, 3, 4, 5, -1, 0, 1, 2);
-  const __m128i alfa=_mm_set_epi8(255,0,0,0, 255,0,0,0, 255,0,0,0, 255,0,0,0);
-  __m128i aaaa,bbbb,cccc,xxxx,yyyy,zzzz,wwww;
-  while(16<=n){
-    aaaa=_mm_loadu_si128((const __m128i*)src); src+=16;
-    bbbb=_mm_loadu_si128((const __m128i*)src); src+=16;
-    cccc=_mm_loadu_si128((const __m128i*)src); src+=16;
-    xxxx=_mm_or_si128(_mm_shuffle_epi8(aaaa,shuf),alfa);
-    yyyy=_mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(bbbb,aaaa,12),shuf),alfa);
-    zzzz=_mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(cccc,bbbb,8),shuf),alfa);
-    wwww=_mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(cccc,cccc,4),shuf),alfa);
-    *dst=_mm_extract_epi32(xxxx,0); dst+=s;
-    *dst=_mm_extract_epi32(xxxx,1); dst+=s;
-    *dst=_mm_extract_epi32(xxxx,2); dst+=s;
-    *dst=_mm_extract_epi32(xxxx,3); dst+=s;
-    *dst=_mm_extract_epi32(yyyy,0); dst+=s;
-    *dst=_mm_extract_epi32(yyyy,1); dst+=s;
-    *dst=_mm_extract_epi32(yyyy,2); dst+=s;
-    *dst=_mm_extract_epi32(yyyy,3); dst+=s;
-    *dst=_mm_extract_epi32(zzzz,0); dst+=s;
-    *dst=_mm_extract_epi32(zzzz,1); dst+=s;
-    *dst=_mm_extract_epi32(zzzz,2); dst+=s;
-    *dst=_mm_extract_epi32(zzzz,3); dst+=s;
-    *dst=_mm_extract_epi32(wwww,0); dst+=s;
-    *dst=_mm_extract_epi32(wwww,1); dst+=s;
-    *dst=_mm_extract_epi32(wwww,2); dst+=s;
-    *dst=_mm_extract_epi32(wwww,3); dst+=s;
-    n-=16;
-    }
-#endif
+  if(s==1){ expandRGB(dst,src,n,dec->features); return; }
   while(n){
     r=src[0];
     g=src[1];
@@ -966,9 +1567,10 @@ static void decodeRGB8BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXu
   }
 
 // Decode 16 bit/pixel rgb
-static void decodeRGB16BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXuval n,FXuval s){
+static void decodeRGB16BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeRGB16BPP);
   FXushort r,g,b;
+  if(s==1){ expandWide(dst,src,n,3,dec->features); return; }
   while(n){
     r=((src[0]<<8)|src[1])/257;
     g=((src[2]<<8)|src[3])/257;
@@ -982,28 +1584,10 @@ static void decodeRGB16BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FX
 
 
 // Decode 8 bit/pixel rgba
-static void decodeRGBA8BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXuval n,FXuval s){
+static void decodeRGBA8BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeRGBA8BPP);
   FXuchar r,g,b,a;
-#if defined(__SSE__) && defined(__SSE2__) && defined(__SSE3__) && defined(__SSSE3__) && defined(__SSE4_1__)
-  const __m128i bgra=_mm_set_epi8(15,12,13,14, 11,8,9,10, 7,4,5,6, 3,0,1,2);
-  __m128i aaaa,bbbb;
-  while(8<=n){
-    aaaa=_mm_loadu_si128((const __m128i*)src); src+=16;
-    aaaa=_mm_shuffle_epi8(aaaa,bgra);
-    bbbb=_mm_loadu_si128((const __m128i*)src); src+=16;
-    bbbb=_mm_shuffle_epi8(bbbb,bgra);
-    *dst=_mm_extract_epi32(aaaa,0); dst+=s;
-    *dst=_mm_extract_epi32(aaaa,1); dst+=s;
-    *dst=_mm_extract_epi32(aaaa,2); dst+=s;
-    *dst=_mm_extract_epi32(aaaa,3); dst+=s;
-    *dst=_mm_extract_epi32(bbbb,0); dst+=s;
-    *dst=_mm_extract_epi32(bbbb,1); dst+=s;
-    *dst=_mm_extract_epi32(bbbb,2); dst+=s;
-    *dst=_mm_extract_epi32(bbbb,3); dst+=s;
-    n-=8;
-    }
-#endif
+  if(s==1){ expandRGBA(dst,src,n,dec->features); return; }
   while(n){
     r=src[0];
     g=src[1];
@@ -1018,9 +1602,10 @@ static void decodeRGBA8BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FX
 
 
 // Decode 16 bit/pixel rgba
-static void decodeRGBA16BPP(FXColor* dst,const PNGDecoder *,const FXuchar* src,FXuval n,FXuval s){
+static void decodeRGBA16BPP(FXColor* dst,const PNGDecoder *dec,const FXuchar* src,FXuval n,FXuval s){
   PERFORMANCE_COUNTER(PNGDecoder_decodeRGBA16BPP);
   FXushort r,g,b,a;
+  if(s==1){ expandWide(dst,src,n,4,dec->features); return; }
   while(n){
     r=((src[0]<<8)|src[1])/257;
     g=((src[2]<<8)|src[3])/257;
@@ -1115,51 +1700,79 @@ static void decodeLine2(FXuchar filt,FXuchar* __restrict dst,const FXuchar* __re
 PERFORMANCE_RECORDER(PNGDecoder_decodeLine);
 
 // Decode one line
-static void decodeLine(FXuchar filt,FXuchar* __restrict cur,const FXuchar* __restrict prv,FXuval count,FXuval step){
+// Sub is undone 16 bytes at a time, Up 16 or 64 bytes at a time, and Avg and
+// Paeth a pixel at a time, for pixels of at least 3 bytes; all else is done
+// a byte at a time.
+static void decodeLine(FXuchar filt,FXuchar* __restrict cur,const FXuchar* __restrict prv,FXuval count,FXuval step,FXuint features){
   PERFORMANCE_COUNTER(PNGDecoder_decodeLine);
+  FXuval i;
+  if(filt==FiltPaeth && !prv){          // Paeth without line above is Sub
+    filt=FiltSub;
+    }
   switch(filt){
   case FiltNone:
     return;
   case FiltSub:
-    for(FXuval i=step; i<count; ++i){
+    i=step;
+#if defined(PNG_DECODE_KERNELS)
+    if((features&CPU_HAS_SSSE3) && 32<=count){
+      for(; i<16; ++i){
+        cur[i]+=cur[i-step];
+        }
+      i=defilterSubSSSE3(cur,count,step);
+      }
+#endif
+    for(; i<count; ++i){
       cur[i]+=cur[i-step];
       }
     return;
   case FiltUp:
     if(prv){
-      for(FXuval i=0; i<count; ++i){
+      i=0;
+#if defined(PNG_DECODE_KERNELS)
+      if(features&CPU_HAS_AVX2) i=defilterUpAVX2(cur,prv,count);
+      if(features&CPU_HAS_SSE2) i+=defilterUpSSE2(cur+i,prv+i,count-i);
+#endif
+      for(; i<count; ++i){
         cur[i]+=prv[i];
         }
       }
     return;
   case FiltAvg:
     if(prv){
-      for(FXuval i=0; i<step; ++i){
+      for(i=0; i<step; ++i){
         cur[i]+=prv[i]/2;
         }
-      for(FXuval i=step; i<count; ++i){
+      }
+#if defined(PNG_DECODE_KERNELS)
+    if((features&CPU_HAS_SSE2) && 3<=step){
+      defilterAvgSSE2(cur,prv,count,step);
+      return;
+      }
+#endif
+    if(prv){
+      for(i=step; i<count; ++i){
         cur[i]+=(cur[i-step]+prv[i])/2;
         }
       }
     else{
-      for(FXuval i=step; i<count; ++i){
+      for(i=step; i<count; ++i){
         cur[i]+=(cur[i-step])/2;
         }
       }
     return;
   case FiltPaeth:
-    if(prv){
-      for(FXuval i=0; i<step; ++i){
-        cur[i]+=prv[i];
-        }
-      for(FXuval i=step; i<count; ++i){
-        cur[i]+=predictor(cur[i-step],prv[i],prv[i-step]);
-        }
+    for(i=0; i<step; ++i){
+      cur[i]+=prv[i];
       }
-    else{
-      for(FXuval i=step; i<count; ++i){
-        cur[i]+=cur[i-step];
-        }
+#if defined(PNG_DECODE_KERNELS)
+    if((features&CPU_HAS_SSE2) && 3<=step){
+      defilterPaethSSE2(cur,prv,count,step);
+      return;
+      }
+#endif
+    for(i=step; i<count; ++i){
+      cur[i]+=predictor(cur[i-step],prv[i],prv[i-step]);
       }
     return;
   default:
@@ -1187,7 +1800,7 @@ FXbool PNGDecoder::decode(){
       for(FXuint row=0; row<intheight[pass]; ++row){
         filt=*cur++;
         if(__unlikely(FiltPaeth<filt)) return false;
-        decodeLine(filt,cur,prv,intbytes[pass],stride);
+        decodeLine(filt,cur,prv,intbytes[pass],stride,features);
         dst=image+xoffset[pass]+((yoffset[pass]+(ystep[pass]*row))*width);
         df(dst,this,cur,intwidth[pass],xstep[pass]);
         prv=cur;
@@ -1201,7 +1814,7 @@ FXbool PNGDecoder::decode(){
     for(FXuint row=0; row<height; ++row){
       filt=*cur++;
       if(__unlikely(FiltPaeth<filt)) return false;
-      decodeLine(filt,cur,prv,numbytes,stride);
+      decodeLine(filt,cur,prv,numbytes,stride,features);
       dst=image+(row*width);
       df(dst,this,cur,width,1);
       prv=cur;
@@ -1317,7 +1930,7 @@ FXbool PNGDecoder::end(FXStream& store,FXuint length){
     }
 
   // Apply alpha color
-  applyTransparency();
+  applyTransparency(image,(FXuval)width*height);
 
   // Checksum
   store >> chunkcrc;
@@ -1334,99 +1947,111 @@ FXbool PNGDecoder::end(FXStream& store,FXuint length){
 PERFORMANCE_RECORDER(PNGDecoder_load);
 
 
-// Decode start
-FXbool PNGDecoder::load(FXStream& store,FXColor*& output_image,FXint& output_width,FXint& output_height){
-  PERFORMANCE_COUNTER(PNGDecoder_load);
+// Load chunks following header, decoding image
+FXbool PNGDecoder::chunks(FXStream& store){
   FXbool result=false;
   FXuint chunklength;
   FXuint chunkid;
 
+  // Finally, image to be returned
+  if(allocElms(image,width*height)){
+
+    // Size of buffer 1.25 x totbytes + 2 x numbytes + 2
+    buffersize=((totbytes*5+3)>>2)+((numbytes+1)<<1);
+
+    FXTRACE((TOPIC_DETAIL,"fxloadPNG: buffersize = %u\n",buffersize));
+
+    // Allocate storage
+    if(allocElms(buffer,buffersize)){
+
+      // Uncompressed data goes here
+      stream.next_out=buffer;
+
+      // Parse chunks
+      while(!store.eof()){
+
+        // Get chunk
+        store >> chunklength;
+        store >> chunkid;
+
+        // Palette
+        if(chunkid==PLTE){
+          if(!palette(store,chunklength)){
+            FXTRACE((TOPIC_DETAIL,"fxloadPNG: failed to load PLTE\n"));
+            break;
+            }
+          continue;
+          }
+
+        // Background
+        if(chunkid==bKGD){
+          if(!background(store,chunklength)){
+            FXTRACE((TOPIC_DETAIL,"fxloadPNG: failed to load bKGD\n"));
+            break;
+            }
+          continue;
+          }
+
+        // Transparancy
+        if(chunkid==tRNS){
+          if(!transparency(store,chunklength)){
+            FXTRACE((TOPIC_DETAIL,"fxloadPNG: failed to load tRNS\n"));
+            break;
+            }
+          continue;
+          }
+
+        // Data
+        if(chunkid==IDAT){
+          if(!data(store,chunklength)){
+            FXTRACE((TOPIC_DETAIL,"fxloadPNG: failed to load IDAT\n"));
+            break;
+            }
+          continue;
+          }
+
+        // End
+        if(chunkid==IEND){
+          if(!end(store,chunklength)){
+            FXTRACE((TOPIC_DETAIL,"fxloadPNG: failed to load IEND\n"));
+            break;
+            }
+          result=true;
+          break;
+          }
+
+        // Other chunk
+        // Skip over the data and the crc
+        store.position(chunklength+4,FXFromCurrent);
+        }
+      freeElms(buffer);
+      }
+    if(!result) freeElms(image);
+    }
+  return result;
+  }
+
+
+// Load image
+FXbool PNGDecoder::load(FXStream& store,FXColor*& output_image,FXint& output_width,FXint& output_height){
+  PERFORMANCE_COUNTER(PNGDecoder_load);
+  FXbool result=false;
+
   // Load header
   if(header(store)){
 
     // Initialize zlib
     if(inflateInit(&stream)==Z_OK){
 
-      // Finally, image to be returned
-      if(allocElms(image,width*height)){
-
-        // Size of buffer 1.25 x totbytes + 2 x numbytes + 2
-        buffersize=((totbytes*5+3)>>2)+((numbytes+1)<<1);
-
-        FXTRACE((TOPIC_DETAIL,"fxloadPNG: buffersize = %u\n",buffersize));
-
-        // Allocate storage
-        if(allocElms(buffer,buffersize)){
-
-          // Uncompressed data goes here
-          stream.next_out=buffer;
-
-          // Parse chunks
-          while(!store.eof()){
-
-            // Get chunk
-            store >> chunklength;
-            store >> chunkid;
-
-            // Palette
-            if(chunkid==PLTE){
-              if(!palette(store,chunklength)){
-                FXTRACE((TOPIC_DETAIL,"fxloadPNG: failed to load PLTE\n"));
-                break;
-                }
-              continue;
-              }
-
-            // Background
-            if(chunkid==bKGD){
-              if(!background(store,chunklength)){
-                FXTRACE((TOPIC_DETAIL,"fxloadPNG: failed to load bKGD\n"));
-                break;
-                }
-              continue;
-              }
-
-            // Transparancy
-            if(chunkid==tRNS){
-              if(!transparency(store,chunklength)){
-                FXTRACE((TOPIC_DETAIL,"fxloadPNG: failed to load tRNS\n"));
-                break;
-                }
-              continue;
-              }
-
-            // Data
-            if(chunkid==IDAT){
-              if(!data(store,chunklength)){
-                FXTRACE((TOPIC_DETAIL,"fxloadPNG: failed to load IDAT\n"));
-                break;
-                }
-              continue;
-              }
-
-            // End
-            if(chunkid==IEND){
-              if(!end(store,chunklength)){
-                FXTRACE((TOPIC_DETAIL,"fxloadPNG: failed to load IEND\n"));
-                break;
-                }
-
-              // Copy to out
-              output_image=image;
-              output_width=width;
-              output_height=height;
-              image=nullptr;
-              result=true;
-              break;
-              }
-
-            // Other chunk
-            // Skip over the data and the crc
-            store.position(chunklength+4,FXFromCurrent);
-            }
-          freeElms(buffer);
-          }
-        freeElms(image);
+      // Decode chunks
+      if(chunks(store)){
+
+        // Copy to out
+        output_image=image;
+        output_width=width;
+        output_height=height;
+        image=nullptr;
+        result=true;
         }
 
       // Close down zlib
@@ -1476,6 +2101,297 @@ FXbool fxcheckPNG(FXStream& store){
 
 /*******************************************************************************/
 
+// Compressed input read at a time by PNG reader
+const FXuint INPUTSIZE=65536;
+
+
+// PNG reader state
+// Unless the image is interlaced, only the current and previous rows are
+// kept, in rows; compressed data is read into input from IDAT chunks as
+// inflate() needs it, and left counts what remains of the current chunk.
+// The header of the chunk following the last IDAT chunk is read when the
+// image data runs out; it is kept in chunklength and chunkid, and pending
+// is set.
+struct FXPNGReader::Decoder : public PNGDecoder {
+  FXuchar      *rows;                   // Current and previous row
+  FXuchar      *input;                  // Compressed input
+  FXuchar      *cur;                    // Current row, with filter byte
+  FXuchar      *prv;                    // Previous row, if any
+  FXuint        left;                   // Bytes left in IDAT chunk
+  FXuint        crc;                    // CRC of IDAT chunk so far
+  FXuint        chunklength;            // Length of pending chunk
+  FXuint        chunkid;                // Id of pending chunk
+  FXbool        pending;                // Read header of next chunk
+  FXbool        inflating;              // Zlib initialized
+  FXbool        swap;                   // Saved byte swap of stream
+public:
+  Decoder():rows(nullptr),input(nullptr),cur(nullptr),prv(nullptr),left(0),crc(0),chunklength(0),chunkid(0),pending(false),inflating(false),swap(false){ }
+  FXbool begin(FXStream& store);
+  FXbool fill(FXStream& store);
+  FXbool line(FXStream& store,FXColor* dst);
+  FXbool skip(FXStream& store);
+ ~Decoder();
+  };
+
+
+// Read header and chunks up to the first IDAT chunk
+// Interlaced images are decoded in full.
+FXbool FXPNGReader::Decoder::begin(FXStream& store){
+  if(header(store) && inflateInit(&stream)==Z_OK){
+    inflating=true;
+    if(interlace==Adam7){
+      return chunks(store);
+      }
+    if(allocElms(rows,((numbytes+1)<<1)+32) && allocElms(input,INPUTSIZE)){
+      cur=rows;
+      while(!store.eof()){
+        store >> chunklength;
+        store >> chunkid;
+        if(store.status()!=FXStreamOK) break;
+        if(chunkid==PLTE){
+          if(!palette(store,chunklength)) break;
+          continue;
+          }
+        if(chunkid==bKGD){
+          if(!background(store,chunklength)) break;
+          continue;
+          }
+        if(chunkid==tRNS){
+          if(!transparency(store,chunklength)) break;
+          continue;
+          }
+        if(chunkid==IDAT){
+          crc=CRC32::CRC(~0,IDAT);
+          left=chunklength;
+          return true;
+          }
+        if(chunkid==IEND) break;
+        store.position(chunklength+4,FXFromCurrent);
+        }
+      }
+    }
+  return false;
+  }
+
+
+// Refill compressed input, moving on to the next IDAT chunk when this
+// one is used up; return false if no image data is left
+FXbool FXPNGReader::Decoder::fill(FXStream& store){
+  FXuint chunkcrc=0;
+  while(left==0){
+    if(pending) return false;
+    store >> chunkcrc;
+    if(chunkcrc!=~crc){
+      FXTRACE((TOPIC_DETAIL,"FXPNGReader: IDAT crc mismatch\n"));
+      return false;
+      }
+    store >> chunklength;
+    store >> chunkid;
+    if(store.status()!=FXStreamOK) return false;
+    if(chunkid!=IDAT){
+      pending=true;
+      return false;
+      }
+    crc=CRC32::CRC(~0,IDAT);
+    left=chunklength;
+    }
+  stream.avail_in=FXMIN(left,INPUTSIZE);
+  stream.next_in=input;
+  store.load(input,stream.avail_in);
+  crc=CRC32::CRC(crc,input,stream.avail_in);
+  left-=stream.avail_in;
+  return (store.status()==FXStreamOK);
+  }
+
+
+// Inflate and decode one row into dst
+FXbool FXPNGReader::Decoder::line(FXStream& store,FXColor* dst){
+  FXint zstatus;
+  FXuchar filt;
+  stream.next_out=cur;
+  stream.avail_out=numbytes+1;
+  while(0<stream.avail_out){
+    if(stream.avail_in==0 && !fill(store)){
+      FXTRACE((TOPIC_DETAIL,"FXPNGReader: image data too short\n"));
+      return false;
+      }
+    zstatus=inflate(&stream,Z_NO_FLUSH);
+    if(zstatus<=Z_ERRNO || (zstatus==Z_STREAM_END && 0<stream.avail_out)){
+      FXTRACE((TOPIC_DETAIL,"FXPNGReader: inflate returned: %d\n",zstatus));
+      return false;
+      }
+    }
+  filt=cur[0];
+  if(__unlikely(FiltPaeth<filt)) return false;
+  decodeLine(filt,cur+1,prv?prv+1:nullptr,numbytes,stride,features);
+  decodeFunc[imagetype][logBitdepth[bitdepth]](dst,this,cur+1,width,1);
+  applyTransparency(dst,width);
+  prv=cur;
+  cur=(cur==rows)?rows+numbytes+1:rows;
+  return true;
+  }
+
+
+// Skip rest of image data, and following chunks up to and including IEND
+FXbool FXPNGReader::Decoder::skip(FXStream& store){
+  FXuint chunkcrc=0;
+  FXuint n;
+  if(interlace==Adam7) return true;
+  if(!pending){
+    while(0<left){
+      n=FXMIN(left,INPUTSIZE);
+      store.load(input,n);
+      crc=CRC32::CRC(crc,input,n);
+      left-=n;
+      }
+    store >> chunkcrc;
+    if(chunkcrc!=~crc){
+      FXTRACE((TOPIC_DETAIL,"FXPNGReader: IDAT crc mismatch\n"));
+      return false;
+      }
+    store >> chunklength;
+    store >> chunkid;
+    pending=true;
+    }
+  while(store.status()==FXStreamOK){
+    if(chunkid==IEND){
+      store >> chunkcrc;
+      return chunklength==0 && chunkcrc==~CRC32::CRC(~0,IEND) && store.status()==FXStreamOK;
+      }
+    store.position(chunklength+4,FXFromCurrent);
+    store >> chunklength;
+    store >> chunkid;
+    }
+  return false;
+  }
+
+
+// Free decoder state
+FXPNGReader::Decoder::~Decoder(){
+  if(inflating) inflateEnd(&stream);
+  freeElms(image);
+  freeElms(rows);
+  freeElms(input);
+  }
+
+
+// Create PNG reader
+FXPNGReader::FXPNGReader():decoder(nullptr){
+  }
+
+
+// Start reading PNG image
+FXbool FXPNGReader::start(FXStream& str){
+  delete decoder;
+  decoder=nullptr;
+  store=nullptr;
+  width=height=row=0;
+  if(str.direction()==FXStreamLoad){
+    FXuchar sig[8]={0,0,0,0,0,0,0,0};
+    FXbool swap=str.swapBytes();
+    str.setBigEndian(true);
+    str.load(sig,8);
+    if(equalElms(sig,signature,8)){
+      decoder=new Decoder;
+      decoder->swap=swap;
+      if(decoder->begin(str)){
+        store=&str;
+        width=decoder->width;
+        height=decoder->height;
+        return true;
+        }
+      delete decoder;
+      decoder=nullptr;
+      }
+    str.swapBytes(swap);
+    }
+  return false;
+  }
+
+
+// Read up to n rows
+FXint FXPNGReader::read(FXColor* buffer,FXint n,FXint stride){
+  FXint count=0;
+  if(decoder){
+    while(count<n && row<height){
+      if(decoder->image){
+        copyElms(buffer+(FXival)count*stride,decoder->image+(FXival)row*width,width);
+        }
+      else if(!decoder->line(*store,buffer+(FXival)count*stride)){
+        break;
+        }
+      ++count;
+      ++row;
+      }
+    }
+  return count;
+  }
+
+
+// Finish reading PNG image
+FXbool FXPNGReader::finish(){
+  FXbool result=false;
+  if(decoder){
+    result=decoder->skip(*store);
+    store->swapBytes(decoder->swap);
+    delete decoder;
+    decoder=nullptr;
+    store=nullptr;
+    }
+  return result;
+  }
+
+
+// Destroy PNG reader
+FXPNGReader::~FXPNGReader(){
+  if(decoder) store->swapBytes(decoder->swap);
+  delete decoder;
+  }
+
+
+// Load a PNG image, scaled down to fit in size by size pixels;
+// rows are read one at a time, and averaged into the scaled image.
+FXbool fxloadScaledPNG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint size){
+  FXPNGReader reader;
+  FXbool result=false;
+  data=nullptr;
+  width=0;
+  height=0;
+  if(reader.start(store)){
+    width=reader.getWidth();
+    height=reader.getHeight();
+    if(0<size && (width>size || height>size)){
+      if(width>height){
+        height=FXMAX((FXint)(((FXlong)size*height)/width),1);
+        width=size;
+        }
+      else{
+        width=FXMAX((FXint)(((FXlong)size*width)/height),1);
+        height=size;
+        }
+      }
+    if(allocElms(data,(FXival)width*height)){
+      if(width==reader.getWidth() && height==reader.getHeight()){
+        result=(reader.read(data,height,width)==height);
+        }
+      else{
+        result=reader.readScaled(data,width,height,width);
+        }
+      result&=reader.finish();
+      if(!result){
+        freeElms(data);
+        }
+      }
+    }
+  if(!result){
+    width=0;
+    height=0;
+    }
+  return result;
+  }
+
+/*******************************************************************************/
+
 // PNG Encoder
 class PNGEncoder {
 public:
@@ -1506,8 +2422,10 @@ public:
   FXbool header(FXStream& store);
   FXbool palette(FXStream& store) const;
   FXbool transparency(FXStream& store) const;
+  void encodeRows(FXuchar* dst,FXuchar* prv,FXuchar* cur,FXuchar* tmp,FXuint fm,FXuint to,FXuint flags) const;
   FXbool encode(FXuint flags);
   FXbool data(FXStream& store);
+  FXbool strips(FXStream& store,FXThreadPool* pool,FXint level,FXuint flags);
   FXbool end(FXStream& store);
 public:
 
@@ -1830,7 +2748,7 @@ static void encodeIndex4BPP(FXuchar* dst,const PNGEncoder* enc,const FXColor* sr
     src+=2;
     n-=2;
     }
-  if(1<=n){ *dst++=enc->index(src[0]); }
+  if(1<=n){ *dst++=(enc->index(src[0])<<4); }
   }
 
 
@@ -2040,24 +2958,62 @@ PERFORMANCE_RECORDER(PNGEncoder_encodeLine);
 static void encodeLine(FXuchar filt,FXuchar*  __restrict dst,const FXuchar*  __restrict cur,const FXuchar* __restrict prv,FXuval count,FXuval step){
   PERFORMANCE_COUNTER(PNGEncoder_encodeLine);
   FXuval i=0;
+#if defined(FOX_HAS_SSE2)
+  const __m128i zero=_mm_setzero_si128();
+  const __m128i one=_mm_set1_epi8(1);
+  __m128i x,a,b,c;
+#endif
   switch(filt){
   case FiltNone:
-    do{ dst[i]=cur[i]; }while(++i<count);
+    memcpy(dst,cur,count);
     return;
   case FiltSub:
-    do{ dst[i]=cur[i]; }while(++i<step);
-    do{ dst[i]=cur[i]-cur[i-step]; }while(++i<count);
+    for(; i<step; ++i){ dst[i]=cur[i]; }
+#if defined(FOX_HAS_SSE2)
+    for(; i+16<=count; i+=16){
+      x=_mm_loadu_si128((const __m128i*)(cur+i));
+      a=_mm_loadu_si128((const __m128i*)(cur+i-step));
+      _mm_storeu_si128((__m128i*)(dst+i),_mm_sub_epi8(x,a));
+      }
+#endif
+    for(; i<count; ++i){ dst[i]=cur[i]-cur[i-step]; }
     return;
   case FiltUp:
-    do{ dst[i]=cur[i]-prv[i]; }while(++i<count);
+#if defined(FOX_HAS_SSE2)
+    for(; i+16<=count; i+=16){
+      x=_mm_loadu_si128((const __m128i*)(cur+i));
+      b=_mm_loadu_si128((const __m128i*)(prv+i));
+      _mm_storeu_si128((__m128i*)(dst+i),_mm_sub_epi8(x,b));
+      }
+#endif
+    for(; i<count; ++i){ dst[i]=cur[i]-prv[i]; }
     return;
   case FiltAvg:
-    do{ dst[i]=cur[i]-(prv[i]>>1); }while(++i<step);
-    do{ dst[i]=cur[i]-((cur[i-step]+prv[i])>>1); }while(++i<count);
+    for(; i<step; ++i){ dst[i]=cur[i]-(prv[i]>>1); }
+#if defined(FOX_HAS_SSE2)
+    for(; i+16<=count; i+=16){                  // Rounding average, less one where a+b is odd
+      x=_mm_loadu_si128((const __m128i*)(cur+i));
+      a=_mm_loadu_si128((const __m128i*)(cur+i-step));
+      b=_mm_loadu_si128((const __m128i*)(prv+i));
+      c=_mm_sub_epi8(_mm_avg_epu8(a,b),_mm_and_si128(_mm_xor_si128(a,b),one));
+      _mm_storeu_si128((__m128i*)(dst+i),_mm_sub_epi8(x,c));
+      }
+#endif
+    for(; i<count; ++i){ dst[i]=cur[i]-((cur[i-step]+prv[i])>>1); }
     return;
   case FiltPaeth:
-    do{ dst[i]=cur[i]-prv[i]; }while(++i<step);
-    do{ dst[i]=cur[i]-predictor(cur[i-step],prv[i],prv[i-step]); }while(++i<count);
+    for(; i<step; ++i){ dst[i]=cur[i]-prv[i]; }
+#if defined(FOX_HAS_SSE2)
+    for(; i+16<=count; i+=16){                  // Predict in 16 bits, eight bytes at a time
+      x=_mm_loadu_si128((const __m128i*)(cur+i));
+      a=_mm_loadu_si128((const __m128i*)(cur+i-step));
+      b=_mm_loadu_si128((const __m128i*)(prv+i));
+      c=_mm_loadu_si128((const __m128i*)(prv+i-step));
+      a=_mm_packus_epi16(predictor8(_mm_unpacklo_epi8(a,zero),_mm_unpacklo_epi8(b,zero),_mm_unpacklo_epi8(c,zero)),predictor8(_mm_unpackhi_epi8(a,zero),_mm_unpackhi_epi8(b,zero),_mm_unpackhi_epi8(c,zero)));
+      _mm_storeu_si128((__m128i*)(dst+i),_mm_sub_epi8(x,a));
+      }
+#endif
+    for(; i<count; ++i){ dst[i]=cur[i]-predictor(cur[i-step],prv[i],prv[i-step]); }
     return;
   default:
     __unreachable();
@@ -2065,24 +3021,40 @@ static void encodeLine(FXuchar filt,FXuchar*  __restrict dst,const FXuchar*  __r
   }
 
 
-// Calculate score, an indication of how well the line may be compressed
-// Nicely vectorizes with pabsb/pmovzxbw/pmovzxwd on x86-64-v3...
-static inline FXint calculateScore(const FXuchar* pix,FXuval n){
-  FXint result=0;
-  while(n){ result+=Math::iabs((FXint)(FXschar)*pix++); --n; }
+// Calculate score, an indication of how well the line may be compressed;
+// this is the sum of the filtered bytes, taken as signed magnitudes.
+// With SSE2, |x| is min(x,-x) as unsigned bytes, summed by psadbw.
+static inline FXuval calculateScore(const FXuchar* pix,FXuval n){
+  FXuval result=0,i=0;
+#if defined(FOX_HAS_SSE2)
+  const __m128i zero=_mm_setzero_si128();
+  __m128i sum=_mm_setzero_si128();
+  __m128i x;
+  for(; i+16<=n; i+=16){
+    x=_mm_loadu_si128((const __m128i*)(pix+i));
+    sum=_mm_add_epi64(sum,_mm_sad_epu8(_mm_min_epu8(x,_mm_sub_epi8(zero,x)),zero));
+    }
+  result=(FXuint)_mm_cvtsi128_si32(sum)+(FXuint)_mm_cvtsi128_si32(_mm_unpackhi_epi64(sum,sum));
+#endif
+  for(; i<n; ++i){ result+=Math::iabs((FXint)(FXschar)pix[i]); }
   return result;
   }
 
 
-// Determine best filter, given
-static inline FXuchar findBestFilter(FXuchar* __restrict dst,const FXuchar* __restrict cur,const FXuchar* __restrict prv,FXuval count,FXuval step){
-  FXint   bestsum=2147483647,sum;
+// Determine best filter, leaving the line filtered with it in dst;
+// each filter is tried in whichever of dst and tmp does not hold the
+// best line so far.
+static inline FXuchar findBestFilter(FXuchar* __restrict dst,FXuchar* __restrict tmp,const FXuchar* __restrict cur,const FXuchar* __restrict prv,FXuval count,FXuval step){
+  FXuval  bestsum=~(FXuval)0,sum;
   FXuchar bestflt=FiltNone;
+  FXuchar *best=tmp;
+  FXuchar *next=dst;
   for(FXuchar flt=FiltNone; flt<=FiltPaeth; ++flt){
-    encodeLine(flt,dst,cur,prv,count,step);
-    sum=calculateScore(dst,count);
-    if(sum<bestsum){ bestflt=flt; bestsum=sum; }
+    encodeLine(flt,next,cur,prv,count,step);
+    sum=calculateScore(next,count);
+    if(sum<bestsum){ bestflt=flt; bestsum=sum; swap(best,next); }
     }
+  if(best!=dst){ memcpy(dst,best,count); }
   return bestflt;
   }
 
@@ -2092,36 +3064,39 @@ static inline FXuchar findBestFilter(FXuchar* __restrict dst,const FXuchar* __re
 PERFORMANCE_RECORDER(PNGEncoder_encode);
 
 
-// Encode image to space at end of buffer, using two extra
-// lines during the encoding, if needed.
-// Only apply filter for bit-depths of at least 8; otherwise
-// just copy to destination in buffer.
-FXbool PNGEncoder::encode(FXuint flags){
-  PERFORMANCE_COUNTER(PNGEncoder_encode);
+// Encode rows fm...to-1 of image to dst, using three lines prv, cur,
+// and tmp during the encoding, if needed.
+// The line above row fm is packed again to serve as the previous line,
+// so that rows of a strip are filtered the same as when done in one go.
+void PNGEncoder::encodeRows(FXuchar* dst,FXuchar* prv,FXuchar* cur,FXuchar* tmp,FXuint fm,FXuint to,FXuint flags) const {
   EncodeFunc ef=encodeFunc[imagetype][logBitdepth[bitdepth]];
-  FXuchar*       dst=buffer+buffersize-totbytes;
-  FXuchar*       prv=buffer;
-  FXuchar*       cur=buffer+numbytes;
-  const FXColor* src=image;
+  const FXColor* src=image+(FXuval)fm*width;
   FXuchar        flt=(flags&PNG_FILTER_MASK);
 
   // No filter, copy to destination directly
   if(flt==PNG_FILTER_NONE){
-    for(FXuint row=0; row<height; ++row){
+    for(FXuint row=fm; row<to; ++row){
       ef(dst+1,this,src,width);
       dst[0]=FiltNone;
       dst+=numbytes+1;
       src+=width;
       }
+    return;
+    }
+
+  // Previous line of first row
+  if(0<fm){
+    ef(prv,this,src-width,width);
+    }
+  else{
+    clearElms(prv,numbytes);
     }
 
   // Find and use best filter
-  else if(flt==PNG_FILTER_BEST){
-    for(FXuint row=0; row<height; ++row){
+  if(flt==PNG_FILTER_BEST){
+    for(FXuint row=fm; row<to; ++row){
       ef(cur,this,src,width);
-      flt=findBestFilter(dst+1,cur,prv,numbytes,stride);
-      encodeLine(flt,dst+1,cur,prv,numbytes,stride);
-      dst[0]=flt;
+      dst[0]=findBestFilter(dst+1,tmp,cur,prv,numbytes,stride);
       dst+=numbytes+1;
       src+=width;
       swap(prv,cur);
@@ -2130,7 +3105,7 @@ FXbool PNGEncoder::encode(FXuint flags){
 
   // Encode with given filter
   else{
-    for(FXuint row=0; row<height; ++row){
+    for(FXuint row=fm; row<to; ++row){
       ef(cur,this,src,width);
       encodeLine(flt,dst+1,cur,prv,numbytes,stride);
       dst[0]=flt;
@@ -2139,7 +3114,17 @@ FXbool PNGEncoder::encode(FXuint flags){
       swap(prv,cur);
       }
     }
-  FXTRACE((TOPIC_DETAIL,"fxsavePNG: encoded: %u/%u\n",(FXuint)(dst-buffer-buffersize+totbytes),totbytes));
+  }
+
+
+// Encode image to space at end of buffer, using three extra
+// lines at the start of the buffer during the encoding.
+// Only apply filter for bit-depths of at least 8; otherwise
+// just copy to destination in buffer.
+FXbool PNGEncoder::encode(FXuint flags){
+  PERFORMANCE_COUNTER(PNGEncoder_encode);
+  encodeRows(buffer+buffersize-totbytes,buffer,buffer+numbytes,buffer+2*numbytes,0,height,flags);
+  FXTRACE((TOPIC_DETAIL,"fxsavePNG: encoded: %u\n",totbytes));
   return true;
   }
 
@@ -2211,6 +3196,174 @@ FXbool PNGEncoder::data(FXStream& store){
   }
 
 
+// Size of filtered data in each strip
+#define STRIPSIZE 262144
+
+
+// Compressed strip
+struct PNGStrip {
+  FXuchar *data;                // Compressed data
+  FXuint   size;                // Size of compressed data
+  FXuint   adler;               // Adler-32 of filtered data
+  };
+
+
+// Filter strips of rows into raw
+class PNGFilterStrips {
+  const PNGEncoder *encoder;
+  FXuchar          *raw;
+  const FXuint      rows;
+  const FXuint      flags;
+  volatile FXint   *failed;
+public:
+  PNGFilterStrips(const PNGEncoder* en,FXuchar* r,FXuint n,FXuint f,volatile FXint* fail):encoder(en),raw(r),rows(n),flags(f),failed(fail){ }
+  void operator()(FXuint s) const {
+    FXuint fm=s*rows;
+    FXuint to=FXMIN(fm+rows,encoder->height);
+    FXuchar *lines;
+    if(allocElms(lines,encoder->numbytes*3)){
+      encoder->encodeRows(raw+(FXuval)fm*(encoder->numbytes+1),lines,lines+encoder->numbytes,lines+encoder->numbytes*2,fm,to,flags);
+      freeElms(lines);
+      return;
+      }
+    atomicSet(failed,1);
+    }
+  };
+
+
+// Deflate strips of raw, each primed with the data before it
+class PNGDeflateStrips {
+  PNGStrip         *strip;
+  const FXuchar    *raw;
+  const FXuval      total;
+  const FXuval      length;
+  const FXuint      nstrips;
+  const FXint       level;
+  volatile FXint   *failed;
+public:
+  PNGDeflateStrips(PNGStrip* st,const FXuchar* r,FXuval tot,FXuval len,FXuint n,FXint lev,volatile FXint* fail):strip(st),raw(r),total(tot),length(len),nstrips(n),level(lev),failed(fail){ }
+  void operator()(FXuint s) const {
+    const FXuchar* src=raw+length*s;
+    FXuval  size=FXMIN(length,total-length*s);
+    FXuval  dict=FXMIN(length*s,32768);
+    FXint   flush=(s+1<nstrips)?Z_FULL_FLUSH:Z_FINISH;
+    FXint   done=(s+1<nstrips)?Z_OK:Z_STREAM_END;
+    FXuint  bound;
+    z_stream zs;
+    clearElms(&zs,1);
+    if(deflateInit2(&zs,level,Z_DEFLATED,-MAX_WBITS,8,Z_DEFAULT_STRATEGY)==Z_OK){
+      bound=deflateBound(&zs,size)+16;                  // Plus room for flush marker
+      if(allocElms(strip[s].data,bound)){
+        if(dict==0 || deflateSetDictionary(&zs,src-dict,dict)==Z_OK){
+          zs.next_in=(Bytef*)src;
+          zs.avail_in=size;
+          zs.next_out=strip[s].data;
+          zs.avail_out=bound;
+          if(deflate(&zs,flush)==done && zs.avail_in==0 && zs.avail_out!=0){
+            strip[s].size=bound-zs.avail_out;
+            strip[s].adler=adler32(adler32(0,nullptr,0),src,size);
+            deflateEnd(&zs);
+            return;
+            }
+          }
+        }
+      deflateEnd(&zs);
+      }
+    atomicSet(failed,1);
+    }
+  };
+
+
+PERFORMANCE_RECORDER(PNGEncoder_strips);
+
+
+// Save image data as strips, filtered and deflated in parallel on the
+// thread pool, then written as a single zlib stream in one IDAT chunk.
+FXbool PNGEncoder::strips(FXStream& store,FXThreadPool* pool,FXint level,FXuint flags){
+  PERFORMANCE_COUNTER(PNGEncoder_strips);
+  FXuint rows=FXMAX(STRIPSIZE/(numbytes+1),1);
+  FXuint nstrips=(height+rows-1)/rows;
+  FXuval striplen=(FXuval)rows*(numbytes+1);
+  volatile FXint failed=0;
+  FXbool result=false;
+  PNGStrip *strip;
+  FXuchar *raw;
+
+  FXTRACE((TOPIC_DETAIL,"fxsavePNG: strips = %u of %u rows\n",nstrips,rows));
+
+  // Allocate strips
+  if(callocElms(strip,nstrips)){
+
+    // Allocate filtered data
+    if(allocElms(raw,totbytes)){
+
+      // Filter strips
+      FXParallelFor(pool,0u,nstrips,1u,nstrips,PNGFilterStrips(this,raw,rows,flags,&failed));
+
+      // Deflate strips
+      if(!failed){
+        FXParallelFor(pool,0u,nstrips,1u,nstrips,PNGDeflateStrips(strip,raw,totbytes,striplen,nstrips,level,&failed));
+        }
+
+      // Write them out
+      if(!failed){
+        FXuint  crc=CRC32::CRC(~0,IDAT);
+        FXuint  adler=adler32(0,nullptr,0);
+        FXuint  length=6;
+        FXuchar zlib[4];
+        FXuint  s;
+
+        // Length of zlib header, strips, and Adler-32
+        for(s=0; s<nstrips; ++s){
+          length+=strip[s].size;
+          }
+
+        FXTRACE((TOPIC_DETAIL,"fxsavePNG: IDAT len: %u\n",length));
+
+        // Save chunk length and chunk id
+        store << length;
+        store << IDAT;
+
+        // Zlib header: deflate, 32K window, and compression level
+        zlib[0]=0x78;
+        zlib[1]=(level==1)?0x00:(level<6 && 0<level)?0x40:(level==6 || level<0)?0x80:0xC0;
+        zlib[1]+=31-((zlib[0]*256+zlib[1])%31);
+        store.save(zlib,2);
+        crc=CRC32::CRC(crc,zlib,2);
+
+        // Strips, and their combined Adler-32
+        for(s=0; s<nstrips; ++s){
+          store.save(strip[s].data,strip[s].size);
+          crc=CRC32::CRC(crc,strip[s].data,strip[s].size);
+          adler=adler32_combine(adler,strip[s].adler,FXMIN(striplen,totbytes-striplen*s));
+          }
+
+        // Adler-32 is big-endian
+        zlib[0]=(FXuchar)(adler>>24);
+        zlib[1]=(FXuchar)(adler>>16);
+        zlib[2]=(FXuchar)(adler>>8);
+        zlib[3]=(FXuchar)adler;
+        store.save(zlib,4);
+        crc=CRC32::CRC(crc,zlib,4);
+
+        // Save CRC
+        crc^=~0;
+        store << crc;
+        result=(store.status()==FXStreamOK);
+        }
+      freeElms(raw);
+      }
+
+    // Free strips
+    for(FXuint s=0; s<nstrips; ++s){
+      freeElms(strip[s].data);
+      }
+    freeElms(strip);
+    }
+  return result;
+  }
+
+
 // Save IEND
 FXbool PNGEncoder::end(FXStream& store){
   FXuint crc=CRC32::CRC(~0,IEND);
@@ -2230,6 +3383,7 @@ PERFORMANCE_RECORDER(PNGEncoder_save);
 FXbool PNGEncoder::save(FXStream& store,const FXColor* img,FXint w,FXint h,FXuint flags){
   PERFORMANCE_COUNTER(PNGEncoder_save);
   FXint  level=Z_DEFAULT_COMPRESSION;
+  FXThreadPool* pool;
   FXbool result=false;
   FXuint mode;
   FXuint ch;
@@ -2306,8 +3460,22 @@ FXbool PNGEncoder::save(FXStream& store,const FXColor* img,FXint w,FXint h,FXuin
     if(flags&PNG_COMPRESS_FAST) level=Z_BEST_SPEED;
     if(flags&PNG_COMPRESS_BEST) level=Z_BEST_COMPRESSION;
 
+    // Set filter to none if less than 2 bytes/pixel
+    if(bitdepth<8){ flags&=~PNG_FILTER_MASK; }
+
+    // Filter and deflate in parallel, if there's a thread pool and more than one strip
+    if((flags&PNG_PARALLEL) && STRIPSIZE<totbytes && (pool=FXThreadPool::instance())!=nullptr && pool->active()){
+
+      // Save strips
+      if(strips(store,pool,level,flags)){
+
+        // Save terminator
+        result=end(store);
+        }
+      }
+
     // Initialize zlib
-    if(deflateInit(&stream,level)==Z_OK){
+    else if(deflateInit(&stream,level)==Z_OK){
 
       // Enough space for deflate() totbytes, plus extra lines
       buffersize=deflateBound(&stream,totbytes+(numbytes<<2));
@@ -2317,9 +3485,6 @@ FXbool PNGEncoder::save(FXStream& store,const FXColor* img,FXint w,FXint h,FXuin
       // Allocate storage
       if(callocElms(buffer,buffersize)){
 
-        // Set filter to none if less than 2 bytes/pixel
-        if(bitdepth<8){ flags&=~PNG_FILTER_MASK; }
-
         // Encode image
         encode(flags);
 
@@ -2399,12 +3564,46 @@ FXbool fxloadPNG(FXStream&,FXColor*& data,FXint& width,FXint& height){
   }
 
 
+// Stub routine
+FXbool fxloadScaledPNG(FXStream& store,FXColor*& data,FXint& width,FXint& height,FXint){
+  return fxloadPNG(store,data,width,height);
+  }
+
+
 // Stub routine
 FXbool fxsavePNG(FXStream&,const FXColor*,FXint,FXint,FXuint){
   return false;
   }
 
 
+// Stub PNG reader
+FXPNGReader::FXPNGReader():decoder(nullptr){
+  }
+
+
+// Stub routine
+FXbool FXPNGReader::start(FXStream&){
+  return false;
+  }
+
+
+// Stub routine
+FXint FXPNGReader::read(FXColor*,FXint,FXint){
+  return 0;
+  }
+
+
+// Stub routine
+FXbool FXPNGReader::finish(){
+  return false;
+  }
+
+
+// Stub PNG reader
+FXPNGReader::~FXPNGReader(){
+  }
+
+
 #endif //////////////////////////////////////////////////////////////////////////
 
 }
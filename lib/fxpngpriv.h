@@ -0,0 +1,35 @@
+/********************************************************************************
+*                                                                               *
+*                P r i v a t e   P N G   D e c o d e r   H o o k s              *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXPNGPRIV_H
+#define FXPNGPRIV_H
+
+// Not part of the API; not installed, and not included by fx.h.
+// Exported only so the tests can reach it in the shared library.
+
+namespace FX {
+
+// Limit processor features used by PNG decoders made from now on to mask;
+// for testing only.  Return previous mask.
+extern FXAPI FXuint __pngfeatures(FXuint mask);
+
+}
+
+#endif
@@ -0,0 +1,131 @@
+/********************************************************************************
+*                                                                               *
+*                     I t e m   L i s t   S o r t i n g                         *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXSORT_H
+#define FXSORT_H
+
+/*
+  Notes:
+  - Internal to the library; shared by FXList and FXIconList.
+  - Items are sorted through an array of entries, each holding an item and its
+    sort key, computed once per item; the sort function is only called to break
+    ties between equal keys.  Without a key function, all keys are zero.
+  - The sort is a stable merge sort: short runs are sorted by insertion first,
+    then merged bottom-up, skipping the merge if the runs are already in order.
+  - If there's no memory for the entries, the items are sorted in place by shell
+    sort, with the sort function only, as was done before.
+*/
+
+namespace FX {
+
+
+// Runs sorted by insertion before merging
+#define SORT_RUN 16
+
+
+// Sort entry; key is computed once per item
+template<typename ITEM>
+struct FXSortEntry {
+  FXlong  key;
+  ITEM   *item;
+  };
+
+
+// Entry a should be placed before entry b
+template<typename ITEM,typename FUNC>
+static inline FXbool before(const FXSortEntry<ITEM>& a,const FXSortEntry<ITEM>& b,FUNC func){
+  return a.key<b.key || (a.key==b.key && func(a.item,b.item)<0);
+  }
+
+
+// Stable merge sort of n entries in a, using b as scratch; returns the
+// array holding the result
+template<typename ITEM,typename FUNC>
+static FXSortEntry<ITEM>* mergesort(FXSortEntry<ITEM>* a,FXSortEntry<ITEM>* b,FXival n,FUNC func){
+  FXSortEntry<ITEM> *src=a,*dst=b,*tmp,t;
+  FXival lo,mid,hi,i,j,k,w;
+  for(lo=0; lo<n; lo+=SORT_RUN){
+    hi=FXMIN(lo+SORT_RUN,n);
+    for(i=lo+1; i<hi; ++i){
+      t=src[i];
+      for(j=i; lo<j && before(t,src[j-1],func); --j){ src[j]=src[j-1]; }
+      src[j]=t;
+      }
+    }
+  for(w=SORT_RUN; w<n; w<<=1){
+    for(lo=0; lo<n; lo+=w+w){
+      mid=FXMIN(lo+w,n);
+      hi=FXMIN(mid+w,n);
+      if(mid<hi && before(src[mid],src[mid-1],func)){
+        for(i=lo,j=mid,k=lo; i<mid && j<hi; ){
+          dst[k++]=before(src[j],src[i],func)?src[j++]:src[i++];
+          }
+        while(i<mid) dst[k++]=src[i++];
+        while(j<hi) dst[k++]=src[j++];
+        }
+      else{
+        for(k=lo; k<hi; ++k) dst[k]=src[k];
+        }
+      }
+    tmp=src; src=dst; dst=tmp;
+    }
+  return src;
+  }
+
+
+// Sort n items by sort key, if any, and sort function; return true if
+// the order of the items changed
+template<typename ITEM,typename FUNC,typename KEY>
+static FXbool sortItemList(ITEM** items,FXival n,FUNC func,KEY key){
+  FXSortEntry<ITEM> *entries,*sorted;
+  FXbool exch=false;
+  FXival i,j,h;
+  ITEM *v;
+  if(allocElms(entries,n+n)){
+    for(i=0; i<n; i++){
+      entries[i].key=key?key(items[i]):0;
+      entries[i].item=items[i];
+      }
+    sorted=mergesort(entries,entries+n,n,func);
+    for(i=0; i<n; i++){
+      if(items[i]!=sorted[i].item){ items[i]=sorted[i].item; exch=true; }
+      }
+    freeElms(entries);
+    return exch;
+    }
+  for(h=1; h<=n/9; h=3*h+1){}
+  for(; h>0; h/=3){
+    for(i=h+1; i<=n; i++){
+      v=items[i-1];
+      j=i;
+      while(j>h && func(items[j-h-1],v)>0){
+        items[j-1]=items[j-h-1];
+        exch=true;
+        j-=h;
+        }
+      items[j-1]=v;
+      }
+    }
+  return exch;
+  }
+
+}
+
+#endif
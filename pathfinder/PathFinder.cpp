@@ -192,6 +192,14 @@ const FXchar fallbackPatterns[]=
   ;
 
 
+// Thumbnail cache directory
+static FXString thumbnailDirectory(){
+  FXString cache=FXSystem::getEnvironment("XDG_CACHE_HOME");
+  if(cache.empty()) cache=FXSystem::getHomeDirectory()+PATHSEPSTRING ".cache";
+  return cache+PATHSEPSTRING "pathfinder" PATHSEPSTRING "thumbnails";
+  }
+
+
 /*******************************************************************************/
 
 // Initialize main window
@@ -201,9 +209,6 @@ PathFinderMain::PathFinderMain(){
 
 // Make some windows
 PathFinderMain::PathFinderMain(FXApp* a):FXMainWindow(a,"PathFinder",nullptr,nullptr,DECOR_ALL,0,0,800,600,0,0),bookmarkeddirs(a,"Bookmarked Directories")
-#if defined(DIRWATCH)
-  ,dirwatch(a) // FIXME
-#endif
 {
 
   // Totals
@@ -350,6 +355,8 @@ PathFinderMain::PathFinderMain(FXApp* a):FXMainWindow(a,"PathFinder",nullptr,nul
   filelist=new FXFileList(switcher,this,ID_FILELIST,LAYOUT_FILL_X|LAYOUT_FILL_Y|ICONLIST_MINI_ICONS|ICONLIST_AUTOSIZE|FILELIST_NO_OWN_ASSOC);
   filelist->horizontalScrollBar()->setWheelLines(1);
   filelist->setAssociations(associations,false,true);
+  filelist->setThreadPool(FXThreadPool::instance());
+  filelist->setThumbnailDirectory(thumbnailDirectory());
   filelist->dropEnable();
 
   // Image view
@@ -1380,16 +1387,8 @@ long PathFinderMain::onCmdDirectory(FXObject*,FXSelector,void* ptr){
   FXTreeItem *item=(FXTreeItem*)ptr;
   FXString path=dirlist->getItemPathname(item);
 
-#if defined(DIRWATCH)
-dirwatch.remWatch(filelist->getDirectory());           // FIXME
-#endif
-
   filelist->setDirectory(path,true);
 
-#if defined(DIRWATCH)
-dirwatch.addWatch(filelist->getDirectory());           // FIXME
-#endif
-
   dirbox->setDirectory(filelist->getDirectory());
   address->setText(filelist->getDirectory());
   visitDirectory(filelist->getDirectory());
@@ -2334,12 +2333,18 @@ int main(int argc,char *argv[]){
     fxerror("FOX Library mismatch; expected version: %d.%d.%d, but found version: %d.%d.%d.\n",FOX_MAJOR,FOX_MINOR,FOX_LEVEL,fxversion[0],fxversion[1],fxversion[2]);
     }
 
+  // Thread pool to make thumbnails; outlives the application
+  FXThreadPool pool;
+
   // Create application
   FXApp application("PathFinder");
 
   // Initialize application
   application.init(argc,argv);
 
+  // Start thread pool
+  pool.start();
+
   // Build GUI
   PathFinderMain* window=new PathFinderMain(&application);
 
@@ -117,9 +117,6 @@ protected:
   FXbool              preview;		        // Preview mode
   FXbool              blending;		        // Icon blending
   FXbool              scaling;                  // Image scaled
-#if defined(DIRWATCH)
-  FXDirWatch dirwatch; // FIXME
-#endif
 protected:
   PathFinderMain();
   FXbool haveSelectedFiles() const;
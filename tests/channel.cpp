@@ -0,0 +1,195 @@
+/********************************************************************************
+*                                                                               *
+*                     M e s s a g e   C h a n n e l   T e s t                   *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Several worker threads send messages through an FXMessageChannel as fast as
+    they can; the main thread reads the channel by calling its handler directly,
+    as FXApp would when the channel's wakeup handle is raised.
+  - Check that every message arrives once, in order per sender, with its payload,
+    and report how many messages were delivered per call of the handler.
+  - Check that coalesced messages deliver the latest value, and that large and
+    handed off payloads arrive intact.
+*/
+
+/*******************************************************************************/
+
+const FXint SENDERS=4;
+const FXint COUNT=250000;
+
+
+// Progress message
+struct Progress {
+  FXint sender;
+  FXint value;
+  };
+
+
+// Receiver of messages
+class Receiver : public FXObject {
+  FXDECLARE(Receiver)
+public:
+  FXint    next[SENDERS];
+  FXint    received;
+  FXint    coalesced;
+  FXint    latest;
+  FXint    big;
+  FXint    errors;
+public:
+  enum{
+    ID_PROGRESS=1,
+    ID_COALESCED,
+    ID_BIG,
+    ID_HANDOFF
+    };
+public:
+  Receiver():received(0),coalesced(0),latest(-1),big(0),errors(0){ for(FXint s=0; s<SENDERS; ++s) next[s]=0; }
+  long onProgress(FXObject*,FXSelector,void*);
+  long onCoalesced(FXObject*,FXSelector,void*);
+  long onBig(FXObject*,FXSelector,void*);
+  };
+
+
+// Map
+FXDEFMAP(Receiver) ReceiverMap[]={
+  FXMAPFUNC(SEL_COMMAND,Receiver::ID_PROGRESS,Receiver::onProgress),
+  FXMAPFUNC(SEL_COMMAND,Receiver::ID_COALESCED,Receiver::onCoalesced),
+  FXMAPFUNCS(SEL_COMMAND,Receiver::ID_BIG,Receiver::ID_HANDOFF,Receiver::onBig)
+  };
+
+FXIMPLEMENT(Receiver,FXObject,ReceiverMap,ARRAYNUMBER(ReceiverMap))
+
+
+// Messages from each sender arrive in order
+long Receiver::onProgress(FXObject*,FXSelector,void* ptr){
+  const Progress* p=(const Progress*)ptr;
+  if(!p || p->sender<0 || SENDERS<=p->sender || p->value!=next[p->sender]){ errors++; return 1; }
+  next[p->sender]++;
+  received++;
+  return 1;
+  }
+
+
+// Coalesced values only increase
+long Receiver::onCoalesced(FXObject*,FXSelector,void* ptr){
+  const Progress* p=(const Progress*)ptr;
+  if(!p || p->value<=latest){ errors++; return 1; }
+  latest=p->value;
+  coalesced++;
+  return 1;
+  }
+
+
+// Big payload is a sequence of bytes
+long Receiver::onBig(FXObject*,FXSelector sel,void* ptr){
+  const FXuchar* data=(const FXuchar*)ptr;
+  FXint size=(FXSELID(sel)==ID_BIG)?5000:1000000;
+  for(FXint i=0; i<size; ++i){
+    if(data[i]!=(FXuchar)i){ errors++; return 1; }
+    }
+  big++;
+  return 1;
+  }
+
+
+// Worker thread sending messages
+class Sender : public FXThread {
+public:
+  FXMessageChannel *channel;
+  Receiver         *receiver;
+  FXint             sender;
+  FXbool            coalesce;
+public:
+  Sender():channel(nullptr),receiver(nullptr),sender(0),coalesce(false){}
+  virtual FXint run();
+  };
+
+
+// Send progress messages
+FXint Sender::run(){
+  Progress p={sender,0};
+  for(p.value=0; p.value<COUNT; ++p.value){
+    if(coalesce)
+      channel->coalesce(receiver,FXSEL(SEL_COMMAND,Receiver::ID_COALESCED),&p,sizeof(p));
+    else
+      channel->message(receiver,FXSEL(SEL_COMMAND,Receiver::ID_PROGRESS),&p,sizeof(p));
+    }
+  return 0;
+  }
+
+
+// Read channel until all senders are done and channel is empty;
+// return the number of reads which delivered any messages
+static FXint drain(FXMessageChannel* channel,Sender* senders,FXint n){
+  FXint reads=0;
+  FXint s;
+  while(1){
+    for(s=0; s<n; ++s){
+      if(senders[s].running()) break;
+      }
+    if(channel->handle(channel,FXSEL(SEL_IO_READ,FXMessageChannel::ID_IO_READ),nullptr)){
+      reads++;
+      continue;
+      }
+    if(s==n) break;
+    FXThread::yield();
+    }
+  return reads;
+  }
+
+
+// Start
+int main(int,char**){
+  FXApp app("channel");
+  FXMessageChannel *channel=new FXMessageChannel(&app);
+  Receiver receiver;
+  Sender senders[SENDERS];
+  FXuchar bytes[5000];
+  FXuchar *heap;
+  FXTime start;
+  FXint i,calls;
+
+  // Many senders
+  start=FXThread::time();
+  for(i=0; i<SENDERS; ++i){
+    senders[i].channel=channel;
+    senders[i].receiver=&receiver;
+    senders[i].sender=i;
+    senders[i].start();
+    }
+  calls=drain(channel,senders,SENDERS);
+  for(i=0; i<SENDERS; ++i) senders[i].join();
+  fxmessage("%d messages from %d senders: %.3lfms, %.0lf messages/s, %.1lf messages per read\n",receiver.received,SENDERS,elapsed(start),receiver.received/(0.001*elapsed(start)),(FXdouble)receiver.received/calls);
+
+  // Coalescing sender
+  start=FXThread::time();
+  senders[0].coalesce=true;
+  senders[0].start();
+  drain(channel,senders,1);
+  senders[0].join();
+  fxmessage("%d coalesced messages: %.3lfms, %d delivered, latest %d\n",COUNT,elapsed(start),receiver.coalesced,receiver.latest);
+
+  // Big payloads
+  for(i=0; i<(FXint)sizeof(bytes); ++i) bytes[i]=(FXuchar)i;
+  channel->message(&receiver,FXSEL(SEL_COMMAND,Receiver::ID_BIG),bytes,sizeof(bytes));
+  allocElms(heap,1000000);
+  for(i=0; i<1000000; ++i) heap[i]=(FXuchar)i;
+  channel->handoff(&receiver,FXSEL(SEL_COMMAND,Receiver::ID_HANDOFF),heap,1000000);
+  channel->handle(channel,FXSEL(SEL_IO_READ,FXMessageChannel::ID_IO_READ),nullptr);
+
+  delete channel;
+
+  if(receiver.errors || receiver.received!=SENDERS*COUNT || receiver.latest!=COUNT-1 || receiver.big!=2){
+    fxmessage("FAILED: %d errors\n",receiver.errors);
+    return 1;
+    }
+  fxmessage("OK\n");
+  return 0;
+  }
@@ -0,0 +1,59 @@
+/********************************************************************************
+*                                                                               *
+*                           T e s t   C h e c k s                               *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#ifndef CHECKS_H
+#define CHECKS_H
+
+/*
+  Notes:
+  - Shared by the test programs which check their results, rather than just
+    show them; include after fx.h.
+  - Each failed check is reported, and counted; report() prints OK or FAILED
+    at the end, and returns the exit code.
+  - Random text for the tests is drawn from a small set of characters, with
+    repeats making the more common ones.
+*/
+
+// Number of failed checks
+static FXint failures=0;
+
+
+// Check condition
+static inline void check(FXbool cond,const FXchar* what){
+  if(!cond){ fxwarning("FAILED: %s\n",what); failures++; }
+  }
+
+
+// Check condition, showing the two values involved
+template<typename A,typename B>
+static inline void check(FXbool cond,const FXchar* what,A a,B b){
+  if(!cond){ fxwarning("FAILED: %s: %s %s\n",what,FXString::value(a).text(),FXString::value(b).text()); failures++; }
+  }
+
+
+// Time since start, in milliseconds
+static inline FXdouble elapsed(FXTime start){
+  return 0.000001*(FXThread::time()-start);
+  }
+
+
+// Fill text with random characters from chars
+static inline void randomText(FXRandom& random,FXchar* text,FXint size,const FXchar* chars){
+  FXuval n=strlen(chars);
+  for(FXint i=0; i<size; ++i){
+    text[i]=chars[random.randLong()%n];
+    }
+  }
+
+
+// Print outcome of the checks; return exit code
+static inline FXint report(){
+  fxmessage(failures?"FAILED\n":"OK\n");
+  return failures?1:0;
+  }
+
+#endif
@@ -0,0 +1,129 @@
+/********************************************************************************
+*                                                                               *
+*                  G l y p h   A d v a n c e   C a c h e   T e s t              *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Needs a display, as the font has to be created to be measured.
+  - Check that the width of a text equals the sum of the widths of its characters,
+    for ASCII, Latin-1, other BMP characters, and characters beyond the BMP; and
+    that widths stay the same after the font is recreated.
+  - Time measuring text one character at a time, as FXText does, and all at once.
+  - Time wrapping a big text to the window width in FXText, which measures every
+    character in the text, and wrapping it again to another width.
+  - If a file is passed, load it instead of generating the big text.
+*/
+
+/*******************************************************************************/
+
+// Make text of words, with some non-ASCII ones thrown in
+static FXString makeText(FXRandom& random,FXint size){
+  static const FXchar *const words[]={"the ","glyph ","advance ","cache ","font ","width ","wrap ","reflow ","na\xC3\xAFve ","\xCE\xB1\xCE\xB2\xCE\xB3 ","\xE2\x82\xAC ","\n"};
+  FXString text;
+  FXint i,n;
+  text.length(size);
+  for(i=0; i<size; i+=n){
+    const FXchar* w=words[random.randLong()%ARRAYNUMBER(words)];
+    for(n=0; w[n] && i+n<size; ++n) text[i+n]=w[n];
+    }
+  return text;
+  }
+
+
+// Sum widths of characters one at a time
+static FXint sumChars(FXFont* font,const FXString& string){
+  FXint width=0;
+  for(FXint p=0; p<string.length(); p=string.inc(p)){
+    width+=font->getCharWidth(string.wc(p));
+    }
+  return width;
+  }
+
+
+// Compare text widths against sums of character widths
+static void compare(FXFont* font){
+  static const FXchar *const strings[]={"","a","Hello, World!","0123456789abcdefghijklmnopqrstuvwxyz","tab\tand\x01 control","na\xC3\xAFve caf\xC3\xA9","\xCE\xB1\xCE\xB2\xCE\xB3 \xE2\x82\xAC 12","\xF0\x9F\x98\x80 smile \xF0\x9F\x98\x80"};
+  for(FXint i=0; i<(FXint)ARRAYNUMBER(strings); ++i){
+    FXString s(strings[i]);
+    check(font->getTextWidth(s)==sumChars(font,s),strings[i],font->getTextWidth(s),sumChars(font,s));
+    }
+  }
+
+
+// Time measuring text by characters, and all at once
+static void benchmark(FXFont* font,const FXString& text){
+  FXTime start;
+  FXint w1,w2;
+  start=FXThread::time();
+  w1=sumChars(font,text);
+  fxmessage("  getCharWidth: %9.3lfms",elapsed(start));
+  start=FXThread::time();
+  w2=font->getTextWidth(text);
+  fxmessage(", getTextWidth: %9.3lfms\n",elapsed(start));
+  check(w1==w2,"big text width",w1,w2);
+  }
+
+
+// Start
+int main(int argc,char *argv[]){
+  FXApp app("fontcache");
+  FXRandom random(1234);
+  FXString big;
+  FXTime start;
+  FXint w;
+
+  // Need display to measure fonts
+  app.init(argc,argv,false);
+  if(!app.openDisplay()){
+    fxmessage("No display\n");
+    return 0;
+    }
+
+  FXMainWindow *main=new FXMainWindow(&app,"fontcache",nullptr,nullptr,DECOR_ALL,0,0,800,600);
+  FXText *text=new FXText(main,nullptr,0,LAYOUT_FILL_X|LAYOUT_FILL_Y|TEXT_WORDWRAP);
+  FXFont *font=new FXFont(&app,"helvetica,100");
+  app.create();
+
+  // Correctness
+  font->create();
+  compare(font);
+  w=font->getTextWidth("abc\xE2\x82\xAC",6);
+  font->destroy();
+  font->create();
+  check(font->getTextWidth("abc\xE2\x82\xAC",6)==w,"recreated font",font->getTextWidth("abc\xE2\x82\xAC",6),w);
+  compare(font);
+
+  // Big text
+  if(1<argc){
+    FXFile file(argv[1],FXIO::Reading);
+    big.length((FXint)file.size());
+    if(!file.isOpen() || file.readBlock(big.text(),big.length())!=big.length()){ fxwarning("Unable to read %s\n",argv[1]); return 1; }
+    }
+  else{
+    big=makeText(random,100000000);
+    }
+
+  // Measuring
+  fxmessage("%d bytes, font %s:\n",big.length(),font->getActualName().text());
+  benchmark(font,big);
+
+  // Wrapping
+  text->setFont(font);
+  text->position(0,0,800,600);
+  start=FXThread::time();
+  text->setText(big);
+  text->layout();
+  fxmessage("  wrapped to %d rows: %9.3lfms",text->getNumRows(),elapsed(start));
+  text->position(0,0,700,600);
+  start=FXThread::time();
+  text->layout();
+  fxmessage(", rewrapped to %d rows: %9.3lfms\n",text->getNumRows(),elapsed(start));
+
+  return report();
+  }
@@ -0,0 +1,155 @@
+/********************************************************************************
+*                                                                               *
+*                 C o m p r e s s e d   F i l e   S t r e a m   T e s t         *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "FXGZFileStream.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Save data with FXGZFileStream, as one compressed stream, and as blocks
+    compressed on a thread pool; load each back as one stream, and as blocks
+    decompressed on the thread pool, and check the data.
+  - Check that a damaged block compressed file fails to load.
+  - Time saving and loading; the thread pool has at least four threads, so that
+    blocks are always being compressed concurrently.
+*/
+
+/*******************************************************************************/
+
+#ifdef HAVE_ZLIB_H
+
+// Make compressible text from a small vocabulary
+static void makeText(FXchar* text,FXint size){
+  static const FXchar *const words[]={"stream ","block ","thread ","pool ","compress ","deflate ","inflate ","window ","buffer ","index ","\n"};
+  FXRandom random(1234);
+  FXint i=0,n;
+  while(i<size){
+    const FXchar* w=words[random.randLong()%ARRAYNUMBER(words)];
+    for(n=0; w[n] && i<size; ++n) text[i++]=w[n];
+    if(random.randLong()%7==0 && i<size) text[i++]='0'+(FXchar)(random.randLong()%10);
+    }
+  }
+
+
+// Save text, with some values in between
+static FXbool save(const FXString& filename,FXThreadPool* pool,FXint level,FXuval blocksize,const FXchar* text,FXint size){
+  FXGZFileStream store;
+  FXint chunk=size/16;
+  store.setThreadPool(pool);
+  store.setCompressionLevel(level);
+  if(!store.open(filename,FXStreamSave,blocksize)) return false;
+  store << size << 3.14;
+  for(FXint i=0; i<16; ++i){
+    store << i;
+    store.save(text+i*chunk,chunk);
+    if(i==8) store.flush();
+    }
+  store << (FXuint)0xDEADBEEF;
+  return store.close() && store.status()==FXStreamOK;
+  }
+
+
+// Load text back, and compare
+static FXbool load(const FXString& filename,FXThreadPool* pool,const FXchar* text,FXchar* copy){
+  FXGZFileStream store;
+  FXint size,chunk,i,j;
+  FXdouble pi;
+  FXuint magic;
+  store.setThreadPool(pool);
+  if(!store.open(filename,FXStreamLoad)) return false;
+  store >> size >> pi;
+  if(store.status()!=FXStreamOK || pi!=3.14) return false;
+  chunk=size/16;
+  for(i=0; i<16; ++i){
+    store >> j;
+    if(j!=i) return false;
+    store.load(copy+i*chunk,chunk);
+    }
+  store >> magic;
+  if(store.status()!=FXStreamOK || magic!=0xDEADBEEF) return false;
+  return memcmp(text,copy,chunk*16)==0;
+  }
+
+
+// Damage file in the middle
+static void damage(const FXString& filename){
+  FXFile file(filename,FXIO::ReadWrite);
+  FXlong at=file.size()/2;
+  FXuchar c;
+  file.position(at);
+  file.readBlock(&c,1);
+  c^=0x55;
+  file.position(at);
+  file.writeBlock(&c,1);
+  }
+
+
+// Start
+int main(int,char**){
+  const FXint SIZE=64000000;
+  FXString filename=FXPath::absolute(FXSystem::getTempDirectory(),"gzstream.gz");
+  FXThreadPool pool;
+  FXchar *text,*copy;
+  FXTime start;
+  FXint level;
+
+  pool.setMaximumThreads(FXMAX(FXThread::processors(),4));
+  pool.start();
+  allocElms(text,SIZE);
+  allocElms(copy,SIZE);
+  makeText(text,SIZE);
+  fxmessage("%d bytes, %u threads\n",SIZE,pool.getMaximumThreads());
+
+  // Small blocks, many of them, and odd sized
+  check(save(filename,&pool,6,70001,text,1000000),"save small blocks");
+  check(load(filename,nullptr,text,copy),"load small blocks as one stream");
+  check(load(filename,&pool,text,copy),"load small blocks");
+
+  // Compare one stream against blocks, at several levels
+  for(level=1; level<=6; level+=5){
+    start=FXThread::time();
+    check(save(filename,nullptr,level,8192,text,SIZE),"save one stream");
+    fxmessage("level %d: one stream: save %8.3lfms (%lld bytes)",level,elapsed(start),FXStat::size(filename));
+    start=FXThread::time();
+    check(load(filename,nullptr,text,copy),"load one stream");
+    fxmessage(", load %8.3lfms\n",elapsed(start));
+    check(load(filename,&pool,text,copy),"load one stream with thread pool");
+
+    start=FXThread::time();
+    check(save(filename,&pool,level,1048576,text,SIZE),"save blocks");
+    fxmessage("level %d: 1MB blocks: save %8.3lfms (%lld bytes)",level,elapsed(start),FXStat::size(filename));
+    start=FXThread::time();
+    check(load(filename,&pool,text,copy),"load blocks");
+    fxmessage(", load %8.3lfms",elapsed(start));
+    start=FXThread::time();
+    check(load(filename,nullptr,text,copy),"load blocks as one stream");
+    fxmessage(", as one stream %8.3lfms\n",elapsed(start));
+    }
+
+  // Damaged file does not load
+  damage(filename);
+  check(!load(filename,&pool,text,copy),"damaged blocks");
+  check(!load(filename,nullptr,text,copy),"damaged blocks as one stream");
+
+  FXFile::remove(filename);
+  freeElms(text);
+  freeElms(copy);
+  pool.stop();
+
+  return report();
+  }
+
+#else
+
+// Start
+int main(int,char**){
+  fxmessage("Compiled without zlib\n");
+  return 0;
+  }
+
+#endif
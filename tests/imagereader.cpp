@@ -0,0 +1,375 @@
+/********************************************************************************
+*                                                                               *
+*                         I m a g e   R e a d e r   T e s t                     *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include <zlib.h>
+#include "checks.h"
+
+/*
+  Notes:
+  - Read PNG images a band of rows at a time, and check the rows against
+    loading the whole image; images are saved plain, gray, and indexed, and
+    also written here, with the image data split over many small IDAT chunks,
+    an extra chunk before IEND, and interlaced.
+  - After finish(), the stream must be just past the image; a few bytes are
+    written after each image and must read back, also when finish() is called
+    with rows left unread.
+  - Truncated or damaged images must come back short, or fail to finish.
+  - Check readScaled() against averaging each output pixel's area of the
+    source, worked out here in double precision.
+  - Read JPEG images, at full and reduced size, against fxloadScaledJPG.
+  - Time making a thumbnail of a big PNG by loading it whole and scaling,
+    and by loading it scaled, which keeps only a few rows in memory.
+*/
+
+/*******************************************************************************/
+
+// Bytes written after each image
+static const FXuchar tail[4]={'T','A','I','L'};
+
+
+// Smooth image with some alpha
+static void picture(FXColor* pix,FXint w,FXint h,FXbool alpha){
+  for(FXint y=0; y<h; ++y){
+    for(FXint x=0; x<w; ++x){
+      FXint r=(x*255)/w;
+      FXint g=(y*255)/h;
+      FXint b=128+(FXint)(100.0*Math::sin(0.05*x)*Math::cos(0.07*y));
+      FXint a=alpha?(x+y)&255:255;
+      pix[(FXival)y*w+x]=FXRGBA(r,g,b,a);
+      }
+    }
+  }
+
+
+// Write chunk
+static void chunk(FXString& out,const FXchar* id,const FXuchar* data,FXuint size){
+  FXuchar head[8]={(FXuchar)(size>>24),(FXuchar)(size>>16),(FXuchar)(size>>8),(FXuchar)size,(FXuchar)id[0],(FXuchar)id[1],(FXuchar)id[2],(FXuchar)id[3]};
+  FXuint crc=crc32(0,head+4,4);
+  if(size) crc=crc32(crc,data,size);
+  FXuchar foot[4]={(FXuchar)(crc>>24),(FXuchar)(crc>>16),(FXuchar)(crc>>8),(FXuchar)crc};
+  out.append((const FXchar*)head,8);
+  out.append((const FXchar*)data,size);
+  out.append((const FXchar*)foot,4);
+  }
+
+
+// Write RGBA image, interlaced or not, with image data split into
+// chunks of at most split bytes
+static FXString writePNG(const FXColor* pix,FXint w,FXint h,FXbool interlace,FXuint split){
+  static const FXint xoffset[7]={0,4,0,2,0,1,0};
+  static const FXint yoffset[7]={0,0,4,0,2,0,1};
+  static const FXint xstep[7]={8,8,4,4,2,2,1};
+  static const FXint ystep[7]={8,8,8,4,4,2,2};
+  static const FXuchar signature[8]={0x89,0x50,0x4E,0x47,0x0D,0x0A,0x1A,0x0A};
+  FXuchar ihdr[13]={(FXuchar)(w>>24),(FXuchar)(w>>16),(FXuchar)(w>>8),(FXuchar)w,(FXuchar)(h>>24),(FXuchar)(h>>16),(FXuchar)(h>>8),(FXuchar)h,8,6,0,0,(FXuchar)interlace};
+  FXString raw,out((const FXchar*)signature,8);
+  FXint passes=interlace?7:1;
+  for(FXint p=0; p<passes; ++p){
+    FXint x0=interlace?xoffset[p]:0,y0=interlace?yoffset[p]:0;
+    FXint xs=interlace?xstep[p]:1,ys=interlace?ystep[p]:1;
+    if(x0>=w || y0>=h) continue;
+    for(FXint y=y0; y<h; y+=ys){
+      raw.append('\0');
+      for(FXint x=x0; x<w; x+=xs){
+        FXColor c=pix[(FXival)y*w+x];
+        raw.append((FXchar)FXREDVAL(c));
+        raw.append((FXchar)FXGREENVAL(c));
+        raw.append((FXchar)FXBLUEVAL(c));
+        raw.append((FXchar)FXALPHAVAL(c));
+        }
+      }
+    }
+  uLongf size=compressBound(raw.length());
+  FXuchar* z;
+  allocElms(z,size);
+  compress2(z,&size,(const Bytef*)raw.text(),raw.length(),6);
+  chunk(out,"IHDR",ihdr,13);
+  for(FXuint i=0; i<size; i+=split){
+    chunk(out,"IDAT",z+i,FXMIN(split,(FXuint)size-i));
+    }
+  chunk(out,"tEXt",(const FXuchar*)"Comment\0reader",14);
+  chunk(out,"IEND",nullptr,0);
+  freeElms(z);
+  return out;
+  }
+
+
+// Save with fxsavePNG or fxsaveJPG
+static FXString save(const FXColor* pix,FXint w,FXint h,FXint type,FXuint flags){
+  FXMemoryStream ms;
+  FXuchar *data=nullptr;
+  FXuval size=0,room;
+  FXString out;
+  ms.open(FXStreamSave,nullptr,4096);
+  if(type==0 ? fxsavePNG(ms,pix,w,h,flags) : fxsaveJPG(ms,pix,w,h,(FXint)flags)){
+    size=ms.position();
+    }
+  ms.takeBuffer(data,room);
+  ms.close();
+  out.assign((const FXchar*)data,(FXint)size);
+  freeElms(data);
+  return out;
+  }
+
+
+// Check tail follows at stream position
+static FXbool atTail(FXStream& ms){
+  FXuchar t[4]={0,0,0,0};
+  ms.load(t,4);
+  return ms.status()==FXStreamOK && memcmp(t,tail,4)==0;
+  }
+
+
+// Read image in bands of n rows, and compare to whole image
+static void bands(FXImageReader& reader,const FXString& file,const FXColor* pix,FXint w,FXint h,FXint n,const FXchar* what){
+  FXString data=file+FXString((const FXchar*)tail,4);
+  FXMemoryStream ms(FXStreamLoad,(FXuchar*)data.text(),data.length());
+  FXColor *band;
+  FXint rows=0,got,bad=0;
+  if(!reader.start(ms)){ check(false,what,n,0); return; }
+  check(reader.getWidth()==w && reader.getHeight()==h,what,reader.getWidth(),reader.getHeight());
+  allocElms(band,(FXival)(w+3)*n);
+  while((got=reader.read(band,n,w+3))>0){
+    for(FXint y=0; y<got; ++y){
+      if(memcmp(band+(FXival)y*(w+3),pix+(FXival)(rows+y)*w,sizeof(FXColor)*w)) bad++;
+      }
+    rows+=got;
+    check(reader.getRow()==rows,what,reader.getRow(),rows);
+    }
+  check(rows==h && bad==0,what,rows,bad);
+  check(reader.finish(),what,n,-1);
+  check(atTail(ms),what,n,-2);
+  freeElms(band);
+  }
+
+
+// Finish with rows left unread; stream must still end up after image
+static void early(FXImageReader& reader,const FXString& file,FXint w,FXint rows,const FXchar* what){
+  FXString data=file+FXString((const FXchar*)tail,4);
+  FXMemoryStream ms(FXStreamLoad,(FXuchar*)data.text(),data.length());
+  FXColor *band;
+  allocElms(band,(FXival)w*FXMAX(rows,1));
+  check(reader.start(ms),what,rows,0);
+  check(reader.read(band,rows,w)==rows,what,rows,1);
+  check(reader.finish(),what,rows,2);
+  check(atTail(ms),what,rows,3);
+  freeElms(band);
+  }
+
+
+// PNG reader against fxloadPNG
+static void pngrows(const FXString& file,const FXchar* what){
+  FXMemoryStream ms(FXStreamLoad,(FXuchar*)file.text(),file.length());
+  FXPNGReader reader;
+  FXColor *pix;
+  FXint w,h;
+  if(!fxloadPNG(ms,pix,w,h)){ check(false,what,0,0); return; }
+  bands(reader,file,pix,w,h,1,what);
+  bands(reader,file,pix,w,h,7,what);
+  bands(reader,file,pix,w,h,h,what);
+  early(reader,file,w,0,what);
+  early(reader,file,w,h/2,what);
+  freeElms(pix);
+  }
+
+
+// Truncated or damaged images must not read in full
+static void damaged(const FXString& file){
+  FXPNGReader reader;
+  FXColor *row;
+  FXint w,h,rows;
+  FXMemoryStream ms(FXStreamLoad,(FXuchar*)file.text(),file.length());
+  check(reader.start(ms),"damaged start",0,0);
+  w=reader.getWidth();
+  h=reader.getHeight();
+  reader.finish();
+  allocElms(row,w);
+
+  // Cut off halfway through image data
+  FXString cut=file.left(file.length()/2);
+  ms.open(FXStreamLoad,(FXuchar*)cut.text(),cut.length());
+  if(reader.start(ms)){
+    for(rows=0; reader.read(row,1,w)==1; ++rows){ }
+    check(rows<h,"truncated rows",rows,h);
+    check(!reader.finish(),"truncated finish",rows,h);
+    }
+  ms.close();
+
+  // Flip a bit in the compressed data
+  FXString bad=file;
+  bad[bad.length()/2]^=0x10;
+  ms.open(FXStreamLoad,(FXuchar*)bad.text(),bad.length());
+  if(reader.start(ms)){
+    for(rows=0; reader.read(row,1,w)==1; ++rows){ }
+    check(!reader.finish(),"damaged finish",rows,h);
+    }
+  ms.close();
+  freeElms(row);
+  }
+
+
+// Average source area of each output pixel, in double precision
+static void reference(FXColor* dst,const FXColor* src,FXint sw,FXint sh,FXint dw,FXint dh){
+  for(FXint k=0; k<dh; ++k){
+    FXdouble y0=(FXdouble)k*sh/dh,y1=(FXdouble)(k+1)*sh/dh;
+    for(FXint j=0; j<dw; ++j){
+      FXdouble x0=(FXdouble)j*sw/dw,x1=(FXdouble)(j+1)*sw/dw;
+      FXdouble sum[4]={0.0,0.0,0.0,0.0};
+      for(FXint y=(FXint)y0; y<sh && y<y1; ++y){
+        FXdouble wy=FXMIN(y1,y+1.0)-FXMAX(y0,(FXdouble)y);
+        for(FXint x=(FXint)x0; x<sw && x<x1; ++x){
+          FXdouble wx=FXMIN(x1,x+1.0)-FXMAX(x0,(FXdouble)x);
+          const FXuchar* p=(const FXuchar*)&src[(FXival)y*sw+x];
+          for(FXint c=0; c<4; ++c) sum[c]+=wx*wy*p[c];
+          }
+        }
+      FXuchar* q=(FXuchar*)&dst[(FXival)k*dw+j];
+      for(FXint c=0; c<4; ++c) q[c]=(FXuchar)(sum[c]*dw*dh/((FXdouble)sw*sh)+0.5);
+      }
+    }
+  }
+
+
+// Scaled read against reference
+static void scaled(const FXString& file,const FXColor* pix,FXint w,FXint h){
+  static const FXint sizes[][2]={{1,1},{7,5},{50,40},{64,48},{99,77},{100,75},{150,120},{199,150},{200,150}};
+  FXColor *dst,*ref;
+  FXPNGReader reader;
+  FXint bad;
+  for(FXuint i=0; i<ARRAYNUMBER(sizes); ++i){
+    FXint dw=sizes[i][0],dh=sizes[i][1];
+    FXMemoryStream ms(FXStreamLoad,(FXuchar*)file.text(),file.length());
+    allocElms(dst,dw*dh);
+    allocElms(ref,dw*dh);
+    reference(ref,pix,w,h,dw,dh);
+    check(reader.start(ms),"scaled start",dw,dh);
+    check(reader.readScaled(dst,dw,dh,dw),"scaled read",dw,dh);
+    check(reader.finish(),"scaled finish",dw,dh);
+    bad=0;
+    for(FXint p=0; p<dw*dh*4; ++p){
+      if(FXABS((FXint)((FXuchar*)dst)[p]-(FXint)((FXuchar*)ref)[p])>1) bad++;
+      }
+    check(bad==0,"scaled pixels",dw,bad);
+    freeElms(dst);
+    freeElms(ref);
+    }
+  FXMemoryStream ms(FXStreamLoad,(FXuchar*)file.text(),file.length());
+  allocElms(dst,1);
+  check(reader.start(ms),"scaled start",w+1,h);
+  check(!reader.readScaled(dst,w+1,h,w+1),"scaled too big",w+1,h);
+  check(!reader.readScaled(dst,0,h,0),"scaled empty",0,h);
+  reader.finish();
+  freeElms(dst);
+  }
+
+
+// JPEG reader against fxloadScaledJPG
+static void jpgrows(const FXString& file,FXint size){
+  FXMemoryStream ms(FXStreamLoad,(FXuchar*)file.text(),file.length());
+  FXJPGReader reader(size);
+  FXColor *pix;
+  FXint w,h,q;
+  if(!fxloadScaledJPG(ms,pix,w,h,q,size)){ check(false,"jpeg load",size,0); return; }
+  bands(reader,file,pix,w,h,1,"jpeg rows");
+  bands(reader,file,pix,w,h,16,"jpeg rows");
+  early(reader,file,w,h/3,"jpeg early");
+  freeElms(pix);
+  }
+
+
+// Scale image to fit size, as icon source does
+static void fit(FXImage* image,FXint size){
+  if(image->getWidth()>size || image->getHeight()>size){
+    if(image->getWidth()>image->getHeight()){
+      image->scale(size,(size*image->getHeight())/image->getWidth(),0);
+      }
+    else{
+      image->scale((size*image->getWidth())/image->getHeight(),size,0);
+      }
+    }
+  }
+
+
+// Time making thumbnail by loading and scaling, and by loading scaled;
+// memory for the latter is a row of pixels and column weights, and the
+// sums for a row of the thumbnail, besides the thumbnail itself
+static void benchmark(FXApp& app,const FXString& file,FXint w,FXint h,FXint size){
+  FXIconSource source;
+  FXMemoryStream ms;
+  FXImage *image;
+  FXdouble ms1,ms2,mb1,mb2;
+  FXTime start;
+  FXint dw=(w>h)?size:(size*w)/h;
+  FXint dh=(w>h)?(size*h)/w:size;
+  mb1=(FXdouble)w*h*4.0/1048576.0;
+  mb2=((FXdouble)w*12.0+(FXdouble)dw*68.0+(FXdouble)dw*dh*4.0)/1048576.0;
+  start=FXThread::time();
+  ms.open(FXStreamLoad,(FXuchar*)file.text(),file.length());
+  image=source.loadImageStream(&app,ms,"png");
+  ms.close();
+  if(image) fit(image,size);
+  ms1=elapsed(start);
+  delete image;
+  start=FXThread::time();
+  ms.open(FXStreamLoad,(FXuchar*)file.text(),file.length());
+  image=source.loadScaledImageStream(&app,ms,size,0,"png");
+  ms.close();
+  ms2=elapsed(start);
+  check(image!=nullptr,"benchmark",size,0);
+  delete image;
+  fxmessage("  thumbnail %4d: load and scale %9.3lfms %7.2lfMB, load scaled %9.3lfms %7.2lfMB\n",size,ms1,mb1,ms2,mb2);
+  }
+
+
+// Start
+int main(int argc,char *argv[]){
+  FXApp app("ImageReader","FoxTest");
+  FXColor *pix,*gray;
+  FXString file;
+  FXint w=333,h=201;
+
+  // PNG rows, in various formats
+  allocElms(pix,w*h);
+  allocElms(gray,w*h);
+  picture(pix,w,h,true);
+  for(FXint i=0; i<w*h; ++i){ FXuchar v=FXBLUEVAL(pix[i]); gray[i]=FXRGB(v,v,v); }
+  pngrows(save(pix,w,h,0,PNG_IMAGE_ANALYZE),"png rgba");
+  pngrows(save(pix,w,h,0,PNG_IMAGE_OPAQUE|PNG_FILTER_BEST),"png rgb");
+  pngrows(save(gray,w,h,0,PNG_IMAGE_GRAY|PNG_IMAGE_OPAQUE|PNG_FILTER_BEST),"png gray");
+  pngrows(save(gray,w,h,0,PNG_INDEX_COLOR|PNG_IMAGE_OPAQUE),"png indexed");
+  pngrows(writePNG(pix,w,h,false,97),"png split");
+  pngrows(writePNG(pix,w,h,true,4096),"png interlaced");
+  pngrows(writePNG(pix,1,1,false,1),"png 1x1");
+  damaged(save(pix,w,h,0,PNG_IMAGE_ANALYZE));
+
+  // Scaled read
+  scaled(writePNG(pix,w,h,false,8192),pix,w,h);
+  scaled(save(pix,200,150,0,PNG_IMAGE_ANALYZE),pix,200,150);
+
+  // JPEG rows
+  picture(pix,w,h,false);
+  file=save(pix,w,h,1,90);
+  jpgrows(file,0);
+  jpgrows(file,100);
+  jpgrows(file,40);
+  freeElms(gray);
+  freeElms(pix);
+
+  // Speed
+  w=8000; h=6000;
+  if(1<argc && FXString(argv[1])=="-quick"){ w=1024; h=768; }
+  allocElms(pix,(FXival)w*h);
+  picture(pix,w,h,false);
+  file=save(pix,w,h,0,PNG_IMAGE_OPAQUE|PNG_COMPRESS_FAST);
+  freeElms(pix);
+  fxmessage("Loading %dx%d PNG of %d bytes:\n",w,h,file.length());
+  benchmark(app,file,w,h,64);
+  benchmark(app,file,w,h,256);
+
+  return report();
+  }
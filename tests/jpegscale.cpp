@@ -0,0 +1,221 @@
+/********************************************************************************
+*                                                                               *
+*                     J P E G   S c a l e d   L o a d   T e s t                 *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Load a JPEG at various sizes, and check it is reduced by the largest of
+    1/2, 1/4, and 1/8 which leaves at least that size, and that each pixel
+    is close to the average of the block of the full size image it stands for.
+  - Check that FXIconSource's scaled loads come out the same size as loading
+    at full size and then scaling, for JPEG, and for PNG, which is scaled as
+    its rows are read; both from a stream, and from a data array.
+  - Time making a thumbnail of a 24 megapixel photo by loading it at full size
+    and scaling, and by loading it scaled.
+*/
+
+/*******************************************************************************/
+
+// Smooth photo-like image
+static void photo(FXColor* pix,FXint w,FXint h){
+  for(FXint y=0; y<h; ++y){
+    for(FXint x=0; x<w; ++x){
+      FXint r=(x*255)/w;
+      FXint g=(y*255)/h;
+      FXint b=128+(FXint)(100.0*Math::sin(0.01*x)*Math::cos(0.013*y));
+      pix[(FXival)y*w+x]=FXRGB(r,g,b);
+      }
+    }
+  }
+
+
+// Save image to memory, returning size or 0 if it failed
+static FXuval save(FXuchar*& data,const FXColor* pix,FXint w,FXint h,FXbool png){
+  FXMemoryStream ms;
+  FXuval size=0;
+  FXuval room;
+  data=nullptr;
+  ms.open(FXStreamSave,nullptr,4096);
+  if(png?fxsavePNG(ms,pix,w,h,0):fxsaveJPG(ms,pix,w,h,90)){
+    size=ms.position();
+    ms.takeBuffer(data,room);
+    }
+  ms.close();
+  return size;
+  }
+
+
+// Load JPEG from memory, scaled to no less than size
+static FXbool load(const FXuchar* data,FXuval bytes,FXColor*& pix,FXint& w,FXint& h,FXint size){
+  FXMemoryStream ms;
+  FXint quality;
+  FXbool ok;
+  ms.open(FXStreamLoad,(FXuchar*)data,bytes);
+  ok=fxloadScaledJPG(ms,pix,w,h,quality,size);
+  ms.close();
+  return ok;
+  }
+
+
+// Check reduction picked for each size, and pixels against block averages
+static void reductions(const FXuchar* data,FXuval bytes,FXint w,FXint h){
+  static const FXint sizes[]={0,4000,2000,1001,1000,512,500,250,200,64,1};
+  FXColor *full,*pix;
+  FXint fw=0,fh=0,pw,ph,d;
+  FXdouble diff;
+  if(!load(data,bytes,full,fw,fh,0)){ check(false,"full size",w,h); return; }
+  check(fw==w && fh==h,"full size",fw,fh);
+  for(FXuint i=0; i<ARRAYNUMBER(sizes); ++i){
+    if(load(data,bytes,pix,pw,ph,sizes[i])){
+      d=1;
+      while(0<sizes[i] && d<8 && FXMAX(w,h)/(d*2)>=sizes[i]) d*=2;
+      check(pw==(w+d-1)/d && ph==(h+d-1)/d,"reduced size",sizes[i],pw);
+      diff=0.0;
+      for(FXint y=0; y<h/d; ++y){
+        for(FXint x=0; x<w/d; ++x){
+          FXint sum[3]={0,0,0};
+          for(FXint yy=0; yy<d; ++yy){
+            for(FXint xx=0; xx<d; ++xx){
+              FXColor c=full[(FXival)(y*d+yy)*w+x*d+xx];
+              sum[0]+=FXREDVAL(c); sum[1]+=FXGREENVAL(c); sum[2]+=FXBLUEVAL(c);
+              }
+            }
+          FXColor c=pix[(FXival)y*pw+x];
+          diff+=FXABS(sum[0]/(d*d)-(FXint)FXREDVAL(c))+FXABS(sum[1]/(d*d)-(FXint)FXGREENVAL(c))+FXABS(sum[2]/(d*d)-(FXint)FXBLUEVAL(c));
+          }
+        }
+      diff/=3.0*(w/d)*(h/d);
+      check(diff<2.0,"reduced pixels",sizes[i],(FXint)(diff*100.0));
+      freeElms(pix);
+      }
+    else{
+      check(false,"load",sizes[i],0);
+      }
+    }
+  freeElms(full);
+  }
+
+
+// Scale image to fit size, as icon source does
+static void fit(FXImage* image,FXint size){
+  if(image->getWidth()>size || image->getHeight()>size){
+    if(image->getWidth()>image->getHeight()){
+      image->scale(size,(size*image->getHeight())/image->getWidth(),0);
+      }
+    else{
+      image->scale((size*image->getWidth())/image->getHeight(),size,0);
+      }
+    }
+  }
+
+
+// Scaled load through icon source against loading and then scaling
+static void iconsource(FXApp& app,const FXuchar* data,FXuval bytes,const FXchar* type){
+  static const FXint sizes[]={32,128,300,5000};
+  FXIconSource source;
+  FXMemoryStream ms;
+  FXImage *image,*scaled,*fromdata;
+  for(FXuint i=0; i<ARRAYNUMBER(sizes); ++i){
+    ms.open(FXStreamLoad,(FXuchar*)data,bytes);
+    image=source.loadImageStream(&app,ms,type);
+    ms.close();
+    ms.open(FXStreamLoad,(FXuchar*)data,bytes);
+    scaled=source.loadScaledImageStream(&app,ms,sizes[i],0,type);
+    ms.close();
+    fromdata=source.loadScaledImageData(&app,data,sizes[i],0,type);
+    if(image && scaled && fromdata){
+      fit(image,sizes[i]);
+      check(scaled->getWidth()==image->getWidth() && scaled->getHeight()==image->getHeight(),type,sizes[i],scaled->getWidth());
+      check(fromdata->getWidth()==image->getWidth() && fromdata->getHeight()==image->getHeight(),type,sizes[i],fromdata->getWidth());
+      }
+    else{
+      check(false,type,sizes[i],0);
+      }
+    delete image;
+    delete scaled;
+    delete fromdata;
+    }
+  image=source.loadImageData(&app,data,type);
+  ms.open(FXStreamLoad,(FXuchar*)data,bytes);
+  scaled=source.loadImageStream(&app,ms,type);
+  ms.close();
+  check(image && scaled && image->getWidth()==scaled->getWidth() && image->getHeight()==scaled->getHeight(),type,0,image?image->getWidth():0);
+  delete image;
+  delete scaled;
+  }
+
+
+// Time making thumbnail the old way, and by loading scaled
+static void benchmark(FXApp& app,const FXuchar* data,FXuval bytes,FXint size){
+  FXIconSource source;
+  FXMemoryStream ms;
+  FXImage *image;
+  FXdouble ms1,ms2;
+  FXTime start;
+  start=FXThread::time();
+  ms.open(FXStreamLoad,(FXuchar*)data,bytes);
+  image=source.loadImageStream(&app,ms,"jpg");
+  ms.close();
+  if(image) fit(image,size);
+  ms1=elapsed(start);
+  delete image;
+  start=FXThread::time();
+  ms.open(FXStreamLoad,(FXuchar*)data,bytes);
+  image=source.loadScaledImageStream(&app,ms,size,0,"jpg");
+  ms.close();
+  ms2=elapsed(start);
+  check(image!=nullptr,"benchmark",size,0);
+  delete image;
+  fxmessage("  thumbnail %4d: load and scale %9.3lfms, load scaled %9.3lfms (%.1lfx)\n",size,ms1,ms2,ms1/ms2);
+  }
+
+
+// Start
+int main(int argc,char *argv[]){
+  FXApp app("JPEGScale","FoxTest");
+  FXuchar *jpg,*png;
+  FXuval jpgsize,pngsize;
+  FXColor *pix;
+  FXint w=6000,h=4000;
+
+  // Correctness
+  allocElms(pix,1000*750);
+  photo(pix,1000,750);
+  jpgsize=save(jpg,pix,1000,750,false);
+  pngsize=save(png,pix,1000,750,true);
+  check(0<jpgsize && 0<pngsize,"save",(FXint)jpgsize,(FXint)pngsize);
+  reductions(jpg,jpgsize,1000,750);
+  iconsource(app,jpg,jpgsize,"jpg");
+  iconsource(app,png,pngsize,"png");
+  freeElms(jpg);
+  freeElms(png);
+  freeElms(pix);
+
+  // Odd sizes, not a multiple of the reduction
+  allocElms(pix,333*97);
+  photo(pix,333,97);
+  jpgsize=save(jpg,pix,333,97,false);
+  reductions(jpg,jpgsize,333,97);
+  freeElms(jpg);
+  freeElms(pix);
+
+  // Speed
+  if(1<argc && FXString(argv[1])=="-quick"){ w=1024; h=768; }
+  allocElms(pix,(FXival)w*h);
+  photo(pix,w,h);
+  jpgsize=save(jpg,pix,w,h,false);
+  fxmessage("Loading %dx%d JPEG of %lu bytes:\n",w,h,(unsigned long)jpgsize);
+  benchmark(app,jpg,jpgsize,64);
+  benchmark(app,jpg,jpgsize,128);
+  benchmark(app,jpg,jpgsize,256);
+  freeElms(jpg);
+  freeElms(pix);
+
+  return report();
+  }
@@ -0,0 +1,222 @@
+/********************************************************************************
+*                                                                               *
+*                   M a p p e d   F i l e   S t r e a m   T e s t               *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Save a file with FXFileStream, and load it back with FXMappedStream; check
+    values, arrays in both byte orders, views of arrays, and moving around.
+  - Time loading a big file of arrays with FXFileStream, with FXMappedStream,
+    and through views of FXMappedStream.
+  - The big file is written to the temp directory, or to the file passed as
+    argument; pass -keep to keep it, so it can be loaded again cold, after
+    flushing the file cache.
+  - The big file is 8 blocks of 8MB by default; pass -blocks n for more, e.g.
+    -blocks 128 for about 1GB.
+*/
+
+/*******************************************************************************/
+
+// Save small file
+static void saveSmall(const FXString& filename){
+  FXFileStream store(filename,FXStreamSave);
+  FXuint ints[100];
+  FXdouble doubles[100];
+  for(FXint i=0; i<100; ++i){ ints[i]=i*1000003; doubles[i]=i*0.5; }
+  store << FXString("header");
+  store << (FXushort)2 << (FXuint)4;    // Aligns what follows at 16
+  store.save(ints,100);
+  store.save(doubles,100);
+  store << (FXuchar)1;                  // Misaligns what follows
+  store.save(ints,100);
+  store << (FXuchar)1 << (FXuchar)2 << (FXuchar)3;
+  store.setBigEndian(!FOX_BIGENDIAN);
+  store.save(ints,100);
+  store << 12345.0;
+  store.close();
+  }
+
+
+// Load small file back
+static void loadSmall(const FXString& filename){
+  FXMappedStream store(filename);
+  const FXuint* vints=nullptr;
+  const FXdouble* vdoubles=nullptr;
+  FXuint ints[100];
+  FXString header;
+  FXuchar c,d,e;
+  FXdouble v;
+  FXushort m;
+  FXuint n;
+  FXlong at;
+  check(store.status()==FXStreamOK && store.direction()==FXStreamLoad,"open");
+  store >> header >> m >> n;
+  check(header=="header" && m==2 && n==4,"header");
+
+  // Aligned native arrays can be viewed
+  at=store.position();
+  check(store.view(vints,100) && vints[99]==99*1000003,"view ints");
+  check(store.view(vdoubles,100) && vdoubles[99]==49.5,"view doubles");
+
+  // Misaligned can't, but can be loaded
+  store >> c;
+  check(!store.view(vints,100) && store.status()==FXStreamOK,"misaligned view");
+  store.load(ints,100);
+  check(ints[99]==99*1000003,"load misaligned");
+
+  // Swapped can't be viewed either
+  store >> c >> d >> e;
+  store.setBigEndian(!FOX_BIGENDIAN);
+  check(!store.view(vints,100) && store.status()==FXStreamOK,"swapped view");
+  store.load(ints,100);
+  check(ints[1]==1000003 && ints[99]==99*1000003,"load swapped");
+  store >> v;
+  check(v==12345.0 && store.position()==store.size(),"last value");
+
+  // Load beyond end
+  store >> c;
+  check(store.status()==FXStreamEnd,"end of file");
+  store.close();
+
+  // Go back and forth; byte order stays as it was
+  store.open(filename);
+  store.setBigEndian(FOX_BIGENDIAN);
+  check(store.position(at) && store.view(vints,1) && vints[0]==0,"position back");
+  check(store.position(-8,FXFromEnd) && store.position()==store.size()-8,"position from end");
+  store.setBigEndian(!FOX_BIGENDIAN);
+  store >> v;
+  check(v==12345.0,"value from end");
+  check(!store.position(1,FXFromEnd) && store.status()==FXStreamEnd,"position beyond end");
+  store.close();
+
+  // View beyond end
+  store.open(filename);
+  store.setBigEndian(FOX_BIGENDIAN);
+  check(!store.view(vints,1000) && store.status()==FXStreamEnd,"view beyond end");
+  store.close();
+
+  // View of so many items that their size wraps around
+  store.open(filename);
+  store.setBigEndian(FOX_BIGENDIAN);
+  check(store.position(at) && !store.view(vints,~(FXuval)0/4+2) && store.status()==FXStreamEnd,"view size overflow");
+  store.close();
+
+  // Can't open nonexistent file
+  check(!store.open(filename+".none") && store.status()==FXStreamNoRead,"nonexistent");
+  }
+
+
+// Save big file of arrays; return its size
+static FXlong saveBig(const FXString& filename,FXint count,FXint blocks){
+  FXFileStream store(filename,FXStreamSave,1048576);
+  FXdouble *array;
+  allocElms(array,count);
+  for(FXint i=0; i<count; ++i) array[i]=i;
+  for(FXint b=0; b<blocks; ++b){
+    store << (FXuint)count << (FXuint)b;
+    store.save(array,count);
+    }
+  freeElms(array);
+  store.close();
+  return (8+8*(FXlong)count)*blocks;
+  }
+
+
+// Sum of array
+static FXdouble sum(const FXdouble* array,FXint count){
+  FXdouble result=0.0;
+  for(FXint i=0; i<count; ++i) result+=array[i];
+  return result;
+  }
+
+
+// Load big file with given stream, or through views if given
+static FXdouble loadBig(FXStream& store,FXMappedStream* views){
+  FXdouble *array=nullptr;
+  const FXdouble* view;
+  FXdouble result=0.0;
+  FXuint count,block;
+  while(store.status()==FXStreamOK){
+    store >> count >> block;
+    if(store.status()!=FXStreamOK) break;
+    if(views && views->view(view,count)){
+      result+=sum(view,count);
+      }
+    else{
+      resizeElms(array,count);
+      store.load(array,count);
+      result+=sum(array,count);
+      }
+    }
+  freeElms(array);
+  return result;
+  }
+
+
+// Time loading big file
+static void benchmark(const FXString& filename,FXlong bytes,FXdouble expect){
+  FXFileStream filestore;
+  FXMappedStream mappedstore;
+  FXTime start;
+  FXdouble s;
+  start=FXThread::time();
+  filestore.open(filename,FXStreamLoad);
+  s=loadBig(filestore,nullptr);
+  filestore.close();
+  check(s==expect,"file stream sum");
+  fxmessage("  FXFileStream:          %8.3lfms, %5.0lf MB/s\n",elapsed(start),bytes/(1000.0*elapsed(start)));
+  start=FXThread::time();
+  mappedstore.open(filename);
+  s=loadBig(mappedstore,nullptr);
+  mappedstore.close();
+  check(s==expect,"mapped stream sum");
+  fxmessage("  FXMappedStream load(): %8.3lfms, %5.0lf MB/s\n",elapsed(start),bytes/(1000.0*elapsed(start)));
+  start=FXThread::time();
+  mappedstore.open(filename);
+  s=loadBig(mappedstore,&mappedstore);
+  mappedstore.close();
+  check(s==expect,"mapped stream view sum");
+  fxmessage("  FXMappedStream view(): %8.3lfms, %5.0lf MB/s\n",elapsed(start),bytes/(1000.0*elapsed(start)));
+  }
+
+
+// Start
+int main(int argc,char *argv[]){
+  const FXint COUNT=1000000;
+  FXString small=FXPath::absolute(FXSystem::getTempDirectory(),"mappedstream-small.dat");
+  FXString big=FXPath::absolute(FXSystem::getTempDirectory(),"mappedstream-big.dat");
+  FXint blocks=8;
+  FXbool keep=false;
+  FXlong bytes;
+  FXTime start;
+
+  for(FXint arg=1; arg<argc; ++arg){
+    if(FXString(argv[arg])=="-keep") keep=true;
+    else if(FXString(argv[arg])=="-blocks" && arg+1<argc) blocks=FXMAX(1,(FXint)strtol(argv[++arg],nullptr,10));
+    else big=argv[arg];
+    }
+
+  // Correctness
+  saveSmall(small);
+  loadSmall(small);
+  FXFile::remove(small);
+
+  // Big file; save unless kept from before
+  bytes=(8+8*(FXlong)COUNT)*blocks;
+  if(FXStat::size(big)!=bytes){
+    start=FXThread::time();
+    saveBig(big,COUNT,blocks);
+    fxmessage("saved %lld bytes: %.3lfms\n",bytes,elapsed(start));
+    }
+  fxmessage("loading %lld bytes:\n",bytes);
+  benchmark(big,bytes,0.5*(COUNT-1.0)*COUNT*blocks);
+  if(!keep) FXFile::remove(big);
+
+  return report();
+  }
@@ -71,6 +71,144 @@ FXint Job::run(){
 
 /*******************************************************************************/
 
+// Pipeline stage performing make-work procedure
+class Stage : public FXRunnable {
+  const FXchar* name;
+public:
+  Stage(const FXchar* nm):name(nm){}
+  virtual FXint run();
+  };
+
+
+// Report stage start and finish
+FXint Stage::run(){
+  fxmessage("Stage %s start th %p\n",name,(void*)FXThread::current());
+  churn();
+  fxmessage("Stage %s done  th %p\n",name,(void*)FXThread::current());
+  return 0;
+  }
+
+/*******************************************************************************/
+
+// Latencies from posting to starting each benchmark task
+FXTime        *latency=nullptr;
+volatile FXint nlatency=0;
+
+
+// Benchmark task recursively spawns two smaller tasks, down to depth zero.
+// Records the time between being posted and being started.
+class Spawn : public FXRunnable {
+  FXTime posted;
+  FXint  depth;
+public:
+  Spawn(FXint d):posted(FXThread::time()),depth(d){}
+  virtual FXint run();
+  };
+
+
+// Record latency, then spawn two children and wait for them
+FXint Spawn::run(){
+  latency[atomicAdd(&nlatency,1)]=FXThread::time()-posted;
+  if(0<depth){
+    FXTaskGroup group;
+    Spawn left(depth-1);
+    Spawn right(depth-1);
+    group.execute(&left);
+    group.executeAndWait(&right);
+    }
+  return 0;
+  }
+
+
+// Compare latencies
+static int compareLatency(const void* a,const void* b){
+  return (*(const FXTime*)a>*(const FXTime*)b)-(*(const FXTime*)a<*(const FXTime*)b);
+  }
+
+
+// Measure tasks per second and task start latency, with or without work-stealing.
+// The shared queue expands the task tree breadth-first, so make it big enough to
+// hold all tasks lest all workers end up blocking in execute().
+void benchmark(FXuint size,FXuint nthreads,FXuint depth,FXuint rounds,FXbool steal){
+  FXint ntasks=(2<<depth)-1;
+  FXThreadPool pool(FXMAX(size,2U<<depth));
+  FXTime start,finish;
+  pool.setMinimumThreads(nthreads);
+  pool.setMaximumThreads(nthreads);
+  pool.setWorkStealing(steal);
+  pool.start(nthreads);
+  allocElms(latency,ntasks*rounds);
+  nlatency=0;
+  start=FXThread::time();
+  for(FXuint r=0; r<rounds; ++r){
+    FXTaskGroup group(&pool);
+    Spawn root(depth);
+    group.executeAndWait(&root);
+    }
+  finish=FXThread::time();
+  pool.stop();
+  qsort(latency,nlatency,sizeof(FXTime),compareLatency);
+  fxmessage("%-14s %3u threads %9d tasks %10.0lf tasks/s  latency p50 %8.2lfus p99 %8.2lfus\n",steal?"work-stealing":"shared-queue",nthreads,nlatency,1.0E9*nlatency/(finish-start),0.001*latency[nlatency/2],0.001*latency[(nlatency*99)/100]);
+  freeElms(latency);
+  }
+
+/*******************************************************************************/
+
+// Sum of squares of items in range
+struct SumSquares {
+  const FXdouble* data;
+  SumSquares(const FXdouble* d):data(d){}
+  FXdouble operator()(FXival fm,FXival to) const { FXdouble s=0.0; while(fm<to){ s+=data[fm]*data[fm]; ++fm; } return s; }
+  };
+
+
+// Add two numbers
+struct Add {
+  FXdouble operator()(FXdouble a,FXdouble b) const { return a+b; }
+  };
+
+
+// Compare two numbers
+struct Less {
+  FXbool operator()(FXdouble a,FXdouble b) const { return a<b; }
+  };
+
+
+// Time reduce, scan, and sort of nitems numbers on 1...maximum threads
+void scaling(FXuint size,FXuint maximum,FXuint nitems){
+  FXArray<FXdouble> data(nitems);
+  FXArray<FXdouble> work(nitems);
+  FXRandom random(1234567);
+  FXTime t0,t1,t2,t3;
+  FXdouble sum;
+  FXival i;
+  for(i=0; i<data.no(); ++i){
+    data[i]=random.randDouble();
+    }
+  fxmessage("threads     reduce       scan       sort  (%u items)\n",nitems);
+  for(FXuint nthreads=1; nthreads<=maximum; ++nthreads){
+    FXThreadPool pool(size);
+    pool.setMinimumThreads(nthreads);
+    pool.setMaximumThreads(nthreads);
+    pool.start(nthreads);
+    work=data;
+    t0=FXThread::time();
+    sum=FXParallelReduce(&pool,(FXival)0,data.no(),(FXival)4096,0.0,SumSquares(data.data()),Add());
+    t1=FXThread::time();
+    FXParallelScan(&pool,data.data(),work.data(),work.no(),0.0,Add());
+    t2=FXThread::time();
+    FXParallelSort(&pool,work,Less());
+    t3=FXThread::time();
+    pool.stop();
+    for(i=1; i<work.no(); ++i){
+      if(work[i]<work[i-1]){ fxmessage("sort failed at %ld\n",i); break; }
+      }
+    fxmessage("%7u %8.3lfms %8.3lfms %8.3lfms  (sum %.6lf)\n",nthreads,0.000001*(t1-t0),0.000001*(t2-t1),0.000001*(t3-t2),sum);
+    }
+  }
+
+/*******************************************************************************/
+
 // Print options
 void printusage(const char* prog){
   fxmessage("%s options:\n",prog);
@@ -80,6 +218,8 @@ void printusage(const char* prog){
   fxmessage("  --jobs <number>             Number of jobs to run.\n");
   fxmessage("  --size <number>             Queue size.\n");
   fxmessage("  --pieces <number>           Split in this many pieces.\n");
+  fxmessage("  --depth <number>            Spawn depth for benchmark.\n");
+  fxmessage("  --items <number>            Number of items for scaling test.\n");
   fxmessage("  -tracelevel <number>        Set trace level.\n");
   fxmessage("  -W, --wait                  Calling thread waits.\n");
   fxmessage("  -h, --help                  Print help.\n");
@@ -87,6 +227,10 @@ void printusage(const char* prog){
   fxmessage("  -P, --pool                  Test thread pool.\n");
   fxmessage("  -L, --loop                  Test parallel loop.\n");
   fxmessage("  -I, --invoke                Test parallel invoke.\n");
+  fxmessage("  -A, --adaptive              Test adaptive parallel loop.\n");
+  fxmessage("  -G, --graph                 Test task graph.\n");
+  fxmessage("  -B, --bench                 Benchmark shared-queue versus work-stealing.\n");
+  fxmessage("  -S, --scaling               Benchmark reduce, scan, and sort on 1...maximum threads.\n");
   }
 
 
@@ -111,6 +255,8 @@ int main(int argc,char* argv[]){
   FXuint nthreads=1;
   FXuint size=512;
   FXuint njobs=10;
+  FXuint depth=12;
+  FXuint nitems=1000000;
   FXuint test=2;
   FXuint wait=0;
 
@@ -152,6 +298,15 @@ int main(int argc,char* argv[]){
       njobs=strtoul(argv[arg],nullptr,0);
       if(njobs<1){ fxmessage("Value for njobs (%d) too small.\n",njobs); exit(1); }
       }
+    else if(strcmp(argv[arg],"--depth")==0){
+      if(++arg>=argc){ fxmessage("Missing depth argument.\n"); exit(1); }
+      depth=strtoul(argv[arg],nullptr,0);
+      if(depth>20){ fxmessage("Value for depth (%d) too large.\n",depth); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--items")==0){
+      if(++arg>=argc){ fxmessage("Missing items argument.\n"); exit(1); }
+      nitems=strtoul(argv[arg],nullptr,0);
+      }
     else if(strcmp(argv[arg],"-W")==0 || strcmp(argv[arg],"--wait")==0){
       wait=1;
       }
@@ -164,6 +319,18 @@ int main(int argc,char* argv[]){
     else if(strcmp(argv[arg],"-I")==0 || strcmp(argv[arg],"--invoke")==0){
       test=3;
       }
+    else if(strcmp(argv[arg],"-A")==0 || strcmp(argv[arg],"--adaptive")==0){
+      test=5;
+      }
+    else if(strcmp(argv[arg],"-G")==0 || strcmp(argv[arg],"--graph")==0){
+      test=7;
+      }
+    else if(strcmp(argv[arg],"-S")==0 || strcmp(argv[arg],"--scaling")==0){
+      test=6;
+      }
+    else if(strcmp(argv[arg],"-B")==0 || strcmp(argv[arg],"--bench")==0){
+      test=4;
+      }
     else if(strcmp(argv[arg],"-N")==0 || strcmp(argv[arg],"--null")==0){
       test=0;
       }
@@ -180,6 +347,19 @@ int main(int argc,char* argv[]){
 
   fxmessage("main thread %p\n",(void*)FXThread::current());
 
+  // Benchmark runs its own thread pools
+  if(4==test){
+    benchmark(size,nthreads,depth,njobs,false);
+    benchmark(size,nthreads,depth,njobs,true);
+    return 0;
+    }
+
+  // Scaling test runs its own thread pools
+  if(6==test){
+    scaling(size,maximum,nitems);
+    return 0;
+    }
+
   // Create thread pool with queue size
   FXThreadPool pool(size);
 
@@ -240,6 +420,58 @@ int main(int argc,char* argv[]){
     fxmessage("...done\n");
     }
 
+  // Test adaptive loop
+  if(5==test){
+    fxmessage("%d-way adaptive parallel for-loop...\n",nthreads);
+
+    // Split on demand down to single iterations
+    FXParallelForAdaptive(0U,njobs,1U,1U,looping);
+
+    fxmessage("...done!\n");
+    }
+
+  // Test task graph
+  if(7==test){
+    fxmessage("task graph...\n");
+
+    // Load, then decode two parts in parallel, join, and render
+    Stage load("load"),decode1("decode1"),decode2("decode2"),render("render");
+    FXTaskNode l(&load),d1(&decode1),d2(&decode2),j,r(&render);
+    FXTaskNode* parts[]={&d1,&d2};
+    FXTaskGroup group;
+    d1.after(&l);
+    d2.after(&l);
+    j.after(parts,2);
+    r.after(&j);
+    group.schedule(&r);
+    group.schedule(&j);
+    group.schedule(&d2);
+    group.schedule(&d1);
+    group.schedule(&l);
+    group.wait();
+
+    // Same graph on a pool which is not running; nodes must be cancelled, not lost
+    FXThreadPool stopped;
+    FXTaskNode sl(&load),sd1(&decode1),sd2(&decode2),sj,sr(&render);
+    FXTaskNode* sparts[]={&sd1,&sd2};
+    FXTaskGroup sgroup(&stopped);
+    sd1.after(&sl);
+    sd2.after(&sl);
+    sj.after(sparts,2);
+    sr.after(&sj);
+    sgroup.schedule(&sr);
+    sgroup.schedule(&sj);
+    sgroup.schedule(&sd2);
+    sgroup.schedule(&sd1);
+    sgroup.schedule(&sl);
+    sgroup.wait();
+    if(!(sl.isDone() && sd1.isDone() && sd2.isDone() && sj.isDone() && sr.isDone() && sr.isCancelled())){
+      fxmessage("FAILED: task graph on stopped pool did not complete\n");
+      }
+
+    fxmessage("...done!\n");
+    }
+
   fxmessage("running: %d!\n",pool.getRunningThreads());
 
   // Wait for user
@@ -0,0 +1,342 @@
+/********************************************************************************
+*                                                                               *
+*                           P N G   D e c o d e r   T e s t                     *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include <zlib.h>
+#include "../lib/fxpngpriv.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Write PNG images of every type and bit depth, plain and interlaced, with
+    a random filter on each line, and check that they load as expected; the
+    expected pixels are worked out here from the samples, one at a time.
+  - Gray and RGB images also get a transparent color from a tRNS chunk, and
+    indexed images alpha values for part of their colormap.
+  - Odd widths make sure the decoder handles the bytes left over after its
+    last full vector.
+  - The checks are repeated with the processor features the decoder may use
+    masked to none, SSE2, and SSE2+SSSE3, so the plain and older vector code
+    are checked too, not just the best the processor has.
+  - Time loading 8K images of the common types, with a random filter on each
+    line.
+*/
+
+/*******************************************************************************/
+
+// Image types
+enum {
+  Gray      = 0,
+  RGB       = 2,
+  Indexed   = 3,
+  GrayAlpha = 4,
+  RGBA      = 6
+  };
+
+
+// Channels for each type
+static const FXuint channels[7]={1,0,3,1,2,0,4};
+
+
+// Adam7 interlace pattern
+static const FXuint xoffset[7]={0,4,0,2,0,1,0};
+static const FXuint yoffset[7]={0,0,4,0,2,0,1};
+static const FXuint xstep[7]={8,8,4,4,2,2,1};
+static const FXuint ystep[7]={8,8,8,4,4,2,2};
+
+
+// Test image
+struct Image {
+  FXuint   width;               // Width
+  FXuint   height;              // Height
+  FXuint   type;                // Image type
+  FXuint   depth;               // Bits per sample
+  FXuint   interlace;           // Adam7 if 1
+  FXuint  *samples;             // Samples, channels per pixel
+  FXuchar  palette[256*3];      // Colormap
+  FXuchar  alphas[256];         // Alpha of colormap entries
+  FXuint   nalphas;             // Number of alphas
+  FXuint   key[3];              // Transparent color
+  FXbool   keyed;               // Has transparent color
+  };
+
+
+// Paeth predictor
+static FXuint paeth(FXint a,FXint b,FXint c){
+  FXint p=a+b-c;
+  FXint pa=FXABS(p-a);
+  FXint pb=FXABS(p-b);
+  FXint pc=FXABS(p-c);
+  if(pa<=pb && pa<=pc) return a;
+  if(pb<=pc) return b;
+  return c;
+  }
+
+
+// Pack row of samples, starting at x by xs, into bytes
+static void packRow(const Image& img,FXuchar* dst,FXuint y,FXuint x,FXuint xs,FXuint n){
+  FXuint ch=channels[img.type];
+  FXuint bit=0;
+  memset(dst,0,(n*ch*img.depth+7)/8);
+  for(FXuint i=0; i<n; ++i){
+    for(FXuint c=0; c<ch; ++c){
+      FXuint v=img.samples[((FXuval)y*img.width+x+i*xs)*ch+c];
+      if(img.depth==16){ dst[bit/8]=(FXuchar)(v>>8); dst[bit/8+1]=(FXuchar)v; }
+      else if(img.depth==8){ dst[bit/8]=(FXuchar)v; }
+      else{ dst[bit/8]|=(FXuchar)(v<<(8-img.depth-(bit&7))); }
+      bit+=img.depth;
+      }
+    }
+  }
+
+
+// Filter row in place, given unfiltered row above, if any
+static void filterRow(FXuchar* dst,const FXuchar* cur,const FXuchar* prv,FXuint n,FXuint bpp,FXuint filter){
+  for(FXuint i=0; i<n; ++i){
+    FXuint a=(i>=bpp)?cur[i-bpp]:0;
+    FXuint b=prv?prv[i]:0;
+    FXuint c=(prv && i>=bpp)?prv[i-bpp]:0;
+    switch(filter){
+      case 0: dst[i]=cur[i]; break;
+      case 1: dst[i]=(FXuchar)(cur[i]-a); break;
+      case 2: dst[i]=(FXuchar)(cur[i]-b); break;
+      case 3: dst[i]=(FXuchar)(cur[i]-((a+b)>>1)); break;
+      case 4: dst[i]=(FXuchar)(cur[i]-paeth(a,b,c)); break;
+      }
+    }
+  }
+
+
+// Filter rows of one pass, filter being 0..4, or random if 5
+static void filterPass(const Image& img,FXString& raw,FXRandom& random,FXuint x,FXuint y,FXuint xs,FXuint ys,FXuint filter){
+  FXuint ch=channels[img.type];
+  FXuint bpp=FXMAX((ch*img.depth)/8,1);
+  FXuint w=(img.width-x+xs-1)/xs;
+  FXuint n=(w*ch*img.depth+7)/8;
+  FXuchar *cur,*prv,*out;
+  FXbool first=true;
+  if(x>=img.width || y>=img.height) return;
+  callocElms(cur,n+1);
+  callocElms(prv,n+1);
+  callocElms(out,n+1);
+  for(FXuint r=y; r<img.height; r+=ys){
+    packRow(img,cur,r,x,xs,w);
+    out[0]=(FXuchar)((filter<5)?filter:random.randLong()%5);
+    filterRow(out+1,cur,first?nullptr:prv,n,bpp,out[0]);
+    raw.append((const FXchar*)out,n+1);
+    swap(cur,prv);
+    first=false;
+    }
+  freeElms(cur);
+  freeElms(prv);
+  freeElms(out);
+  }
+
+
+// Write chunk
+static void chunk(FXString& png,const FXchar* id,const FXuchar* data,FXuint size){
+  FXuchar len[4]={(FXuchar)(size>>24),(FXuchar)(size>>16),(FXuchar)(size>>8),(FXuchar)size};
+  uLong crc=crc32(0,(const Bytef*)id,4);
+  if(size) crc=crc32(crc,data,size);
+  FXuchar sum[4]={(FXuchar)(crc>>24),(FXuchar)(crc>>16),(FXuchar)(crc>>8),(FXuchar)crc};
+  png.append((const FXchar*)len,4);
+  png.append(id,4);
+  png.append((const FXchar*)data,size);
+  png.append((const FXchar*)sum,4);
+  }
+
+
+// Write image as PNG
+static FXString writePNG(const Image& img,FXRandom& random,FXuint filter){
+  static const FXuchar signature[8]={0x89,0x50,0x4E,0x47,0x0D,0x0A,0x1A,0x0A};
+  FXuchar hdr[13]={(FXuchar)(img.width>>24),(FXuchar)(img.width>>16),(FXuchar)(img.width>>8),(FXuchar)img.width,(FXuchar)(img.height>>24),(FXuchar)(img.height>>16),(FXuchar)(img.height>>8),(FXuchar)img.height,(FXuchar)img.depth,(FXuchar)img.type,0,0,(FXuchar)img.interlace};
+  FXuchar trns[6];
+  FXString png((const FXchar*)signature,8);
+  FXString raw;
+  FXuchar *zip;
+  uLongf ziplen;
+  chunk(png,"IHDR",hdr,13);
+  if(img.type==Indexed){
+    chunk(png,"PLTE",img.palette,(1<<img.depth)*3);
+    if(img.nalphas) chunk(png,"tRNS",img.alphas,img.nalphas);
+    }
+  if(img.keyed && img.type==Gray){
+    trns[0]=(FXuchar)(img.key[0]>>8); trns[1]=(FXuchar)img.key[0];
+    chunk(png,"tRNS",trns,2);
+    }
+  if(img.keyed && img.type==RGB){
+    for(FXuint c=0; c<3; ++c){ trns[2*c]=(FXuchar)(img.key[c]>>8); trns[2*c+1]=(FXuchar)img.key[c]; }
+    chunk(png,"tRNS",trns,6);
+    }
+  if(img.interlace){
+    for(FXuint p=0; p<7; ++p){
+      filterPass(img,raw,random,xoffset[p],yoffset[p],xstep[p],ystep[p],filter);
+      }
+    }
+  else{
+    filterPass(img,raw,random,0,0,1,1,filter);
+    }
+  ziplen=compressBound(raw.length());
+  allocElms(zip,ziplen);
+  compress2(zip,&ziplen,(const Bytef*)raw.text(),raw.length(),1);
+  chunk(png,"IDAT",zip,(FXuint)ziplen);
+  chunk(png,"IEND",nullptr,0);
+  freeElms(zip);
+  return png;
+  }
+
+
+// Sample to 8 bits
+static FXuint eight(FXuint v,FXuint depth){
+  if(depth==16) return v/257;
+  return v*255/((1<<depth)-1);
+  }
+
+
+// Expected pixel
+static FXColor expected(const Image& img,FXuint x,FXuint y){
+  FXuint ch=channels[img.type];
+  const FXuint* s=img.samples+((FXuval)y*img.width+x)*ch;
+  FXColor color=0;
+  switch(img.type){
+    case Gray: color=FXRGB(eight(s[0],img.depth),eight(s[0],img.depth),eight(s[0],img.depth)); break;
+    case RGB: color=FXRGB(eight(s[0],img.depth),eight(s[1],img.depth),eight(s[2],img.depth)); break;
+    case Indexed: color=FXRGBA(img.palette[3*s[0]],img.palette[3*s[0]+1],img.palette[3*s[0]+2],(s[0]<img.nalphas)?img.alphas[s[0]]:255); break;
+    case GrayAlpha: color=FXRGBA(eight(s[0],img.depth),eight(s[0],img.depth),eight(s[0],img.depth),eight(s[1],img.depth)); break;
+    case RGBA: color=FXRGBA(eight(s[0],img.depth),eight(s[1],img.depth),eight(s[2],img.depth),eight(s[3],img.depth)); break;
+    }
+  if(img.keyed && img.type==Gray && color==FXRGB(eight(img.key[0],img.depth),eight(img.key[0],img.depth),eight(img.key[0],img.depth))) color&=FXRGBA(255,255,255,0);
+  if(img.keyed && img.type==RGB && color==FXRGB(eight(img.key[0],img.depth),eight(img.key[1],img.depth),eight(img.key[2],img.depth))) color&=FXRGBA(255,255,255,0);
+  return color;
+  }
+
+
+// Make image with random samples; smooth ones if photo
+static void makeImage(Image& img,FXRandom& random,FXuint w,FXuint h,FXuint type,FXuint depth,FXbool photo){
+  FXuint ch=channels[type];
+  FXuint maxval=(1<<depth)-1;
+  img.width=w;
+  img.height=h;
+  img.type=type;
+  img.depth=depth;
+  img.interlace=0;
+  allocElms(img.samples,(FXuval)w*h*ch);
+  for(FXuint y=0; y<h; ++y){
+    for(FXuint x=0; x<w; ++x){
+      for(FXuint c=0; c<ch; ++c){
+        FXuint v=(FXuint)random.randLong();
+        if(photo) v=((x*(c+1)+y*(3-c%3))*maxval)/(2*w+2*h)+(v&3);
+        img.samples[((FXuval)y*w+x)*ch+c]=v&maxval;
+        }
+      }
+    }
+  for(FXuint i=0; i<256*3; ++i){ img.palette[i]=(FXuchar)random.randLong(); }
+  for(FXuint i=0; i<256; ++i){ img.alphas[i]=(FXuchar)random.randLong(); }
+  img.nalphas=(type==Indexed)?(1<<depth)/2:0;
+  img.keyed=(type==Gray || type==RGB);
+  for(FXuint c=0; c<3; ++c){ img.key[c]=img.samples[c%ch]; }
+  }
+
+
+// Load PNG from memory
+static FXbool loadPNG(const FXString& png,FXColor*& pix,FXint& w,FXint& h){
+  FXMemoryStream ms;
+  FXbool ok;
+  ms.open(FXStreamLoad,(FXuchar*)png.text(),png.length());
+  ok=fxloadPNG(ms,pix,w,h);
+  ms.close();
+  return ok;
+  }
+
+
+// Check every type and depth with each filter, plain and interlaced
+static void types(FXRandom& random,FXuint w,FXuint h){
+  static const FXuint kinds[][2]={{Gray,1},{Gray,2},{Gray,4},{Gray,8},{Gray,16},{RGB,8},{RGB,16},{Indexed,1},{Indexed,2},{Indexed,4},{Indexed,8},{GrayAlpha,8},{GrayAlpha,16},{RGBA,8},{RGBA,16}};
+  FXColor *pix;
+  FXint iw,ih;
+  FXuint bad;
+  Image img;
+  for(FXuint k=0; k<ARRAYNUMBER(kinds); ++k){
+    makeImage(img,random,w,h,kinds[k][0],kinds[k][1],false);
+    for(FXuint interlace=0; interlace<2; ++interlace){
+      img.interlace=interlace;
+      for(FXuint filter=0; filter<=5; ++filter){
+        FXString png=writePNG(img,random,filter);
+        if(loadPNG(png,pix,iw,ih)){
+          bad=0;
+          for(FXuint y=0; y<h; ++y){
+            for(FXuint x=0; x<w; ++x){
+              if(pix[(FXuval)y*w+x]!=expected(img,x,y)) bad++;
+              }
+            }
+          check(bad==0 && iw==(FXint)w && ih==(FXint)h,"type/depth",kinds[k][0]*100+kinds[k][1],w*10+filter);
+          freeElms(pix);
+          }
+        else{
+          check(false,"load",kinds[k][0]*100+kinds[k][1],w*10+filter);
+          }
+        }
+      }
+    freeElms(img.samples);
+    }
+  }
+
+
+// Time loading big image of given type
+static void benchmark(FXRandom& random,FXuint w,FXuint h,FXuint type,FXuint depth){
+  static const FXchar *const names[]={"gray","","rgb","index","grayalpha","","rgba"};
+  const FXint ROUNDS=3;
+  FXColor *pix;
+  FXint iw,ih;
+  FXdouble ms=1.0E30;
+  FXTime start;
+  Image img;
+  makeImage(img,random,w,h,type,depth,true);
+  img.keyed=false;
+  FXString png=writePNG(img,random,5);
+  for(FXint r=0; r<ROUNDS; ++r){
+    start=FXThread::time();
+    check(loadPNG(png,pix,iw,ih),"benchmark",type,depth);
+    ms=FXMIN(ms,elapsed(start));
+    freeElms(pix);
+    }
+  fxmessage("  %-9s %2u bits: %9.3lfms %8.1lf Mpixel/s\n",names[type],depth,ms,(0.001*w*h)/ms);
+  freeElms(img.samples);
+  }
+
+
+// Start
+int main(int argc,char *argv[]){
+  FXRandom random(1234);
+  FXuint w=7680,h=4320;
+
+  // Correctness, with processor features masked
+  static const FXuint masks[]={0,CPU_HAS_SSE2,CPU_HAS_SSE2|CPU_HAS_SSSE3,~0U};
+  for(FXuint m=0; m<ARRAYNUMBER(masks); ++m){
+    fxmessage("Features %08x:\n",fxCPUFeatures()&masks[m]);
+    __pngfeatures(masks[m]);
+    types(random,1,1);
+    types(random,3,2);
+    types(random,17,9);
+    types(random,61,13);
+    types(random,255,21);
+    }
+
+  // Speed
+  if(1<argc && FXString(argv[1])=="-quick"){ w=1024; h=768; }
+  fxmessage("Loading %ux%u:\n",w,h);
+  benchmark(random,w,h,Gray,8);
+  benchmark(random,w,h,GrayAlpha,8);
+  benchmark(random,w,h,RGB,8);
+  benchmark(random,w,h,RGBA,8);
+  benchmark(random,w,h,Indexed,8);
+  benchmark(random,w,h,Indexed,4);
+  benchmark(random,w,h,RGB,16);
+  benchmark(random,w,h,RGBA,16);
+
+  return report();
+  }
@@ -0,0 +1,319 @@
+/********************************************************************************
+*                                                                               *
+*                         I m a g e   R e s a m p l e r   T e s t               *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Check that scaling to the same size gives back the same image, and that a
+    constant image stays constant, for every filter.
+  - Check Lanczos and Mitchell against a plain two-dimensional filter worked out
+    in double precision, box against FXImage's box filter, and scaling on the
+    thread pool against scaling on one thread.
+  - Check that scaling into part of a bigger buffer leaves the rest alone.
+  - Time making a thumbnail and a half size copy of a 40 megapixel photo, with
+    FXImage's scale qualities, and with FXResampler on one thread and on the
+    thread pool.
+*/
+
+/*******************************************************************************/
+
+// Fill image with random pixels; opaque, or with random alpha
+static void randomize(FXRandom& random,FXColor* pix,FXint n,FXbool opaque){
+  for(FXint i=0; i<n; ++i){
+    pix[i]=(FXColor)random.randLong();
+    if(opaque) pix[i]|=FXRGBA(0,0,0,255);
+    }
+  }
+
+
+// Fill image with smooth photo-like pixels
+static void photo(FXColor* pix,FXint w,FXint h){
+  for(FXint y=0; y<h; ++y){
+    for(FXint x=0; x<w; ++x){
+      pix[(FXival)y*w+x]=FXRGB((x*255)/w,(y*255)/h,((x^y)&63)+96);
+      }
+    }
+  }
+
+
+// Largest difference between channels of two pixels
+static FXint difference(FXColor a,FXColor b){
+  FXint d=0;
+  for(FXint s=0; s<32; s+=8){
+    d=FXMAX(d,FXABS((FXint)((a>>s)&255)-(FXint)((b>>s)&255)));
+    }
+  return d;
+  }
+
+
+// Lanczos filter with 3 lobes
+static FXdouble lanczos(FXdouble x){
+  x=Math::fabs(x);
+  if(x<1.0E-9) return 1.0;
+  if(x>=3.0) return 0.0;
+  return Math::sin(PI*x)*Math::sin(PI*x/3.0)/(PI*x*PI*x/3.0);
+  }
+
+
+// Mitchell-Netravali filter, B=C=1/3
+static FXdouble mitchell(FXdouble x){
+  const FXdouble B=1.0/3.0,C=1.0/3.0;
+  x=Math::fabs(x);
+  if(x<1.0) return ((12.0-9.0*B-6.0*C)*x*x*x+(-18.0+12.0*B+6.0*C)*x*x+(6.0-2.0*B))/6.0;
+  if(x<2.0) return ((-B-6.0*C)*x*x*x+(6.0*B+30.0*C)*x*x+(-12.0*B-48.0*C)*x+(8.0*B+24.0*C))/6.0;
+  return 0.0;
+  }
+
+
+// Weight of source pixel j in output pixel i, scaling n to m pixels;
+// the size staying the same, pixels are taken as they are
+static FXdouble weight(FXuint filter,FXint i,FXint j,FXint n,FXint m){
+  if(n==m) return (i==j)?1.0:0.0;
+  FXdouble scale=(FXdouble)n/m;
+  FXdouble stretch=FXMAX(scale,1.0);
+  FXdouble x=(j+0.5-(i+0.5)*scale)/stretch;
+  return (filter==FXResampler::Lanczos)?lanczos(x):mitchell(x);
+  }
+
+
+// Range of source pixels under output pixel i, scaling n to m pixels
+static void under(FXuint filter,FXint i,FXint n,FXint m,FXint& lo,FXint& hi){
+  FXdouble scale=(FXdouble)n/m;
+  FXdouble support=((filter==FXResampler::Lanczos)?3.0:2.0)*FXMAX(scale,1.0);
+  lo=(FXint)Math::floor((i+0.5)*scale-support)-1;
+  hi=(FXint)Math::ceil((i+0.5)*scale+support)+1;
+  }
+
+
+// Scale image the slow way: each output pixel sums all source pixels,
+// clamped to the edge, weighted by filter in x and y, in linear light
+static void reference(FXColor* dst,FXint dw,FXint dh,const FXColor* src,FXint sw,FXint sh,FXuint filter,FXdouble gamma){
+  for(FXint y=0; y<dh; ++y){
+    for(FXint x=0; x<dw; ++x){
+      FXdouble acc[4]={0.0,0.0,0.0,0.0},sum=0.0,wx,wy,a;
+      FXint xlo,xhi,ylo,yhi;
+      under(filter,x,sw,dw,xlo,xhi);
+      under(filter,y,sh,dh,ylo,yhi);
+      for(FXint j=ylo; j<=yhi; ++j){
+        if((wy=weight(filter,y,j,sh,dh))==0.0) continue;
+        for(FXint i=xlo; i<=xhi; ++i){
+          if((wx=weight(filter,x,i,sw,dw))==0.0) continue;
+          FXColor p=src[FXCLAMP(0,j,sh-1)*sw+FXCLAMP(0,i,sw-1)];
+          a=FXALPHAVAL(p)/255.0;
+          acc[0]+=wx*wy*a*Math::pow(FXREDVAL(p)/255.0,gamma);
+          acc[1]+=wx*wy*a*Math::pow(FXGREENVAL(p)/255.0,gamma);
+          acc[2]+=wx*wy*a*Math::pow(FXBLUEVAL(p)/255.0,gamma);
+          acc[3]+=wx*wy*a;
+          sum+=wx*wy;
+          }
+        }
+      a=FXCLAMP(0.0,acc[3]/sum,1.0);
+      for(FXint c=0; c<3; ++c){
+        acc[c]=(0.0<a)?255.0*Math::pow(FXCLAMP(0.0,acc[c]/sum/a,1.0),1.0/gamma):0.0;
+        }
+      dst[y*dw+x]=FXRGBA((FXint)(acc[0]+0.5),(FXint)(acc[1]+0.5),(FXint)(acc[2]+0.5),(FXint)(255.0*a+0.5));
+      }
+    }
+  }
+
+
+// Compare images, return largest difference
+static FXint compare(const FXColor* a,const FXColor* b,FXint n){
+  FXint d=0;
+  for(FXint i=0; i<n; ++i){
+    d=FXMAX(d,difference(a[i],b[i]));
+    }
+  return d;
+  }
+
+
+// Scaling to the same size gives back the same image
+static void identity(FXRandom& random){
+  FXColor src[37*23],dst[37*23];
+  randomize(random,src,37*23,false);
+  for(FXuint filter=FXResampler::Box; filter<=FXResampler::Lanczos; ++filter){
+    FXResampler resampler(filter,2.2f,nullptr);
+    resampler.setThreadPool(nullptr);
+    resampler.scale(dst,37,23,37,src,37,23,37);
+    for(FXint i=0; i<37*23; ++i){
+      FXColor expect=FXALPHAVAL(src[i])?src[i]:0;
+      if(dst[i]!=expect){ check(false,"identity",dst[i],expect); break; }
+      }
+    }
+  }
+
+
+// Constant image stays constant, scaling up or down
+static void constant(){
+  static const FXint sizes[][4]={{64,48,16,12},{64,48,5,3},{16,12,64,48},{7,5,100,1},{1,1,9,9},{300,2,1,1}};
+  FXColor src[64*48],dst[100*48];
+  for(FXuint filter=FXResampler::Box; filter<=FXResampler::Lanczos; ++filter){
+    FXResampler resampler(filter,2.2f,nullptr);
+    resampler.setThreadPool(nullptr);
+    for(FXuint s=0; s<ARRAYNUMBER(sizes); ++s){
+      FXint sw=sizes[s][0],sh=sizes[s][1],dw=sizes[s][2],dh=sizes[s][3];
+      FXColor pix=FXRGBA(200,100,3,128);
+      FXColor *big=nullptr;
+      const FXColor *from=src;
+      if(sw*sh>64*48){ allocElms(big,sw*sh); from=big; }
+      fillElms(big?big:src,pix,sw*sh);
+      resampler.scale(dst,dw,dh,dw,from,sw,sh,sw);
+      for(FXint i=0; i<dw*dh; ++i){
+        if(difference(dst[i],pix)>1){ check(false,"constant",dst[i],pix); break; }
+        }
+      freeElms(big);
+      }
+    }
+  }
+
+
+// Filters against plain two-dimensional filter
+static void filters(FXRandom& random){
+  static const FXint sizes[][4]={{40,30,13,11},{12,9,31,25},{33,17,33,40},{20,20,3,7}};
+  FXColor src[40*30],dst[40*40],ref[40*40];
+  for(FXuint filter=FXResampler::Mitchell; filter<=FXResampler::Lanczos; ++filter){
+    for(FXuint s=0; s<ARRAYNUMBER(sizes); ++s){
+      FXint sw=sizes[s][0],sh=sizes[s][1],dw=sizes[s][2],dh=sizes[s][3];
+      for(FXint g=0; g<2; ++g){
+        FXdouble gamma=g?2.2:1.0;
+        FXResampler resampler(filter,(FXfloat)gamma,nullptr);
+        resampler.setThreadPool(nullptr);
+        randomize(random,src,sw*sh,(s&1)!=0);
+        resampler.scale(dst,dw,dh,dw,src,sw,sh,sw);
+        reference(ref,dw,dh,src,sw,sh,filter,gamma);
+        FXint d=0;
+        for(FXint i=0; i<dw*dh; ++i){
+          if(FXALPHAVAL(ref[i])<8) continue;    // Color of nearly clear pixels is too far off to tell
+          d=FXMAX(d,difference(dst[i],ref[i]));
+          }
+        check(d<=1,filter==FXResampler::Lanczos?"lanczos":"mitchell",d,s);
+        }
+      }
+    }
+  }
+
+
+// Box filter against FXImage's, which truncates where we round
+static void box(FXApp& app,FXRandom& random){
+  static const FXint sizes[][4]={{64,48,16,12},{61,47,17,13},{50,50,7,3},{10,10,25,35}};
+  FXColor src[64*48],dst[40*40];
+  FXResampler resampler(FXResampler::Box,1.0f,nullptr);
+  resampler.setThreadPool(nullptr);
+  for(FXuint s=0; s<ARRAYNUMBER(sizes); ++s){
+    FXint sw=sizes[s][0],sh=sizes[s][1],dw=sizes[s][2],dh=sizes[s][3];
+    randomize(random,src,sw*sh,true);
+    FXImage image(&app,src,0,sw,sh);
+    image.scale(dw,dh,1);
+    resampler.scale(dst,dw,dh,dw,src,sw,sh,sw);
+    check(compare(dst,image.getData(),dw*dh)<=2,"box",sw,dw);
+    }
+  }
+
+
+// Same image on the thread pool as on one thread, and scaled by FXImage
+static void parallel(FXApp& app,FXThreadPool& pool){
+  FXint sw=1031,sh=777,dw=517,dh=1201;
+  FXColor *src,*one,*many;
+  allocElms(src,sw*sh);
+  allocElms(one,dw*dh);
+  allocElms(many,dw*dh);
+  photo(src,sw,sh);
+  FXResampler resampler(FXResampler::Lanczos,2.2f,&pool);
+  check(resampler.scale(many,dw,dh,dw,src,sw,sh,sw),"parallel",dw,dh);
+  resampler.setThreadPool(nullptr);
+  check(resampler.scale(one,dw,dh,dw,src,sw,sh,sw),"serial",dw,dh);
+  check(memcmp(one,many,sizeof(FXColor)*dw*dh)==0,"parallel",dw,dh);
+  FXImage image(&app,src,IMAGE_OWNED,sw,sh);
+  image.scale(dw,dh,3);
+  check(image.getWidth()==dw && image.getHeight()==dh,"image",image.getWidth(),image.getHeight());
+  check(memcmp(one,image.getData(),sizeof(FXColor)*dw*dh)==0,"image",dw,dh);
+  freeElms(many);
+  freeElms(one);
+  }
+
+
+// Scale into part of bigger buffer
+static void stride(FXRandom& random){
+  FXColor src[50*40],dst[30*20];
+  FXResampler resampler(FXResampler::Lanczos,2.2f,nullptr);
+  randomize(random,src,50*40,true);
+  fillElms(dst,FXRGBA(1,2,3,4),30*20);
+  resampler.scale(dst+30*5+7,13,9,30,src+50*3+4,40,30,50);
+  for(FXint y=0; y<20; ++y){
+    for(FXint x=0; x<30; ++x){
+      FXbool inside=(7<=x && x<20 && 5<=y && y<14);
+      if(inside==(dst[y*30+x]==FXRGBA(1,2,3,4))){ check(false,"stride",x,y); return; }
+      }
+    }
+  check(!resampler.scale(dst,31,9,30,src,40,30,50),"bad stride",31,30);
+  check(!resampler.scale(dst,0,9,30,src,40,30,50),"bad size",0,9);
+  }
+
+
+// Time scaling photo to given size
+static void benchmark(FXApp& app,FXThreadPool& pool,const FXColor* src,FXint sw,FXint sh,FXint dw,FXint dh){
+  static const FXchar* const names[]={"box","mitchell","lanczos"};
+  FXColor *dst;
+  FXTime start;
+  fxmessage("%dx%d to %dx%d:\n",sw,sh,dw,dh);
+  for(FXint q=1; q<=3; ++q){
+    FXColor *copy;
+    dupElms(copy,src,(FXival)sw*sh);
+    FXImage image(&app,copy,IMAGE_OWNED,sw,sh);
+    start=FXThread::time();
+    image.scale(dw,dh,q);
+    fxmessage("  FXImage::scale quality %d:  %9.3lfms\n",q,elapsed(start));
+    }
+  allocElms(dst,(FXival)dw*dh);
+  for(FXuint filter=FXResampler::Box; filter<=FXResampler::Lanczos; ++filter){
+    FXResampler resampler(filter,2.2f,&pool);
+    start=FXThread::time();
+    resampler.scale(dst,dw,dh,dw,src,sw,sh,sw);
+    fxmessage("  FXResampler %-8s pool:  %9.3lfms",names[filter],elapsed(start));
+    resampler.setThreadPool(nullptr);
+    start=FXThread::time();
+    resampler.scale(dst,dw,dh,dw,src,sw,sh,sw);
+    fxmessage(", one thread: %9.3lfms\n",elapsed(start));
+    }
+  freeElms(dst);
+  }
+
+
+// Start
+int main(int argc,char *argv[]){
+  FXApp app("Resample","FoxTest");
+  FXThreadPool pool;
+  FXRandom random(1234);
+  FXColor *src;
+  FXint sw=7728,sh=5152;
+
+  // Run on all processors
+  pool.setMaximumThreads(FXThread::processors());
+  pool.start(FXThread::processors());
+
+  // Correctness
+  identity(random);
+  constant();
+  filters(random);
+  box(app,random);
+  parallel(app,pool);
+  stride(random);
+
+  // Speed
+  if(1<argc && FXString(argv[1])=="-quick"){ sw=1024; sh=768; }
+  allocElms(src,(FXival)sw*sh);
+  photo(src,sw,sh);
+  benchmark(app,pool,src,sw,sh,256,(256*sh)/sw);
+  benchmark(app,pool,src,sw,sh,sw/2,sh/2);
+  benchmark(app,pool,src,sw/4,sh/4,sw/2,sh/2);
+  freeElms(src);
+
+  pool.stop();
+  return report();
+  }
@@ -0,0 +1,171 @@
+/********************************************************************************
+*                                                                               *
+*                  R e g u l a r   E x p r e s s i o n   S e a r c h   T e s t  *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Search random text with many patterns, forwards and backwards, and compare
+    the result against trying a match at every position in turn, which is what
+    FXRex::search() used to do for patterns without a known first character.
+  - Time finding all matches in a big text both ways.
+*/
+
+/*******************************************************************************/
+
+// Patterns, and the modes to parse them with
+static const struct { const FXchar* pattern; FXint mode; } patterns[]={
+  {"a",FXRex::Normal},
+  {"a",FXRex::IgnoreCase},
+  {"ab",FXRex::Normal},
+  {"Ab",FXRex::IgnoreCase},
+  {"abc",FXRex::IgnoreCase},
+  {"abca",FXRex::Normal},
+  {"abcab",FXRex::IgnoreCase},
+  {"bab ba",FXRex::Normal},
+  {"aBcAbC",FXRex::IgnoreCase},
+  {"a.c",FXRex::Normal},
+  {"ab+c",FXRex::Normal},
+  {"(ab)(c|a)",FXRex::Capture},
+  {"(?i:ab)c",FXRex::Normal},
+  {"a(?i:bC)",FXRex::Normal},
+  {"\\bab",FXRex::Normal},
+  {"ab\\b",FXRex::Normal},
+  {"(?=ab)a",FXRex::Normal},
+  {"(?<=c)ab",FXRex::Normal},
+  {"(?<!b)abc",FXRex::Normal},
+  {"ca|ba",FXRex::Normal},
+  {"(cab|bca)a",FXRex::Capture},
+  {"[bc]a",FXRex::Normal},
+  {"[bc]+a",FXRex::Normal},
+  {"[^abc ]",FXRex::Normal},
+  {"\\d+",FXRex::Normal},
+  {"\\s\\w",FXRex::Normal},
+  {"a*b",FXRex::Normal},
+  {"a?bc",FXRex::Normal},
+  {"a{2,}",FXRex::Normal},
+  {"a{0,2}c",FXRex::Normal},
+  {"(?>ab|a)c",FXRex::Normal},
+  {"(a|c)?b",FXRex::Normal},
+  {"^ab",FXRex::Normal},
+  {"ab$",FXRex::Normal},
+  {"cab",FXRex::Words},
+  {"CAB",FXRex::Words|FXRex::IgnoreCase},
+  {"a.b*",FXRex::Verbatim},
+  {"a\nb",FXRex::Verbatim|FXRex::IgnoreCase},
+  {"x",FXRex::Normal},
+  {"xyzzy",FXRex::IgnoreCase}
+  };
+
+
+// Reference search: try match at every position
+static FXint reference(const FXRex& rex,const FXchar* text,FXint len,FXint fm,FXint to,FXint* beg,FXint* end,FXint npar){
+  if(fm<=to){
+    for(FXint pos=fm; pos<=to; ++pos){
+      if(rex.amatch(text,len,pos,FXRex::Normal,beg,end,npar)) return pos;
+      }
+    }
+  else{
+    for(FXint pos=fm; pos>=to; --pos){
+      if(rex.amatch(text,len,pos,FXRex::Normal,beg,end,npar)) return pos;
+      }
+    }
+  return -1;
+  }
+
+
+// Compare search against reference for random ranges of random text
+static void compare(FXRandom& random,const FXRex& rex,const FXchar* pattern){
+  const FXint SIZE=400;
+  FXchar text[SIZE];
+  FXint beg[3],end[3],rbeg[3],rend[3];
+  FXint len,fm,to,p,q,i;
+  for(i=0; i<2000; ++i){
+    len=1+(FXint)(random.randLong()%SIZE);
+    randomText(random,text,len,"aabbcAB 1\n");
+    fm=(FXint)(random.randLong()%(len+1));
+    to=(FXint)(random.randLong()%(len+1));
+    p=rex.search(text,len,fm,to,FXRex::Normal,beg,end,3);
+    q=reference(rex,text,len,fm,to,rbeg,rend,3);
+    if(p!=q || (0<=p && (beg[0]!=rbeg[0] || end[0]!=rend[0] || beg[1]!=rbeg[1] || end[1]!=rend[1]))){
+      fxwarning("FAILED: \"%s\" from %d to %d: %d, expected %d\n",pattern,fm,to,p,q);
+      failures++;
+      return;
+      }
+    }
+  }
+
+
+// Time finding all matches in text, with search and by trying every position
+static void benchmark(const FXchar* text,FXint len,const FXchar* pattern,FXint mode){
+  FXRex rex(pattern,mode);
+  FXint beg[1],end[1];
+  FXint count=0,rcount=0,pos;
+  FXdouble searching,trying;
+  FXTime start;
+  start=FXThread::time();
+  pos=0;
+  while(pos<len && (pos=rex.search(text,len,pos,len,FXRex::Normal,beg,end,1))>=0){
+    pos=FXMAX(end[0],pos+1);
+    count++;
+    }
+  searching=elapsed(start);
+  start=FXThread::time();
+  pos=0;
+  while(pos<len && (pos=reference(rex,text,len,pos,len,beg,end,1))>=0){
+    pos=FXMAX(end[0],pos+1);
+    rcount++;
+    }
+  trying=elapsed(start);
+  if(count!=rcount){ fxwarning("FAILED: \"%s\" found %d, expected %d\n",pattern,count,rcount); failures++; }
+  fxmessage("  %-24s %-10s %7d matches: search %9.3lfms (%6.0lf MB/s), every position %9.3lfms\n",pattern,(mode&FXRex::IgnoreCase)?"ignorecase":"",count,searching,len/(1000.0*searching),trying);
+  }
+
+
+// Start
+int main(int argc,char *argv[]){
+  const FXint SIZE=16000000;
+  static const FXchar *const words[]={"the ","search ","string ","pattern ","regular ","expression ","Horspool ","match ","text ","\n"};
+  FXRandom random(1234);
+  FXString big;
+  FXint i,n;
+
+  // Correctness
+  for(i=0; i<(FXint)ARRAYNUMBER(patterns); ++i){
+    FXRex rex(patterns[i].pattern,patterns[i].mode|FXRex::Capture);
+    if(rex.empty()){ fxwarning("FAILED: \"%s\" does not parse\n",patterns[i].pattern); failures++; continue; }
+    compare(random,rex,patterns[i].pattern);
+    }
+
+  // Big text of words, or given file
+  if(1<argc){
+    FXFile file(argv[1],FXIO::Reading);
+    big.length((FXint)file.size());
+    if(!file.isOpen() || file.readBlock(big.text(),big.length())!=big.length()){ fxwarning("Unable to read %s\n",argv[1]); return 1; }
+    }
+  else{
+    big.length(SIZE);
+    for(i=0; i<SIZE; i+=n){
+      const FXchar* w=words[random.randLong()%ARRAYNUMBER(words)];
+      for(n=0; w[n] && i+n<SIZE; ++n) big[i+n]=w[n];
+      }
+    }
+  fxmessage("%d bytes:\n",big.length());
+  benchmark(big.text(),big.length(),"e",FXRex::Normal);
+  benchmark(big.text(),big.length(),"Horspool",FXRex::Normal);
+  benchmark(big.text(),big.length(),"horspool",FXRex::IgnoreCase);
+  benchmark(big.text(),big.length(),"xyzzy",FXRex::Normal);
+  benchmark(big.text(),big.length(),"xyzzy",FXRex::IgnoreCase);
+  benchmark(big.text(),big.length(),"regular expression",FXRex::Normal);
+  benchmark(big.text(),big.length(),"pattern",FXRex::Words);
+  benchmark(big.text(),big.length(),"\\bex\\w+",FXRex::Normal);
+  benchmark(big.text(),big.length(),"(match|text) the",FXRex::Normal);
+  benchmark(big.text(),big.length(),"[xyz]\\w+",FXRex::Normal);
+
+  return report();
+  }
@@ -0,0 +1,210 @@
+/********************************************************************************
+*                                                                               *
+*                 L i n e a r - T i m e   R e g u l a r   E x p r e s s i o n   *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Match and search random text with many patterns, forwards and backwards, with the
+    Pike VM (FXRex::Linear) and with the backtracker (FXRex::Backtrack), and check that
+    both find the same matches, and the same captures.
+  - Time patterns which make the backtracker take exponential time, with the backtracker,
+    and with the default, which switches over to the Pike VM when backtracking takes too
+    long.
+  - Time finding all matches of ordinary patterns in a big text with either matcher.
+*/
+
+/*******************************************************************************/
+
+// Patterns, and the modes to parse them with
+static const struct { const FXchar* pattern; FXint mode; } patterns[]={
+  {"a",FXRex::Normal},
+  {"ab",FXRex::IgnoreCase},
+  {"a.c",FXRex::Normal},
+  {"a*",FXRex::Normal},
+  {"a*?b",FXRex::Normal},
+  {"a+?",FXRex::Normal},
+  {"(a+)(a*)",FXRex::Normal},
+  {"(a*?)(a+)b",FXRex::Normal},
+  {"(a|ab)(c|bcd)?",FXRex::Normal},
+  {"(a|b)*c",FXRex::Normal},
+  {"(a|b)*?c",FXRex::Normal},
+  {"(a|b)+",FXRex::Normal},
+  {"(a|b)+?b",FXRex::Normal},
+  {"((a)|(b))*",FXRex::Normal},
+  {"((a)|b)+c",FXRex::Normal},
+  {"(ab|a)(bc|c)",FXRex::Normal},
+  {"(a?b)?b",FXRex::Normal},
+  {"(a+)+b",FXRex::Normal},
+  {"(a|aa)*c",FXRex::Normal},
+  {"a{2,3}",FXRex::Normal},
+  {"a{2,3}?b",FXRex::Normal},
+  {"[ab]{1,4}c",FXRex::Normal},
+  {"(a|b){0,2}",FXRex::Normal},
+  {"(ab){2,}",FXRex::Normal},
+  {"[^a\\n]+",FXRex::Normal},
+  {"\\w+",FXRex::Normal},
+  {"\\s\\w",FXRex::Normal},
+  {"\\bab",FXRex::Normal},
+  {"b\\b",FXRex::Normal},
+  {"\\Bb\\B",FXRex::Normal},
+  {"^a",FXRex::Normal},
+  {"b$",FXRex::Normal},
+  {"^$",FXRex::Normal},
+  {"^(a|b)*$",FXRex::Normal},
+  {"\\Aab",FXRex::Normal},
+  {"b\\Z",FXRex::Normal},
+  {"a*",FXRex::NotEmpty},
+  {"(a|b)*",FXRex::Exact},
+  {"ab",FXRex::Words},
+  {"(a.)+?\\n",FXRex::Normal},
+  {".*b",FXRex::Newline},
+  {"(?i:ab)+",FXRex::Normal},
+  {"a(b|c)*?",FXRex::Normal},
+  {"(a|b|c)?a",FXRex::Normal},
+  {"(a(b(c)?)?)+",FXRex::Normal},
+  {"(a)\\1",FXRex::Normal},
+  {"(?=a)ab",FXRex::Normal},
+  {"(?>a+)b",FXRex::Normal},
+  {"a++b",FXRex::Normal},
+  {"(ab)*+",FXRex::Normal}
+  };
+
+
+// Compare match and search with Pike VM against backtracker, for random text
+static void compare(FXRandom& random,const FXRex& rex,const FXchar* pattern){
+  const FXint SIZE=200;
+  const FXint NPAR=4;
+  FXchar text[SIZE];
+  FXint beg[NPAR],end[NPAR],rbeg[NPAR],rend[NPAR];
+  FXint len,fm,to,p,q,i,j;
+  FXbool m,n;
+  for(i=0; i<1000; ++i){
+    len=(FXint)(random.randLong()%SIZE);
+    randomText(random,text,len,"aaabbcAB \n");
+    fm=(FXint)(random.randLong()%(len+1));
+    to=(FXint)(random.randLong()%(len+1));
+    m=rex.amatch(text,len,fm,FXRex::Linear,beg,end,NPAR);
+    n=rex.amatch(text,len,fm,FXRex::Backtrack,rbeg,rend,NPAR);
+    if(m!=n || !equalElms(beg,rbeg,NPAR) || !equalElms(end,rend,NPAR)){
+      fxwarning("FAILED: \"%s\" match at %d: %d, expected %d\n",pattern,fm,m,n);
+      failures++;
+      return;
+      }
+    p=rex.search(text,len,fm,to,FXRex::Linear,beg,end,NPAR);
+    q=rex.search(text,len,fm,to,FXRex::Backtrack,rbeg,rend,NPAR);
+    if(p!=q || !equalElms(beg,rbeg,NPAR) || !equalElms(end,rend,NPAR)){
+      fxwarning("FAILED: \"%s\" search from %d to %d in \"%.*s\": %d, expected %d\n",pattern,fm,to,len,text,p,q);
+      for(j=0; j<NPAR; ++j){ fxwarning("  %d: %d-%d, expected %d-%d\n",j,beg[j],end[j],rbeg[j],rend[j]); }
+      failures++;
+      return;
+      }
+    }
+  }
+
+
+// Time search for pattern which makes the backtracker go exponential on strings of
+// growing length; with the backtracker until it gets too slow, then without it
+static void pathological(const FXchar* pattern,FXchar ch,FXint mode){
+  FXRex rex(pattern,mode);
+  FXString text;
+  FXdouble backtrack=0.0,automatic,linear;
+  FXint n,p,q,r;
+  FXTime start;
+  fxmessage("  %s\n",pattern);
+  for(n=2; n<=1048576; n=(backtrack<100.0)?n+2:n*2){
+    text.assign(ch,n);
+    if(backtrack<100.0){
+      start=FXThread::time();
+      q=rex.search(text,0,n,FXRex::Backtrack);
+      backtrack=elapsed(start);
+      }
+    else if(n<1024){
+      continue;
+      }
+    start=FXThread::time();
+    p=rex.search(text,0,n);
+    automatic=elapsed(start);
+    start=FXThread::time();
+    r=rex.search(text,0,n,FXRex::Linear);
+    linear=elapsed(start);
+    if(p!=r){ fxwarning("FAILED: \"%s\" on %d characters: %d, expected %d\n",pattern,n,p,r); failures++; }
+    if(n<1024){
+      if(p!=q){ fxwarning("FAILED: \"%s\" on %d characters: %d, expected %d\n",pattern,n,p,q); failures++; }
+      fxmessage("    n=%-8d backtrack %10.3lfms, default %10.3lfms, linear %10.3lfms\n",n,backtrack,automatic,linear);
+      }
+    else{
+      fxmessage("    n=%-8d %23s default %10.3lfms, linear %10.3lfms\n",n,"",automatic,linear);
+      }
+    }
+  }
+
+
+// Time finding all matches in text, with given match mode
+static FXdouble findall(const FXRex& rex,const FXchar* text,FXint len,FXint mode,FXint& count){
+  FXint beg[1],end[1];
+  FXint pos=0;
+  FXTime start=FXThread::time();
+  count=0;
+  while(pos<len && (pos=rex.search(text,len,pos,len,mode,beg,end,1))>=0){
+    pos=FXMAX(end[0],pos+1);
+    count++;
+    }
+  return elapsed(start);
+  }
+
+
+// Time finding all matches of ordinary pattern, with either matcher
+static void benchmark(const FXchar* text,FXint len,const FXchar* pattern,FXint mode){
+  FXRex rex(pattern,mode);
+  FXdouble backtrack,linear;
+  FXint count,lcount;
+  backtrack=findall(rex,text,len,FXRex::Backtrack,count);
+  linear=findall(rex,text,len,FXRex::Linear,lcount);
+  if(count!=lcount){ fxwarning("FAILED: \"%s\" found %d, expected %d\n",pattern,lcount,count); failures++; }
+  fxmessage("  %-24s %7d matches: backtrack %9.3lfms (%5.0lf MB/s), linear %9.3lfms (%5.0lf MB/s)\n",pattern,count,backtrack,len/(1000.0*backtrack),linear,len/(1000.0*linear));
+  }
+
+
+// Start
+int main(int,char**){
+  const FXint SIZE=4000000;
+  static const FXchar *const words[]={"the ","search ","string ","pattern ","regular ","expression ","backtrack ","match ","text ","\n"};
+  FXRandom random(1234);
+  FXString big;
+  FXint i,n;
+
+  // Correctness
+  for(i=0; i<(FXint)ARRAYNUMBER(patterns); ++i){
+    FXRex rex(patterns[i].pattern,patterns[i].mode|FXRex::Capture);
+    if(rex.empty()){ fxwarning("FAILED: \"%s\" does not parse\n",patterns[i].pattern); failures++; continue; }
+    compare(random,rex,patterns[i].pattern);
+    }
+
+  // Exponential backtracking
+  fxmessage("pathological patterns:\n");
+  pathological("(a|aa)*b",'a',FXRex::Normal);
+  pathological("(a+)+b",'a',FXRex::Normal);
+  pathological("(x+x+)+y",'x',FXRex::Normal);
+
+  // Big text of words
+  big.length(SIZE);
+  for(i=0; i<SIZE; i+=n){
+    const FXchar* w=words[random.randLong()%ARRAYNUMBER(words)];
+    for(n=0; w[n] && i+n<SIZE; ++n) big[i+n]=w[n];
+    }
+  fxmessage("%d bytes:\n",big.length());
+  benchmark(big.text(),big.length(),"pattern",FXRex::Normal);
+  benchmark(big.text(),big.length(),"\\bex\\w+",FXRex::Normal);
+  benchmark(big.text(),big.length(),"(match|text) the",FXRex::Normal);
+  benchmark(big.text(),big.length(),"[xyz]\\w+",FXRex::Normal);
+  benchmark(big.text(),big.length(),"\\w+ing",FXRex::Normal);
+  benchmark(big.text(),big.length(),"s.*?h",FXRex::Normal);
+
+  return report();
+  }
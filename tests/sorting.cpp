@@ -0,0 +1,177 @@
+/********************************************************************************
+*                                                                               *
+*                          L i s t   S o r t   T e s t                          *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Benchmark FXIconList::sortItems(), for 10k, 100k, and 1M items, with items
+    labeled "name\tsize"; the sort function parses the size from the label each
+    time it is called, like FXFileList's sort functions extract fields from the
+    item text.
+  - Compare with the shell sort previously used, with the merge sort, and with the
+    merge sort using a sort key function which parses the size only once per item.
+  - Check that sorting is stable, and that all three methods agree.
+  - If a directory is passed, also check that each of FXFileList's sort key functions
+    orders its items the same as the corresponding sort function.
+*/
+
+/*******************************************************************************/
+
+// Parse size field from label
+static FXlong labelsize(const FXIconItem* a){
+  return a->getText().section('\t',1).toLong();
+  }
+
+
+// Compare by size parsed from label
+static FXint bysize(const FXIconItem* a,const FXIconItem* b){
+  return FXSGNZ(labelsize(a)-labelsize(b));
+  }
+
+
+// Sort key is size parsed from label
+static FXlong bysizekey(const FXIconItem* a){
+  return labelsize(a);
+  }
+
+
+// Shell sort, as previously used by sortItems()
+static void shellsort(FXIconItem** items,FXint n,FXIconListSortFunc sortfunc){
+  FXIconItem *v;
+  FXint i,j,h;
+  for(h=1; h<=n/9; h=3*h+1){}
+  for(; h>0; h/=3){
+    for(i=h+1;i<=n;i++){
+      v=items[i-1];
+      j=i;
+      while(j>h && sortfunc(items[j-h-1],v)>0){
+        items[j-1]=items[j-h-1];
+        j-=h;
+        }
+      items[j-1]=v;
+      }
+    }
+  }
+
+
+// Fill list with n items in random order, sizes having many duplicates
+static void fill(FXIconList* list,FXint n,FXRandom& random){
+  list->clearItems();
+  for(FXint i=0; i<n; ++i){
+    list->appendItem(FXString::value("item%d\t%lu",i,random.randLong()%(n/4+1)));
+    }
+  }
+
+
+// Check list is sorted, and items with equal sizes kept their order
+static FXbool stable(FXIconList* list){
+  for(FXint i=1; i<list->getNumItems(); ++i){
+    FXlong s1=labelsize(list->getItem(i-1));
+    FXlong s2=labelsize(list->getItem(i));
+    if(s2<s1) return false;
+    if(s1==s2 && list->getItemText(i).mid(4,20).toInt()<list->getItemText(i-1).mid(4,20).toInt()) return false;
+    }
+  return true;
+  }
+
+
+// Benchmark sorting of n items
+static FXbool testSort(FXIconList* list,FXint n,FXRandom& random){
+  FXArray<FXIconItem*> items;
+  FXTime start;
+  FXbool ok=true;
+  FXint i;
+
+  // Old shell sort
+  fill(list,n,random);
+  items.no(n);
+  for(i=0; i<n; ++i) items[i]=list->getItem(i);
+  start=FXThread::time();
+  shellsort(items.data(),n,bysize);
+  fxmessage("%8d items: shell sort %10.3lfms",n,elapsed(start));
+
+  // Merge sort
+  list->setSortFunc(bysize);
+  start=FXThread::time();
+  list->sortItems();
+  fxmessage("  merge sort %10.3lfms",elapsed(start));
+  ok&=stable(list);
+
+  // Same order as shell sort, for distinct sizes
+  for(i=0; i<n; ++i){
+    if(labelsize(items[i])!=labelsize(list->getItem(i))){ ok=false; break; }
+    }
+
+  // Merge sort with sort keys, from original order
+  fill(list,n,random);
+  list->setSortFunc(bysize,bysizekey);
+  start=FXThread::time();
+  list->sortItems();
+  fxmessage("  keyed merge sort %10.3lfms",elapsed(start));
+  ok&=stable(list);
+
+  // Sorting sorted list
+  start=FXThread::time();
+  list->sortItems();
+  fxmessage("  resort %10.3lfms\n",elapsed(start));
+  ok&=stable(list);
+  return ok;
+  }
+
+
+// Check sort keys of file list agree with sort functions
+static FXbool testFileList(FXFileList* files,const FXString& dir){
+  const FXIconListSortFunc funcs[]={
+    FXFileList::ascending,FXFileList::descending,FXFileList::ascendingCase,FXFileList::descendingCase,
+    FXFileList::ascendingType,FXFileList::descendingType,FXFileList::ascendingSize,FXFileList::descendingSize,
+    FXFileList::ascendingTime,FXFileList::descendingTime,FXFileList::ascendingUser,FXFileList::descendingUser,
+    FXFileList::ascendingGroup,FXFileList::descendingGroup
+    };
+  FXArray<FXIconItem*> plain;
+  FXTime start;
+  FXbool ok=true;
+  FXint i,f;
+  files->setDirectory(dir);
+  fxmessage("%s: %d items\n",dir.text(),files->getNumItems());
+  for(f=0; f<(FXint)ARRAYNUMBER(funcs); ++f){
+    files->FXIconList::setSortFunc(funcs[f]);
+    start=FXThread::time();
+    files->sortItems();
+    fxmessage("  sort %2d: %9.3lfms",f,elapsed(start));
+    plain.no(files->getNumItems());
+    for(i=0; i<files->getNumItems(); ++i) plain[i]=files->getItem(i);
+    files->setSortFunc(funcs[f]);
+    start=FXThread::time();
+    files->sortItems();
+    fxmessage("  keyed %9.3lfms\n",elapsed(start));
+    for(i=0; i<files->getNumItems(); ++i){
+      if(plain[i]!=files->getItem(i)){ fxwarning("sort %d: key mismatch at %d: %s\n",f,i,files->getItemFilename(i).text()); ok=false; break; }
+      }
+    }
+  return ok;
+  }
+
+
+// Start
+int main(int argc,char *argv[]){
+  FXApp app("sorting");
+  FXMainWindow *main=new FXMainWindow(&app,"sorting");
+  FXIconList *list=new FXIconList(main);
+  FXRandom random(1234);
+  FXbool ok=true;
+  ok&=testSort(list,10000,random);
+  ok&=testSort(list,100000,random);
+  ok&=testSort(list,1000000,random);
+  if(1<argc){
+    FXFileList *files=new FXFileList(main);
+    ok&=testFileList(files,FXPath::absolute(argv[1]));
+    }
+  fxmessage(ok?"OK\n":"FAILED\n");
+  return ok?0:1;
+  }
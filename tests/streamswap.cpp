@@ -0,0 +1,198 @@
+/********************************************************************************
+*                                                                               *
+*                   S t r e a m   A r r a y   S w a p   T e s t                 *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Save and load arrays of 16, 32, and 64 bit values through FXStream, in native
+    and in swapped byte order, and check the bytes in the stream against values
+    byte swapped one at a time.
+  - Go through a stream with a small, odd-sized buffer too, so that arrays are
+    split over many buffer refills, some of them in the middle of a value.
+  - Time saving and loading big arrays through a memory stream.
+*/
+
+/*******************************************************************************/
+
+// Stream through small buffer into a string
+class ChunkStream : public FXStream {
+public:
+  FXString data;
+  FXint    at;
+protected:
+  virtual FXuval writeBuffer(FXuval count);
+  virtual FXuval readBuffer(FXuval count);
+public:
+  ChunkStream():at(0){ }
+  void rewind(){ at=0; }
+  virtual FXbool close();
+  };
+
+
+// Append buffer contents to string
+FXuval ChunkStream::writeBuffer(FXuval){
+  data.append((const FXchar*)rdptr,(FXint)(wrptr-rdptr));
+  rdptr=begptr;
+  wrptr=begptr;
+  return endptr-wrptr;
+  }
+
+
+// Refill buffer from string, keeping unread bytes
+FXuval ChunkStream::readBuffer(FXuval){
+  FXival m=wrptr-rdptr;
+  FXival n;
+  if(m){memmove(begptr,rdptr,m);}
+  rdptr=begptr;
+  wrptr=begptr+m;
+  n=FXMIN(endptr-wrptr,(FXival)(data.length()-at));
+  memcpy(wrptr,data.text()+at,n);
+  wrptr+=n;
+  at+=(FXint)n;
+  return wrptr-rdptr;
+  }
+
+
+// Flush buffer when saving, and close
+FXbool ChunkStream::close(){
+  if(dir==FXStreamSave) writeBuffer(0);
+  return FXStream::close();
+  }
+
+/*******************************************************************************/
+
+// Reverse bytes of each element unless native order
+static void reference(FXuchar* dst,const FXuchar* src,FXuval n,FXint size,FXbool big){
+  for(FXuval i=0; i<n; i+=size){
+    for(FXint j=0; j<size; ++j){
+      dst[i+j]=(big==FOX_BIGENDIAN) ? src[i+j] : src[i+size-1-j];
+      }
+    }
+  }
+
+
+// Save array of elements of given size
+static void saveArray(FXStream& store,const FXuchar* src,FXuval count,FXint size){
+  switch(size){
+    case 2: store.save((const FXushort*)src,count); break;
+    case 4: store.save((const FXuint*)src,count); break;
+    case 8: store.save((const FXulong*)src,count); break;
+    }
+  }
+
+
+// Load array of elements of given size
+static void loadArray(FXStream& store,FXuchar* dst,FXuval count,FXint size){
+  switch(size){
+    case 2: store.load((FXushort*)dst,count); break;
+    case 4: store.load((FXuint*)dst,count); break;
+    case 8: store.load((FXulong*)dst,count); break;
+    }
+  }
+
+
+// Save and load arrays of many lengths, at unaligned offsets, through small buffer
+static void verify(FXint size,FXbool big){
+  const FXuval MAXCOUNT=1000;
+  FXuchar src[MAXCOUNT*8+8];
+  FXuchar dst[MAXCOUNT*8+8];
+  FXuchar ref[MAXCOUNT*8];
+  FXuchar buffer[61];
+  ChunkStream store;
+  FXuval count,i;
+  FXint off;
+  for(i=0; i<sizeof(src); ++i) src[i]=(FXuchar)(i*7+3);
+  for(count=0; count<=MAXCOUNT; count+=(count<70)?1:37){
+    off=(FXint)(count%5);
+
+    // Save; check bytes in stream
+    store.data.clear();
+    store.open(FXStreamSave,buffer,sizeof(buffer));
+    store.setBigEndian(big);
+    saveArray(store,src+off,count,size);
+    store.close();
+    reference(ref,src+off,count*size,size,big);
+    check(store.data.length()==(FXint)(count*size) && memcmp(store.data.text(),ref,count*size)==0,"save",size*8,big);
+
+    // Load; check we get back the original
+    memset(dst,0,sizeof(dst));
+    store.rewind();
+    store.open(FXStreamLoad,buffer,sizeof(buffer));
+    store.setBigEndian(big);
+    loadArray(store,dst+off,count,size);
+    check(store.status()==FXStreamOK && store.position()==(FXlong)(count*size),"load status",size*8,big);
+    store.close();
+    check(memcmp(dst+off,src+off,count*size)==0,"load",size*8,big);
+    }
+  }
+
+
+// Time saving and loading a big array through memory stream
+static void benchmark(FXuchar* src,FXuchar* dst,FXuval bytes,FXint size,FXbool big){
+  const FXint ROUNDS=10;
+  FXuchar* data=nullptr;
+  FXuval length=0;
+  FXdouble saving,loading;
+  FXMemoryStream store;
+  FXTime start;
+  FXint r;
+  store.open(FXStreamSave,nullptr,bytes+64,false);
+  store.setBigEndian(big);
+  start=FXThread::time();
+  for(r=0; r<ROUNDS; ++r){
+    store.position(0);
+    saveArray(store,src,bytes/size,size);
+    }
+  saving=elapsed(start);
+  store.takeBuffer(data,length);
+  store.close();
+  store.open(FXStreamLoad,data,bytes,true);
+  store.setBigEndian(big);
+  start=FXThread::time();
+  for(r=0; r<ROUNDS; ++r){
+    store.position(0);
+    loadArray(store,dst,bytes/size,size);
+    }
+  loading=elapsed(start);
+  store.close();
+  check(memcmp(src,dst,bytes)==0,"big array",size*8,big);
+  fxmessage("  %2d bit %s endian: save %7.0lf MB/s, load %7.0lf MB/s\n",size*8,big?"big   ":"little",ROUNDS*bytes/(1000.0*saving),ROUNDS*bytes/(1000.0*loading));
+  }
+
+
+// Start
+int main(int,char**){
+  const FXuval BYTES=64000000;
+  FXuint features=fxCPUFeatures();
+  FXuchar *src,*dst;
+  FXint size;
+  FXuval i;
+
+  fxmessage("cpu: %s%s\n",(features&CPU_HAS_AVX2)?"avx2 ":"",(features&CPU_HAS_SSSE3)?"ssse3":"");
+
+  // Correctness
+  for(size=2; size<=8; size<<=1){
+    verify(size,false);
+    verify(size,true);
+    }
+
+  // Throughput
+  allocElms(src,BYTES);
+  allocElms(dst,BYTES);
+  for(i=0; i<BYTES; ++i) src[i]=(FXuchar)(i*13);
+  fxmessage("%lu byte arrays:\n",BYTES);
+  for(size=2; size<=8; size<<=1){
+    benchmark(src,dst,BYTES,size,FOX_BIGENDIAN);
+    benchmark(src,dst,BYTES,size,!FOX_BIGENDIAN);
+    }
+  freeElms(src);
+  freeElms(dst);
+
+  return report();
+  }
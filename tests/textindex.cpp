@@ -0,0 +1,304 @@
+/********************************************************************************
+*                                                                               *
+*                       T e x t   L i n e   I n d e x   T e s t                 *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Exercise FXText's line index without a display; the widget is laid out, but
+    never created or painted, so characters are one pixel wide.
+  - After random edits, compare line and row navigation against the plain scans
+    FXText used before it had a line index, both with and without word wrapping.
+  - Time going to random lines and rows of a big text, with the index and with
+    the plain scans.
+  - Save the text and load it into a new widget, which must rebuild its line
+    index from the loaded buffer.
+  - If a file is passed, load it instead of generating the big text.
+*/
+
+/*******************************************************************************/
+
+// Gain access to internals; the reference functions scan the buffer
+class Text : public FXText {
+public:
+  Text(){ }
+  Text(FXComposite* p,FXuint opts):FXText(p,nullptr,0,opts){ }
+  FXint refLineStart(FXint pos) const;
+  FXint refNextLine(FXint pos,FXint nl) const;
+  FXint refPrevLine(FXint pos,FXint nl) const;
+  FXint refRowStart(FXint pos) const;
+  FXint refNextRow(FXint pos,FXint nr) const;
+  FXint refPrevRow(FXint pos,FXint nr) const;
+  FXint refCountRows(FXint start,FXint end) const;
+  FXint refCountLines(FXint start,FXint end) const;
+  };
+
+
+// Line start by scanning
+FXint Text::refLineStart(FXint pos) const {
+  while(0<pos && getByte(pos-1)!='\n') --pos;
+  return pos;
+  }
+
+
+// Next line by scanning
+FXint Text::refNextLine(FXint pos,FXint nl) const {
+  if(0<nl){
+    while(pos<length){
+      if(getByte(pos++)=='\n' && --nl<=0) break;
+      }
+    }
+  return pos;
+  }
+
+
+// Previous line by scanning
+FXint Text::refPrevLine(FXint pos,FXint nl) const {
+  if(0<nl){
+    while(0<pos){
+      if(getByte(pos-1)=='\n' && --nl<0) break;
+      pos--;
+      }
+    }
+  return pos;
+  }
+
+
+// Row start by scanning
+FXint Text::refRowStart(FXint pos) const {
+  FXint p=pos,t;
+  pos=refLineStart(pos);
+  if(options&TEXT_WORDWRAP){
+    while(pos<p && (t=wrap(pos))<=p && t<length) pos=t;
+    }
+  return pos;
+  }
+
+
+// Next row by scanning
+FXint Text::refNextRow(FXint pos,FXint nr) const {
+  if(!(options&TEXT_WORDWRAP)) return refNextLine(pos,nr);
+  if(0<nr){
+    pos=refRowStart(pos);
+    while(pos<length){
+      pos=wrap(pos);
+      if(--nr<=0) break;
+      }
+    }
+  return pos;
+  }
+
+
+// Previous row by scanning
+FXint Text::refPrevRow(FXint pos,FXint nr) const {
+  FXint p,q,t;
+  if(!(options&TEXT_WORDWRAP)) return refPrevLine(pos,nr);
+  if(0<nr){
+    while(0<pos){
+      p=pos;
+      pos=refLineStart(pos);
+      q=pos;
+      while(q<p && (t=wrap(q))<=p && t<length){ --nr; q=t; }
+      while(nr<0){ pos=wrap(pos); ++nr; }
+      if(nr==0) break;
+      if(pos==0) break;
+      --pos;
+      --nr;
+      }
+    }
+  return pos;
+  }
+
+
+// Count rows by scanning
+FXint Text::refCountRows(FXint start,FXint end) const {
+  FXint result=0;
+  if(!(options&TEXT_WORDWRAP)) return refCountLines(start,end);
+  while(start<end){ start=wrap(start); result++; }
+  return result;
+  }
+
+
+// Count lines by scanning
+FXint Text::refCountLines(FXint start,FXint end) const {
+  FXint result=0;
+  while(start<end){ if(getByte(start++)=='\n') result++; }
+  return result;
+  }
+
+/*******************************************************************************/
+
+// Make random text; mostly short lines, some very long ones
+static FXString makeText(FXRandom& random,FXint size){
+  FXString text;
+  FXint n;
+  text.length(size);
+  for(FXint i=0; i<size; ){
+    n=(random.randLong()%100==0) ? (FXint)(random.randLong()%20000) : (FXint)(random.randLong()%120);
+    for(; 0<n && i<size; --n){
+      text[i++]=(random.randLong()%6==0) ? ' ' : 'a'+(FXchar)(random.randLong()%26);
+      }
+    if(i<size) text[i++]='\n';
+    }
+  return text;
+  }
+
+
+// Random count, mostly small, sometimes large
+static FXint randCount(FXRandom& random,FXint max){
+  return (random.randLong()&1) ? (FXint)(random.randLong()%5) : (FXint)(random.randLong()%(max+1));
+  }
+
+
+// Compare navigation with reference scans at random places
+static void compare(Text* text,FXRandom& random,FXint n){
+  FXint len=text->getLength();
+  FXint rows=text->refCountRows(0,len);
+  FXint lines=text->refCountLines(0,len);
+  FXint i,p,q,r,c;
+  check(text->countRows(0,len)==rows,"countRows all",text->countRows(0,len),rows);
+  check(text->countLines(0,len)==lines,"countLines all",text->countLines(0,len),lines);
+  for(i=0; i<n; ++i){
+    p=(FXint)(random.randLong()%(len+1));
+    q=(FXint)(random.randLong()%(len+1));
+    if(q<p) FXSWAP(p,q,c);
+    check(text->lineStart(p)==text->refLineStart(p),"lineStart",text->lineStart(p),text->refLineStart(p));
+    check(text->rowStart(p)==text->refRowStart(p),"rowStart",text->rowStart(p),text->refRowStart(p));
+    check(text->countLines(p,q)==text->refCountLines(p,q),"countLines",p,q);
+    c=randCount(random,lines);
+    check(text->nextLine(p,c)==text->refNextLine(p,c),"nextLine",p,c);
+    check(text->prevLine(p,c)==text->refPrevLine(p,c),"prevLine",p,c);
+    c=randCount(random,rows);
+    r=text->refRowStart(p);
+    check(text->nextRow(r,c)==text->refNextRow(r,c),"nextRow",r,c);
+    check(text->prevRow(r,c)==text->refPrevRow(r,c),"prevRow",r,c);
+    q=text->refRowStart(q);
+    check(text->countRows(r,q)==text->refCountRows(r,q),"countRows",r,q);
+    }
+  rows=text->refCountRows(0,text->refRowStart(len));
+  check(text->getNumRows()==rows+1,"number of rows",text->getNumRows(),rows+1);
+  }
+
+
+// Make random edits, and compare after each batch
+static void edit(Text* text,FXRandom& random,FXint batches){
+  FXString ins;
+  FXint b,i,p,d;
+  for(b=0; b<batches; ++b){
+    for(i=0; i<20; ++i){
+      p=(FXint)(random.randLong()%(text->getLength()+1));
+      d=(FXint)(random.randLong()%((random.randLong()%10==0)?30000:50));
+      d=FXMIN(d,text->getLength()-p);
+      ins=makeText(random,(FXint)(random.randLong()%((random.randLong()%10==0)?30000:50)));
+      text->replaceText(p,d,ins);
+      }
+    compare(text,random,50);
+    }
+  }
+
+
+// Save text, load it into a new one, and compare navigation on that
+static void reload(FXApp& app,Text* text,FXRandom& random){
+  FXMemoryStream ms(&app);
+  FXuchar *data;
+  FXuval size;
+  Text *copy=new Text;
+  ms.open(FXStreamSave,nullptr,4096);
+  text->save(ms);
+  size=ms.position();
+  ms.takeBuffer(data,size);
+  ms.close();
+  ms.open(FXStreamLoad,data,size);
+  copy->load(ms);
+  ms.close();
+  copy->position(0,0,600,400);
+  copy->layout();
+  check(copy->getLength()==text->getLength(),"reload length",copy->getLength(),text->getLength());
+  compare(copy,random,50);
+  freeElms(data);
+  delete copy;
+  }
+
+
+// Time going to random lines, or rows
+static void benchmark(Text* text,FXRandom& random,FXint jumps){
+  FXint lines=text->countLines(0,text->getLength());
+  FXint rows=text->getNumRows();
+  FXTime start;
+  FXint i,l;
+  start=FXThread::time();
+  for(i=0; i<jumps; ++i){
+    l=(FXint)(random.randLong()%(lines+1));
+    text->setCursorRow(l,false);
+    text->makePositionVisible(text->getCursorPos());
+    }
+  fxmessage("  %d jumps to random rows out of %d: %.3lfms/jump\n",jumps,rows,elapsed(start)/jumps);
+  start=FXThread::time();
+  for(i=0; i<jumps; ++i){
+    l=(FXint)(random.randLong()%(lines+1));
+    text->nextLine(0,l);
+    }
+  fxmessage("  %d jumps to random lines out of %d: %.3lfus/jump indexed",jumps,lines,1000.0*elapsed(start)/jumps);
+  start=FXThread::time();
+  for(i=0; i<10; ++i){
+    l=(FXint)(random.randLong()%(lines+1));
+    text->refNextLine(0,l);
+    }
+  fxmessage(", %.3lfus/jump scanning\n",1000.0*elapsed(start)/10);
+  }
+
+
+// Start
+int main(int argc,char *argv[]){
+  FXApp app("textindex");
+  FXMainWindow *main=new FXMainWindow(&app,"textindex",nullptr,nullptr,DECOR_ALL,0,0,600,400);
+  Text *text=new Text(main,LAYOUT_FILL_X|LAYOUT_FILL_Y);
+  FXRandom random(1234);
+  FXString big;
+  FXTime start;
+
+  // Set up small text and edit it
+  text->setWrapColumns(60);
+  text->setText(makeText(random,200000));
+  text->position(0,0,600,400);
+  text->layout();
+  fxmessage("unwrapped: %d bytes, %d rows\n",text->getLength(),text->getNumRows());
+  compare(text,random,200);
+  edit(text,random,10);
+  reload(app,text,random);
+
+  // Same, wrapped
+  text->setTextStyle(text->getTextStyle()|TEXT_WORDWRAP|TEXT_FIXEDWRAP);
+  text->layout();
+  fxmessage("wrapped: %d bytes, %d rows\n",text->getLength(),text->getNumRows());
+  compare(text,random,200);
+  edit(text,random,10);
+
+  // Big text
+  if(1<argc){
+    FXFile file(argv[1],FXIO::Reading);
+    big.length((FXint)file.size());
+    if(!file.isOpen() || file.readBlock(big.text(),big.length())!=big.length()){ fxwarning("Unable to read %s\n",argv[1]); return 1; }
+    }
+  else{
+    big=makeText(random,100000000);
+    }
+  text->setTextStyle(text->getTextStyle()&~(TEXT_WORDWRAP|TEXT_FIXEDWRAP));
+  start=FXThread::time();
+  text->setText(big);
+  text->layout();
+  fxmessage("unwrapped: %d bytes, %d rows, set in %.3lfms\n",text->getLength(),text->getNumRows(),elapsed(start));
+  benchmark(text,random,1000);
+  text->setTextStyle(text->getTextStyle()|TEXT_WORDWRAP|TEXT_FIXEDWRAP);
+  start=FXThread::time();
+  text->layout();
+  fxmessage("wrapped: %d bytes, %d rows, reflowed in %.3lfms\n",text->getLength(),text->getNumRows(),elapsed(start));
+  benchmark(text,random,1000);
+
+  return report();
+  }
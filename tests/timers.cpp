@@ -0,0 +1,137 @@
+/********************************************************************************
+*                                                                               *
+*                         T i m e r   Q u e u e   T e s t                       *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Benchmark timer bookkeeping of FXApp and FXDispatcher, for large numbers
+    of timers, each with its own target.
+  - Timers are added with random intervals, then looked up, re-armed, and removed
+    in random order.
+  - FXDispatcher's timers are also dispatched, earliest first.
+*/
+
+/*******************************************************************************/
+
+// Timer target
+class Target : public FXObject {
+public:
+  FXuint count;
+public:
+  Target():count(0){}
+  FXbool expired(FXDispatcher*,FXTime,void*){ count++; return true; }
+  };
+
+
+// Random permutation of 0...n-1
+static void shuffle(FXArray<FXint>& order,FXRandom& random){
+  for(FXint i=0; i<order.no(); ++i) order[i]=i;
+  for(FXint i=order.no()-1; 0<i; --i){
+    FXint j=random.randLong()%(i+1);
+    swap(order[i],order[j]);
+    }
+  }
+
+
+// Benchmark FXApp timers
+static void testApp(FXApp& app,Target* targets,FXint n,FXRandom& random){
+  FXArray<FXint> order(n);
+  FXTime start;
+  FXint found=0;
+  FXint i;
+  shuffle(order,random);
+
+  start=FXThread::time();
+  for(i=0; i<n; ++i){
+    app.addTimeout(&targets[i],1,1000000000+random.randLong()%1000000000);
+    }
+  fxmessage("FXApp        %8d timers: add %9.3lfms",n,elapsed(start));
+
+  start=FXThread::time();
+  for(i=0; i<n; ++i){
+    found+=app.hasTimeout(&targets[order[i]],1);
+    }
+  fxmessage(" has %9.3lfms",elapsed(start));
+
+  start=FXThread::time();
+  for(i=0; i<n; ++i){
+    app.addTimeout(&targets[order[i]],1,1000000000+random.randLong()%1000000000);
+    }
+  fxmessage(" re-add %9.3lfms",elapsed(start));
+
+  start=FXThread::time();
+  for(i=0; i<n; ++i){
+    app.removeTimeout(&targets[order[i]],1);
+    }
+  fxmessage(" remove %9.3lfms (%d found)\n",elapsed(start),found);
+  }
+
+
+// Benchmark FXDispatcher timers
+static void testDispatcher(FXDispatcher& dispatcher,Target* targets,FXint n,FXRandom& random){
+  FXArray<FXint> order(n);
+  FXTime start;
+  FXint found=0;
+  FXint fired=0;
+  FXint i;
+  shuffle(order,random);
+
+  start=FXThread::time();
+  for(i=0; i<n; ++i){
+    dispatcher.addInterval(FXDispatcher::TimeoutCallback::create<Target,&Target::expired>(&targets[i]),1000000000+random.randLong()%1000000000);
+    }
+  fxmessage("FXDispatcher %8d timers: add %9.3lfms",n,elapsed(start));
+
+  start=FXThread::time();
+  for(i=0; i<n; ++i){
+    found+=dispatcher.hasTimeout(FXDispatcher::TimeoutCallback::create<Target,&Target::expired>(&targets[order[i]]));
+    }
+  fxmessage(" has %9.3lfms",elapsed(start));
+
+  start=FXThread::time();
+  for(i=0; i<n/2; ++i){
+    dispatcher.remTimeout(FXDispatcher::TimeoutCallback::create<Target,&Target::expired>(&targets[order[i]]));
+    }
+  fxmessage(" remove %9.3lfms",elapsed(start));
+
+  start=FXThread::time();
+  while(dispatcher.dispatchTimeout(forever)){
+    fired++;
+    }
+  fxmessage(" dispatch %9.3lfms (%d found, %d fired)\n",elapsed(start),found,fired);
+  }
+
+
+// Start
+int main(int argc,char* argv[]){
+  FXint counts[]={10000,100000,1000000};
+  FXint maximum=counts[ARRAYNUMBER(counts)-1];
+  FXRandom random(1234);
+  FXApp app("Timers","FoxTest");
+  FXDispatcher dispatcher;
+
+  // Limit number of timers
+  if(1<argc){
+    maximum=strtoul(argv[1],nullptr,0);
+    }
+
+  dispatcher.init();
+
+  Target *targets=new Target[maximum];
+
+  for(FXuint c=0; c<ARRAYNUMBER(counts) && counts[c]<=maximum; ++c){
+    testApp(app,targets,counts[c],random);
+    testDispatcher(dispatcher,targets,counts[c],random);
+    }
+
+  delete [] targets;
+
+  dispatcher.exit();
+  return 0;
+  }
@@ -0,0 +1,181 @@
+/********************************************************************************
+*                                                                               *
+*                       V i r t u a l   T a b l e   T e s t                     *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "fx.h"
+#include "checks.h"
+
+/*
+  Notes:
+  - Exercise FXVirtualTable with a provider of 100 million rows, without a display;
+    the table is laid out, but never created or painted.
+  - Check that the scroll offset reaches the last row, even though the content is
+    too tall for the scroll bar, and that the scroll bar position maps onto it.
+  - Check that rows are fetched from the provider only once while they stay in the
+    cache, and that notifications flush them and adjust current cell and selection.
+  - Time jumping to random places in the table, and fetching the visible rows.
+  - If run with -show, open a window with the table.
+*/
+
+/*******************************************************************************/
+
+// Provider of a hundred million rows
+class Provider : public FXTableProvider {
+public:
+  mutable FXlong calls;
+  FXint          shift;
+public:
+  Provider():calls(0),shift(0){ }
+  virtual FXString getCellText(FXint row,FXint col) const {
+    calls++;
+    return FXString::value("%d:%d",row+shift,col);
+    }
+  virtual FXuint getCellStyle(FXint,FXint col) const {
+    return col ? FXTableItem::RIGHT : FXTableItem::LEFT;
+    }
+  };
+
+
+// Gain access to cache
+class Table : public FXVirtualTable {
+public:
+  Table(FXComposite* p,FXuint opts):FXVirtualTable(p,nullptr,0,opts){ }
+  const Cell* fetch(FXint row){ return getCachedRow(row); }
+  FXint getCacheSize() const { return cachesize; }
+  FXint firstVisibleRow() const { return rowAtY(getVisibleY()); }
+  FXint lastVisibleRow() const { return FXMIN(rowAtY(getVisibleY()+getVisibleHeight()-1),getNumRows()-1); }
+  };
+
+
+// Fetch visible rows, return number of provider calls
+static FXlong fetchVisible(Table* table,Provider& provider){
+  FXlong before=provider.calls;
+  for(FXint r=table->firstVisibleRow(); r<=table->lastVisibleRow(); ++r){
+    table->fetch(r);
+    }
+  return provider.calls-before;
+  }
+
+
+// Start
+int main(int argc,char *argv[]){
+  const FXint ROWS=100000000;
+  const FXint COLS=5;
+  FXApp app("virtualtable");
+  FXbool show=(1<argc && FXString(argv[1])=="-show");
+  if(show) app.init(argc,argv);
+  FXMainWindow *main=new FXMainWindow(&app,"Virtual Table",nullptr,nullptr,DECOR_ALL,0,0,600,400);
+  Table *table=new Table(main,LAYOUT_FILL_X|LAYOUT_FILL_Y|TABLE_COL_SIZABLE);
+  Provider provider;
+  FXRandom random(1234);
+  FXTableRange range;
+  FXlong calls,total;
+  FXTime start;
+  FXint i,r,pages;
+
+  // Set up table
+  table->setProvider(&provider);
+  table->setNumColumns(COLS);
+  for(i=0; i<COLS; ++i) table->setColumnText(i,FXString::value("Column %d",i));
+  table->setNumRows(ROWS);
+  table->setRowLabelWidth(80);
+  if(show){
+    app.create();
+    main->show(PLACEMENT_SCREEN);
+    return app.run();
+    }
+  table->position(0,0,600,400);
+  table->layout();
+  fxmessage("rows=%d visible=%d..%d cache=%d rows\n",table->getNumRows(),table->firstVisibleRow(),table->lastVisibleRow(),table->getCacheSize());
+
+  // Scroll bar range is limited, but offset reaches last row
+  total=(FXlong)ROWS*table->getRowHeight()+1;
+  check(table->getContentHeight()<=(1<<30),"content height within scroll bar range");
+  table->makePositionVisible(ROWS-1,0);
+  check(table->getScrollOffset()==total-table->getVisibleHeight(),"scroll to last row");
+  check(table->lastVisibleRow()==ROWS-1,"last row visible");
+  check(table->verticalScrollBar()->getPosition()==table->verticalScrollBar()->getRange()-table->verticalScrollBar()->getPage(),"scroll bar at end");
+
+  // Scroll bar position maps linearly onto offset
+  table->setPosition(0,-(table->verticalScrollBar()->getRange()-table->verticalScrollBar()->getPage())/2);
+  r=table->firstVisibleRow();
+  check(ROWS/2-ROWS/100<r && r<ROWS/2+ROWS/100,"scroll bar half way");
+  table->setPosition(0,0);
+  check(table->getScrollOffset()==0 && table->firstVisibleRow()==0,"scroll bar at top");
+
+  // Row exactly at top when made visible going up
+  table->makePositionVisible(12345678,0);
+  table->makePositionVisible(12345600,0);
+  check(table->firstVisibleRow()==12345600 && table->getScrollOffset()==(FXlong)12345600*table->getRowHeight(),"exact offset");
+
+  // Visible rows fetched once, and still cached after scrolling a bit
+  calls=fetchVisible(table,provider);
+  check(calls==(table->lastVisibleRow()-table->firstVisibleRow()+1)*COLS,"visible rows fetched");
+  check(fetchVisible(table,provider)==0,"visible rows cached");
+  table->setScrollOffset(table->getScrollOffset()+3*table->getRowHeight());
+  check(fetchVisible(table,provider)==3*COLS,"scrolled rows fetched");
+  table->setScrollOffset(table->getScrollOffset()-3*table->getRowHeight());
+  check(fetchVisible(table,provider)==0,"scrolled back rows cached");
+
+  // Changed rows are fetched again
+  r=table->firstVisibleRow();
+  table->rowsChanged(r+2,2);
+  check(fetchVisible(table,provider)==2*COLS,"changed rows fetched");
+
+  // Inserting rows above shifts current, anchor, and selection
+  table->setCurrentItem(r+5,2);
+  table->setAnchorItem(r+5,2);
+  table->selectRows(r+10,r+20);
+  provider.shift=-3;
+  table->rowsInserted(r,3);
+  table->getSelection(range);
+  check(table->getNumRows()==ROWS+3,"rows inserted");
+  check(table->getCurrentRow()==r+8 && table->getAnchorRow()==r+8,"current after insert");
+  check(range.fm.row==r+13 && range.to.row==r+23,"selection after insert");
+  check(fetchVisible(table,provider)==(table->lastVisibleRow()-r+1)*COLS,"rows after insert fetched");
+
+  // Removing rows overlapping selection trims it
+  provider.shift=0;
+  table->rowsRemoved(r+10,5);
+  table->getSelection(range);
+  check(table->getNumRows()==ROWS-2,"rows removed");
+  check(table->getCurrentRow()==r+8,"current after remove");
+  check(range.fm.row==r+10 && range.to.row==r+18,"selection after remove");
+  table->rowsRemoved(r+10,9);
+  check(!table->isAnythingSelected(),"selection removed");
+
+  // Moving rows carries the current row along
+  table->rowsMoved(r+8,r+100,1);
+  check(table->getCurrentRow()==r+99,"current moved down");
+  table->rowsMoved(r+99,r,1);
+  check(table->getCurrentRow()==r,"current moved up");
+  table->rowsMoved(r+50,r+10,20);
+  check(table->getCurrentRow()==r,"current unaffected by move");
+  table->setNumRows(ROWS);
+
+  // Jump around randomly, fetching visible rows
+  provider.calls=0;
+  pages=100000;
+  start=FXThread::time();
+  for(i=0; i<pages; ++i){
+    table->setScrollOffset((FXlong)(random.randDouble()*total));
+    fetchVisible(table,provider);
+    }
+  fxmessage("%d random pages: %.3lfus/page, %lld cells fetched\n",pages,0.001*(FXThread::time()-start)/pages,provider.calls);
+
+  // Scroll through a stretch of rows one line at a time
+  provider.calls=0;
+  table->setScrollOffset(0);
+  start=FXThread::time();
+  for(i=0; i<pages; ++i){
+    table->setScrollOffset(table->getScrollOffset()+table->getRowHeight());
+    fetchVisible(table,provider);
+    }
+  check(provider.calls==(FXlong)(pages-1+table->lastVisibleRow()-table->firstVisibleRow()+1)*COLS,"each row fetched once while scrolling");
+  fxmessage("%d line scrolls: %.3lfus/line, %lld cells fetched\n",pages,0.001*(FXThread::time()-start)/pages,provider.calls);
+
+  return report();
+  }